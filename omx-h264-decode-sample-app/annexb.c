@@ -0,0 +1,612 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: annexb.c
+ *
+ * DESCRIPTION:
+ *   H.264 Annex-B byte stream parser definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'annexb.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "annexb.h"
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+/* Reader of the bits of a NAL unit payload. Emulation prevention bytes
+ * (00 00 03) are skipped, so the reader sees the RBSP */
+typedef struct
+{
+    const uint8_t * p_data;
+    size_t len;
+
+    /* Offset of the next byte */
+    size_t pos;
+
+    /* Current byte and the number of its bits not read yet */
+    uint8_t byte;
+    uint32_t bits_left;
+
+    /* The number of zero bytes just read */
+    uint32_t zeros;
+
+    /* True if the reader went past the end of the payload */
+    bool overrun;
+
+} annexb_bits_t;
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Check if the NAL unit whose header is at 'hdr' starts a new AU.
+ * 'has_vcl' is true if the current AU already contains a slice */
+static bool annexb_is_au_start(const annexb_t * p_annexb,
+                               size_t hdr, bool has_vcl);
+
+/* Read 'count' (up to 32) bits of 'p_bits' as an unsigned integer */
+static uint32_t annexb_read_bits(annexb_bits_t * p_bits, uint32_t count);
+
+/* Read an Exp-Golomb coded unsigned integer, ue(v) */
+static uint32_t annexb_read_ue(annexb_bits_t * p_bits);
+
+/* Read an Exp-Golomb coded signed integer, se(v) */
+static int32_t annexb_read_se(annexb_bits_t * p_bits);
+
+/* Skip a 'scaling_list' of 'size' coefficients (section 7.3.2.1.1.1) */
+static void annexb_skip_scaling_list(annexb_bits_t * p_bits, uint32_t size);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool annexb_open(annexb_t * p_annexb, const char * p_file_name)
+{
+    struct stat file_stat;
+    void * p_map = NULL;
+
+    /* Check parameters */
+    assert((p_annexb != NULL) && (p_file_name != NULL));
+
+    memset(p_annexb, 0, sizeof(annexb_t));
+
+    p_annexb->fd = open(p_file_name, O_RDONLY);
+    if (p_annexb->fd < 0)
+    {
+        printf("Error: Failed to open '%s'\n", p_file_name);
+        return false;
+    }
+
+    if ((fstat(p_annexb->fd, &file_stat) != 0) || (file_stat.st_size == 0))
+    {
+        printf("Error: '%s' is empty\n", p_file_name);
+        annexb_close(p_annexb);
+        return false;
+    }
+
+    p_map = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                 p_annexb->fd, 0);
+    if (p_map == MAP_FAILED)
+    {
+        printf("Error: Failed to map '%s' into memory\n", p_file_name);
+        annexb_close(p_annexb);
+        return false;
+    }
+
+    p_annexb->p_data = (const uint8_t *)p_map;
+    p_annexb->len    = (size_t)file_stat.st_size;
+
+    /* The stream is parsed once from start to end */
+    madvise(p_map, p_annexb->len, MADV_SEQUENTIAL);
+
+    return true;
+}
+
+bool annexb_next_au(annexb_t * p_annexb, const uint8_t ** pp_au, size_t * p_len)
+{
+    const uint8_t * p_data = NULL;
+
+    size_t au_start = 0;
+    size_t au_end = 0;
+    size_t start_code = 0;
+    size_t hdr = 0;
+    uint8_t nal_type = 0;
+    bool has_vcl = false;
+
+    /* Check parameters */
+    assert((p_annexb != NULL) && (pp_au != NULL) && (p_len != NULL));
+
+    p_data   = p_annexb->p_data;
+    au_start = p_annexb->pos;
+    au_end   = p_annexb->len;
+
+    start_code = annexb_find_start_code(p_data, p_annexb->len, au_start);
+
+    if (start_code == p_annexb->len)
+    {
+        /* No more NAL unit */
+        p_annexb->pos = p_annexb->len;
+        return false;
+    }
+
+    while (start_code < p_annexb->len)
+    {
+        hdr = start_code + 3;
+        if (hdr >= p_annexb->len)
+        {
+            break;
+        }
+
+        if (annexb_is_au_start(p_annexb, hdr, has_vcl))
+        {
+            /* Zero bytes before the start code are the 'zero_byte' of
+             * a 4-byte start code, so they go to the next AU */
+            au_end = start_code;
+            while ((au_end > au_start) && (p_data[au_end - 1] == 0))
+            {
+                au_end--;
+            }
+
+            break;
+        }
+
+        p_annexb->nal_count++;
+
+        nal_type = p_data[hdr] & 0x1F;
+        if ((nal_type == ANNEXB_NAL_SLICE) || (nal_type == ANNEXB_NAL_IDR_SLICE))
+        {
+            has_vcl = true;
+        }
+
+        start_code = annexb_find_start_code(p_data, p_annexb->len, hdr);
+    }
+
+    p_annexb->pos = au_end;
+
+    *pp_au = p_data + au_start;
+    *p_len = au_end - au_start;
+
+    p_annexb->au_count++;
+    if (*p_len > p_annexb->au_size_max)
+    {
+        p_annexb->au_size_max = *p_len;
+    }
+
+    return true;
+}
+
+void annexb_close(annexb_t * p_annexb)
+{
+    /* Check parameter */
+    assert(p_annexb != NULL);
+
+    if (p_annexb->p_data != NULL)
+    {
+        munmap((void *)p_annexb->p_data, p_annexb->len);
+        p_annexb->p_data = NULL;
+    }
+
+    if (p_annexb->fd >= 0)
+    {
+        close(p_annexb->fd);
+        p_annexb->fd = -1;
+    }
+}
+
+bool annexb_parse_sps(const annexb_t * p_annexb, annexb_sps_t * p_sps)
+{
+    annexb_bits_t bits;
+
+    size_t start_code = 0;
+    size_t hdr = 0;
+    uint8_t nal_type = 0;
+
+    uint32_t profile_idc = 0;
+    uint32_t chroma_format_idc = 1;
+    uint32_t separate_colour_plane = 0;
+    uint32_t poc_type = 0;
+    uint32_t width_mbs = 0;
+    uint32_t height_map_units = 0;
+    uint32_t frame_mbs_only = 0;
+    uint32_t crop[4] = { 0, 0, 0, 0 };
+    uint32_t index = 0;
+
+    /* Units of the cropping offsets (table 6-1 and equations 7-19 to 7-22) */
+    uint32_t crop_unit_x = 1;
+    uint32_t crop_unit_y = 1;
+
+    /* Check parameters */
+    assert((p_annexb != NULL) && (p_sps != NULL));
+
+    /* Find the SPS NAL unit. It comes before the first slice */
+    start_code = annexb_find_start_code(p_annexb->p_data, p_annexb->len, 0);
+
+    while (start_code < p_annexb->len)
+    {
+        hdr = start_code + 3;
+        if (hdr >= p_annexb->len)
+        {
+            return false;
+        }
+
+        nal_type = p_annexb->p_data[hdr] & 0x1F;
+        if (nal_type == ANNEXB_NAL_SPS)
+        {
+            break;
+        }
+
+        if ((nal_type == ANNEXB_NAL_SLICE) ||
+            (nal_type == ANNEXB_NAL_IDR_SLICE))
+        {
+            return false;
+        }
+
+        start_code = annexb_find_start_code(p_annexb->p_data,
+                                            p_annexb->len, hdr);
+    }
+
+    if (start_code == p_annexb->len)
+    {
+        return false;
+    }
+
+    /* The payload ends at the next start code (trailing zero bytes are
+     * never read) */
+    memset(&bits, 0, sizeof(bits));
+
+    bits.p_data = p_annexb->p_data + hdr + 1;
+    bits.len    = annexb_find_start_code(p_annexb->p_data, p_annexb->len,
+                                         hdr) - (hdr + 1);
+
+    profile_idc = annexb_read_bits(&bits, 8);
+    annexb_read_bits(&bits, 16);        /* Constraint flags and 'level_idc' */
+    annexb_read_ue(&bits);              /* seq_parameter_set_id */
+
+    if ((profile_idc == 100) || (profile_idc == 110) || (profile_idc == 122) ||
+        (profile_idc == 244) || (profile_idc == 44)  || (profile_idc == 83)  ||
+        (profile_idc == 86)  || (profile_idc == 118) || (profile_idc == 128) ||
+        (profile_idc == 138) || (profile_idc == 139) || (profile_idc == 134) ||
+        (profile_idc == 135))
+    {
+        chroma_format_idc = annexb_read_ue(&bits);
+        if (chroma_format_idc == 3)
+        {
+            separate_colour_plane = annexb_read_bits(&bits, 1);
+        }
+
+        annexb_read_ue(&bits);          /* bit_depth_luma_minus8 */
+        annexb_read_ue(&bits);          /* bit_depth_chroma_minus8 */
+        annexb_read_bits(&bits, 1);     /* qpprime_y_zero_transform_... */
+
+        if (annexb_read_bits(&bits, 1)) /* seq_scaling_matrix_present_flag */
+        {
+            for (index = 0; index < ((chroma_format_idc != 3) ? 8u : 12u);
+                 index++)
+            {
+                if (annexb_read_bits(&bits, 1))
+                {
+                    annexb_skip_scaling_list(&bits, (index < 6) ? 16 : 64);
+                }
+            }
+        }
+    }
+
+    annexb_read_ue(&bits);              /* log2_max_frame_num_minus4 */
+
+    poc_type = annexb_read_ue(&bits);
+    if (poc_type == 0)
+    {
+        annexb_read_ue(&bits);          /* log2_max_pic_order_cnt_lsb_minus4 */
+    }
+    else if (poc_type == 1)
+    {
+        annexb_read_bits(&bits, 1);     /* delta_pic_order_always_zero_flag */
+        annexb_read_se(&bits);          /* offset_for_non_ref_pic */
+        annexb_read_se(&bits);          /* offset_for_top_to_bottom_field */
+
+        /* num_ref_frames_in_pic_order_cnt_cycle */
+        for (index = annexb_read_ue(&bits);
+             (index > 0) && (bits.overrun == false); index--)
+        {
+            annexb_read_se(&bits);      /* offset_for_ref_frame */
+        }
+    }
+
+    p_sps->max_num_ref_frames = annexb_read_ue(&bits);
+    annexb_read_bits(&bits, 1);         /* gaps_in_frame_num_value_... */
+
+    width_mbs        = annexb_read_ue(&bits) + 1;
+    height_map_units = annexb_read_ue(&bits) + 1;
+    frame_mbs_only   = annexb_read_bits(&bits, 1);
+
+    if (!frame_mbs_only)
+    {
+        annexb_read_bits(&bits, 1);     /* mb_adaptive_frame_field_flag */
+    }
+
+    annexb_read_bits(&bits, 1);         /* direct_8x8_inference_flag */
+
+    if (annexb_read_bits(&bits, 1))     /* frame_cropping_flag */
+    {
+        for (index = 0; index < 4; index++)
+        {
+            crop[index] = annexb_read_ue(&bits);
+        }
+    }
+
+    if (bits.overrun || (width_mbs > ANNEXB_SPS_MAX_MBS) ||
+        (height_map_units > ANNEXB_SPS_MAX_MBS) ||
+        (p_sps->max_num_ref_frames > ANNEXB_SPS_MAX_REF_FRAMES))
+    {
+        return false;
+    }
+
+    p_sps->coded_width  = width_mbs * 16;
+    p_sps->coded_height = (2 - frame_mbs_only) * height_map_units * 16;
+
+    if ((chroma_format_idc != 0) && (separate_colour_plane == 0))
+    {
+        /* 4:2:0 and 4:2:2 chroma have half the width of luma, and 4:2:0
+         * chroma half its height */
+        crop_unit_x = (chroma_format_idc == 3) ? 1 : 2;
+        crop_unit_y = (chroma_format_idc == 1) ? 2 : 1;
+    }
+
+    crop_unit_y *= 2 - frame_mbs_only;
+
+    /* Each offset is bounded by the size, so the sums cannot overflow */
+    if ((crop[0] > p_sps->coded_width) || (crop[1] > p_sps->coded_width) ||
+        (crop[2] > p_sps->coded_height) || (crop[3] > p_sps->coded_height) ||
+        (((crop[0] + crop[1]) * crop_unit_x) >= p_sps->coded_width) ||
+        (((crop[2] + crop[3]) * crop_unit_y) >= p_sps->coded_height))
+    {
+        return false;
+    }
+
+    p_sps->width  = p_sps->coded_width  - ((crop[0] + crop[1]) * crop_unit_x);
+    p_sps->height = p_sps->coded_height - ((crop[2] + crop[3]) * crop_unit_y);
+
+    return true;
+}
+
+size_t annexb_find_start_code(const uint8_t * p_data, size_t len, size_t pos)
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i bytes0;
+    __m128i bytes1;
+    uint32_t mask = 0;
+    uint32_t bit = 0;
+
+    /* Find pairs of zero bytes 16 positions at a time. The 3rd byte of each
+     * pair is only checked for the (rare) candidates */
+    while ((pos + 18) <= len)
+    {
+        bytes0 = _mm_loadu_si128((const __m128i *)(p_data + pos));
+        bytes1 = _mm_loadu_si128((const __m128i *)(p_data + pos + 1));
+
+        mask = (uint32_t)_mm_movemask_epi8(
+                   _mm_and_si128(_mm_cmpeq_epi8(bytes0, zero),
+                                 _mm_cmpeq_epi8(bytes1, zero)));
+
+        while (mask != 0)
+        {
+            bit = (uint32_t)__builtin_ctz(mask);
+            if (p_data[pos + bit + 2] == 1)
+            {
+                return pos + bit;
+            }
+
+            mask &= mask - 1;
+        }
+
+        pos += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+
+    uint8x16_t pairs;
+    uint32_t index = 0;
+
+    /* Find pairs of zero bytes 16 positions at a time. The block is only
+     * scanned byte by byte when it contains a candidate */
+    while ((pos + 18) <= len)
+    {
+        pairs = vandq_u8(vceqq_u8(vld1q_u8(p_data + pos), zero),
+                         vceqq_u8(vld1q_u8(p_data + pos + 1), zero));
+
+        if (vmaxvq_u8(pairs) != 0)
+        {
+            for (index = 0; index < 16; index++)
+            {
+                if ((p_data[pos + index] == 0) &&
+                    (p_data[pos + index + 1] == 0) &&
+                    (p_data[pos + index + 2] == 1))
+                {
+                    return pos + index;
+                }
+            }
+        }
+
+        pos += 16;
+    }
+#endif
+
+    /* Scalar search (the last bytes, or the whole buffer without SIMD) */
+    while ((pos + 3) <= len)
+    {
+        if (p_data[pos + 2] > 1)
+        {
+            /* None of the 3 bytes can start a start code at 'pos' */
+            pos += 3;
+        }
+        else if ((p_data[pos] == 0) && (p_data[pos + 1] == 0) &&
+                 (p_data[pos + 2] == 1))
+        {
+            return pos;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+
+    return len;
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static bool annexb_is_au_start(const annexb_t * p_annexb,
+                               size_t hdr, bool has_vcl)
+{
+    uint8_t nal_type = p_annexb->p_data[hdr] & 0x1F;
+
+    if (!has_vcl)
+    {
+        /* NAL units before the first slice belong to the current AU */
+        return false;
+    }
+
+    switch (nal_type)
+    {
+        case ANNEXB_NAL_SEI:
+        case ANNEXB_NAL_SPS:
+        case ANNEXB_NAL_PPS:
+        case ANNEXB_NAL_AUD:
+        case 14:
+        case 15:
+        case 16:
+        case 17:
+        case 18:
+        {
+            return true;
+        }
+
+        case ANNEXB_NAL_SLICE:
+        case ANNEXB_NAL_IDR_SLICE:
+        {
+            /* 'first_mb_in_slice' is ue(v) coded. Its value is 0 if and only
+             * if the first bit of the slice header is 1 */
+            return ((hdr + 1) < p_annexb->len) &&
+                   ((p_annexb->p_data[hdr + 1] & 0x80) != 0);
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
+
+static uint32_t annexb_read_bits(annexb_bits_t * p_bits, uint32_t count)
+{
+    uint32_t value = 0;
+
+    while (count > 0)
+    {
+        if (p_bits->bits_left == 0)
+        {
+            /* Skip 'emulation_prevention_three_byte' (section 7.4.1) */
+            if ((p_bits->zeros >= 2) && (p_bits->pos < p_bits->len) &&
+                (p_bits->p_data[p_bits->pos] == 0x03))
+            {
+                p_bits->pos++;
+                p_bits->zeros = 0;
+            }
+
+            if (p_bits->pos >= p_bits->len)
+            {
+                /* Every further bit reads as 0 */
+                p_bits->overrun = true;
+                p_bits->byte = 0;
+            }
+            else
+            {
+                p_bits->byte = p_bits->p_data[p_bits->pos++];
+                p_bits->zeros = (p_bits->byte == 0) ? (p_bits->zeros + 1) : 0;
+            }
+
+            p_bits->bits_left = 8;
+        }
+
+        p_bits->bits_left--;
+        value = (value << 1) | ((p_bits->byte >> p_bits->bits_left) & 1);
+        count--;
+    }
+
+    return value;
+}
+
+static uint32_t annexb_read_ue(annexb_bits_t * p_bits)
+{
+    uint32_t leading_zeros = 0;
+
+    while ((annexb_read_bits(p_bits, 1) == 0) && (p_bits->overrun == false))
+    {
+        leading_zeros++;
+
+        if (leading_zeros > 31)
+        {
+            /* Not a valid 32-bit code */
+            p_bits->overrun = true;
+        }
+    }
+
+    if (p_bits->overrun)
+    {
+        return 0;
+    }
+
+    /* Equation 9-2 ('leading_zeros' is at most 31) */
+    return (uint32_t)((1ull << leading_zeros) - 1) +
+           annexb_read_bits(p_bits, leading_zeros);
+}
+
+static int32_t annexb_read_se(annexb_bits_t * p_bits)
+{
+    uint32_t code = annexb_read_ue(p_bits);
+
+    /* Table 9-3: 1, 2, 3, 4... map to 1, -1, 2, -2... */
+    return (code & 1) ? (int32_t)((code + 1) / 2) : -(int32_t)(code / 2);
+}
+
+static void annexb_skip_scaling_list(annexb_bits_t * p_bits, uint32_t size)
+{
+    int32_t last_scale = 8;
+    int32_t next_scale = 8;
+    uint32_t index = 0;
+
+    for (index = 0; index < size; index++)
+    {
+        if (next_scale != 0)
+        {
+            next_scale = (last_scale + annexb_read_se(p_bits) + 256) % 256;
+        }
+
+        last_scale = (next_scale == 0) ? last_scale : next_scale;
+    }
+}
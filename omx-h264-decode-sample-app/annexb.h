@@ -0,0 +1,133 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: annexb.h
+ *
+ * DESCRIPTION:
+ *   H.264 Annex-B byte stream parser.
+ *
+ *   The input file is mapped into memory. 'annexb_next_au' scans it for start
+ *   codes (00 00 01) and groups NAL units into access units (AU), so that each
+ *   input buffer of the decoder receives exactly one coded picture, like
+ *   GStreamer's 'h264parse' with 'alignment=au'.
+ *
+ *   A new AU starts (section 7.4.1.2.3 in ITU-T H.264) at the first of the
+ *   following NAL units after a slice of the current AU:
+ *     - Access unit delimiter, SPS, PPS, SEI or NAL unit type 14 to 18.
+ *     - A slice whose 'first_mb_in_slice' is 0.
+ *
+ *   Start codes are searched 16 bytes at a time with SSE2 (x86) or
+ *   NEON (Arm) instructions when the compiler supports them.
+ *
+ *   'annexb_parse_sps' reads the picture size and the number of reference
+ *   frames from the first sequence parameter set (SPS, section 7.3.2.1.1 in
+ *   ITU-T H.264), so that the output port of the decoder can be sized before
+ *   any buffer is allocated.
+ *
+ * PUBLIC FUNCTIONS:
+ *   annexb_open
+ *   annexb_next_au
+ *   annexb_close
+ *
+ *   annexb_parse_sps
+ *
+ *   annexb_find_start_code
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _ANNEXB_H_
+#define _ANNEXB_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* H.264 NAL unit types (table 7-1 in ITU-T H.264) */
+#define ANNEXB_NAL_SLICE     1
+#define ANNEXB_NAL_IDR_SLICE 5
+#define ANNEXB_NAL_SEI       6
+#define ANNEXB_NAL_SPS       7
+#define ANNEXB_NAL_PPS       8
+#define ANNEXB_NAL_AUD       9
+
+/* The maximum width and height (in macroblocks) accepted in an SPS */
+#define ANNEXB_SPS_MAX_MBS 512
+
+/* The maximum 'max_num_ref_frames' accepted in an SPS (the limit of H.264,
+ * 'MaxDpbFrames') */
+#define ANNEXB_SPS_MAX_REF_FRAMES 16
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* File descriptor of input file */
+    int fd;
+
+    /* Mapping of input file */
+    const uint8_t * p_data;
+    size_t len;
+
+    /* Offset of the start code of the next NAL unit */
+    size_t pos;
+
+    /* The number of AUs and NAL units found */
+    uint64_t au_count;
+    uint64_t nal_count;
+
+    /* Size of the largest AU (in bytes) */
+    size_t au_size_max;
+
+} annexb_t;
+
+typedef struct
+{
+    /* Size of the pictures (after cropping) */
+    uint32_t width;
+    uint32_t height;
+
+    /* Size of the decoded pictures (whole macroblocks, before cropping) */
+    uint32_t coded_width;
+    uint32_t coded_height;
+
+    /* The maximum number of frames used for reference ('max_num_ref_frames') */
+    uint32_t max_num_ref_frames;
+
+} annexb_sps_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Open and map 'p_file_name' for 'p_annexb'.
+ * Return true if successful. Otherwise, return false */
+bool annexb_open(annexb_t * p_annexb, const char * p_file_name);
+
+/* Get the next access unit of 'p_annexb'. On success, '*pp_au' points to
+ * the AU (starting with its first start code) in the mapping of input file
+ * and '*p_len' is its size in bytes.
+ * Return true if successful. Otherwise (end of stream), return false */
+bool annexb_next_au(annexb_t * p_annexb, const uint8_t ** pp_au, size_t * p_len);
+
+/* Unmap and close input file of 'p_annexb' */
+void annexb_close(annexb_t * p_annexb);
+
+/* Parse the first SPS of 'p_annexb' (before its first slice) to 'p_sps'.
+ * The position of 'annexb_next_au' does not change.
+ * Return true if successful. Otherwise (no SPS or invalid SPS), return false */
+bool annexb_parse_sps(const annexb_t * p_annexb, annexb_sps_t * p_sps);
+
+/* Find the first start code (00 00 01) in 'p_data' at or after 'pos'.
+ * Return its offset. Otherwise (not found), return 'len' */
+size_t annexb_find_start_code(const uint8_t * p_data, size_t len, size_t pos);
+
+#endif /* _ANNEXB_H_ */
@@ -0,0 +1,546 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: bench.c
+ *
+ * DESCRIPTION:
+ *   Benchmark harness for a media component (MC) definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'bench.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <time.h>
+#include <sys/resource.h>
+
+#include "bench.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Indexes of 'ports' */
+#define BENCH_PORT_IN  0
+#define BENCH_PORT_OUT 1
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Add the time 'p_port' held 'held' buffers (until 'now_ns') to 'held_area',
+ * then add 'delta' to 'held' */
+static void bench_update_held(bench_port_t * p_port, uint64_t now_ns, int delta);
+
+/* Record that 'p_buf' was sent to the MC through 'p_port' at 'now_ns' */
+static void bench_send(bench_port_t * p_port, OMX_BUFFERHEADERTYPE * p_buf,
+                       uint64_t now_ns);
+
+/* Record that 'p_buf' was returned by the MC through 'p_port' at 'now_ns' */
+static void bench_return(bench_t * p_bench, bench_port_t * p_port,
+                         OMX_BUFFERHEADERTYPE * p_buf, uint64_t now_ns);
+
+/* Add 'value' to 'p_samples' which has 'p_count' samples. It is dropped if
+ * 'p_samples' is full */
+static void bench_add_sample(bench_t * p_bench, uint64_t * p_samples,
+                             uint32_t * p_count, uint64_t value);
+
+/* Get CPU time (in ns) used so far by all threads of the process */
+static uint64_t bench_get_cpu_ns(void);
+
+/* Compare two 'uint64_t' for 'qsort' */
+static int bench_compare(const void * p_a, const void * p_b);
+
+/* Return the nearest-rank 'percent' percentile of sorted 'p_samples' */
+static uint64_t bench_percentile(const uint64_t * p_samples, uint32_t count,
+                                 double percent);
+
+/* Write the percentiles of 'count' sorted samples 'p_samples' (in ns) as a
+ * JSON object (in ms) */
+static void bench_write_percentiles(FILE * p_file, const char * p_name,
+                                    uint64_t * p_samples, uint32_t count);
+
+/* Write the occupancy of 'p_port' as a JSON object */
+static void bench_write_port(FILE * p_file, const char * p_name,
+                             bench_port_t * p_port, uint64_t duration_ns);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool bench_init(bench_t * p_bench, const char * p_app_name,
+                uint32_t capacity, bool frame_end_flag)
+{
+    /* Check parameters */
+    assert((p_bench != NULL) && (p_app_name != NULL) && (capacity > 0));
+
+    memset(p_bench, 0, sizeof(bench_t));
+
+    p_bench->p_app_name     = p_app_name;
+    p_bench->frame_end_flag = frame_end_flag;
+    p_bench->capacity       = capacity;
+    p_bench->cpu_start_ns   = bench_get_cpu_ns();
+
+    pthread_mutex_init(&p_bench->mutex, NULL);
+
+    /* All samples are allocated now, so recording one never allocates */
+    p_bench->p_etb_ns     = calloc(capacity, sizeof(uint64_t));
+    p_bench->p_latency_ns = calloc(capacity, sizeof(uint64_t));
+
+    p_bench->ports[BENCH_PORT_IN].p_hold_ns  = calloc(capacity,
+                                                      sizeof(uint64_t));
+    p_bench->ports[BENCH_PORT_OUT].p_hold_ns = calloc(capacity,
+                                                      sizeof(uint64_t));
+
+    if ((p_bench->p_etb_ns == NULL) || (p_bench->p_latency_ns == NULL) ||
+        (p_bench->ports[BENCH_PORT_IN].p_hold_ns == NULL) ||
+        (p_bench->ports[BENCH_PORT_OUT].p_hold_ns == NULL))
+    {
+        printf("Error: Failed to allocate samples of benchmark\n");
+
+        bench_deinit(p_bench);
+        return false;
+    }
+
+    return true;
+}
+
+void bench_deinit(bench_t * p_bench)
+{
+    if (p_bench == NULL)
+    {
+        return;
+    }
+
+    free(p_bench->p_etb_ns);
+    free(p_bench->p_latency_ns);
+    free(p_bench->ports[BENCH_PORT_IN].p_hold_ns);
+    free(p_bench->ports[BENCH_PORT_OUT].p_hold_ns);
+
+    p_bench->p_etb_ns     = NULL;
+    p_bench->p_latency_ns = NULL;
+
+    p_bench->ports[BENCH_PORT_IN].p_hold_ns  = NULL;
+    p_bench->ports[BENCH_PORT_OUT].p_hold_ns = NULL;
+
+    pthread_mutex_destroy(&p_bench->mutex);
+}
+
+void bench_on_empty_this_buffer(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t now_ns = 0;
+
+    if (p_bench == NULL)
+    {
+        return;
+    }
+
+    now_ns = omx_get_time_ns();
+
+    pthread_mutex_lock(&p_bench->mutex);
+
+    if (p_bench->etb_count == 0)
+    {
+        p_bench->first_ns = now_ns;
+    }
+
+    /* The MC copies this index to the output buffer of the frame */
+    p_buf->nTimeStamp = (OMX_TICKS)p_bench->etb_count;
+
+    if (p_bench->etb_count < p_bench->capacity)
+    {
+        p_bench->p_etb_ns[p_bench->etb_count] = now_ns;
+    }
+
+    p_bench->etb_count++;
+    p_bench->ports[BENCH_PORT_IN].bytes += p_buf->nFilledLen;
+
+    bench_send(&p_bench->ports[BENCH_PORT_IN], p_buf, now_ns);
+
+    pthread_mutex_unlock(&p_bench->mutex);
+}
+
+void bench_on_empty_buffer_done(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t now_ns = 0;
+
+    if (p_bench == NULL)
+    {
+        return;
+    }
+
+    now_ns = omx_get_time_ns();
+
+    pthread_mutex_lock(&p_bench->mutex);
+
+    bench_return(p_bench, &p_bench->ports[BENCH_PORT_IN], p_buf, now_ns);
+
+    pthread_mutex_unlock(&p_bench->mutex);
+}
+
+void bench_on_fill_this_buffer(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t now_ns = 0;
+
+    if (p_bench == NULL)
+    {
+        return;
+    }
+
+    now_ns = omx_get_time_ns();
+
+    pthread_mutex_lock(&p_bench->mutex);
+
+    bench_send(&p_bench->ports[BENCH_PORT_OUT], p_buf, now_ns);
+
+    pthread_mutex_unlock(&p_bench->mutex);
+}
+
+void bench_on_fill_buffer_done(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t now_ns  = 0;
+    uint64_t index   = 0;
+    uint64_t latency = 0;
+    uint32_t bucket  = 0;
+
+    bool is_frame = false;
+
+    if (p_bench == NULL)
+    {
+        return;
+    }
+
+    now_ns = omx_get_time_ns();
+
+    pthread_mutex_lock(&p_bench->mutex);
+
+    bench_return(p_bench, &p_bench->ports[BENCH_PORT_OUT], p_buf, now_ns);
+
+    p_bench->ports[BENCH_PORT_OUT].bytes += p_buf->nFilledLen;
+
+    if (p_bench->frame_end_flag)
+    {
+        is_frame = (p_buf->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) &&
+                   (p_buf->nFilledLen > 0);
+    }
+    else
+    {
+        is_frame = (p_buf->nFilledLen > 0);
+    }
+
+    if (is_frame)
+    {
+        p_bench->frame_count++;
+        p_bench->last_ns = now_ns;
+
+        /* Find when the input of this frame was sent */
+        index = (uint64_t)p_buf->nTimeStamp;
+
+        if ((index < p_bench->etb_count) && (index < p_bench->capacity))
+        {
+            latency = now_ns - p_bench->p_etb_ns[index];
+
+            bench_add_sample(p_bench, p_bench->p_latency_ns,
+                             &p_bench->latency_count, latency);
+
+            /* Bucket 'i' holds latencies in [2^i, 2^(i+1)) us */
+            for (latency /= 1000; (latency > 1) &&
+                 (bucket < (BENCH_HISTOGRAM_BUCKETS - 1)); latency >>= 1)
+            {
+                bucket++;
+            }
+
+            p_bench->histogram[bucket]++;
+        }
+    }
+
+    pthread_mutex_unlock(&p_bench->mutex);
+}
+
+bool bench_write_report(bench_t * p_bench, const char * p_file_name)
+{
+    FILE * p_file = NULL;
+
+    bench_port_t * p_in  = NULL;
+    bench_port_t * p_out = NULL;
+
+    uint64_t duration_ns = 0;
+    double seconds = 0;
+
+    /* CPU time (in ns) used since 'bench_init' and resource usage (for the
+     * peak resident memory) of the process */
+    struct rusage usage;
+    uint64_t cpu_ns = bench_get_cpu_ns() - p_bench->cpu_start_ns;
+
+    uint32_t index = 0;
+    bool is_first  = true;
+
+    /* Check parameters */
+    assert((p_bench != NULL) && (p_file_name != NULL));
+
+    if (strcmp(p_file_name, "-") == 0)
+    {
+        p_file = stdout;
+    }
+    else
+    {
+        p_file = fopen(p_file_name, "w");
+        if (p_file == NULL)
+        {
+            printf("Error: Failed to open file '%s'\n", p_file_name);
+            return false;
+        }
+    }
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        usage.ru_maxrss = 0;
+    }
+
+    pthread_mutex_lock(&p_bench->mutex);
+
+    p_in  = &p_bench->ports[BENCH_PORT_IN];
+    p_out = &p_bench->ports[BENCH_PORT_OUT];
+
+    if (p_bench->last_ns > p_bench->first_ns)
+    {
+        duration_ns = p_bench->last_ns - p_bench->first_ns;
+        seconds     = duration_ns / 1e9;
+    }
+
+    /* Sort samples to get percentiles */
+    qsort(p_bench->p_latency_ns, p_bench->latency_count,
+          sizeof(uint64_t), bench_compare);
+    qsort(p_in->p_hold_ns, p_in->sample_count,
+          sizeof(uint64_t), bench_compare);
+    qsort(p_out->p_hold_ns, p_out->sample_count,
+          sizeof(uint64_t), bench_compare);
+
+    fprintf(p_file, "{\n");
+    fprintf(p_file, "  \"app\": \"%s\",\n", p_bench->p_app_name);
+    fprintf(p_file, "  \"frames\": %llu,\n",
+            (unsigned long long)p_bench->frame_count);
+    fprintf(p_file, "  \"duration_ms\": %.3f,\n", duration_ns / 1e6);
+    fprintf(p_file, "  \"fps\": %.2f,\n",
+            (seconds > 0) ? (p_bench->frame_count / seconds) : 0.0);
+    fprintf(p_file, "  \"in_mb_per_s\": %.3f,\n",
+            (seconds > 0) ? (p_in->bytes / seconds / 1e6) : 0.0);
+    fprintf(p_file, "  \"out_mb_per_s\": %.3f,\n",
+            (seconds > 0) ? (p_out->bytes / seconds / 1e6) : 0.0);
+    fprintf(p_file, "  \"cpu_ms_per_frame\": %.4f,\n",
+            (p_bench->frame_count > 0) ?
+            (cpu_ns / 1e6 / p_bench->frame_count) : 0.0);
+    fprintf(p_file, "  \"peak_rss_kb\": %ld,\n", usage.ru_maxrss);
+
+    bench_write_percentiles(p_file, "latency_ms",
+                            p_bench->p_latency_ns, p_bench->latency_count);
+
+    /* Only non-empty buckets are written */
+    fprintf(p_file, "  \"latency_histogram_us\": [");
+
+    for (index = 0; index < BENCH_HISTOGRAM_BUCKETS; index++)
+    {
+        if (p_bench->histogram[index] == 0)
+        {
+            continue;
+        }
+
+        fprintf(p_file, "%s\n    {\"ge\": %llu, \"lt\": %llu, \"count\": %llu}",
+                is_first ? "" : ",",
+                (index == 0) ? 0ULL : (1ULL << index), 1ULL << (index + 1),
+                (unsigned long long)p_bench->histogram[index]);
+
+        is_first = false;
+    }
+
+    fprintf(p_file, "%s],\n", is_first ? "" : "\n  ");
+
+    bench_write_percentiles(p_file, "in_buffer_ms",
+                            p_in->p_hold_ns, p_in->sample_count);
+    bench_write_percentiles(p_file, "out_buffer_ms",
+                            p_out->p_hold_ns, p_out->sample_count);
+
+    fprintf(p_file, "  \"occupancy\": {\n");
+    bench_write_port(p_file, "in", p_in, duration_ns);
+    fprintf(p_file, ",\n");
+    bench_write_port(p_file, "out", p_out, duration_ns);
+    fprintf(p_file, "\n  },\n");
+
+    fprintf(p_file, "  \"dropped_samples\": %llu\n",
+            (unsigned long long)p_bench->dropped);
+    fprintf(p_file, "}\n");
+
+    pthread_mutex_unlock(&p_bench->mutex);
+
+    if (p_file != stdout)
+    {
+        fclose(p_file);
+    }
+
+    return true;
+}
+
+void bench_get_summary(bench_t * p_bench, double * p_fps, double * p_p99_ms)
+{
+    double seconds = 0;
+
+    /* Check parameters */
+    assert((p_bench != NULL) && (p_fps != NULL) && (p_p99_ms != NULL));
+
+    pthread_mutex_lock(&p_bench->mutex);
+
+    if (p_bench->last_ns > p_bench->first_ns)
+    {
+        seconds = (p_bench->last_ns - p_bench->first_ns) / 1e9;
+    }
+
+    *p_fps = (seconds > 0) ? (p_bench->frame_count / seconds) : 0.0;
+
+    qsort(p_bench->p_latency_ns, p_bench->latency_count,
+          sizeof(uint64_t), bench_compare);
+
+    *p_p99_ms = bench_percentile(p_bench->p_latency_ns,
+                                 p_bench->latency_count, 99.0) / 1e6;
+
+    pthread_mutex_unlock(&p_bench->mutex);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static void bench_update_held(bench_port_t * p_port, uint64_t now_ns, int delta)
+{
+    if (p_port->held_last_ns != 0)
+    {
+        p_port->held_area += p_port->held * (now_ns - p_port->held_last_ns);
+    }
+
+    p_port->held_last_ns = now_ns;
+    p_port->held        += delta;
+
+    if (p_port->held > p_port->held_max)
+    {
+        p_port->held_max = p_port->held;
+    }
+}
+
+static void bench_send(bench_port_t * p_port, OMX_BUFFERHEADERTYPE * p_buf,
+                       uint64_t now_ns)
+{
+    uint32_t index = 0;
+
+    for (index = 0; index < BENCH_MAX_BUFFERS; index++)
+    {
+        if (p_port->pending[index].p_buf == NULL)
+        {
+            p_port->pending[index].p_buf   = p_buf;
+            p_port->pending[index].sent_ns = now_ns;
+
+            bench_update_held(p_port, now_ns, 1);
+            break;
+        }
+    }
+}
+
+static void bench_return(bench_t * p_bench, bench_port_t * p_port,
+                         OMX_BUFFERHEADERTYPE * p_buf, uint64_t now_ns)
+{
+    uint32_t index = 0;
+
+    for (index = 0; index < BENCH_MAX_BUFFERS; index++)
+    {
+        if (p_port->pending[index].p_buf == p_buf)
+        {
+            bench_add_sample(p_bench, p_port->p_hold_ns, &p_port->sample_count,
+                             now_ns - p_port->pending[index].sent_ns);
+
+            p_port->pending[index].p_buf = NULL;
+
+            bench_update_held(p_port, now_ns, -1);
+            break;
+        }
+    }
+
+    p_port->buf_count++;
+}
+
+static void bench_add_sample(bench_t * p_bench, uint64_t * p_samples,
+                             uint32_t * p_count, uint64_t value)
+{
+    if (*p_count >= p_bench->capacity)
+    {
+        p_bench->dropped++;
+        return;
+    }
+
+    p_samples[*p_count] = value;
+    (*p_count)++;
+}
+
+static uint64_t bench_get_cpu_ns(void)
+{
+    struct timespec time;
+
+    if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+    {
+        return 0;
+    }
+
+    return ((uint64_t)time.tv_sec * 1000000000ULL) + (uint64_t)time.tv_nsec;
+}
+
+static int bench_compare(const void * p_a, const void * p_b)
+{
+    uint64_t a = *(const uint64_t *)p_a;
+    uint64_t b = *(const uint64_t *)p_b;
+
+    return (a > b) - (a < b);
+}
+
+static uint64_t bench_percentile(const uint64_t * p_samples, uint32_t count,
+                                 double percent)
+{
+    /* Nearest-rank percentile */
+    uint32_t rank = (uint32_t)((percent / 100.0) * count + 0.999999);
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    return p_samples[(rank > 0) ? (rank - 1) : 0];
+}
+
+static void bench_write_percentiles(FILE * p_file, const char * p_name,
+                                    uint64_t * p_samples, uint32_t count)
+{
+    const double percents[] = { 50.0, 95.0, 99.0 };
+
+    uint32_t index = 0;
+
+    fprintf(p_file, "  \"%s\": {", p_name);
+
+    for (index = 0; index < (sizeof(percents) / sizeof(percents[0])); index++)
+    {
+        fprintf(p_file, "\"p%.0f\": %.3f, ", percents[index],
+                bench_percentile(p_samples, count, percents[index]) / 1e6);
+    }
+
+    fprintf(p_file, "\"max\": %.3f, \"samples\": %u},\n",
+            (count > 0) ? (p_samples[count - 1] / 1e6) : 0.0, count);
+}
+
+static void bench_write_port(FILE * p_file, const char * p_name,
+                             bench_port_t * p_port, uint64_t duration_ns)
+{
+    fprintf(p_file, "    \"%s\": {\"buffers\": %llu, \"bytes\": %llu, "
+            "\"held_avg\": %.2f, \"held_max\": %u}",
+            p_name, (unsigned long long)p_port->buf_count,
+            (unsigned long long)p_port->bytes,
+            (duration_ns > 0) ? ((double)p_port->held_area / duration_ns) : 0.0,
+            p_port->held_max);
+}
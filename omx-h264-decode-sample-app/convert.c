@@ -0,0 +1,664 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: convert.c
+ *
+ * DESCRIPTION:
+ *   Colour format converter definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'convert.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "omx.h"
+#include "convert.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Convert a pixel to RGB (ITU-R BT.601, limited range) */
+static inline void convert_pixel_rgb(uint8_t * p_rgb, int32_t y, int32_t u,
+                                     int32_t v);
+
+/* Split a row of interleaved U and V samples ('count' pairs) */
+static void convert_row_i420(uint8_t * p_u, uint8_t * p_v,
+                             const uint8_t * p_uv, uint32_t count);
+
+/* Convert a row of 'width' pixels (rounded up to even) to YUY2 */
+static void convert_row_yuy2(uint8_t * p_dst, const uint8_t * p_y,
+                             const uint8_t * p_uv, uint32_t width);
+
+/* Convert a row of 'width' pixels to RGB24 */
+static void convert_row_rgb(uint8_t * p_dst, const uint8_t * p_y,
+                            const uint8_t * p_uv, uint32_t width);
+
+/* Convert stripe 'index' of the current frame */
+static void convert_stripe(convert_t * p_convert, uint32_t index);
+
+/* Thread function of workers */
+static void * convert_worker_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool convert_fmt_from_str(const char * p_str, convert_fmt_t * p_fmt)
+{
+    /* Check parameters */
+    assert((p_str != NULL) && (p_fmt != NULL));
+
+    if (strcmp(p_str, "nv12") == 0)
+    {
+        *p_fmt = CONVERT_FMT_NV12;
+    }
+    else if (strcmp(p_str, "i420") == 0)
+    {
+        *p_fmt = CONVERT_FMT_I420;
+    }
+    else if (strcmp(p_str, "yuy2") == 0)
+    {
+        *p_fmt = CONVERT_FMT_YUY2;
+    }
+    else if (strcmp(p_str, "rgb") == 0)
+    {
+        *p_fmt = CONVERT_FMT_RGB24;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+const char * convert_fmt_to_str(convert_fmt_t fmt)
+{
+    switch (fmt)
+    {
+        case CONVERT_FMT_NV12:
+        {
+            return "nv12";
+        }
+
+        case CONVERT_FMT_I420:
+        {
+            return "i420";
+        }
+
+        case CONVERT_FMT_YUY2:
+        {
+            return "yuy2";
+        }
+
+        case CONVERT_FMT_RGB24:
+        {
+            return "rgb";
+        }
+
+        default:
+        {
+            return "unknown";
+        }
+    }
+}
+
+bool convert_init(convert_t * p_convert, convert_fmt_t fmt,
+                  uint32_t thread_count)
+{
+    uint32_t index = 0;
+    convert_worker_t * p_worker = NULL;
+
+    /* Check parameters */
+    assert(p_convert != NULL);
+    assert((thread_count > 0) && (thread_count <= CONVERT_MAX_THREADS));
+
+    memset(p_convert, 0, sizeof(convert_t));
+
+    p_convert->fmt          = fmt;
+    p_convert->thread_count = 1;
+
+    atomic_init(&p_convert->stop, false);
+    sem_init(&p_convert->smp_done, 0, 0);
+
+    /* The calling thread converts stripe 0 */
+    for (index = 1; index < thread_count; index++)
+    {
+        p_worker = &p_convert->workers[index];
+
+        p_worker->p_convert = p_convert;
+        p_worker->index     = index;
+
+        sem_init(&p_worker->smp_start, 0, 0);
+
+        if (pthread_create(&p_worker->thread, NULL,
+                           convert_worker_thread, p_worker) != 0)
+        {
+            printf("Error: Failed to create worker '%d' of converter\n", index);
+
+            sem_destroy(&p_worker->smp_start);
+            convert_deinit(p_convert);
+            return false;
+        }
+
+        p_convert->thread_count++;
+    }
+
+    return true;
+}
+
+void convert_set_layout(convert_t * p_convert,
+                        uint32_t width, uint32_t height,
+                        uint32_t stride, uint32_t slice_height)
+{
+    /* Check parameters. Rows of UV plane (and YUY2 rows) are read up to
+     * 'width' rounded up to even */
+    assert(p_convert != NULL);
+    assert((width > 0) && (ROUND_UP(width, 2) <= stride));
+    assert(height <= slice_height);
+
+    p_convert->width        = width;
+    p_convert->height       = height;
+    p_convert->stride       = stride;
+    p_convert->slice_height = slice_height;
+}
+
+size_t convert_get_frame_size(convert_t * p_convert)
+{
+    size_t luma_size = 0;
+    size_t chroma_width = 0;
+    size_t chroma_height = 0;
+
+    /* Check parameter */
+    assert(p_convert != NULL);
+
+    luma_size     = (size_t)p_convert->width * p_convert->height;
+    chroma_width  = (p_convert->width + 1) / 2;
+    chroma_height = (p_convert->height + 1) / 2;
+
+    switch (p_convert->fmt)
+    {
+        case CONVERT_FMT_I420:
+        {
+            return luma_size + (2 * chroma_width * chroma_height);
+        }
+
+        case CONVERT_FMT_YUY2:
+        {
+            return 4 * chroma_width * p_convert->height;
+        }
+
+        case CONVERT_FMT_RGB24:
+        {
+            return 3 * luma_size;
+        }
+
+        case CONVERT_FMT_NV12:
+        default:
+        {
+            return luma_size + (2 * chroma_width * chroma_height);
+        }
+    }
+}
+
+void convert_frame(convert_t * p_convert,
+                   const uint8_t * p_src, uint8_t * p_dst)
+{
+    uint32_t index = 0;
+
+    uint64_t start_ns = 0;
+    uint64_t convert_ns = 0;
+
+    /* Check parameters */
+    assert((p_convert != NULL) && (p_src != NULL) && (p_dst != NULL));
+    assert(p_convert->width > 0);
+
+    start_ns = omx_get_time_ns();
+
+    p_convert->p_src = p_src;
+    p_convert->p_dst = p_dst;
+
+    for (index = 1; index < p_convert->thread_count; index++)
+    {
+        sem_post(&p_convert->workers[index].smp_start);
+    }
+
+    convert_stripe(p_convert, 0);
+
+    /* Wait for the other stripes */
+    for (index = 1; index < p_convert->thread_count; index++)
+    {
+        sem_wait(&p_convert->smp_done);
+    }
+
+    convert_ns = omx_get_time_ns() - start_ns;
+
+    p_convert->frame_count++;
+    p_convert->convert_ns += convert_ns;
+    if (convert_ns > p_convert->convert_ns_max)
+    {
+        p_convert->convert_ns_max = convert_ns;
+    }
+}
+
+void convert_deinit(convert_t * p_convert)
+{
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_convert != NULL);
+
+    atomic_store(&p_convert->stop, true);
+
+    for (index = 1; index < p_convert->thread_count; index++)
+    {
+        sem_post(&p_convert->workers[index].smp_start);
+        pthread_join(p_convert->workers[index].thread, NULL);
+
+        sem_destroy(&p_convert->workers[index].smp_start);
+    }
+
+    sem_destroy(&p_convert->smp_done);
+}
+
+void convert_print_stats(convert_t * p_convert)
+{
+    /* Check parameter */
+    assert(p_convert != NULL);
+
+    printf("Converter: %llu frames to %s (%u threads), convert time %.3f ms / "
+           "max %.3f ms\n",
+           (unsigned long long)p_convert->frame_count,
+           convert_fmt_to_str(p_convert->fmt), p_convert->thread_count,
+           p_convert->convert_ns / 1e6, p_convert->convert_ns_max / 1e6);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static inline void convert_pixel_rgb(uint8_t * p_rgb, int32_t y, int32_t u,
+                                     int32_t v)
+{
+    int32_t c = 298 * (y - 16);
+    int32_t d = u - 128;
+    int32_t e = v - 128;
+
+    int32_t r = (c + (409 * e) + 128) >> 8;
+    int32_t g = (c - (100 * d) - (208 * e) + 128) >> 8;
+    int32_t b = (c + (516 * d) + 128) >> 8;
+
+    p_rgb[0] = (uint8_t)((r < 0) ? 0 : ((r > 255) ? 255 : r));
+    p_rgb[1] = (uint8_t)((g < 0) ? 0 : ((g > 255) ? 255 : g));
+    p_rgb[2] = (uint8_t)((b < 0) ? 0 : ((b > 255) ? 255 : b));
+}
+
+#if defined(__SSE2__)
+/* Compute ('a' * ka + 'b' * kb + 'c' * kc + 'd' * kd) >> 8 for 8 pixels
+ * (16-bit lanes), where 'k_ab' holds (ka, kb) and 'k_cd' holds (kc, kd) */
+static inline __m128i convert_sse2_dot(__m128i a, __m128i b, __m128i k_ab,
+                                       __m128i c, __m128i d, __m128i k_cd)
+{
+    __m128i lo = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), k_ab),
+                               _mm_madd_epi16(_mm_unpacklo_epi16(c, d), k_cd));
+    __m128i hi = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), k_ab),
+                               _mm_madd_epi16(_mm_unpackhi_epi16(c, d), k_cd));
+
+    return _mm_packs_epi32(_mm_srai_epi32(lo, 8), _mm_srai_epi32(hi, 8));
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+/* Compute (298 * 'y' + 'c0' * k0 + 'c1' * k1 + 128) >> 8 for 8 pixels and
+ * saturate the result to 8 bits */
+static inline uint8x8_t convert_neon_dot(int16x8_t y, int16x8_t c0, int16_t k0,
+                                         int16x8_t c1, int16_t k1)
+{
+    int32x4_t lo = vmull_n_s16(vget_low_s16(y), 298);
+    int32x4_t hi = vmull_high_n_s16(y, 298);
+
+    lo = vmlal_n_s16(lo, vget_low_s16(c0), k0);
+    hi = vmlal_high_n_s16(hi, c0, k0);
+
+    lo = vmlal_n_s16(lo, vget_low_s16(c1), k1);
+    hi = vmlal_high_n_s16(hi, c1, k1);
+
+    return vqmovun_s16(vcombine_s16(vrshrn_n_s32(lo, 8), vrshrn_n_s32(hi, 8)));
+}
+#endif
+
+static void convert_row_i420(uint8_t * p_u, uint8_t * p_v,
+                             const uint8_t * p_uv, uint32_t count)
+{
+    uint32_t index = 0;
+
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+
+    __m128i uv0;
+    __m128i uv1;
+
+    for (; (index + 16) <= count; index += 16)
+    {
+        uv0 = _mm_loadu_si128((const __m128i *)(p_uv + (2 * index)));
+        uv1 = _mm_loadu_si128((const __m128i *)(p_uv + (2 * index) + 16));
+
+        _mm_storeu_si128((__m128i *)(p_u + index),
+                         _mm_packus_epi16(_mm_and_si128(uv0, mask),
+                                          _mm_and_si128(uv1, mask)));
+
+        _mm_storeu_si128((__m128i *)(p_v + index),
+                         _mm_packus_epi16(_mm_srli_epi16(uv0, 8),
+                                          _mm_srli_epi16(uv1, 8)));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16x2_t uv;
+
+    for (; (index + 16) <= count; index += 16)
+    {
+        uv = vld2q_u8(p_uv + (2 * index));
+
+        vst1q_u8(p_u + index, uv.val[0]);
+        vst1q_u8(p_v + index, uv.val[1]);
+    }
+#endif
+
+    /* The last samples (or the whole row without SIMD) */
+    for (; index < count; index++)
+    {
+        p_u[index] = p_uv[2 * index];
+        p_v[index] = p_uv[(2 * index) + 1];
+    }
+}
+
+static void convert_row_yuy2(uint8_t * p_dst, const uint8_t * p_y,
+                             const uint8_t * p_uv, uint32_t width)
+{
+    uint32_t index = 0;
+
+    /* Each pair of pixels takes 'Y0 U Y1 V', that is Y and UV samples
+     * interleaved byte by byte */
+    width = ROUND_UP(width, 2);
+
+#if defined(__SSE2__)
+    __m128i y;
+    __m128i uv;
+
+    for (; (index + 16) <= width; index += 16)
+    {
+        y  = _mm_loadu_si128((const __m128i *)(p_y + index));
+        uv = _mm_loadu_si128((const __m128i *)(p_uv + index));
+
+        _mm_storeu_si128((__m128i *)(p_dst + (2 * index)),
+                         _mm_unpacklo_epi8(y, uv));
+        _mm_storeu_si128((__m128i *)(p_dst + (2 * index) + 16),
+                         _mm_unpackhi_epi8(y, uv));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16x2_t y_uv;
+
+    for (; (index + 16) <= width; index += 16)
+    {
+        y_uv.val[0] = vld1q_u8(p_y + index);
+        y_uv.val[1] = vld1q_u8(p_uv + index);
+
+        vst2q_u8(p_dst + (2 * index), y_uv);
+    }
+#endif
+
+    /* The last pixels (or the whole row without SIMD) */
+    for (; index < width; index++)
+    {
+        p_dst[2 * index]       = p_y[index];
+        p_dst[(2 * index) + 1] = p_uv[index];
+    }
+}
+
+static void convert_row_rgb(uint8_t * p_dst, const uint8_t * p_y,
+                            const uint8_t * p_uv, uint32_t width)
+{
+    uint32_t index = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero    = _mm_setzero_si128();
+    const __m128i one     = _mm_set1_epi16(1);
+    const __m128i mask    = _mm_set1_epi16(0x00FF);
+    const __m128i y_bias  = _mm_set1_epi16(16);
+    const __m128i uv_bias = _mm_set1_epi16(128);
+
+    /* Coefficients (low, high) of each pair of 16-bit lanes */
+    const __m128i k_yv   = _mm_set_epi16(409, 298, 409, 298, 409, 298, 409, 298);
+    const __m128i k_yu_g = _mm_set_epi16(-100, 298, -100, 298,
+                                         -100, 298, -100, 298);
+    const __m128i k_yu_b = _mm_set_epi16(516, 298, 516, 298, 516, 298, 516, 298);
+    const __m128i k_v1_g = _mm_set_epi16(128, -208, 128, -208,
+                                         128, -208, 128, -208);
+    const __m128i k_1    = _mm_set_epi16(0, 128, 0, 128, 0, 128, 0, 128);
+
+    __m128i y8;
+    __m128i uv;
+    __m128i y[2];
+    __m128i u[2];
+    __m128i v[2];
+    __m128i r[2];
+    __m128i g[2];
+    __m128i b[2];
+
+    uint8_t rgb[3][16] __attribute__((aligned(16)));
+    uint32_t half = 0;
+    uint32_t pixel = 0;
+
+    for (; (index + 16) <= width; index += 16)
+    {
+        y8 = _mm_loadu_si128((const __m128i *)(p_y + index));
+        uv = _mm_loadu_si128((const __m128i *)(p_uv + index));
+
+        y[0] = _mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), y_bias);
+        y[1] = _mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), y_bias);
+
+        /* 8 U and 8 V samples, each of them for 2 pixels */
+        u[0] = _mm_sub_epi16(_mm_and_si128(uv, mask), uv_bias);
+        v[0] = _mm_sub_epi16(_mm_srli_epi16(uv, 8), uv_bias);
+
+        u[1] = _mm_unpackhi_epi16(u[0], u[0]);
+        u[0] = _mm_unpacklo_epi16(u[0], u[0]);
+        v[1] = _mm_unpackhi_epi16(v[0], v[0]);
+        v[0] = _mm_unpacklo_epi16(v[0], v[0]);
+
+        for (half = 0; half < 2; half++)
+        {
+            r[half] = convert_sse2_dot(y[half], v[half], k_yv,
+                                       one, zero, k_1);
+            g[half] = convert_sse2_dot(y[half], u[half], k_yu_g,
+                                       v[half], one, k_v1_g);
+            b[half] = convert_sse2_dot(y[half], u[half], k_yu_b,
+                                       one, zero, k_1);
+        }
+
+        _mm_store_si128((__m128i *)rgb[0], _mm_packus_epi16(r[0], r[1]));
+        _mm_store_si128((__m128i *)rgb[1], _mm_packus_epi16(g[0], g[1]));
+        _mm_store_si128((__m128i *)rgb[2], _mm_packus_epi16(b[0], b[1]));
+
+        /* SSE2 has no byte shuffle, so the planes are interleaved here */
+        for (pixel = 0; pixel < 16; pixel++)
+        {
+            p_dst[(3 * (index + pixel))]     = rgb[0][pixel];
+            p_dst[(3 * (index + pixel)) + 1] = rgb[1][pixel];
+            p_dst[(3 * (index + pixel)) + 2] = rgb[2][pixel];
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const int16x8_t y_bias  = vdupq_n_s16(16);
+    const int16x8_t uv_bias = vdupq_n_s16(128);
+    const int16x8_t zero    = vdupq_n_s16(0);
+
+    uint8x16_t y8;
+    uint8x8x2_t uv;
+    int16x8_t y[2];
+    int16x8_t u;
+    int16x8_t v;
+    int16x8_t u2[2];
+    int16x8_t v2[2];
+    uint8x16x3_t rgb;
+
+    for (; (index + 16) <= width; index += 16)
+    {
+        y8 = vld1q_u8(p_y + index);
+        uv = vld2_u8(p_uv + index);
+
+        y[0] = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y8))),
+                         y_bias);
+        y[1] = vsubq_s16(vreinterpretq_s16_u16(vmovl_high_u8(y8)), y_bias);
+
+        /* 8 U and 8 V samples, each of them for 2 pixels */
+        u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[0])), uv_bias);
+        v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(uv.val[1])), uv_bias);
+
+        u2[0] = vzip1q_s16(u, u);
+        u2[1] = vzip2q_s16(u, u);
+        v2[0] = vzip1q_s16(v, v);
+        v2[1] = vzip2q_s16(v, v);
+
+        rgb.val[0] = vcombine_u8(convert_neon_dot(y[0], v2[0], 409, zero, 0),
+                                 convert_neon_dot(y[1], v2[1], 409, zero, 0));
+        rgb.val[1] = vcombine_u8(
+                         convert_neon_dot(y[0], u2[0], -100, v2[0], -208),
+                         convert_neon_dot(y[1], u2[1], -100, v2[1], -208));
+        rgb.val[2] = vcombine_u8(convert_neon_dot(y[0], u2[0], 516, zero, 0),
+                                 convert_neon_dot(y[1], u2[1], 516, zero, 0));
+
+        vst3q_u8(p_dst + (3 * index), rgb);
+    }
+#endif
+
+    /* The last pixels (or the whole row without SIMD) */
+    for (; index < width; index++)
+    {
+        convert_pixel_rgb(p_dst + (3 * index), p_y[index],
+                          p_uv[index & ~1u], p_uv[(index & ~1u) + 1]);
+    }
+}
+
+static void convert_stripe(convert_t * p_convert, uint32_t index)
+{
+    const uint8_t * p_src_y  = p_convert->p_src;
+    const uint8_t * p_src_uv = p_convert->p_src +
+                               ((size_t)p_convert->stride *
+                                p_convert->slice_height);
+
+    uint32_t width  = p_convert->width;
+    uint32_t height = p_convert->height;
+    uint32_t stride = p_convert->stride;
+
+    uint32_t chroma_width  = (width + 1) / 2;
+    uint32_t chroma_height = (height + 1) / 2;
+
+    /* Stripes are made of pairs of rows, which share a row of UV plane */
+    uint32_t first = (index * chroma_height) / p_convert->thread_count;
+    uint32_t last  = ((index + 1) * chroma_height) / p_convert->thread_count;
+    uint32_t row_end = (2 * last < height) ? (2 * last) : height;
+
+    uint8_t * p_dst_y = p_convert->p_dst;
+    uint8_t * p_dst_u = NULL;
+    uint8_t * p_dst_v = NULL;
+
+    uint32_t row = 0;
+
+    switch (p_convert->fmt)
+    {
+        case CONVERT_FMT_I420:
+        {
+            p_dst_u = p_dst_y + ((size_t)width * height);
+            p_dst_v = p_dst_u + ((size_t)chroma_width * chroma_height);
+
+            for (row = 2 * first; row < row_end; row++)
+            {
+                memcpy(p_dst_y + ((size_t)row * width),
+                       p_src_y + ((size_t)row * stride), width);
+            }
+
+            for (row = first; row < last; row++)
+            {
+                convert_row_i420(p_dst_u + ((size_t)row * chroma_width),
+                                 p_dst_v + ((size_t)row * chroma_width),
+                                 p_src_uv + ((size_t)row * stride),
+                                 chroma_width);
+            }
+        }
+        break;
+
+        case CONVERT_FMT_YUY2:
+        {
+            for (row = 2 * first; row < row_end; row++)
+            {
+                convert_row_yuy2(p_dst_y + ((size_t)row * 4 * chroma_width),
+                                 p_src_y + ((size_t)row * stride),
+                                 p_src_uv + ((size_t)(row / 2) * stride),
+                                 width);
+            }
+        }
+        break;
+
+        case CONVERT_FMT_RGB24:
+        {
+            for (row = 2 * first; row < row_end; row++)
+            {
+                convert_row_rgb(p_dst_y + ((size_t)row * 3 * width),
+                                p_src_y + ((size_t)row * stride),
+                                p_src_uv + ((size_t)(row / 2) * stride),
+                                width);
+            }
+        }
+        break;
+
+        case CONVERT_FMT_NV12:
+        default:
+        {
+            /* Only drop the padding */
+            p_dst_u = p_dst_y + ((size_t)width * height);
+
+            for (row = 2 * first; row < row_end; row++)
+            {
+                memcpy(p_dst_y + ((size_t)row * width),
+                       p_src_y + ((size_t)row * stride), width);
+            }
+
+            for (row = first; row < last; row++)
+            {
+                memcpy(p_dst_u + ((size_t)row * 2 * chroma_width),
+                       p_src_uv + ((size_t)row * stride), 2 * chroma_width);
+            }
+        }
+        break;
+    }
+}
+
+static void * convert_worker_thread(void * p_param)
+{
+    convert_worker_t * p_worker = (convert_worker_t *)p_param;
+    convert_t * p_convert = p_worker->p_convert;
+
+    while (true)
+    {
+        sem_wait(&p_worker->smp_start);
+
+        if (atomic_load(&p_convert->stop))
+        {
+            break;
+        }
+
+        convert_stripe(p_convert, p_worker->index);
+
+        sem_post(&p_convert->smp_done);
+    }
+
+    return NULL;
+}
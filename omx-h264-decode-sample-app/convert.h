@@ -0,0 +1,161 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: convert.h
+ *
+ * DESCRIPTION:
+ *   Colour format converter for decoded NV12 frames.
+ *
+ *   'convert_frame' reads a decoded frame in the layout of output buffers
+ *   ('stride' and 'slice_height') and writes it as a tightly packed frame of
+ *   one of the following formats:
+ *     - I420:  Y plane, then U plane, then V plane.
+ *     - YUY2:  Y0 U0 Y1 V0 for each pair of pixels.
+ *     - RGB24: R G B for each pixel (ITU-R BT.601, limited range).
+ *
+ *   The rows of a frame are split in stripes. Each stripe is converted by a
+ *   thread of a pool (the calling thread converts the first one), with SSE2
+ *   (x86) or NEON (Arm) kernels when the compiler supports them.
+ *
+ * PUBLIC FUNCTIONS:
+ *   convert_fmt_from_str
+ *   convert_fmt_to_str
+ *
+ *   convert_init
+ *   convert_set_layout
+ *   convert_get_frame_size
+ *   convert_frame
+ *   convert_deinit
+ *
+ *   convert_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _CONVERT_H_
+#define _CONVERT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The maximum number of threads (including the calling thread) */
+#define CONVERT_MAX_THREADS 8
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef enum
+{
+    CONVERT_FMT_NV12 = 0, /* No conversion */
+    CONVERT_FMT_I420,
+    CONVERT_FMT_YUY2,
+    CONVERT_FMT_RGB24,
+
+} convert_fmt_t;
+
+/* Forward declaration */
+struct convert;
+
+typedef struct
+{
+    /* Converter which owns the worker */
+    struct convert * p_convert;
+
+    /* Index of the stripe converted by the worker */
+    uint32_t index;
+
+    /* Post this semaphore to let the worker convert its stripe */
+    sem_t smp_start;
+
+    /* Worker thread */
+    pthread_t thread;
+
+} convert_worker_t;
+
+typedef struct convert
+{
+    /* Output format */
+    convert_fmt_t fmt;
+
+    /* Visible size of the frame (in pixels) */
+    uint32_t width;
+    uint32_t height;
+
+    /* Layout of NV12 frames in output buffers */
+    uint32_t stride;
+    uint32_t slice_height;
+
+    /* Frame being converted */
+    const uint8_t * p_src;
+    uint8_t * p_dst;
+
+    /* The number of stripes (and threads) */
+    uint32_t thread_count;
+
+    /* Workers which convert stripes 1 to 'thread_count' - 1 */
+    convert_worker_t workers[CONVERT_MAX_THREADS];
+
+    /* Post this semaphore when a worker has converted its stripe */
+    sem_t smp_done;
+
+    /* True if the workers must exit */
+    atomic_bool stop;
+
+    /* The number of converted frames */
+    uint64_t frame_count;
+
+    /* Time (in ns) spent in 'convert_frame' */
+    uint64_t convert_ns;
+    uint64_t convert_ns_max;
+
+} convert_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Get the format whose name is 'p_str' ("nv12", "i420", "yuy2" or "rgb").
+ * Return true if successful. Otherwise, return false */
+bool convert_fmt_from_str(const char * p_str, convert_fmt_t * p_fmt);
+
+/* Get the name of 'fmt' */
+const char * convert_fmt_to_str(convert_fmt_t fmt);
+
+/* Initialize 'p_convert' for 'fmt' and start 'thread_count' - 1 workers.
+ * Return true if successful. Otherwise, return false */
+bool convert_init(convert_t * p_convert, convert_fmt_t fmt,
+                  uint32_t thread_count);
+
+/* Set the size of frames and their layout in output buffers.
+ *
+ * Note: Do not call it while 'convert_frame' is running */
+void convert_set_layout(convert_t * p_convert,
+                        uint32_t width, uint32_t height,
+                        uint32_t stride, uint32_t slice_height);
+
+/* Get the number of bytes of a converted frame */
+size_t convert_get_frame_size(convert_t * p_convert);
+
+/* Convert the NV12 frame at 'p_src' to 'p_dst'
+ * ('convert_get_frame_size' bytes) */
+void convert_frame(convert_t * p_convert,
+                   const uint8_t * p_src, uint8_t * p_dst);
+
+/* Stop the workers of 'p_convert' */
+void convert_deinit(convert_t * p_convert);
+
+/* Print statistics of 'p_convert' */
+void convert_print_stats(convert_t * p_convert);
+
+#endif /* _CONVERT_H_ */
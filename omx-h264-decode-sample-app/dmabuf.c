@@ -0,0 +1,255 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: dmabuf.c
+ *
+ * DESCRIPTION:
+ *   Allocator of shareable buffers definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'dmabuf.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+/* Needed for 'memfd_create' */
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <errno.h>
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <linux/udmabuf.h>
+
+#include "dmabuf.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Device which exports a memfd as a dma-buf */
+#define DMABUF_UDMABUF_DEV "/dev/udmabuf"
+
+/******************************************************************************
+ *                              FUNCTION MACROS                               *
+ ******************************************************************************/
+
+/* Round 'VAL' up to a multiple of 'RND' (a power of 2) */
+#define DMABUF_ROUND_UP(VAL, RND) (((VAL) + (RND) - 1) & (~((RND) - 1)))
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+#ifdef USE_MMNGR
+/* Allocate 'p_buf->size' bytes with MMNGR and export them as a dma-buf.
+ * Return true if successful. Otherwise, return false */
+static bool dmabuf_alloc_mmngr(dmabuf_t * p_buf);
+#endif
+
+/* Allocate 'p_buf->size' bytes in a sealed memfd and map them. Then, try to
+ * export the memfd as a dma-buf with '/dev/udmabuf'.
+ * Return true if successful. Otherwise, return false */
+static bool dmabuf_alloc_memfd(dmabuf_t * p_buf);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool dmabuf_alloc(dmabuf_t * p_buf, size_t size)
+{
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* Check parameters */
+    assert((p_buf != NULL) && (size > 0));
+
+    memset(p_buf, 0, sizeof(dmabuf_t));
+
+    p_buf->fd     = -1;
+    p_buf->mem_fd = -1;
+    p_buf->size   = DMABUF_ROUND_UP(size, page_size);
+
+#ifdef USE_MMNGR
+    if (dmabuf_alloc_mmngr(p_buf))
+    {
+        return true;
+    }
+#endif
+
+    return dmabuf_alloc_memfd(p_buf);
+}
+
+void dmabuf_free(dmabuf_t * p_buf)
+{
+    /* Check parameter */
+    assert(p_buf != NULL);
+
+#ifdef USE_MMNGR
+    if (p_buf->kind == DMABUF_KIND_MMNGR)
+    {
+        if (p_buf->fd >= 0)
+        {
+            mmngr_export_end_in_user_ext(p_buf->export_id);
+        }
+
+        if (p_buf->p_addr != NULL)
+        {
+            mmngr_free_in_user_ext(p_buf->mmngr_id);
+        }
+
+        memset(p_buf, 0, sizeof(dmabuf_t));
+
+        p_buf->fd     = -1;
+        p_buf->mem_fd = -1;
+        return;
+    }
+#endif
+
+    if (p_buf->p_addr != NULL)
+    {
+        munmap(p_buf->p_addr, p_buf->size);
+        p_buf->p_addr = NULL;
+    }
+
+    if ((p_buf->fd >= 0) && (p_buf->fd != p_buf->mem_fd))
+    {
+        close(p_buf->fd);
+    }
+
+    if (p_buf->mem_fd >= 0)
+    {
+        close(p_buf->mem_fd);
+    }
+
+    p_buf->fd     = -1;
+    p_buf->mem_fd = -1;
+}
+
+const char * dmabuf_kind_to_str(dmabuf_kind_t kind)
+{
+    switch (kind)
+    {
+        case DMABUF_KIND_MMNGR:
+        {
+            return "mmngr";
+        }
+
+        case DMABUF_KIND_UDMABUF:
+        {
+            return "udmabuf";
+        }
+
+        case DMABUF_KIND_MEMFD:
+        {
+            return "memfd";
+        }
+
+        default:
+        {
+            return "unknown";
+        }
+    }
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+#ifdef USE_MMNGR
+static bool dmabuf_alloc_mmngr(dmabuf_t * p_buf)
+{
+    unsigned int  phys_addr = 0;
+    unsigned int  hard_addr = 0;
+    unsigned long virt_addr = 0;
+
+    if (mmngr_alloc_in_user_ext(&p_buf->mmngr_id, p_buf->size, &phys_addr,
+                                &hard_addr, &virt_addr, MMNGR_VA_SUPPORT,
+                                NULL) != R_MM_OK)
+    {
+        printf("Warning: Failed to allocate %zu bytes with MMNGR\n",
+               p_buf->size);
+        return false;
+    }
+
+    p_buf->p_addr = (uint8_t *)virt_addr;
+    p_buf->kind   = DMABUF_KIND_MMNGR;
+
+    if (mmngr_export_start_in_user_ext(&p_buf->export_id, p_buf->size,
+                                       hard_addr, &p_buf->fd,
+                                       NULL) != R_MM_OK)
+    {
+        printf("Warning: Failed to export MMNGR buffer as dma-buf\n");
+
+        p_buf->fd = -1;
+        dmabuf_free(p_buf);
+        return false;
+    }
+
+    return true;
+}
+#endif
+
+static bool dmabuf_alloc_memfd(dmabuf_t * p_buf)
+{
+    struct udmabuf_create create;
+    int dev_fd = -1;
+
+    p_buf->kind   = DMABUF_KIND_MEMFD;
+    p_buf->mem_fd = memfd_create("decoder-out", MFD_ALLOW_SEALING);
+    if (p_buf->mem_fd < 0)
+    {
+        printf("Error: Failed to create memfd (errno %d)\n", errno);
+        return false;
+    }
+
+    /* '/dev/udmabuf' only exports memfds which cannot shrink */
+    if ((ftruncate(p_buf->mem_fd, (off_t)p_buf->size) != 0) ||
+        (fcntl(p_buf->mem_fd, F_ADD_SEALS, F_SEAL_SHRINK) != 0))
+    {
+        printf("Error: Failed to size memfd (errno %d)\n", errno);
+        dmabuf_free(p_buf);
+        return false;
+    }
+
+    p_buf->p_addr = (uint8_t *)mmap(NULL, p_buf->size, PROT_READ | PROT_WRITE,
+                                    MAP_SHARED, p_buf->mem_fd, 0);
+    if ((void *)p_buf->p_addr == MAP_FAILED)
+    {
+        printf("Error: Failed to map memfd (errno %d)\n", errno);
+
+        p_buf->p_addr = NULL;
+        dmabuf_free(p_buf);
+        return false;
+    }
+
+    dev_fd = open(DMABUF_UDMABUF_DEV, O_RDWR | O_CLOEXEC);
+    if (dev_fd >= 0)
+    {
+        memset(&create, 0, sizeof(create));
+
+        create.memfd  = (uint32_t)p_buf->mem_fd;
+        create.flags  = UDMABUF_FLAGS_CLOEXEC;
+        create.offset = 0;
+        create.size   = p_buf->size;
+
+        p_buf->fd = ioctl(dev_fd, UDMABUF_CREATE, &create);
+        close(dev_fd);
+    }
+
+    if (p_buf->fd >= 0)
+    {
+        p_buf->kind = DMABUF_KIND_UDMABUF;
+    }
+    else
+    {
+        /* No udmabuf support: hand the memfd itself */
+        p_buf->fd = p_buf->mem_fd;
+    }
+
+    return true;
+}
@@ -0,0 +1,99 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: dmabuf.h
+ *
+ * DESCRIPTION:
+ *   Allocator of buffers which can be shared with other processes and
+ *   devices through a file descriptor.
+ *
+ *   Each buffer is mapped in the application (its address is passed to
+ *   'OMX_UseBuffer') and exported as a file descriptor. The allocator tries,
+ *   in turn:
+ *     - DMABUF_KIND_MMNGR: physically contiguous memory of the Renesas
+ *       memory manager (MMNGR) exported as a dma-buf (only if the app is
+ *       built with 'USE_MMNGR', see 'Makefile').
+ *     - DMABUF_KIND_UDMABUF: a sealed memfd exported as a dma-buf by
+ *       '/dev/udmabuf', so that the same code path runs on a PC kernel.
+ *     - DMABUF_KIND_MEMFD: the memfd itself. Consumer processes can map it,
+ *       but devices cannot import it.
+ *
+ * PUBLIC FUNCTIONS:
+ *   dmabuf_alloc
+ *   dmabuf_free
+ *   dmabuf_kind_to_str
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _DMABUF_H_
+#define _DMABUF_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef USE_MMNGR
+#include <mmngr_user_public.h>
+#include <mmngr_buf_user_public.h>
+#endif
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef enum
+{
+    DMABUF_KIND_MMNGR = 0,
+    DMABUF_KIND_UDMABUF,
+    DMABUF_KIND_MEMFD
+
+} dmabuf_kind_t;
+
+typedef struct
+{
+    /* Address of the buffer in the application */
+    uint8_t * p_addr;
+
+    /* Size of the buffer (multiple of the page size) */
+    size_t size;
+
+    /* File descriptor handed to other processes: a dma-buf, or the memfd
+     * for 'DMABUF_KIND_MEMFD' */
+    int fd;
+
+    /* memfd which holds the memory (-1 for 'DMABUF_KIND_MMNGR') */
+    int mem_fd;
+
+    /* How the buffer was allocated and exported */
+    dmabuf_kind_t kind;
+
+#ifdef USE_MMNGR
+    /* IDs of the MMNGR allocation and of its export */
+    MMNGR_ID mmngr_id;
+    int export_id;
+#endif
+
+} dmabuf_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Allocate a buffer of at least 'size' bytes to 'p_buf' and export it (see
+ * the order of attempts above).
+ * Return true if successful. Otherwise, return false */
+bool dmabuf_alloc(dmabuf_t * p_buf, size_t size);
+
+/* Unmap 'p_buf' and close its file descriptors. Consumers which still hold
+ * a file descriptor of a memfd-based buffer keep its memory, but MMNGR memory
+ * is freed: they must release it first */
+void dmabuf_free(dmabuf_t * p_buf);
+
+/* Get the name of 'kind' ("mmngr", "udmabuf" or "memfd") */
+const char * dmabuf_kind_to_str(dmabuf_kind_t kind);
+
+#endif /* _DMABUF_H_ */
@@ -0,0 +1,613 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: exporter.c
+ *
+ * DESCRIPTION:
+ *   Exporter of output buffers definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'exporter.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+/* Needed for 'accept4' */
+#define _GNU_SOURCE
+
+#include <time.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+#include "exporter.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get current time (in ns) of the monotonic clock */
+static uint64_t exporter_now_ns(void);
+
+/* Accept a new consumer. It is refused if a consumer is already connected */
+static void exporter_accept(exporter_t * p_exp);
+
+/* Send the buffers of the current generation to the consumer */
+static void exporter_announce(exporter_t * p_exp);
+
+/* Send the frames of the buffers in 'buf_queue' to the consumer (or return
+ * the buffers if there is none) */
+static void exporter_send_frames(exporter_t * p_exp);
+
+/* Handle the messages received from the consumer */
+static void exporter_recv_releases(exporter_t * p_exp);
+
+/* Close the connection to the consumer and return the buffers it holds */
+static void exporter_drop_client(exporter_t * p_exp);
+
+/* Thread function */
+static void * exporter_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool exporter_open(exporter_t * p_exp, const char * p_path, uint32_t buf_count)
+{
+    /* Check parameters */
+    assert((p_exp != NULL) && (p_path != NULL) && (buf_count > 0));
+
+    memset(p_exp, 0, sizeof(exporter_t));
+
+    p_exp->listen_fd = -1;
+    p_exp->conn_fd   = -1;
+    p_exp->wake_fd   = -1;
+
+    if (strlen(p_path) >= sizeof(p_exp->addr.sun_path))
+    {
+        printf("Error: Socket path '%s' is too long\n", p_path);
+        return false;
+    }
+
+    p_exp->addr.sun_family = AF_UNIX;
+    strcpy(p_exp->addr.sun_path, p_path);
+
+    p_exp->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (p_exp->listen_fd < 0)
+    {
+        printf("Error: Failed to create socket (errno %d)\n", errno);
+        return false;
+    }
+
+    /* Remove the socket of a previous run */
+    unlink(p_path);
+
+    if ((bind(p_exp->listen_fd, (struct sockaddr *)&p_exp->addr,
+              sizeof(p_exp->addr)) != 0) ||
+        (listen(p_exp->listen_fd, 1) != 0))
+    {
+        printf("Error: Failed to listen on '%s' (errno %d)\n", p_path, errno);
+        exporter_close(p_exp);
+        return false;
+    }
+
+    p_exp->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (p_exp->wake_fd < 0)
+    {
+        printf("Error: Failed to create eventfd of exporter\n");
+        exporter_close(p_exp);
+        return false;
+    }
+
+    if (!queue_init(&p_exp->buf_queue, buf_count))
+    {
+        printf("Error: Failed to allocate queue of exporter\n");
+        exporter_close(p_exp);
+        return false;
+    }
+
+    pthread_mutex_init(&p_exp->mutex, NULL);
+    sem_init(&p_exp->smp_client, 0, 0);
+
+    atomic_init(&p_exp->stop, false);
+
+    return true;
+}
+
+void exporter_set_layout(exporter_t * p_exp, uint32_t width, uint32_t height,
+                         uint32_t stride, uint32_t slice_height)
+{
+    /* Check parameters */
+    assert(p_exp != NULL);
+    assert((width > 0) && (width <= stride) && (height <= slice_height));
+
+    pthread_mutex_lock(&p_exp->mutex);
+
+    p_exp->width        = width;
+    p_exp->height       = height;
+    p_exp->stride       = stride;
+    p_exp->slice_height = slice_height;
+
+    pthread_mutex_unlock(&p_exp->mutex);
+}
+
+void exporter_set_bufs(exporter_t * p_exp, OMX_BUFFERHEADERTYPE ** pp_bufs,
+                       const dmabuf_t * p_mems, uint32_t count)
+{
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert(p_exp != NULL);
+    assert((count == 0) || ((pp_bufs != NULL) && (p_mems != NULL)));
+    assert(count <= EXPORTER_MAX_BUFS);
+
+    pthread_mutex_lock(&p_exp->mutex);
+
+    for (index = 0; index < EXPORTER_MAX_BUFS; index++)
+    {
+        p_exp->p_bufs[index] = (index < count) ? pp_bufs[index] : NULL;
+    }
+
+    p_exp->p_mems    = p_mems;
+    p_exp->buf_count = count;
+
+    p_exp->generation++;
+    p_exp->announce = true;
+
+    pthread_mutex_unlock(&p_exp->mutex);
+
+    if (p_exp->wake_fd >= 0)
+    {
+        /* Let the thread send the new buffers to the consumer */
+        eventfd_write(p_exp->wake_fd, 1);
+    }
+}
+
+bool exporter_start(exporter_t * p_exp,
+                    exporter_release_fn release_fn, void * p_release_ctx)
+{
+    /* Check parameters */
+    assert((p_exp != NULL) && (release_fn != NULL));
+
+    p_exp->release_fn    = release_fn;
+    p_exp->p_release_ctx = p_release_ctx;
+
+    if (pthread_create(&p_exp->thread, NULL, exporter_thread, p_exp) != 0)
+    {
+        printf("Error: Failed to create thread of exporter\n");
+
+        p_exp->release_fn = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+bool exporter_wait_client(exporter_t * p_exp, uint32_t timeout_ms)
+{
+    struct timespec deadline;
+
+    /* Check parameter */
+    assert(p_exp != NULL);
+
+    /* 'sem_timedwait' takes an absolute time of the realtime clock */
+    clock_gettime(CLOCK_REALTIME, &deadline);
+
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec  += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    while (sem_timedwait(&p_exp->smp_client, &deadline) != 0)
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void exporter_push(exporter_t * p_exp, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    /* Check parameters */
+    assert((p_exp != NULL) && (p_buf != NULL));
+
+    /* The queue is never full because it can hold all output buffers */
+    assert(queue_push(&p_exp->buf_queue, p_buf));
+    eventfd_write(p_exp->wake_fd, 1);
+}
+
+void exporter_close(exporter_t * p_exp)
+{
+    /* Check parameter */
+    assert(p_exp != NULL);
+
+    if (p_exp->release_fn != NULL)
+    {
+        /* The thread sends pending frames and EXPORTMSG_END, then waits
+         * for the consumer */
+        atomic_store(&p_exp->stop, true);
+        eventfd_write(p_exp->wake_fd, 1);
+
+        pthread_join(p_exp->thread, NULL);
+
+        p_exp->release_fn = NULL;
+    }
+
+    if (p_exp->buf_queue.pp_items != NULL)
+    {
+        queue_deinit(&p_exp->buf_queue);
+
+        pthread_mutex_destroy(&p_exp->mutex);
+        sem_destroy(&p_exp->smp_client);
+    }
+
+    if (p_exp->wake_fd >= 0)
+    {
+        close(p_exp->wake_fd);
+        p_exp->wake_fd = -1;
+    }
+
+    if (p_exp->listen_fd >= 0)
+    {
+        close(p_exp->listen_fd);
+        unlink(p_exp->addr.sun_path);
+
+        p_exp->listen_fd = -1;
+    }
+}
+
+void exporter_print_stats(exporter_t * p_exp)
+{
+    exporter_stats_t * p_stats = NULL;
+
+    /* Check parameter */
+    assert(p_exp != NULL);
+
+    p_stats = &p_exp->stats;
+
+    printf("Exporter: %llu frames sent, %llu released by the consumer "
+           "(%u held at most), %llu returned without consumer\n",
+           (unsigned long long)p_stats->frame_count,
+           (unsigned long long)p_stats->release_count, p_stats->held_max,
+           (unsigned long long)p_stats->skip_count);
+
+    printf("Exporter: %u consumers connected, %u refused, "
+           "%u invalid releases\n", p_stats->client_count,
+           p_stats->refuse_count, p_stats->bad_release_count);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static uint64_t exporter_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void exporter_accept(exporter_t * p_exp)
+{
+    int conn_fd = accept4(p_exp->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+    if (conn_fd < 0)
+    {
+        return;
+    }
+
+    if (p_exp->conn_fd >= 0)
+    {
+        /* Frames go to a single consumer */
+        close(conn_fd);
+        p_exp->stats.refuse_count++;
+        return;
+    }
+
+    p_exp->conn_fd = conn_fd;
+    p_exp->stats.client_count++;
+
+    /* The new consumer needs all buffers before any frame */
+    pthread_mutex_lock(&p_exp->mutex);
+    p_exp->announce = true;
+    pthread_mutex_unlock(&p_exp->mutex);
+
+    exporter_announce(p_exp);
+
+    sem_post(&p_exp->smp_client);
+}
+
+static void exporter_announce(exporter_t * p_exp)
+{
+    exportmsg_t msg;
+    uint32_t index = 0;
+    bool is_sent   = true;
+
+    pthread_mutex_lock(&p_exp->mutex);
+
+    if (p_exp->announce && (p_exp->conn_fd >= 0))
+    {
+        p_exp->announce = false;
+
+        for (index = 0; (index < p_exp->buf_count) && is_sent; index++)
+        {
+            memset(&msg, 0, sizeof(msg));
+
+            msg.type       = EXPORTMSG_BUFFER;
+            msg.generation = p_exp->generation;
+            msg.index      = index;
+            msg.buf_count  = p_exp->buf_count;
+            msg.kind       = (uint32_t)p_exp->p_mems[index].kind;
+            msg.size       = p_exp->p_mems[index].size;
+
+            is_sent = exportmsg_send(p_exp->conn_fd, &msg,
+                                     p_exp->p_mems[index].fd);
+        }
+    }
+
+    pthread_mutex_unlock(&p_exp->mutex);
+
+    if (!is_sent)
+    {
+        exporter_drop_client(p_exp);
+    }
+}
+
+static void exporter_send_frames(exporter_t * p_exp)
+{
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+    omx_buf_meta_t * p_meta = NULL;
+
+    exportmsg_t msg;
+    uint32_t index   = 0;
+    bool is_exported = false;
+
+    while ((p_buf = (OMX_BUFFERHEADERTYPE *)queue_pop(&p_exp->buf_queue))
+           != NULL)
+    {
+        p_meta = omx_get_buf_meta(p_buf);
+        index  = p_meta->index;
+
+        memset(&msg, 0, sizeof(msg));
+
+        pthread_mutex_lock(&p_exp->mutex);
+
+        /* Only frames of the current buffers can be sent */
+        is_exported = (p_buf->nFilledLen > 0) && (p_exp->conn_fd >= 0) &&
+                      (index < p_exp->buf_count) &&
+                      (p_exp->p_bufs[index] == p_buf);
+
+        if (is_exported)
+        {
+            msg.type         = EXPORTMSG_FRAME;
+            msg.generation   = p_exp->generation;
+            msg.index        = index;
+            msg.offset       = p_buf->nOffset;
+            msg.len          = p_buf->nFilledLen;
+            msg.width        = p_exp->width;
+            msg.height       = p_exp->height;
+            msg.stride       = p_exp->stride;
+            msg.slice_height = p_exp->slice_height;
+            msg.seq          = ++p_exp->seq;
+            msg.timestamp_us = (int64_t)p_buf->nTimeStamp;
+        }
+
+        pthread_mutex_unlock(&p_exp->mutex);
+
+        if (is_exported && exportmsg_send(p_exp->conn_fd, &msg, -1))
+        {
+            /* The buffer comes back with EXPORTMSG_RELEASE */
+            p_exp->held[index] = true;
+            p_exp->held_count++;
+
+            p_exp->stats.frame_count++;
+            if (p_exp->held_count > p_exp->stats.held_max)
+            {
+                p_exp->stats.held_max = p_exp->held_count;
+            }
+
+            continue;
+        }
+
+        if (is_exported)
+        {
+            /* The consumer has gone */
+            exporter_drop_client(p_exp);
+        }
+
+        if (p_buf->nFilledLen > 0)
+        {
+            p_exp->stats.skip_count++;
+        }
+
+        p_exp->release_fn(p_exp->p_release_ctx, p_buf);
+    }
+}
+
+static void exporter_recv_releases(exporter_t * p_exp)
+{
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+
+    exportmsg_t msg;
+    ssize_t ret = 0;
+
+    while (true)
+    {
+        ret = recv(p_exp->conn_fd, &msg, sizeof(msg), MSG_DONTWAIT);
+        if ((ret < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+        {
+            return;
+        }
+
+        if (ret <= 0)
+        {
+            /* The consumer has closed the connection */
+            exporter_drop_client(p_exp);
+            return;
+        }
+
+        if ((ret != (ssize_t)sizeof(msg)) ||
+            (msg.type != EXPORTMSG_RELEASE))
+        {
+            p_exp->stats.bad_release_count++;
+            continue;
+        }
+
+        p_buf = NULL;
+
+        pthread_mutex_lock(&p_exp->mutex);
+
+        if ((msg.generation == p_exp->generation) &&
+            (msg.index < p_exp->buf_count) && p_exp->held[msg.index])
+        {
+            p_buf = p_exp->p_bufs[msg.index];
+        }
+
+        pthread_mutex_unlock(&p_exp->mutex);
+
+        if (p_buf == NULL)
+        {
+            p_exp->stats.bad_release_count++;
+            continue;
+        }
+
+        p_exp->held[msg.index] = false;
+        p_exp->held_count--;
+        p_exp->stats.release_count++;
+
+        p_exp->release_fn(p_exp->p_release_ctx, p_buf);
+    }
+}
+
+static void exporter_drop_client(exporter_t * p_exp)
+{
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+    uint32_t index = 0;
+
+    if (p_exp->conn_fd >= 0)
+    {
+        close(p_exp->conn_fd);
+        p_exp->conn_fd = -1;
+    }
+
+    for (index = 0; index < EXPORTER_MAX_BUFS; index++)
+    {
+        if (!p_exp->held[index])
+        {
+            continue;
+        }
+
+        pthread_mutex_lock(&p_exp->mutex);
+        p_buf = p_exp->p_bufs[index];
+        pthread_mutex_unlock(&p_exp->mutex);
+
+        p_exp->held[index] = false;
+        p_exp->held_count--;
+
+        p_exp->release_fn(p_exp->p_release_ctx, p_buf);
+    }
+}
+
+static void * exporter_thread(void * p_param)
+{
+    exporter_t * p_exp = (exporter_t *)p_param;
+    struct pollfd fds[3];
+
+    exportmsg_t msg;
+    eventfd_t value = 0;
+
+    /* End of the wait for the consumer after EXPORTMSG_END (0 before) */
+    uint64_t end_ns = 0;
+    uint64_t now_ns = 0;
+    int timeout_ms  = -1;
+
+    trace_name_thread("exporter");
+
+    while (true)
+    {
+        fds[0].fd     = p_exp->wake_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd     = p_exp->listen_fd;
+        fds[1].events = POLLIN;
+        fds[2].fd     = p_exp->conn_fd;
+        fds[2].events = POLLIN;
+
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        fds[2].revents = 0;
+
+        if (end_ns != 0)
+        {
+            now_ns     = exporter_now_ns();
+            timeout_ms = (now_ns < end_ns) ?
+                         (int)((end_ns - now_ns + 999999) / 1000000) : 0;
+        }
+
+        /* A negative 'conn_fd' is ignored by 'poll' */
+        if ((poll(fds, 3, timeout_ms) < 0) && (errno != EINTR))
+        {
+            printf("Error: Exporter failed to poll (errno %d)\n", errno);
+            break;
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            eventfd_read(p_exp->wake_fd, &value);
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            exporter_accept(p_exp);
+        }
+
+        if ((p_exp->conn_fd >= 0) && (fds[2].revents != 0))
+        {
+            exporter_recv_releases(p_exp);
+        }
+
+        exporter_announce(p_exp);
+        exporter_send_frames(p_exp);
+
+        if ((end_ns == 0) && atomic_load(&p_exp->stop))
+        {
+            /* All frames pushed before 'exporter_close' have been sent */
+            memset(&msg, 0, sizeof(msg));
+
+            msg.type       = EXPORTMSG_END;
+            msg.generation = p_exp->generation;
+
+            if (p_exp->conn_fd >= 0)
+            {
+                exportmsg_send(p_exp->conn_fd, &msg, -1);
+            }
+
+            end_ns = exporter_now_ns() +
+                     ((uint64_t)EXPORTER_CLOSE_MS * 1000000ULL);
+        }
+
+        if ((end_ns != 0) &&
+            ((p_exp->held_count == 0) || (p_exp->conn_fd < 0) ||
+             (exporter_now_ns() >= end_ns)))
+        {
+            break;
+        }
+    }
+
+    /* Return the buffers held by the consumer and those not sent yet */
+    exporter_drop_client(p_exp);
+    exporter_send_frames(p_exp);
+
+    return NULL;
+}
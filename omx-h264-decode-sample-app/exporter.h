@@ -0,0 +1,202 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: exporter.h
+ *
+ * DESCRIPTION:
+ *   Exporter of output buffers to a consumer process.
+ *
+ *   The exporter listens on a UNIX socket ('SOCK_SEQPACKET'). When a consumer
+ *   connects, it sends one EXPORTMSG_BUFFER message (see 'exportmsg.h') per
+ *   output buffer, with the file descriptor of the buffer (see 'dmabuf.h')
+ *   attached. The consumer maps (or imports) each buffer once.
+ *
+ *   FillBufferDone hands filled buffers to the exporter with 'exporter_push'.
+ *   The exporter thread sends an EXPORTMSG_FRAME message which tells in
+ *   which buffer the frame is. The buffer is only returned to the application
+ *   (through 'exporter_release_fn', which sends it back to output port) when
+ *   the consumer replies with EXPORTMSG_RELEASE. So, the frame is never
+ *   copied and the MC does not overwrite it while the consumer reads it.
+ *
+ *   Without a consumer, buffers are returned at once. If the consumer
+ *   disconnects, the buffers it holds are returned. After a change of output
+ *   buffers ('exporter_set_bufs'), they are sent again with a new generation.
+ *   EXPORTMSG_END tells the consumer that no more frame will be sent.
+ *
+ * PUBLIC FUNCTIONS:
+ *   exporter_open
+ *   exporter_set_layout
+ *   exporter_set_bufs
+ *   exporter_start
+ *   exporter_wait_client
+ *   exporter_push
+ *   exporter_close
+ *   exporter_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _EXPORTER_H_
+#define _EXPORTER_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/un.h>
+
+#include "omx.h"
+#include "queue.h"
+#include "dmabuf.h"
+#include "exportmsg.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The maximum number of output buffers exported at the same time */
+#define EXPORTER_MAX_BUFS 32
+
+/* Time (in ms) 'exporter_close' waits for the consumer to release its frames
+ * after EXPORTMSG_END */
+#define EXPORTER_CLOSE_MS 1000
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+/* Called by the exporter thread when 'p_buf' is no longer used by the
+ * consumer. Usually, it sends 'p_buf' back to output port */
+typedef void (*exporter_release_fn)(void * p_ctx,
+                                    OMX_BUFFERHEADERTYPE * p_buf);
+
+typedef struct
+{
+    /* The number of frames sent to consumers and released by them */
+    uint64_t frame_count;
+    uint64_t release_count;
+
+    /* The number of buffers returned without being sent (no consumer or
+     * buffer not exported) */
+    uint64_t skip_count;
+
+    /* The number of consumers which connected, and of connections refused
+     * because a consumer was already connected */
+    uint32_t client_count;
+    uint32_t refuse_count;
+
+    /* The number of invalid EXPORTMSG_RELEASE messages (stale generation
+     * or buffer not held) */
+    uint32_t bad_release_count;
+
+    /* The maximum number of frames held by a consumer at the same time */
+    uint32_t held_max;
+
+} exporter_stats_t;
+
+typedef struct
+{
+    /* Path and file descriptor of the listening socket */
+    struct sockaddr_un addr;
+    int listen_fd;
+
+    /* Socket of the connected consumer (-1 if none) */
+    int conn_fd;
+
+    /* eventfd which wakes the exporter thread up */
+    int wake_fd;
+
+    /* Lock this mutex to change the buffers or the layout */
+    pthread_mutex_t mutex;
+
+    /* Exported buffers (their headers and memory) and their generation */
+    OMX_BUFFERHEADERTYPE * p_bufs[EXPORTER_MAX_BUFS];
+    const dmabuf_t * p_mems;
+    uint32_t buf_count;
+    uint32_t generation;
+
+    /* True if the buffers must be sent to the consumer again */
+    bool announce;
+
+    /* Layout of NV12 frames in output buffers */
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t slice_height;
+
+    /* True for each buffer held by the consumer, and their number */
+    bool held[EXPORTER_MAX_BUFS];
+    uint32_t held_count;
+
+    /* Sequence number of the last frame sent */
+    uint64_t seq;
+
+    /* Buffers pushed by FillBufferDone and waiting to be sent */
+    queue_t buf_queue;
+
+    /* Post this semaphore when a consumer connects */
+    sem_t smp_client;
+
+    /* True if the thread must exit after 'buf_queue' is drained */
+    atomic_bool stop;
+
+    /* Thread which sends frames and receives releases */
+    pthread_t thread;
+
+    /* Function (and its context) used to return buffers to the application */
+    exporter_release_fn release_fn;
+    void * p_release_ctx;
+
+    /* Statistics (only valid after 'exporter_close') */
+    exporter_stats_t stats;
+
+} exporter_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Listen on UNIX socket 'p_path' (replaced if it exists) for 'p_exp'.
+ * 'buf_count' is the maximum number of buffers pushed but not yet released.
+ * Return true if successful. Otherwise, return false */
+bool exporter_open(exporter_t * p_exp, const char * p_path, uint32_t buf_count);
+
+/* Set the layout of NV12 frames in output buffers.
+ *
+ * Note: Call it before 'exporter_start' or while no buffer is pushed (for
+ *       example, while output port is disabled) */
+void exporter_set_layout(exporter_t * p_exp, uint32_t width, uint32_t height,
+                         uint32_t stride, uint32_t slice_height);
+
+/* Export the 'count' buffers 'pp_bufs' whose memory is 'p_mems' (NULL and 0
+ * to export none). Buffer 'index' must use 'p_mems[index]'. The consumer
+ * receives them with a new generation.
+ *
+ * Note: Call it while no buffer is pushed or held (for example, while output
+ *       port is disabled). 'p_mems' must stay valid until the next call */
+void exporter_set_bufs(exporter_t * p_exp, OMX_BUFFERHEADERTYPE ** pp_bufs,
+                       const dmabuf_t * p_mems, uint32_t count);
+
+/* Start the thread of 'p_exp'. Buffers will be returned by calling
+ * 'release_fn(p_release_ctx, buffer)'.
+ * Return true if successful. Otherwise, return false */
+bool exporter_start(exporter_t * p_exp,
+                    exporter_release_fn release_fn, void * p_release_ctx);
+
+/* Wait up to 'timeout_ms' ms until a consumer connects to 'p_exp'.
+ * Return true if a consumer is connected. Otherwise, return false */
+bool exporter_wait_client(exporter_t * p_exp, uint32_t timeout_ms);
+
+/* Hand 'p_buf' to 'p_exp'. The function never blocks, so it can be called
+ * from FillBufferDone */
+void exporter_push(exporter_t * p_exp, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Send pending frames and EXPORTMSG_END, wait up to 'EXPORTER_CLOSE_MS'
+ * for the consumer to release its frames, then return all buffers, stop
+ * the thread and remove the socket */
+void exporter_close(exporter_t * p_exp);
+
+/* Print statistics of 'p_exp' (call it after 'exporter_close') */
+void exporter_print_stats(exporter_t * p_exp);
+
+#endif /* _EXPORTER_H_ */
@@ -0,0 +1,182 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: exportmsg.c
+ *
+ * DESCRIPTION:
+ *   Messages between the exporter and its consumer definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'exportmsg.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+/* Needed for 'SOCK_CLOEXEC' and 'MSG_CMSG_CLOEXEC' */
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "exportmsg.h"
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool exportmsg_send(int sock_fd, const exportmsg_t * p_msg, int fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr * p_cmsg = NULL;
+
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+
+    ssize_t ret = 0;
+
+    /* Check parameter */
+    assert(p_msg != NULL);
+
+    memset(&msg, 0, sizeof(msg));
+    memset(&ctrl, 0, sizeof(ctrl));
+
+    iov.iov_base = (void *)p_msg;
+    iov.iov_len  = sizeof(exportmsg_t);
+
+    msg.msg_iov    = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fd >= 0)
+    {
+        /* The peer receives its own file descriptor */
+        msg.msg_control    = ctrl.buf;
+        msg.msg_controllen = sizeof(ctrl.buf);
+
+        p_cmsg = CMSG_FIRSTHDR(&msg);
+
+        p_cmsg->cmsg_level = SOL_SOCKET;
+        p_cmsg->cmsg_type  = SCM_RIGHTS;
+        p_cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+
+        memcpy(CMSG_DATA(p_cmsg), &fd, sizeof(int));
+    }
+
+    do
+    {
+        ret = sendmsg(sock_fd, &msg, MSG_NOSIGNAL);
+    }
+    while ((ret < 0) && (errno == EINTR));
+
+    return (ret == (ssize_t)sizeof(exportmsg_t));
+}
+
+bool exportmsg_recv(int sock_fd, exportmsg_t * p_msg, int * p_fd)
+{
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr * p_cmsg = NULL;
+
+    union
+    {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } ctrl;
+
+    ssize_t ret = 0;
+
+    /* Check parameters */
+    assert((p_msg != NULL) && (p_fd != NULL));
+
+    *p_fd = -1;
+
+    memset(&msg, 0, sizeof(msg));
+
+    iov.iov_base = p_msg;
+    iov.iov_len  = sizeof(exportmsg_t);
+
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    do
+    {
+        ret = recvmsg(sock_fd, &msg, MSG_CMSG_CLOEXEC);
+    }
+    while ((ret < 0) && (errno == EINTR));
+
+    for (p_cmsg = CMSG_FIRSTHDR(&msg); p_cmsg != NULL;
+         p_cmsg = CMSG_NXTHDR(&msg, p_cmsg))
+    {
+        if ((p_cmsg->cmsg_level == SOL_SOCKET) &&
+            (p_cmsg->cmsg_type == SCM_RIGHTS))
+        {
+            memcpy(p_fd, CMSG_DATA(p_cmsg), sizeof(int));
+        }
+    }
+
+    return (ret == (ssize_t)sizeof(exportmsg_t));
+}
+
+int exportmsg_connect(const char * p_path)
+{
+    struct sockaddr_un addr;
+    int sock_fd = -1;
+
+    /* Check parameter */
+    assert(p_path != NULL);
+
+    if (strlen(p_path) >= sizeof(addr.sun_path))
+    {
+        printf("Error: Socket path '%s' is too long\n", p_path);
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, p_path);
+
+    sock_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (sock_fd < 0)
+    {
+        printf("Error: Failed to create socket (errno %d)\n", errno);
+        return -1;
+    }
+
+    if (connect(sock_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        printf("Error: Failed to connect to '%s' (errno %d)\n", p_path, errno);
+        close(sock_fd);
+        return -1;
+    }
+
+    return sock_fd;
+}
+
+bool exportmsg_release_frame(int sock_fd, const exportmsg_t * p_frame)
+{
+    exportmsg_t release;
+
+    /* Check parameter */
+    assert(p_frame != NULL);
+
+    memset(&release, 0, sizeof(release));
+
+    release.type       = EXPORTMSG_RELEASE;
+    release.generation = p_frame->generation;
+    release.index      = p_frame->index;
+    release.seq        = p_frame->seq;
+
+    return exportmsg_send(sock_fd, &release, -1);
+}
@@ -0,0 +1,123 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: exportmsg.h
+ *
+ * DESCRIPTION:
+ *   Messages between the exporter of output buffers (see 'exporter.h') and
+ *   its consumer process.
+ *
+ *   Messages are sent on a UNIX socket ('SOCK_SEQPACKET'), one 'exportmsg_t'
+ *   per packet. The file descriptor of a buffer is attached to
+ *   EXPORTMSG_BUFFER with 'SCM_RIGHTS'.
+ *
+ *   This unit has no dependency on OMX IL: a consumer only builds
+ *   'exportmsg.c' (and may include 'dmabuf.h' for the kinds of buffers).
+ *
+ * PUBLIC FUNCTIONS:
+ *   exportmsg_send
+ *   exportmsg_recv
+ *
+ *   exportmsg_connect
+ *   exportmsg_release_frame
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _EXPORTMSG_H_
+#define _EXPORTMSG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef enum
+{
+    /* Decoder to consumer: buffer 'index' of 'buf_count' ('size' bytes,
+     * allocated as 'kind'). Its file descriptor is attached */
+    EXPORTMSG_BUFFER = 1,
+
+    /* Decoder to consumer: a frame is in buffer 'index' */
+    EXPORTMSG_FRAME,
+
+    /* Decoder to consumer: no more frame will be sent */
+    EXPORTMSG_END,
+
+    /* Consumer to decoder: the frame in buffer 'index' has been read */
+    EXPORTMSG_RELEASE
+
+} exportmsg_type_t;
+
+typedef struct
+{
+    /* Type of the message ('exportmsg_type_t') */
+    uint32_t type;
+
+    /* Generation of the set of buffers. It changes whenever the buffers are
+     * replaced (the consumer then closes the previous ones) */
+    uint32_t generation;
+
+    /* Index of the buffer */
+    uint32_t index;
+
+    /* EXPORTMSG_BUFFER: the number of buffers of the generation and how the
+     * buffer was allocated ('dmabuf_kind_t' in 'dmabuf.h') */
+    uint32_t buf_count;
+    uint32_t kind;
+
+    /* EXPORTMSG_FRAME: position of the frame in the buffer */
+    uint32_t offset;
+    uint32_t len;
+
+    /* EXPORTMSG_FRAME: visible size (in pixels), stride and slice height of
+     * the NV12 frame */
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    uint32_t slice_height;
+
+    uint32_t reserved;
+
+    /* EXPORTMSG_BUFFER: size of the buffer */
+    uint64_t size;
+
+    /* EXPORTMSG_FRAME: sequence number (from 1) and timestamp ('nTimeStamp',
+     * in us) of the frame */
+    uint64_t seq;
+    int64_t timestamp_us;
+
+} exportmsg_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Send 'p_msg' on socket 'sock_fd', with file descriptor 'fd' attached (-1
+ * for none).
+ * Return true if successful. Otherwise, return false */
+bool exportmsg_send(int sock_fd, const exportmsg_t * p_msg, int fd);
+
+/* Receive a message from socket 'sock_fd' to 'p_msg'. '*p_fd' is the file
+ * descriptor attached to it (-1 if none).
+ * Return true if successful. Otherwise (the peer has closed the
+ * connection), return false */
+bool exportmsg_recv(int sock_fd, exportmsg_t * p_msg, int * p_fd);
+
+/* Functions of the consumers */
+
+/* Connect to the decoder listening on 'p_path'.
+ * Return the socket if successful. Otherwise, return -1 */
+int exportmsg_connect(const char * p_path);
+
+/* Tell the decoder (on socket 'sock_fd') that the frame of EXPORTMSG_FRAME
+ * message 'p_frame' has been read.
+ * Return true if successful. Otherwise, return false */
+bool exportmsg_release_frame(int sock_fd, const exportmsg_t * p_frame);
+
+#endif /* _EXPORTMSG_H_ */
@@ -0,0 +1,109 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: logger.h
+ *
+ * DESCRIPTION:
+ *   Asynchronous leveled logger.
+ *
+ *   'LOG_ERROR', 'LOG_WARN', 'LOG_INFO' and 'LOG_DEBUG' format a message
+ *   (like 'printf') into a fixed-size record and push it to a lock-free
+ *   queue. A background thread takes records from the queue and writes them
+ *   to stdout, so OMX callbacks never wait for console I/O. If the queue is
+ *   full, the message is dropped (and counted) instead of blocking.
+ *
+ *   A message is only formatted if its level is enabled:
+ *     - At compile time: levels above 'LOG_COMPILE_LEVEL' are removed from
+ *       the program (build with 'make LOG_LEVEL=<level>').
+ *     - At run time: levels above 'logger_level' are skipped after a single
+ *       comparison ('logger_set_level').
+ *
+ *   Before 'logger_init' and after 'logger_deinit', messages are written
+ *   directly to stdout.
+ *
+ * PUBLIC FUNCTIONS:
+ *   logger_init
+ *   logger_deinit
+ *   logger_flush
+ *   logger_set_level
+ *   logger_push
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _LOGGER_H_
+#define _LOGGER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Levels of messages (from the most to the least important) */
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN  1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+
+/* The highest level compiled into the program */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/* The number of records of the queue (power of 2) */
+#define LOGGER_QUEUE_SIZE 256
+
+/* The maximum length of a message (longer messages are truncated) */
+#define LOGGER_MSG_LEN 160
+
+/* Log a message of level 'LEVEL' */
+#define LOG(LEVEL, ...)                                                       \
+    do                                                                        \
+    {                                                                         \
+        if (((LEVEL) <= LOG_COMPILE_LEVEL) && ((LEVEL) <= logger_level))      \
+        {                                                                     \
+            logger_push(__VA_ARGS__);                                         \
+        }                                                                     \
+    } while (0)
+
+#define LOG_ERROR(...) LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG(LOG_LEVEL_WARN,  __VA_ARGS__)
+#define LOG_INFO(...)  LOG(LOG_LEVEL_INFO,  __VA_ARGS__)
+#define LOG_DEBUG(...) LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+/******************************************************************************
+ *                                 VARIABLES                                  *
+ ******************************************************************************/
+
+/* The highest level written at run time (default: 'LOG_LEVEL_INFO') */
+extern int logger_level;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Start the thread which writes messages.
+ * Return true if successful. Otherwise, return false */
+bool logger_init(void);
+
+/* Write the remaining messages and stop the thread */
+void logger_deinit(void);
+
+/* Wait until every message queued so far is written. Call it before
+ * printing directly to stdout, so that the order of messages is kept */
+void logger_flush(void);
+
+/* Set the highest level written at run time (it is limited to
+ * 'LOG_COMPILE_LEVEL') */
+void logger_set_level(int level);
+
+/* Format a message and queue it. Use the 'LOG_*' macros, which check its
+ * level first */
+void logger_push(const char * p_format, ...)
+    __attribute__((format(printf, 1, 2)));
+
+#endif /* _LOGGER_H_ */
@@ -1,9 +1,22 @@
 #include "omx.h"
-
+#include "queue.h"
+#include "writer.h"
+#include "convert.h"
+#include "scheduler.h"
+#include "bench.h"
+#include "logger.h"
+#include "tuner.h"
+#include "annexb.h"
+#include "shmring.h"
+#include "exporter.h"
+
+#include <pthread.h>
 #include <semaphore.h>
 
+#ifdef USE_GSTREAMER
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>
+#endif
 
 /******************************************************************************
  *                                   MACROS                                   *
@@ -12,29 +25,188 @@
 /* Input file which contains H.264 frames */
 #define IN_FILE_NAME "in-h264-640x480.264"
 
-/* Output file which contains NV12 frames */
-#define OUT_FILE_NAME "out-nv12-640x480.raw"
+/* Output file which contains decoded frames ('%s' is the output format) */
+#define OUT_FILE_NAME "out-%s-640x480.raw"
+
+/* Output file of jobs whose line in the job list ('-j') has no output file
+ * ('%s' is the output format and '%%u' is the index of the job) */
+#define OUT_JOB_FILE_NAME "out-%s-job%%u.raw"
+
+/* The maximum number of MCs decoding at the same time (option '-n') */
+#define MAX_INSTANCES 1
+
+/* Format of output file: "nv12", "i420", "yuy2" or "rgb" (RGB24).
+ * It can be changed for a run with the first command-line argument.
+ * Except for "nv12", decoded frames are converted by the writer */
+#define OUT_FORMAT "nv12"
 
-/* The number of buffers for input port of media component (MC) */
+/* The number of threads which convert each frame (by stripes of rows) */
+#define OUT_CONVERT_THREADS 2
+
+/* The number of buffers for input port of media component (MC).
+ * It can be changed for a run with a buffer profile (option '-p') */
 #define IN_BUFFER_COUNT 2
 
-/* The number of buffers for output port of media component (MC) */
+/* The number of buffers for output port of media component (MC).
+ * It can be changed for a run with a buffer profile (option '-p') */
 #define OUT_BUFFER_COUNT 3
 
+/* The maximum number of buffers for output port. The MC may ask for more
+ * buffers than 'OUT_BUFFER_COUNT' (for example, after a change of
+ * resolution); the output writer and the exporter can hold up to this
+ * count. It must not exceed 'BENCH_MAX_BUFFERS' nor 'EXPORTER_MAX_BUFS' */
+#define OUT_MAX_BUFFER_COUNT 32
+
+#if (OUT_MAX_BUFFER_COUNT > BENCH_MAX_BUFFERS) || \
+    (OUT_MAX_BUFFER_COUNT > EXPORTER_MAX_BUFS)
+#error "OUT_MAX_BUFFER_COUNT exceeds the buffers of the bench or exporter"
+#endif
+
+/* The buffer tuner (option '-a') tries up to 'nBufferCountMin' +
+ * 'TUNE_EXTRA_BUFFERS' buffers on each port */
+#define TUNE_EXTRA_BUFFERS 4
+
+/* Size of each staging buffer of the output writer. Decoded frames are
+ * gathered in staging buffers and written to output file in large blocks */
+#define OUT_STAGE_SIZE (4 * 1024 * 1024)
+
+/* Set to 'true' to write output file with 'O_DIRECT' (bypass page cache) */
+#define OUT_DIRECT_IO false
+
+/* Set to 'true' to drop the padding (stride and slice height) of decoded
+ * frames, so that output file contains tightly packed NV12 frames */
+#define OUT_PACK_NV12 true
+
+/* Set to 'true' to allocate the memory of output buffers in the application
+ * ('OMX_UseBuffer'), so that it is reused when the MC changes the settings
+ * of output port to a frame size which still fits. Otherwise, the MC
+ * allocates it ('OMX_AllocateBuffer') again for each change */
+#define OUT_REUSE_BUFFERS true
+
+/* Alignment (in bytes) of the memory of output buffers */
+#define OUT_BUFFER_ALIGN 4096
+
+/* The number of slots of the shared-memory ring (option '-r') */
+#define RING_SLOT_COUNT 4
+
+/* Size of each slot of the ring: the largest output buffer it holds. Pages
+ * of the ring are only allocated when a frame is first written to them */
+#define RING_SLOT_SIZE (16 * 1024 * 1024)
+
+/* With policy "block", the maximum time (in ms) to wait for the first
+ * consumer of the ring before decoding starts */
+#define RING_WAIT_READER_MS 10000
+
+/* The maximum time (in ms) to wait for the consumer of exported output
+ * buffers (option '-e') before decoding starts */
+#define EXPORT_WAIT_CLIENT_MS 10000
+
+/* Maximum time (in ms) to wait for the MC to complete a state transition */
+#define STATE_TIMEOUT_MS 3000
+
+/* The maximum number of samples of each kind (latency, time in the MC)
+ * recorded by the benchmark (option '-b') */
+#define BENCH_MAX_SAMPLES 100000
+
 /******************************************************************************
  *                                 STRUCTURES                                 *
  ******************************************************************************/
 
 typedef struct
 {
+    /* Format of output files */
+    convert_fmt_t out_fmt;
+
+    /* True if each decode prints its events and statistics */
+    bool verbose;
+
+    /* File to which the benchmark report is written (NULL if disabled) */
+    const char * p_bench_file;
+
+    /* The number of buffers of input and output ports */
+    tuner_profile_t bufs;
+
+    /* If not NULL, the decode is benchmarked and its frame rate, p99
+     * latency and buffer memory are stored to it (option '-a') */
+    tuner_result_t * p_tune_result;
+
+    /* True if decoded frames are published to a shared-memory ring instead
+     * of output file (option '-r'), and the policy of the ring */
+    bool ring;
+    shmring_policy_t ring_policy;
+
+    /* Socket on which output buffers are exported to a consumer (NULL if
+     * disabled, option '-e') */
+    const char * p_export_path;
+
+} decode_cfg_t;
+
+typedef struct
+{
+    /* Settings of the decodes run by the tuner */
+    const decode_cfg_t * p_cfg;
+
+    /* Output file of the decodes */
+    const char * p_out_file_name;
+
+} tune_ctx_t;
+
+typedef struct
+{
+    /* True if events of this decode are printed */
+    bool verbose;
+
+    /* Benchmark of this decode (NULL if disabled) */
+    bench_t * p_bench;
+
+    /* The number of decoded frames handed to the writer */
+    uint64_t frame_count;
+
+    /* Time (from 'omx_get_time_ns') of the first decoded frame */
+    uint64_t first_frame_ns;
+
     /* End-of-Stream (EOS) flag */
     bool eos;
 
-    /* Lock this semaphore in main() until EOS event occurs */
-    sem_t smp_eos;
+    /* True if input data did not fit in an input buffer. The feeder thread
+     * then sent End-of-Stream early and the decode fails */
+    bool in_failed;
+
+    /* True if 'OMX_EventPortSettingsChanged' occurred and output port has
+     * not been reconfigured yet */
+    bool settings_changed;
+
+    /* Lock this semaphore in main() until EOS event or
+     * 'OMX_EventPortSettingsChanged' event occurs */
+    sem_t smp_event;
 
-    /* True if the output port has been completely disabled */
-    bool port_disabled;
+    /* True if output buffers match the settings of output port. Otherwise
+     * (output port is being reconfigured), returned buffers are kept */
+    bool out_port_ready;
+
+    /* Lock this mutex to change 'out_port_ready' or to send a buffer back to
+     * output port from the writer */
+    pthread_mutex_t out_mutex;
+
+    /* Post this semaphore whenever an output buffer is returned while output
+     * port is being reconfigured (by the MC or by the writer) */
+    sem_t smp_out_buf_returned;
+
+    /* Memory of output buffers if 'OUT_REUSE_BUFFERS' is true: 'out_mem_cnt'
+     * blocks of 'out_mem_size' bytes */
+    OMX_U8 ** pp_out_mem;
+    uint32_t out_mem_cnt;
+    OMX_U32 out_mem_size;
+
+    /* The number of reconfigurations of output port, and how many of them
+     * reused the memory of output buffers */
+    uint32_t reconfig_count;
+    uint32_t reuse_count;
+
+    /* Statistics of the buffers of input and output ports (the buffers of
+     * output port freed by reconfigurations included) */
+    omx_buf_stats_t in_buf_stats;
+    omx_buf_stats_t out_buf_stats;
 
     /* Lock this semaphore in main() until output port is completely disabled */
     sem_t smp_port_disabled;
@@ -42,17 +214,58 @@ typedef struct
     /* Lock this semaphore in main() until output port is completely enabled */
     sem_t smp_port_enabled;
 
-    /* Lock this semaphore in main() until output port changes settings */
-    sem_t smp_port_settings_changed;
-
+#ifdef USE_GSTREAMER
     /* File descriptor of input file */
     FILE * p_in_file;
 
-    /* File descriptor of output file */
-    FILE * p_out_file;
-
     /* GStreamer element from which the application gets H.264 frames */
     GstElement * p_appsink;
+#else
+    /* Parser which splits input file into H.264 access units */
+    annexb_t annexb;
+#endif
+
+    /* Writer which writes decoded frames to output file */
+    writer_t writer;
+
+    /* True if the writer publishes decoded frames to 'ring' instead */
+    bool use_ring;
+
+    /* Shared-memory ring read by consumer processes (option '-r') */
+    shmring_t ring;
+
+    /* True if output buffers are exported to a consumer instead of being
+     * handed to the writer (option '-e') */
+    bool use_export;
+
+    /* Exporter of output buffers and their memory ('out_mem_cnt' buffers,
+     * NULL unless 'use_export' is true) */
+    exporter_t exporter;
+    dmabuf_t * p_out_dmabufs;
+
+    /* Format of output file */
+    convert_fmt_t out_fmt;
+
+    /* Converter used by the writer (if 'out_fmt' is not NV12) */
+    convert_t convert;
+
+    /* State of the MC (updated by the event handler) */
+    omx_state_t state;
+
+    /* Handle of the MC */
+    OMX_HANDLETYPE handle;
+
+    /* Input buffers returned by EmptyBufferDone and waiting to be refilled */
+    queue_t in_buf_queue;
+
+    /* Post this semaphore whenever a buffer is added to 'in_buf_queue' */
+    sem_t smp_in_buf;
+
+    /* True if 'feeder_thread' must exit */
+    atomic_bool feeder_stop;
+
+    /* Thread which refills input buffers and sends them to input port */
+    pthread_t feeder_thread;
 
 } omx_data_t;
 
@@ -105,9 +318,85 @@ OMX_ERRORTYPE omx_fill_buffer_done(OMX_HANDLETYPE hComponent,
  *                                 FUNCTIONS                                  *
  ******************************************************************************/
 
+/* Decode 'p_in_file_name' to 'p_out_file_name' with a new MC.
+ * OMX IL core (and GStreamer) must have been initialized.
+ * Return true if successful. Otherwise, return false */
+bool decode_file(const char * p_in_file_name, const char * p_out_file_name,
+                 const decode_cfg_t * p_cfg, uint64_t * p_frame_count);
+
+/* Job function of the scheduler. 'p_ctx' points to a 'decode_cfg_t' */
+bool decode_job(scheduler_job_t * p_job, void * p_ctx);
+
+/* Get 'nBufferCountMin' of input and output ports from a new MC.
+ * Return true if successful. Otherwise, return false */
+bool get_min_buf_counts(tuner_profile_t * p_min);
+
+/* Decode 'IN_FILE_NAME' with more and more buffers (see 'tuner.h') and save
+ * the recommended buffer counts to profile 'p_profile_file'.
+ * Return true if successful. Otherwise, return false */
+bool tune_buffers(const decode_cfg_t * p_cfg, const char * p_out_file_name,
+                  const char * p_profile_file);
+
+/* Run function of the tuner. 'p_ctx' points to a 'tune_ctx_t' */
+bool tune_run(const tuner_profile_t * p_profile, tuner_result_t * p_result,
+              void * p_ctx);
+
+/* Parse the first SPS of 'p_in_file_name' to 'p_sps'.
+ * Return true if successful. Otherwise, return false */
+bool read_sps(const char * p_in_file_name, annexb_sps_t * p_sps);
+
+/* Set NV12 format to output port. If 'p_sps' is not NULL, also size output
+ * port for the pictures of 'p_sps', so that the MC does not need to send
+ * 'OMX_EventPortSettingsChanged' event before the first frame.
+ * Return true if successful. Otherwise, return false */
+bool set_out_port(OMX_HANDLETYPE handle, const annexb_sps_t * p_sps);
+
+/* Give the frame layout of output port to the writer (and the converter) */
+void set_out_layout(omx_data_t * p_data);
+
+/* Get the 'out_buf_cnt' buffers of output port. If 'OUT_REUSE_BUFFERS' is
+ * true, the memory of the previous buffers is reused when it can hold
+ * 'nBufferSize' bytes. '*p_reused' tells if it was.
+ * Return non-NULL value if successful. Otherwise, return NULL */
+OMX_BUFFERHEADERTYPE ** get_out_bufs(omx_data_t * p_data,
+                                     uint32_t out_buf_cnt, bool * p_reused);
+
+/* Free the memory of output buffers (after their buffer headers) */
+void free_out_mem(omx_data_t * p_data);
+
+/* Replace the '*p_out_buf_cnt' output buffers 'pp_out_bufs' by buffers for
+ * the new settings of output port, then send them to output port. Frames
+ * decoded before the change are all written. If the MC now needs more
+ * buffers ('nBufferCountMin'), '*p_out_buf_cnt' is raised to that number.
+ * Return the new buffers if successful. Otherwise (output port is then left
+ * disabled), return NULL */
+OMX_BUFFERHEADERTYPE ** reconfig_out_port(omx_data_t * p_data,
+                                          OMX_BUFFERHEADERTYPE ** pp_out_bufs,
+                                          uint32_t * p_out_buf_cnt);
+
 /* Fill data to input buffer (if possible). Then, set its nFilledLen and nFlags.
+ * If the data does not fit in the buffer, '*p_is_failed' is set to true and
+ * the buffer becomes the End-of-Stream buffer.
  * The function will return nFlags of the input buffer upon exiting */
-OMX_U32 setup_in_buf(GstElement * p_appsink, OMX_BUFFERHEADERTYPE * p_in_buf);
+#ifdef USE_GSTREAMER
+OMX_U32 setup_in_buf(GstElement * p_appsink, OMX_BUFFERHEADERTYPE * p_in_buf,
+                     bool * p_is_failed);
+#else
+OMX_U32 setup_in_buf(annexb_t * p_annexb, OMX_BUFFERHEADERTYPE * p_in_buf,
+                     bool * p_is_failed);
+#endif
+
+/* Called by the writer when the data of output buffer 'p_buf' has been copied
+ * (or by the exporter when the consumer has released it).
+ * Send 'p_buf' back to output port when EOS event does not occur */
+void release_out_buf(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Thread function which takes buffers from 'in_buf_queue', refills them
+ * with 'setup_in_buf' and sends them back to input port.
+ *
+ * It exits after the End-of-Stream buffer has been sent to input port or
+ * when 'feeder_stop' is set */
+void * feeder_thread_func(void * p_param);
 
 /******************************************************************************
  *                               MAIN FUNCTION                                *
@@ -115,260 +404,336 @@ OMX_U32 setup_in_buf(GstElement * p_appsink, OMX_BUFFERHEADERTYPE * p_in_buf);
 
 int main(int argc, char * p_argv[])
 {
-    /* Handle of the MC */
-    OMX_HANDLETYPE handle;
-
-    /* Callbacks used by the MC */
-    OMX_CALLBACKTYPE callbacks =
+    /* Decode jobs (a single job unless option '-j' is given) */
+    scheduler_t scheduler;
+
+    /* Settings shared by all decodes */
+    decode_cfg_t cfg;
+
+    /* Name of output file and pattern of output files of the job list */
+    char out_file_name[64];
+    char out_pattern[64];
+
+    /* Command-line options */
+    const char * p_out_fmt   = OUT_FORMAT;
+    const char * p_job_list  = NULL;
+    const char * p_bench     = NULL;
+    const char * p_trace     = NULL;
+    const char * p_tune      = NULL;
+    const char * p_profile   = NULL;
+    const char * p_ring      = NULL;
+    const char * p_export    = NULL;
+    bool debug               = false;
+    uint32_t max_instances   = MAX_INSTANCES;
+    bool sweep               = false;
+    int option               = 0;
+
+    /* The number of MCs of the current run */
+    uint32_t instances = 0;
+
+    bool is_success = true;
+
+#ifdef USE_GSTREAMER
+    /* Initialize the GStreamer library */
+    gst_init(&argc, &p_argv);
+#endif
+
+    /* Usage: decoder [-b report] [-t trace] [-v] [-a profile | -p profile]
+     *                [-j job_list] [-n max_instances] [-s]
+     *                [-r policy | -e socket] [format]
+     *   -b: Benchmark the decode and write a JSON report to 'report'
+     *       ("-" for stdout). It cannot be used with '-j'.
+     *   -t: Trace OMX calls and callbacks, then write them to 'trace'
+     *       (Chrome trace-event JSON).
+     *   -v: Also print buffer events (EmptyBufferDone, FillBufferDone).
+     *   -a: Tune the buffer counts of both ports with 'IN_FILE_NAME' and
+     *       save the recommended counts to 'profile'. It cannot be used
+     *       with '-b' or '-j'.
+     *   -p: Use the buffer counts of 'profile' (written by '-a').
+     *   -j: Decode the jobs of 'job_list' instead of 'IN_FILE_NAME'.
+     *   -n: Decode up to 'max_instances' jobs at the same time.
+     *   -s: Run the jobs with 1, 2, ... 'max_instances' MCs in turn, to show
+     *       how the aggregate frame rate scales.
+     *   -r: Publish decoded NV12 frames to a shared-memory ring instead of
+     *       output file. 'policy' is "block" (wait for consumers when the
+     *       ring is full) or "drop" (overwrite the oldest frame). It cannot
+     *       be used with '-a' or '-j'.
+     *   -e: Export output buffers (dma-buf) to a consumer connected to UNIX
+     *       socket 'socket' instead of writing output file. Each buffer is
+     *       sent back to output port when the consumer releases its frame.
+     *       It cannot be used with '-a', '-j' or '-r' */
+    while ((option = getopt(argc, p_argv, "b:t:va:p:j:n:sr:e:")) != -1)
     {
-        .EventHandler    = omx_event_handler,
-        .EmptyBufferDone = omx_empty_buffer_done,
-        .FillBufferDone  = omx_fill_buffer_done
-    };
-
-    /* Buffers of input and output ports */
-    OMX_BUFFERHEADERTYPE ** pp_in_bufs  = NULL;
-    OMX_BUFFERHEADERTYPE ** pp_out_bufs = NULL;
+        switch (option)
+        {
+            case 'b':
+            {
+                p_bench = optarg;
+            }
+            break;
 
-    /* Iterator */
-    int index = 0;
+            case 't':
+            {
+                p_trace = optarg;
+            }
+            break;
 
-    /* Shared data between OMX's callbacks */
-    omx_data_t omx_data;
+            case 'v':
+            {
+                debug = true;
+            }
+            break;
 
-    /* GStreamer pipeline and elements */
-    GstElement * p_pipeline   = NULL;
-    GstElement * p_filesrc    = NULL;
-    GstElement * p_h264parse  = NULL;
-    GstElement * p_capsfilter = NULL;
-    GstElement * p_appsink    = NULL;
+            case 'a':
+            {
+                p_tune = optarg;
+            }
+            break;
 
-    GstCaps * p_caps = NULL;
+            case 'p':
+            {
+                p_profile = optarg;
+            }
+            break;
 
-    omx_data.eos = false;
-    omx_data.port_disabled = false;
+            case 'j':
+            {
+                p_job_list = optarg;
+            }
+            break;
 
-    /* Prepare the semaphores */
-    sem_init(&omx_data.smp_eos, 0, 0);
-    sem_init(&omx_data.smp_port_disabled, 0, 0);
-    sem_init(&omx_data.smp_port_enabled, 0, 0);
-    sem_init(&omx_data.smp_port_settings_changed, 0, 0);
+            case 'n':
+            {
+                max_instances = (uint32_t)strtoul(optarg, NULL, 10);
+            }
+            break;
 
-    /**************************************************************************
-     *                  STEP 1: OPEN INPUT AND OUTPUT FILES                   *
-     **************************************************************************/
+            case 's':
+            {
+                sweep = true;
+            }
+            break;
 
-    omx_data.p_in_file = fopen(IN_FILE_NAME, "rb");
-    assert(omx_data.p_in_file != NULL);
+            case 'r':
+            {
+                p_ring = optarg;
+            }
+            break;
 
-    omx_data.p_out_file = fopen(OUT_FILE_NAME, "wb");
-    assert(omx_data.p_out_file != NULL);
+            case 'e':
+            {
+                p_export = optarg;
+            }
+            break;
 
-    /* Set file position indicator of input file to the end of file */
-    fseek(omx_data.p_in_file, 0, SEEK_END);
+            default:
+            {
+                printf("Usage: %s [-b report] [-t trace] [-v] "
+                       "[-a profile | -p profile] [-j job_list] "
+                       "[-n max_instances] [-s] [-r policy | -e socket] "
+                       "[format]\n", p_argv[0]);
+                return -1;
+            }
+            break;
+        }
+    }
 
-    /* Exit program if the input file is empty */
-    assert(ftell(omx_data.p_in_file) != 0);
+    if (optind < argc)
+    {
+        p_out_fmt = p_argv[optind];
+    }
 
-    /* Set file position indicator of input file to the beginning of file */
-    fseek(omx_data.p_in_file, 0, SEEK_SET);
+    if (convert_fmt_from_str(p_out_fmt, &cfg.out_fmt) == false)
+    {
+        printf("Error: Unknown output format '%s' "
+               "(expected 'nv12', 'i420', 'yuy2' or 'rgb')\n", p_out_fmt);
+        return -1;
+    }
 
-    /**************************************************************************
-     *  STEP 2: SET UP GSTREAMER PIPELINE (FILESRC -> H264PARSE -> APPSINK)   *
-     **************************************************************************/
+    if ((p_bench != NULL) && (p_job_list != NULL))
+    {
+        printf("Error: Option '-b' cannot be used with option '-j'\n");
+        return -1;
+    }
 
-    /* Initialize the GStreamer library */
-    gst_init(&argc, &p_argv);
+    if ((p_tune != NULL) &&
+        ((p_bench != NULL) || (p_job_list != NULL) || (p_profile != NULL)))
+    {
+        printf("Error: Option '-a' cannot be used with option '-b', '-j' "
+               "or '-p'\n");
+        return -1;
+    }
 
-    /* Create an empty pipeline */
-    p_pipeline = gst_pipeline_new(NULL);
+    cfg.ring        = (p_ring != NULL);
+    cfg.ring_policy = SHMRING_POLICY_BLOCK;
 
-    /* Create elements */
-    p_filesrc    = gst_element_factory_make("filesrc",   NULL);
-    p_h264parse  = gst_element_factory_make("h264parse", NULL);
-    p_capsfilter = gst_element_factory_make("capsfilter", NULL);
-    p_appsink    = gst_element_factory_make("appsink", NULL);
+    if (cfg.ring)
+    {
+        if ((p_tune != NULL) || (p_job_list != NULL))
+        {
+            printf("Error: Option '-r' cannot be used with option '-a' "
+                   "or '-j'\n");
+            return -1;
+        }
 
-    assert(p_pipeline && p_filesrc && p_h264parse && p_capsfilter && p_appsink);
-    omx_data.p_appsink = p_appsink;
+        if (cfg.out_fmt != CONVERT_FMT_NV12)
+        {
+            printf("Error: Option '-r' only publishes 'nv12' frames\n");
+            return -1;
+        }
 
-    /* Set properties for 'filesrc' element */
-    g_object_set(G_OBJECT(p_filesrc), "location", IN_FILE_NAME, NULL);
+        if (strcmp(p_ring, "drop") == 0)
+        {
+            cfg.ring_policy = SHMRING_POLICY_DROP;
+        }
+        else if (strcmp(p_ring, "block") != 0)
+        {
+            printf("Error: Unknown policy '%s' of option '-r' "
+                   "(expected 'block' or 'drop')\n", p_ring);
+            return -1;
+        }
+    }
 
-    /* Set properties for 'capsfilter' element */
-    p_caps = gst_caps_new_simple("video/x-h264",
-                                 "stream-format", G_TYPE_STRING, "byte-stream",
-                                 "alignment", G_TYPE_STRING, "au", NULL);
+    cfg.p_export_path = p_export;
 
-    g_object_set(G_OBJECT(p_capsfilter), "caps", p_caps, NULL);
-    gst_caps_unref(p_caps);
+    if (p_export != NULL)
+    {
+        if ((p_tune != NULL) || (p_job_list != NULL) || (p_ring != NULL))
+        {
+            printf("Error: Option '-e' cannot be used with option '-a', '-j' "
+                   "or '-r'\n");
+            return -1;
+        }
 
-    /* Add and link the elements to the pipeline */
-    gst_bin_add_many(GST_BIN(p_pipeline),
-                     p_filesrc, p_h264parse, p_capsfilter, p_appsink, NULL);
+        if (cfg.out_fmt != CONVERT_FMT_NV12)
+        {
+            printf("Error: Option '-e' only exports 'nv12' frames\n");
+            return -1;
+        }
 
-    assert(gst_element_link_many(p_filesrc, p_h264parse,
-                                 p_capsfilter, p_appsink, NULL));
+        if (!OUT_REUSE_BUFFERS)
+        {
+            printf("Error: Option '-e' needs 'OUT_REUSE_BUFFERS' (output "
+                   "buffers allocated by the application)\n");
+            return -1;
+        }
+    }
 
-    /**************************************************************************
-     *                         STEP 3: SET UP OMX IL                          *
-     **************************************************************************/
+    cfg.bufs.in_buf_cnt  = IN_BUFFER_COUNT;
+    cfg.bufs.out_buf_cnt = OUT_BUFFER_COUNT;
 
-    /* Initialize OMX IL core */
-    assert(OMX_Init() == OMX_ErrorNone);
+    if ((p_profile != NULL) &&
+        (tuner_load_profile(p_profile, &cfg.bufs) == false))
+    {
+        return -1;
+    }
 
-    /* Locate Renesas's H.264 decoder.
-     * If successful, the MC will be in state LOADED */
-    assert(OMX_ErrorNone == OMX_GetHandle(&handle,
-                                          RENESAS_VIDEO_DECODER_NAME,
-                                          (OMX_PTR)&omx_data, &callbacks));
+    if ((cfg.bufs.in_buf_cnt == 0) || (cfg.bufs.out_buf_cnt == 0))
+    {
+        printf("Error: Each port needs at least 1 buffer\n");
+        return -1;
+    }
 
-    /* Configure input port */
-    assert(omx_set_port_buf_cnt(handle, 0, IN_BUFFER_COUNT));
+    if ((max_instances == 0) || (max_instances > SCHEDULER_MAX_INSTANCES))
+    {
+        printf("Error: The number of instances must be between 1 and %d\n",
+               SCHEDULER_MAX_INSTANCES);
+        return -1;
+    }
 
-    /* Configure output port */
-    assert(omx_set_out_port_fmt(handle, OMX_COLOR_FormatYUV420SemiPlanar));
+    /* Build the list of jobs */
+    scheduler_init(&scheduler);
 
-    assert(omx_set_port_buf_cnt(handle, 1, OUT_BUFFER_COUNT));
+    if (p_job_list == NULL)
+    {
+        snprintf(out_file_name, sizeof(out_file_name), OUT_FILE_NAME,
+                 convert_fmt_to_str(cfg.out_fmt));
 
-    /* Transition into state IDLE */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle,
-                                            OMX_CommandStateSet,
-                                            OMX_StateIdle, NULL));
+        is_success = scheduler_add_job(&scheduler, IN_FILE_NAME, out_file_name);
+    }
+    else
+    {
+        snprintf(out_pattern, sizeof(out_pattern), OUT_JOB_FILE_NAME,
+                 convert_fmt_to_str(cfg.out_fmt));
 
-    /**************************************************************************
-     *               STEP 4: ALLOCATE INPUT AND OUTPUT BUFFERS                *
-     **************************************************************************/
+        is_success = scheduler_load_jobs(&scheduler, p_job_list, out_pattern);
+    }
 
-    pp_in_bufs = omx_alloc_buffers(handle, 0);
-    assert(pp_in_bufs != NULL);
+    if (is_success == false)
+    {
+        scheduler_deinit(&scheduler);
+        return -1;
+    }
 
-    pp_out_bufs = omx_alloc_buffers(handle, 1);
-    assert(pp_out_bufs != NULL);
+    /* Events and statistics of concurrent decodes would be interleaved.
+     * The tuner prints its own line per configuration */
+    cfg.verbose = (p_job_list == NULL) && (p_tune == NULL);
 
-    omx_wait_state(handle, OMX_StateIdle);
+    cfg.p_bench_file  = p_bench;
+    cfg.p_tune_result = NULL;
 
-    /**************************************************************************
-     *        STEP 5: PREPARE FOR 'OMX_EventPortSettingsChanged' EVENT        *
-     **************************************************************************/
+    if (p_trace != NULL)
+    {
+        /* Record from now on (all threads are started later) */
+        trace_enable();
+        trace_name_thread("main");
+    }
 
-    /* Transition into state EXECUTING */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
-                                            OMX_StateExecuting, NULL));
-    omx_wait_state(handle, OMX_StateExecuting);
+    /* Callbacks queue their messages to the logger thread */
+    if (debug)
+    {
+        logger_set_level(LOG_LEVEL_DEBUG);
+    }
 
-    /* Play the pipeline */
-    gst_element_set_state(p_pipeline, GST_STATE_PLAYING);
+    if (logger_init() == false)
+    {
+        scheduler_deinit(&scheduler);
+        return -1;
+    }
 
-    /* Send output buffers to output port */
-    assert(omx_fill_buffers(handle, pp_out_bufs, OUT_BUFFER_COUNT));
+    /* Initialize OMX IL core (once for all MCs) */
+    assert(OMX_Init() == OMX_ErrorNone);
 
-    /* Fill data to input buffers and send the buffers to input port */
-    for (index = 0; index < IN_BUFFER_COUNT; index++)
+    if (p_tune != NULL)
+    {
+        /* Decode 'IN_FILE_NAME' as many times as needed */
+        is_success = tune_buffers(&cfg, out_file_name, p_tune);
+    }
+    else
     {
-        if (setup_in_buf(p_appsink, pp_in_bufs[index]) & OMX_BUFFERFLAG_EOS)
+        for (instances = sweep ? 1 : max_instances;
+             instances <= max_instances; instances++)
         {
-            /* Stop if the current buffer is marked as 'OMX_BUFFERFLAG_EOS' */
-            break;
-        }
+            if (scheduler_run(&scheduler, instances, decode_job, &cfg) == false)
+            {
+                is_success = false;
+            }
 
-        assert(OMX_EmptyThisBuffer(handle, pp_in_bufs[index]) == OMX_ErrorNone);
-    }
+            if (p_job_list != NULL)
+            {
+                logger_flush();
 
-    /**************************************************************************
-     *     STEP 6: WAIT UNTIL 'OMX_EventPortSettingsChanged' EVENT OCCURS     *
-     **************************************************************************/
+                /* Lines of each job would hide the trend of a sweep */
+                scheduler_print_report(&scheduler, !sweep);
+            }
+        }
+    }
 
-    sem_wait(&omx_data.smp_port_settings_changed);
+    /* Deinitialize OMX IL core */
+    assert(OMX_Deinit() == OMX_ErrorNone);
 
-    /**************************************************************************
-     *                   STEP 7: REALLOCATE OUTPUT BUFFERS                    *
-     **************************************************************************/
+    logger_deinit();
 
-    /* To disable and enable output port, the program follows steps in
-     * section 3.4.4.2: "Non-tunneled Port Disablement and Enablement" in
-     * OMX IL specification 1.1.2 */
+    /* All traced threads have exited */
+    if ((p_trace != NULL) && (trace_write_chrome(p_trace) == false))
+    {
+        is_success = false;
+    }
 
-    /* The application asked the MC to disable output port */
-    assert(OMX_ErrorNone ==
-           OMX_SendCommand(handle, OMX_CommandPortDisable, 1, NULL));
+    scheduler_deinit(&scheduler);
 
-    /* When all output buffers have been returned and OMX_FreeBuffer called,
-     * the MC can complete the port disablement */
-    sem_wait(&omx_data.smp_port_disabled);
-
-    /* Change workflow of FillBufferDone callback */
-    omx_data.port_disabled = true;
-
-    /* The application asked the MC to enable the disabled output port */
-    assert(OMX_ErrorNone ==
-           OMX_SendCommand(handle, OMX_CommandPortEnable, 1, NULL));
-
-    /* The application provides to the MC all buffers that output port needs */
-    pp_out_bufs = omx_alloc_buffers(handle, 1);
-    assert(pp_out_bufs != NULL);
-
-    /* When all of the required buffers needed are available, the MC can
-     * complete the port enablement */
-    sem_wait(&omx_data.smp_port_enabled);
-
-    /**************************************************************************
-     *                         STEP 8: START DECODING                         *
-     **************************************************************************/
-
-    /* Send new output buffers to output port */
-    assert(omx_fill_buffers(handle, pp_out_bufs, OUT_BUFFER_COUNT));
-
-    /* Wait until EOS event occurs */
-    sem_wait(&omx_data.smp_eos);
-
-    /**************************************************************************
-     *                          STEP 9: CLEAN UP OMX                          *
-     **************************************************************************/
-
-    /* Transition back to idle state */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
-                                            OMX_StateIdle, NULL));
-    omx_wait_state(handle, OMX_StateIdle);
-
-    /* Transition back to loaded state */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
-                                            OMX_StateLoaded, NULL));
-
-    /* Free output buffers */
-    omx_dealloc_all_port_bufs(handle, 1, pp_out_bufs);
-
-    /* Free input buffers */
-    omx_dealloc_all_port_bufs(handle, 0, pp_in_bufs);
-
-    /* Wait until the component is in state LOADED */
-    omx_wait_state(handle, OMX_StateLoaded);
-
-    /* Free the component's handle */
-    assert(OMX_FreeHandle(handle) == OMX_ErrorNone);
-
-    /* Deinitialize OMX IL core */
-    assert(OMX_Deinit() == OMX_ErrorNone);
-
-    /**************************************************************************
-     *                      STEP 10: CLEAN UP GSTREAMER                       *
-     **************************************************************************/
-
-    gst_element_set_state(p_pipeline, GST_STATE_NULL);
-    gst_object_unref(p_pipeline);
-
-    /**************************************************************************
-     *                 STEP 11: CLOSE INPUT AND OUTPUT FILES                  *
-     **************************************************************************/
-
-    /* Close output file */
-    fclose(omx_data.p_out_file);
-
-    /* Close input file */
-    fclose(omx_data.p_in_file);
-
-    return 0;
-}
+    return is_success ? 0 : -1;
+}
 
 /******************************************************************************
  *                           OMX CALLBACK HANDLERS                            *
@@ -384,7 +749,10 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
 
     omx_data_t * p_data = (omx_data_t *)pAppData;
 
-    char * p_state_str = NULL;
+    const char * p_state_str = NULL;
+
+    /* Start of the callback in the trace (0 if tracing is disabled) */
+    uint64_t trace_ns = trace_now();
 
     switch (eEvent)
     {
@@ -392,19 +760,25 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
         {
             if (nData1 == OMX_CommandStateSet)
             {
+                /* Wake up 'omx_wait_state' */
+                omx_state_notify(&p_data->state, (OMX_STATETYPE)nData2);
+
                 p_state_str = omx_state_to_str((OMX_STATETYPE)nData2);
-                if (p_state_str != NULL)
+                if (p_data->verbose && (p_state_str != NULL))
                 {
                     /* Print OMX state */
-                    printf("OMX state: '%s'\n", p_state_str);
-                    free(p_state_str);
+                    LOG_INFO("OMX state: '%s'\n", p_state_str);
                 }
             }
             else if (nData1 == OMX_CommandPortEnable)
             {
                 if (nData2 == 1) /* Output port */
                 {
-                    printf("Output port is enabled\n");
+                    if (p_data->verbose)
+                    {
+                        LOG_INFO("Output port is enabled\n");
+                    }
+
                     sem_post(&p_data->smp_port_enabled);
                 }
             }
@@ -412,7 +786,11 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
             {
                 if (nData2 == 1) /* Output port */
                 {
-                    printf("Output port is disabled\n");
+                    if (p_data->verbose)
+                    {
+                        LOG_INFO("Output port is disabled\n");
+                    }
+
                     sem_post(&p_data->smp_port_disabled);
                 }
             }
@@ -423,8 +801,15 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
         {
             if (nData1 == 1) /* Output port */
             {
-                printf("OMX event: 'Output port settings changed'\n");
-                sem_post(&p_data->smp_port_settings_changed);
+                if (p_data->verbose)
+                {
+                    LOG_INFO("OMX event: 'Output port settings changed'\n");
+                }
+
+                /* The MC may send it again later (new resolution) */
+                p_data->settings_changed = true;
+
+                sem_post(&p_data->smp_event);
             }
         }
         break;
@@ -434,14 +819,27 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
             if (nData1 == OMX_BUFFERFLAG_EOS)
             {
                 /* The buffer contains the last output picture data */
-                printf("OMX event: 'End-of-Stream'\n");
+                if (p_data->verbose)
+                {
+                    LOG_INFO("OMX event: 'End-of-Stream'\n");
+                }
 
-                sem_post(&p_data->smp_eos);
                 p_data->eos = true;
+                sem_post(&p_data->smp_event);
             }
         }
         break;
 
+        case OMX_EventError:
+        {
+            /* Section 2.1.2 in document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
+            LOG_ERROR("OMX error event: '0x%x'\n", nData1);
+
+            /* Wake up 'omx_wait_state' if the error fails a transition */
+            omx_state_notify_error(&p_data->state, (OMX_ERRORTYPE)nData1);
+        }
+        break;
+
         default:
         {
             /* Intentionally left blank */
@@ -449,6 +847,8 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
         break;
     }
 
+    trace_record(TRACE_EVENT_EVENT_HANDLER, trace_ns, eEvent, nData1);
+
     return OMX_ErrorNone;
 }
 
@@ -458,17 +858,38 @@ OMX_ERRORTYPE omx_empty_buffer_done(OMX_HANDLETYPE hComponent,
 {
     omx_data_t * p_data = (omx_data_t *)pAppData;
 
+    /* Start of the callback in the trace (0 if tracing is disabled) */
+    uint64_t trace_ns = trace_now();
+
     /* Check parameter */
     assert(p_data != NULL);
 
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    bench_on_empty_buffer_done(p_data->p_bench, pBuffer);
+
+    if (pBuffer != NULL)
+    {
+        omx_buf_move(pBuffer, OMX_BUF_OWNER_MC, OMX_BUF_OWNER_APP);
+    }
+
     if ((p_data->eos == false) && (pBuffer != NULL))
     {
-        /* Add buffer back to the input port when EOS event does not occur */
-        setup_in_buf(p_data->p_appsink, pBuffer);
-        assert(OMX_EmptyThisBuffer(hComponent, pBuffer) == OMX_ErrorNone);
+        /* Hand the buffer to the feeder thread when EOS event does not occur.
+         * The queue is never full because it can hold all input buffers */
+        assert(queue_push(&p_data->in_buf_queue, pBuffer));
+        sem_post(&p_data->smp_in_buf);
     }
 
-    printf("EmptyBufferDone exited\n");
+    if (p_data->verbose)
+    {
+        LOG_DEBUG("EmptyBufferDone exited\n");
+    }
+
+    trace_record(TRACE_EVENT_EMPTY_BUFFER_DONE, trace_ns,
+                 (uintptr_t)pBuffer, 0);
+
     return OMX_ErrorNone;
 }
 
@@ -478,31 +899,70 @@ OMX_ERRORTYPE omx_fill_buffer_done(OMX_HANDLETYPE hComponent,
 {
     omx_data_t * p_data = (omx_data_t *)pAppData;
 
+    /* Start of the callback in the trace (0 if tracing is disabled) and
+     * length of the frame (the buffer may be refilled before returning) */
+    uint64_t trace_ns   = trace_now();
+    OMX_U32  filled_len = (pBuffer != NULL) ? pBuffer->nFilledLen : 0;
+
     /* Check parameter */
     assert(p_data != NULL);
 
-    if (p_data->port_disabled == false)
+    bench_on_fill_buffer_done(p_data->p_bench, pBuffer);
+
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    if (pBuffer != NULL)
     {
-        /* The application asked the MC to disable output port.
-         * Then, the MC will return the buffers via FillBufferDone callback.
-         * For each buffer returned, the application will call OMX_FreeBuffer */
-        OMX_FreeBuffer(hComponent, 1, pBuffer);
+        omx_buf_move(pBuffer, OMX_BUF_OWNER_MC, OMX_BUF_OWNER_APP);
     }
-    else if ((p_data->eos == false) && (pBuffer != NULL))
+
+    if ((p_data->eos == false) && (pBuffer != NULL))
     {
-        if (pBuffer->nFilledLen > 0)
+        if ((pBuffer->nFilledLen == 0) && (p_data->out_port_ready == false))
         {
-            fwrite(pBuffer->pBuffer, 1, pBuffer->nFilledLen, p_data->p_out_file);
+            /* The application asked the MC to disable output port.
+             * Then, the MC returns its buffers via FillBufferDone callback.
+             * They are freed once all buffers are back ('reconfig_out_port') */
+            sem_post(&p_data->smp_out_buf_returned);
         }
+        else
+        {
+            if (pBuffer->nFilledLen > 0)
+            {
+                if (p_data->frame_count == 0)
+                {
+                    p_data->first_frame_ns = omx_get_time_ns();
+                }
+
+                p_data->frame_count++;
+            }
 
-        pBuffer->nFlags     = 0;
-        pBuffer->nFilledLen = 0;
+            /* The writer copies the frame and then calls 'release_out_buf'
+             * to add the buffer back to the output port (frames decoded
+             * before a change of settings are written too). The exporter
+             * calls it when the consumer has released the frame */
+            omx_buf_move(pBuffer, OMX_BUF_OWNER_APP, OMX_BUF_OWNER_IO);
+
+            if (p_data->use_export)
+            {
+                exporter_push(&p_data->exporter, pBuffer);
+            }
+            else
+            {
+                writer_push(&p_data->writer, pBuffer);
+            }
+        }
+    }
 
-        /* Add buffer back to the output port when EOS event does not occur */
-        assert(OMX_FillThisBuffer(hComponent, pBuffer) == OMX_ErrorNone);
+    if (p_data->verbose)
+    {
+        LOG_DEBUG("FillBufferDone callback.\n");
     }
 
-    printf("FillBufferDone callback.\n");
+    trace_record(TRACE_EVENT_FILL_BUFFER_DONE, trace_ns,
+                 (uintptr_t)pBuffer, filled_len);
+
     return OMX_ErrorNone;
 }
 
@@ -510,34 +970,1301 @@ OMX_ERRORTYPE omx_fill_buffer_done(OMX_HANDLETYPE hComponent,
  *                                 FUNCTIONS                                  *
  ******************************************************************************/
 
-OMX_U32 setup_in_buf(GstElement * p_appsink, OMX_BUFFERHEADERTYPE * p_in_buf)
+bool decode_file(const char * p_in_file_name, const char * p_out_file_name,
+                 const decode_cfg_t * p_cfg, uint64_t * p_frame_count)
 {
-    GstSample * p_gst_sample = NULL;
-    GstBuffer * p_gst_buffer = NULL;
+    /* Handle of the MC */
+    OMX_HANDLETYPE handle;
 
-    GstMapInfo gst_map;
+    /* Callbacks used by the MC */
+    OMX_CALLBACKTYPE callbacks =
+    {
+        .EventHandler    = omx_event_handler,
+        .EmptyBufferDone = omx_empty_buffer_done,
+        .FillBufferDone  = omx_fill_buffer_done
+    };
 
-    p_gst_sample = gst_app_sink_pull_sample(GST_APP_SINK(p_appsink));
+    /* Buffers of input and output ports */
+    OMX_BUFFERHEADERTYPE ** pp_in_bufs  = NULL;
+    OMX_BUFFERHEADERTYPE ** pp_out_bufs = NULL;
 
-    if (p_gst_sample == NULL)
+    /* Definitions of input port and output port (at the end of decoding) */
+    OMX_PARAM_PORTDEFINITIONTYPE in_port;
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+
+    /* First SPS of input file. If it is found, output port is sized before
+     * any buffer is allocated */
+    annexb_sps_t sps;
+    bool has_sps = false;
+
+    /* Always false for the first output buffers (nothing to reuse) */
+    bool reused = false;
+
+    /* False if the decode stopped on an error */
+    bool is_success = true;
+
+    /* Iterator */
+    int index = 0;
+
+    /* Shared data between OMX's callbacks (one per decode, so that several
+     * decodes can run at the same time) */
+    omx_data_t * p_data = NULL;
+
+    /* Benchmark of the decode (if 'p_bench_file' or 'p_tune_result' is
+     * set) */
+    bench_t bench;
+
+    /* The number of buffers of input and output ports */
+    uint32_t in_buf_cnt  = 0;
+    uint32_t out_buf_cnt = 0;
+
+#ifdef USE_GSTREAMER
+    /* GStreamer pipeline and elements */
+    GstElement * p_pipeline   = NULL;
+    GstElement * p_filesrc    = NULL;
+    GstElement * p_h264parse  = NULL;
+    GstElement * p_capsfilter = NULL;
+    GstElement * p_appsink    = NULL;
+
+    GstCaps * p_caps = NULL;
+#endif
+
+    /* Time (in ns) taken to start the MC, to decode the first frame and to
+     * tear down the MC */
+    uint64_t start_ns       = 0;
+    uint64_t startup_ns     = 0;
+    uint64_t first_frame_ns = 0;
+    uint64_t teardown_ns    = 0;
+
+    /* Check parameters */
+    assert((p_in_file_name != NULL) && (p_out_file_name != NULL));
+    assert(p_cfg != NULL);
+
+    p_data = (omx_data_t *)calloc(1, sizeof(omx_data_t));
+    assert(p_data != NULL);
+
+    p_data->verbose  = p_cfg->verbose;
+    p_data->out_fmt  = p_cfg->out_fmt;
+    p_data->use_ring = p_cfg->ring;
+
+    p_data->use_export = (p_cfg->p_export_path != NULL);
+
+    in_buf_cnt  = p_cfg->bufs.in_buf_cnt;
+    out_buf_cnt = p_cfg->bufs.out_buf_cnt;
+
+    /**************************************************************************
+     *                  STEP 1: OPEN INPUT AND OUTPUT FILES                   *
+     **************************************************************************/
+
+#ifdef USE_GSTREAMER
+    /* The decode fails (other decodes go on) if input file cannot be read */
+    p_data->p_in_file = fopen(p_in_file_name, "rb");
+    if (p_data->p_in_file == NULL)
     {
-        p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
-        p_in_buf->nFilledLen = 0;
+        printf("Error: Failed to open '%s'\n", p_in_file_name);
+
+        free(p_data);
+        return false;
     }
-    else
+
+    /* Set file position indicator of input file to the end of file */
+    fseek(p_data->p_in_file, 0, SEEK_END);
+
+    /* Stop the decode if the input file is empty */
+    if (ftell(p_data->p_in_file) == 0)
     {
-        p_gst_buffer = gst_sample_get_buffer(p_gst_sample);
-        assert(gst_buffer_map(p_gst_buffer, &gst_map, GST_MAP_READ) == TRUE);
+        printf("Error: '%s' is empty\n", p_in_file_name);
 
-        /* Put H.264 data to input buffer */
-        memcpy(p_in_buf->pBuffer, gst_map.data, gst_map.size);
+        fclose(p_data->p_in_file);
+        free(p_data);
+        return false;
+    }
 
-        p_in_buf->nFilledLen = gst_map.size;
-        p_in_buf->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    /* Set file position indicator of input file to the beginning of file */
+    fseek(p_data->p_in_file, 0, SEEK_SET);
+#else
+    /* Map input file. The decode fails (other decodes go on) if it cannot
+     * be read or is empty */
+    if (!annexb_open(&p_data->annexb, p_in_file_name))
+    {
+        free(p_data);
+        return false;
+    }
+#endif
+
+    /* Read the picture size from the SPS (without it, the size is only known
+     * when 'OMX_EventPortSettingsChanged' event occurs) */
+#ifdef USE_GSTREAMER
+    has_sps = read_sps(p_in_file_name, &sps);
+#else
+    has_sps = annexb_parse_sps(&p_data->annexb, &sps);
+#endif
+
+    /* The MC holds up to 'max_num_ref_frames' frames for reference while it
+     * decodes into another buffer */
+    if (has_sps && (out_buf_cnt < (sps.max_num_ref_frames + 1)))
+    {
+        out_buf_cnt = sps.max_num_ref_frames + 1;
+    }
 
-        /* Unmap the buffer data */
-        gst_buffer_unmap(p_gst_buffer, &gst_map);
+    /* The writer, the exporter and the benchmark follow at most
+     * 'OUT_MAX_BUFFER_COUNT' output buffers */
+    if (out_buf_cnt > OUT_MAX_BUFFER_COUNT)
+    {
+        printf("Warning: %u output buffers requested, %d are used\n",
+               out_buf_cnt, OUT_MAX_BUFFER_COUNT);
+
+        out_buf_cnt = OUT_MAX_BUFFER_COUNT;
     }
 
-    return p_in_buf->nFlags;
+    /* With a ring or exported buffers, no output file is written. The
+     * writer and the exporter can hold every buffer output port may get */
+    if (!writer_open(&p_data->writer,
+                     (p_data->use_ring || p_data->use_export) ?
+                     NULL : p_out_file_name,
+                     OUT_MAX_BUFFER_COUNT, OUT_STAGE_SIZE, OUT_DIRECT_IO))
+    {
+#ifdef USE_GSTREAMER
+        fclose(p_data->p_in_file);
+#else
+        annexb_close(&p_data->annexb);
+#endif
+        free(p_data);
+        return false;
+    }
+
+    if (p_data->use_export)
+    {
+        assert(exporter_open(&p_data->exporter, p_cfg->p_export_path,
+                             OUT_MAX_BUFFER_COUNT));
+
+        /* FillBufferDone hands decoded frames to the exporter (instead of
+         * the writer), which sends them to the consumer */
+        assert(exporter_start(&p_data->exporter, release_out_buf, p_data));
+
+        printf("Exporter: consumer connects to '%s'\n", p_cfg->p_export_path);
+        fflush(stdout);
+
+        if (!exporter_wait_client(&p_data->exporter, EXPORT_WAIT_CLIENT_MS))
+        {
+            printf("Warning: No consumer after %d ms, frames are dropped "
+                   "until one connects\n", EXPORT_WAIT_CLIENT_MS);
+        }
+    }
+
+    if (p_data->use_ring)
+    {
+        assert(shmring_create(&p_data->ring, RING_SLOT_COUNT, RING_SLOT_SIZE,
+                              p_cfg->ring_policy));
+
+        writer_set_ring(&p_data->writer, &p_data->ring);
+
+        /* Consumers open the memfd through the file descriptor of this
+         * process */
+        printf("Ring: consumers open '/proc/%d/fd/%d' (%d slots, policy "
+               "'%s')\n", (int)getpid(), p_data->ring.fd, RING_SLOT_COUNT,
+               (p_cfg->ring_policy == SHMRING_POLICY_DROP) ? "drop" : "block");
+        fflush(stdout);
+
+        if ((p_cfg->ring_policy == SHMRING_POLICY_BLOCK) &&
+            !shmring_wait_reader(&p_data->ring, RING_WAIT_READER_MS))
+        {
+            printf("Warning: No consumer of the ring after %d ms, "
+                   "frames are overwritten until one attaches\n",
+                   RING_WAIT_READER_MS);
+        }
+    }
+
+    /* The files are open: prepare the decode */
+    if ((p_cfg->p_bench_file != NULL) || (p_cfg->p_tune_result != NULL))
+    {
+        assert(bench_init(&bench, "decoder", BENCH_MAX_SAMPLES, false));
+        p_data->p_bench = &bench;
+    }
+
+    p_data->eos = false;
+    p_data->settings_changed = false;
+    p_data->out_port_ready = false;
+
+    pthread_mutex_init(&p_data->out_mutex, NULL);
+
+    atomic_init(&p_data->feeder_stop, false);
+
+    omx_state_init(&p_data->state);
+
+    /* Prepare the semaphores */
+    sem_init(&p_data->smp_event, 0, 0);
+    sem_init(&p_data->smp_port_disabled, 0, 0);
+    sem_init(&p_data->smp_port_enabled, 0, 0);
+    sem_init(&p_data->smp_out_buf_returned, 0, 0);
+    sem_init(&p_data->smp_in_buf, 0, 0);
+
+    /* The queue never holds more than 'in_buf_cnt' buffers */
+    assert(queue_init(&p_data->in_buf_queue, in_buf_cnt));
+
+    if (p_data->out_fmt != CONVERT_FMT_NV12)
+    {
+        assert(convert_init(&p_data->convert, p_data->out_fmt,
+                            OUT_CONVERT_THREADS));
+    }
+
+    /**************************************************************************
+     *  STEP 2: SET UP GSTREAMER PIPELINE (FILESRC -> H264PARSE -> APPSINK)   *
+     **************************************************************************/
+
+#ifdef USE_GSTREAMER
+    /* Create an empty pipeline */
+    p_pipeline = gst_pipeline_new(NULL);
+
+    /* Create elements */
+    p_filesrc    = gst_element_factory_make("filesrc",   NULL);
+    p_h264parse  = gst_element_factory_make("h264parse", NULL);
+    p_capsfilter = gst_element_factory_make("capsfilter", NULL);
+    p_appsink    = gst_element_factory_make("appsink", NULL);
+
+    assert(p_pipeline && p_filesrc && p_h264parse && p_capsfilter && p_appsink);
+    p_data->p_appsink = p_appsink;
+
+    /* Set properties for 'filesrc' element */
+    g_object_set(G_OBJECT(p_filesrc), "location", p_in_file_name, NULL);
+
+    /* Set properties for 'capsfilter' element */
+    p_caps = gst_caps_new_simple("video/x-h264",
+                                 "stream-format", G_TYPE_STRING, "byte-stream",
+                                 "alignment", G_TYPE_STRING, "au", NULL);
+
+    g_object_set(G_OBJECT(p_capsfilter), "caps", p_caps, NULL);
+    gst_caps_unref(p_caps);
+
+    /* Add and link the elements to the pipeline */
+    gst_bin_add_many(GST_BIN(p_pipeline),
+                     p_filesrc, p_h264parse, p_capsfilter, p_appsink, NULL);
+
+    assert(gst_element_link_many(p_filesrc, p_h264parse,
+                                 p_capsfilter, p_appsink, NULL));
+#else
+    /* Nothing to do: the built-in parser reads the mapping of input file */
+#endif
+
+    /**************************************************************************
+     *                         STEP 3: SET UP OMX IL                          *
+     **************************************************************************/
+
+    start_ns = omx_get_time_ns();
+
+    /* Locate Renesas's H.264 decoder.
+     * If successful, the MC will be in state LOADED */
+    assert(OMX_ErrorNone == OMX_GetHandle(&handle,
+                                          RENESAS_VIDEO_DECODER_NAME,
+                                          (OMX_PTR)p_data, &callbacks));
+
+    p_data->handle = handle;
+
+    /* From now, FillBufferDone can hand decoded frames to the writer */
+    assert(writer_start(&p_data->writer, release_out_buf, p_data));
+
+    /* Configure input port */
+    assert(omx_set_port_buf_cnt(handle, 0, in_buf_cnt));
+
+    /* Configure output port */
+    assert(set_out_port(handle, has_sps ? &sps : NULL));
+
+    assert(omx_set_port_buf_cnt(handle, 1, out_buf_cnt));
+
+    if (has_sps)
+    {
+        /* The first buffers already fit the decoded frames */
+        set_out_layout(p_data);
+        p_data->out_port_ready = true;
+
+        if (p_data->verbose)
+        {
+            LOG_INFO("Output port: %ux%u (from SPS), %u buffers\n",
+                     sps.width, sps.height, out_buf_cnt);
+        }
+    }
+
+    /* Transition into state IDLE */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+
+    /**************************************************************************
+     *               STEP 4: ALLOCATE INPUT AND OUTPUT BUFFERS                *
+     **************************************************************************/
+
+    pp_in_bufs = omx_alloc_buffers(handle, 0);
+    assert(pp_in_bufs != NULL);
+
+    pp_out_bufs = get_out_bufs(p_data, out_buf_cnt, &reused);
+    assert(pp_out_bufs != NULL);
+
+    if (p_data->use_export)
+    {
+        exporter_set_bufs(&p_data->exporter, pp_out_bufs,
+                          p_data->p_out_dmabufs, out_buf_cnt);
+
+        if (p_data->verbose)
+        {
+            LOG_INFO("Exporter: %u output buffers exported (%s)\n",
+                     out_buf_cnt,
+                     dmabuf_kind_to_str(p_data->p_out_dmabufs[0].kind));
+        }
+    }
+
+    assert(omx_wait_state(handle, &p_data->state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    /**************************************************************************
+     *                         STEP 5: START DECODING                         *
+     **************************************************************************/
+
+    /* Transition into state EXECUTING */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
+                                            OMX_StateExecuting, NULL));
+    assert(omx_wait_state(handle, &p_data->state,
+                          OMX_StateExecuting, STATE_TIMEOUT_MS));
+
+    startup_ns = omx_get_time_ns() - start_ns;
+
+#ifdef USE_GSTREAMER
+    /* Play the pipeline */
+    gst_element_set_state(p_pipeline, GST_STATE_PLAYING);
+#endif
+
+    /* Send output buffers to output port */
+    for (index = 0; index < (int)out_buf_cnt; index++)
+    {
+        bench_on_fill_this_buffer(p_data->p_bench, pp_out_bufs[index]);
+    }
+
+    assert(omx_fill_buffers(handle, pp_out_bufs, out_buf_cnt));
+
+    /* Hand all input buffers to the feeder thread. It fills them with data
+     * and sends them to input port */
+    for (index = 0; index < (int)in_buf_cnt; index++)
+    {
+        assert(queue_push(&p_data->in_buf_queue, pp_in_bufs[index]));
+        sem_post(&p_data->smp_in_buf);
+    }
+
+    assert(pthread_create(&p_data->feeder_thread, NULL,
+                          feeder_thread_func, p_data) == 0);
+
+    /**************************************************************************
+     *                  STEP 6: WAIT UNTIL EOS EVENT OCCURS                   *
+     **************************************************************************/
+
+    while (true)
+    {
+        sem_wait(&p_data->smp_event);
+
+        if (p_data->eos)
+        {
+            break;
+        }
+
+        if (p_data->settings_changed)
+        {
+            /* Fallback when output port could not be sized from the SPS
+             * (or the MC chose other settings) */
+            p_data->settings_changed = false;
+
+            pp_out_bufs = reconfig_out_port(p_data, pp_out_bufs,
+                                            &out_buf_cnt);
+            if (pp_out_bufs == NULL)
+            {
+                printf("Error: Failed to reconfigure output port\n");
+
+                is_success = false;
+                break;
+            }
+        }
+    }
+
+    if (p_data->frame_count > 0)
+    {
+        first_frame_ns = p_data->first_frame_ns - start_ns;
+    }
+
+    /* Stop the feeder thread (it may still wait for a returned buffer) */
+    atomic_store(&p_data->feeder_stop, true);
+    sem_post(&p_data->smp_in_buf);
+
+    pthread_join(p_data->feeder_thread, NULL);
+
+    if (p_data->in_failed)
+    {
+        printf("Error: Input data did not fit in input buffers, "
+               "the decode stopped early\n");
+
+        is_success = false;
+    }
+
+    /* Write remaining decoded frames. The writer does not send any buffer
+     * to output port after this point */
+    if (!writer_close(&p_data->writer))
+    {
+        is_success = false;
+    }
+
+    if (p_data->use_ring)
+    {
+        /* Consumers read the last frames from their own mapping */
+        shmring_close(&p_data->ring);
+    }
+
+    if (p_data->use_export)
+    {
+        /* Send the last frames and wait for the consumer to release them */
+        exporter_close(&p_data->exporter);
+    }
+
+    if (p_cfg->p_tune_result != NULL)
+    {
+        /* Memory taken by the buffers of both ports */
+        assert(omx_get_port(handle, 0, &in_port));
+        assert(omx_get_port(handle, 1, &out_port));
+
+        p_cfg->p_tune_result->mem_bytes =
+            ((uint64_t)in_port.nBufferCountActual * in_port.nBufferSize) +
+            ((uint64_t)out_port.nBufferCountActual * out_port.nBufferSize);
+    }
+
+    if (p_data->out_fmt != CONVERT_FMT_NV12)
+    {
+        convert_deinit(&p_data->convert);
+    }
+
+    /**************************************************************************
+     *                          STEP 7: CLEAN UP OMX                          *
+     **************************************************************************/
+
+    start_ns = omx_get_time_ns();
+
+    /* Transition back to idle state */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+    assert(omx_wait_state(handle, &p_data->state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    /* Transition back to loaded state */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
+                                            OMX_StateLoaded, NULL));
+
+    /* Statistics of the buffers (before they are freed) */
+    omx_add_buf_stats(pp_in_bufs, in_buf_cnt, &p_data->in_buf_stats);
+
+    /* Free output buffers (if a failed reconfiguration has not already
+     * freed them) */
+    if (pp_out_bufs != NULL)
+    {
+        omx_add_buf_stats(pp_out_bufs, out_buf_cnt, &p_data->out_buf_stats);
+        omx_dealloc_all_port_bufs(handle, 1, pp_out_bufs);
+    }
+
+    /* Free input buffers */
+    omx_dealloc_all_port_bufs(handle, 0, pp_in_bufs);
+
+    /* Wait until the component is in state LOADED */
+    assert(omx_wait_state(handle, &p_data->state,
+                          OMX_StateLoaded, STATE_TIMEOUT_MS));
+
+    /* Free the component's handle */
+    assert(OMX_FreeHandle(handle) == OMX_ErrorNone);
+
+    /* No buffer header uses the memory of output buffers any more */
+    free_out_mem(p_data);
+
+    teardown_ns = omx_get_time_ns() - start_ns;
+
+    omx_state_deinit(&p_data->state);
+
+    /**************************************************************************
+     *                       STEP 8: CLEAN UP GSTREAMER                       *
+     **************************************************************************/
+
+#ifdef USE_GSTREAMER
+    gst_element_set_state(p_pipeline, GST_STATE_NULL);
+    gst_object_unref(p_pipeline);
+#endif
+
+    queue_deinit(&p_data->in_buf_queue);
+
+    /**************************************************************************
+     *                 STEP 9: CLOSE INPUT AND OUTPUT FILES                   *
+     **************************************************************************/
+
+    /* Output file was closed by 'writer_close'. Events of this decode are
+     * printed before its statistics */
+    logger_flush();
+
+    if (p_data->verbose)
+    {
+        if (p_data->use_export)
+        {
+            exporter_print_stats(&p_data->exporter);
+        }
+        else
+        {
+            writer_print_stats(&p_data->writer);
+        }
+
+        if (p_data->use_ring)
+        {
+            shmring_print_stats(&p_data->ring);
+        }
+
+        if (p_data->out_fmt != CONVERT_FMT_NV12)
+        {
+            convert_print_stats(&p_data->convert);
+        }
+
+        if (p_data->reconfig_count > 0)
+        {
+            printf("Output port: %u changes of settings, %u of them reused "
+                   "the memory of output buffers\n",
+                   p_data->reconfig_count, p_data->reuse_count);
+        }
+
+        omx_print_buf_stats("input port", &p_data->in_buf_stats);
+        omx_print_buf_stats("output port", &p_data->out_buf_stats);
+
+        printf("Timing: startup %.3f ms (OMX_GetHandle to Executing), "
+               "first frame %.3f ms (OMX_GetHandle to FillBufferDone), "
+               "teardown %.3f ms (Executing to OMX_FreeHandle)\n",
+               startup_ns / 1e6, first_frame_ns / 1e6, teardown_ns / 1e6);
+    }
+
+    /* Close input file */
+#ifdef USE_GSTREAMER
+    fclose(p_data->p_in_file);
+#else
+    annexb_close(&p_data->annexb);
+
+    if (p_data->verbose)
+    {
+        printf("Parser: %llu access units, %llu NAL units, "
+               "largest AU %zu bytes\n",
+               (unsigned long long)p_data->annexb.au_count,
+               (unsigned long long)p_data->annexb.nal_count,
+               p_data->annexb.au_size_max);
+    }
+#endif
+
+    if (p_data->p_bench != NULL)
+    {
+        if (p_cfg->p_tune_result != NULL)
+        {
+            bench_get_summary(p_data->p_bench, &p_cfg->p_tune_result->fps,
+                              &p_cfg->p_tune_result->p99_ms);
+        }
+
+        if ((p_cfg->p_bench_file != NULL) &&
+            bench_write_report(p_data->p_bench, p_cfg->p_bench_file) &&
+            (strcmp(p_cfg->p_bench_file, "-") != 0))
+        {
+            printf("Bench: report written to '%s'\n", p_cfg->p_bench_file);
+        }
+
+        bench_deinit(p_data->p_bench);
+    }
+
+    *p_frame_count = p_data->frame_count;
+
+    free(p_data);
+
+    return is_success;
+}
+
+
+
+bool decode_job(scheduler_job_t * p_job, void * p_ctx)
+{
+    /* Check parameters */
+    assert((p_job != NULL) && (p_ctx != NULL));
+
+    return decode_file(p_job->in_file_name, p_job->out_file_name,
+                       (const decode_cfg_t *)p_ctx, &p_job->frame_count);
+}
+
+bool get_min_buf_counts(tuner_profile_t * p_min)
+{
+    OMX_HANDLETYPE handle;
+
+    OMX_CALLBACKTYPE callbacks =
+    {
+        .EventHandler    = omx_event_handler,
+        .EmptyBufferDone = omx_empty_buffer_done,
+        .FillBufferDone  = omx_fill_buffer_done
+    };
+
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+
+    /* First SPS of 'IN_FILE_NAME' */
+    annexb_sps_t sps;
+    bool has_sps = false;
+
+    bool is_success = true;
+
+    /* Check parameter */
+    assert(p_min != NULL);
+
+    has_sps = read_sps(IN_FILE_NAME, &sps);
+
+    /* No command is sent, so the callbacks are never called */
+    if (OMX_GetHandle(&handle, RENESAS_VIDEO_DECODER_NAME,
+                      NULL, &callbacks) != OMX_ErrorNone)
+    {
+        printf("Error: Failed to get handle of '%s'\n",
+               RENESAS_VIDEO_DECODER_NAME);
+        return false;
+    }
+
+    /* Output port is configured as in 'decode_file' */
+    if (set_out_port(handle, has_sps ? &sps : NULL) &&
+        omx_get_port(handle, 0, &port))
+    {
+        p_min->in_buf_cnt = port.nBufferCountMin;
+    }
+    else
+    {
+        is_success = false;
+    }
+
+    if (is_success && omx_get_port(handle, 1, &port))
+    {
+        p_min->out_buf_cnt = port.nBufferCountMin;
+
+        /* 'decode_file' never uses fewer buffers */
+        if (has_sps && (p_min->out_buf_cnt < (sps.max_num_ref_frames + 1)))
+        {
+            p_min->out_buf_cnt = sps.max_num_ref_frames + 1;
+        }
+
+        if (p_min->out_buf_cnt > OUT_MAX_BUFFER_COUNT)
+        {
+            p_min->out_buf_cnt = OUT_MAX_BUFFER_COUNT;
+        }
+    }
+    else
+    {
+        is_success = false;
+    }
+
+    assert(OMX_FreeHandle(handle) == OMX_ErrorNone);
+
+    return is_success;
+}
+
+bool tune_buffers(const decode_cfg_t * p_cfg, const char * p_out_file_name,
+                  const char * p_profile_file)
+{
+    tuner_t * p_tuner = NULL;
+    tune_ctx_t ctx;
+
+    /* Range of buffer counts */
+    tuner_profile_t min;
+    tuner_profile_t max;
+
+    bool is_success = false;
+
+    /* Check parameters */
+    assert((p_cfg != NULL) && (p_out_file_name != NULL));
+    assert(p_profile_file != NULL);
+
+    if (get_min_buf_counts(&min) == false)
+    {
+        return false;
+    }
+
+    /* The benchmark follows up to 'BENCH_MAX_BUFFERS' buffers per port */
+    max.in_buf_cnt  = min.in_buf_cnt + TUNE_EXTRA_BUFFERS;
+    max.out_buf_cnt = min.out_buf_cnt + TUNE_EXTRA_BUFFERS;
+
+    if (max.in_buf_cnt > BENCH_MAX_BUFFERS)
+    {
+        max.in_buf_cnt = BENCH_MAX_BUFFERS;
+    }
+
+    if (max.out_buf_cnt > BENCH_MAX_BUFFERS)
+    {
+        max.out_buf_cnt = BENCH_MAX_BUFFERS;
+    }
+
+    printf("Tuner: '%s', input buffers %u-%u, output buffers %u-%u\n",
+           IN_FILE_NAME, min.in_buf_cnt, max.in_buf_cnt,
+           min.out_buf_cnt, max.out_buf_cnt);
+
+    ctx.p_cfg = p_cfg;
+    ctx.p_out_file_name = p_out_file_name;
+
+    p_tuner = (tuner_t *)malloc(sizeof(tuner_t));
+    assert(p_tuner != NULL);
+
+    if (tuner_sweep(p_tuner, &min, &max, tune_run, &ctx))
+    {
+        tuner_print_report(p_tuner);
+
+        is_success = tuner_save_profile(p_tuner, p_profile_file, "decoder");
+        if (is_success)
+        {
+            printf("Tuner: profile written to '%s'\n", p_profile_file);
+        }
+    }
+
+    free(p_tuner);
+
+    return is_success;
+}
+
+bool tune_run(const tuner_profile_t * p_profile, tuner_result_t * p_result,
+              void * p_ctx)
+{
+    tune_ctx_t * p_tune = (tune_ctx_t *)p_ctx;
+
+    /* Settings of this decode */
+    decode_cfg_t cfg;
+
+    uint64_t frame_count = 0;
+
+    /* Check parameters */
+    assert((p_profile != NULL) && (p_result != NULL) && (p_tune != NULL));
+
+    cfg = *p_tune->p_cfg;
+    cfg.bufs = *p_profile;
+    cfg.p_tune_result = p_result;
+
+    return decode_file(IN_FILE_NAME, p_tune->p_out_file_name,
+                       &cfg, &frame_count);
+}
+
+bool read_sps(const char * p_in_file_name, annexb_sps_t * p_sps)
+{
+    annexb_t annexb;
+    bool is_success = false;
+
+    /* Check parameters */
+    assert((p_in_file_name != NULL) && (p_sps != NULL));
+
+    if (annexb_open(&annexb, p_in_file_name))
+    {
+        is_success = annexb_parse_sps(&annexb, p_sps);
+        annexb_close(&annexb);
+    }
+
+    return is_success;
+}
+
+bool set_out_port(OMX_HANDLETYPE handle, const annexb_sps_t * p_sps)
+{
+    if (omx_set_out_port_fmt(handle, OMX_COLOR_FormatYUV420SemiPlanar) == false)
+    {
+        return false;
+    }
+
+    if (p_sps == NULL)
+    {
+        return true;
+    }
+
+    /* The MC decodes whole macroblocks, so the slice height is the coded
+     * height (the stride is rounded up by 'omx_set_out_port_size') */
+    return omx_set_out_port_size(handle, p_sps->width, p_sps->height,
+                                 p_sps->coded_height);
+}
+
+void set_out_layout(omx_data_t * p_data)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    /* No output buffer is held by the writer while the layout changes.
+     * The ring needs the layout even if frames are not packed */
+    if (!OUT_PACK_NV12 && !p_data->use_ring && !p_data->use_export &&
+        (p_data->out_fmt == CONVERT_FMT_NV12))
+    {
+        return;
+    }
+
+    assert(omx_get_port(p_data->handle, 1, &out_port));
+    assert(out_port.format.video.nStride > 0);
+
+    if (p_data->use_export)
+    {
+        /* The consumer reads frames in output buffers */
+        exporter_set_layout(&p_data->exporter,
+                            out_port.format.video.nFrameWidth,
+                            out_port.format.video.nFrameHeight,
+                            (uint32_t)out_port.format.video.nStride,
+                            out_port.format.video.nSliceHeight);
+        return;
+    }
+
+    if (p_data->out_fmt != CONVERT_FMT_NV12)
+    {
+        convert_set_layout(&p_data->convert,
+                           out_port.format.video.nFrameWidth,
+                           out_port.format.video.nFrameHeight,
+                           (uint32_t)out_port.format.video.nStride,
+                           out_port.format.video.nSliceHeight);
+
+        writer_set_convert(&p_data->writer, &p_data->convert);
+    }
+    else
+    {
+        writer_set_nv12_layout(&p_data->writer,
+                               out_port.format.video.nFrameWidth,
+                               out_port.format.video.nFrameHeight,
+                               (uint32_t)out_port.format.video.nStride,
+                               out_port.format.video.nSliceHeight);
+    }
+}
+
+OMX_BUFFERHEADERTYPE ** get_out_bufs(omx_data_t * p_data,
+                                     uint32_t out_buf_cnt, bool * p_reused)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert((p_data != NULL) && (p_reused != NULL));
+
+    *p_reused = false;
+
+    if (!OUT_REUSE_BUFFERS)
+    {
+        return omx_alloc_buffers(p_data->handle, 1);
+    }
+
+    if (omx_get_port(p_data->handle, 1, &out_port) == false)
+    {
+        return NULL;
+    }
+
+    if ((p_data->pp_out_mem != NULL) && (p_data->out_mem_cnt == out_buf_cnt) &&
+        (p_data->out_mem_size >= out_port.nBufferSize))
+    {
+        /* The frames still fit: keep the memory */
+        *p_reused = true;
+    }
+    else
+    {
+        free_out_mem(p_data);
+
+        p_data->out_mem_size = ROUND_UP(out_port.nBufferSize, OUT_BUFFER_ALIGN);
+        p_data->pp_out_mem = (OMX_U8 **)calloc(out_buf_cnt, sizeof(OMX_U8 *));
+        if (p_data->pp_out_mem == NULL)
+        {
+            return NULL;
+        }
+
+        p_data->out_mem_cnt = out_buf_cnt;
+
+        if (p_data->use_export)
+        {
+            /* The memory can be handed to the consumer as a file
+             * descriptor (see 'dmabuf.h') */
+            p_data->p_out_dmabufs = (dmabuf_t *)calloc(out_buf_cnt,
+                                                       sizeof(dmabuf_t));
+            if (p_data->p_out_dmabufs == NULL)
+            {
+                return NULL;
+            }
+
+            for (index = 0; index < out_buf_cnt; index++)
+            {
+                p_data->p_out_dmabufs[index].fd     = -1;
+                p_data->p_out_dmabufs[index].mem_fd = -1;
+            }
+        }
+
+        for (index = 0; index < out_buf_cnt; index++)
+        {
+            if (p_data->use_export)
+            {
+                if (!dmabuf_alloc(&p_data->p_out_dmabufs[index],
+                                  p_data->out_mem_size))
+                {
+                    printf("Error: Failed to allocate output buffer '%u'\n",
+                           index);
+                    return NULL;
+                }
+
+                p_data->pp_out_mem[index] =
+                    p_data->p_out_dmabufs[index].p_addr;
+            }
+            else if (posix_memalign((void **)&p_data->pp_out_mem[index],
+                               OUT_BUFFER_ALIGN, p_data->out_mem_size) != 0)
+            {
+                printf("Error: Failed to allocate output buffer '%u'\n",
+                       index);
+
+                p_data->pp_out_mem[index] = NULL;
+                return NULL;
+            }
+        }
+    }
+
+    return omx_use_buffers(p_data->handle, 1, p_data->pp_out_mem,
+                           p_data->out_mem_size);
+}
+
+void free_out_mem(omx_data_t * p_data)
+{
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    if (p_data->pp_out_mem == NULL)
+    {
+        return;
+    }
+
+    for (index = 0; index < p_data->out_mem_cnt; index++)
+    {
+        if (p_data->p_out_dmabufs != NULL)
+        {
+            dmabuf_free(&p_data->p_out_dmabufs[index]);
+        }
+        else
+        {
+            free(p_data->pp_out_mem[index]);
+        }
+    }
+
+    free(p_data->pp_out_mem);
+    free(p_data->p_out_dmabufs);
+
+    p_data->p_out_dmabufs = NULL;
+
+    p_data->pp_out_mem   = NULL;
+    p_data->out_mem_cnt  = 0;
+    p_data->out_mem_size = 0;
+}
+
+OMX_BUFFERHEADERTYPE ** reconfig_out_port(omx_data_t * p_data,
+                                          OMX_BUFFERHEADERTYPE ** pp_out_bufs,
+                                          uint32_t * p_out_buf_cnt)
+{
+    OMX_HANDLETYPE handle = NULL;
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+
+    uint32_t out_buf_cnt = 0;
+    uint32_t index = 0;
+    uint64_t start_ns = 0;
+    bool reused = false;
+
+    /* Check parameters */
+    assert((p_data != NULL) && (pp_out_bufs != NULL));
+    assert(p_out_buf_cnt != NULL);
+
+    handle      = p_data->handle;
+    out_buf_cnt = *p_out_buf_cnt;
+    start_ns    = omx_get_time_ns();
+
+    /* From now, the writer keeps the buffers it releases instead of sending
+     * them to output port */
+    pthread_mutex_lock(&p_data->out_mutex);
+    p_data->out_port_ready = false;
+    pthread_mutex_unlock(&p_data->out_mutex);
+
+    /* To disable and enable output port, the program follows steps in
+     * section 3.4.4.2: "Non-tunneled Port Disablement and Enablement" in
+     * OMX IL specification 1.1.2 */
+
+    /* The application asked the MC to disable output port */
+    assert(OMX_ErrorNone ==
+           OMX_SendCommand(handle, OMX_CommandPortDisable, 1, NULL));
+
+    /* Wait until every output buffer is back: the MC returns the buffers it
+     * holds, and the writer the frames decoded before the change once they
+     * are copied (or the consumer once it has read them). So, no frame is
+     * lost */
+    for (index = 0; index < out_buf_cnt; index++)
+    {
+        sem_wait(&p_data->smp_out_buf_returned);
+    }
+
+    if (p_data->use_export)
+    {
+        /* The consumer has released all frames: stop exporting the buffers
+         * before their memory may be freed */
+        exporter_set_bufs(&p_data->exporter, NULL, NULL, 0);
+    }
+
+    /* When all output buffers have been freed (only their headers if the
+     * memory belongs to the application), the MC can complete the port
+     * disablement */
+    omx_add_buf_stats(pp_out_bufs, out_buf_cnt, &p_data->out_buf_stats);
+    omx_dealloc_port_bufs(handle, 1, pp_out_bufs, out_buf_cnt);
+
+    sem_wait(&p_data->smp_port_disabled);
+
+    /* The new settings are known from now. The MC may need more buffers
+     * than before (for example, more reference frames at the new size) */
+    if (omx_get_port(handle, 1, &out_port) == false)
+    {
+        return NULL;
+    }
+
+    if (out_buf_cnt < out_port.nBufferCountMin)
+    {
+        out_buf_cnt = out_port.nBufferCountMin;
+    }
+
+    if (out_buf_cnt > OUT_MAX_BUFFER_COUNT)
+    {
+        printf("Error: Output port needs %u buffers (at most %d)\n",
+               out_buf_cnt, OUT_MAX_BUFFER_COUNT);
+        return NULL;
+    }
+
+    if (omx_set_port_buf_cnt(handle, 1, out_buf_cnt) == false)
+    {
+        return NULL;
+    }
+
+    *p_out_buf_cnt = out_buf_cnt;
+
+    set_out_layout(p_data);
+
+    /* The application asked the MC to enable the disabled output port */
+    if (OMX_SendCommand(handle, OMX_CommandPortEnable, 1, NULL) !=
+        OMX_ErrorNone)
+    {
+        printf("Error: Failed to enable output port\n");
+        return NULL;
+    }
+
+    /* The application provides to the MC all buffers that output port needs */
+    pp_out_bufs = get_out_bufs(p_data, out_buf_cnt, &reused);
+    if (pp_out_bufs == NULL)
+    {
+        printf("Error: Failed to get %u output buffers\n", out_buf_cnt);
+        return NULL;
+    }
+
+    if (p_data->use_export)
+    {
+        /* The consumer gets the new buffers before their first frame */
+        exporter_set_bufs(&p_data->exporter, pp_out_bufs,
+                          p_data->p_out_dmabufs, out_buf_cnt);
+    }
+
+    /* When all of the required buffers needed are available, the MC can
+     * complete the port enablement */
+    sem_wait(&p_data->smp_port_enabled);
+
+    pthread_mutex_lock(&p_data->out_mutex);
+    p_data->out_port_ready = true;
+    pthread_mutex_unlock(&p_data->out_mutex);
+
+    /* Send new output buffers to output port */
+    for (index = 0; index < out_buf_cnt; index++)
+    {
+        bench_on_fill_this_buffer(p_data->p_bench, pp_out_bufs[index]);
+    }
+
+    assert(omx_fill_buffers(handle, pp_out_bufs, out_buf_cnt));
+
+    p_data->reconfig_count++;
+    if (reused)
+    {
+        p_data->reuse_count++;
+    }
+
+    if (p_data->verbose && omx_get_port(handle, 1, &out_port))
+    {
+        LOG_INFO("Output port: %ux%u, %u buffers of %u bytes (%s) "
+                 "in %.3f ms\n", out_port.format.video.nFrameWidth,
+                 out_port.format.video.nFrameHeight, out_buf_cnt,
+                 out_port.nBufferSize, reused ? "memory reused" : "allocated",
+                 (omx_get_time_ns() - start_ns) / 1e6);
+    }
+
+    return pp_out_bufs;
+}
+
+#ifdef USE_GSTREAMER
+OMX_U32 setup_in_buf(GstElement * p_appsink, OMX_BUFFERHEADERTYPE * p_in_buf,
+                     bool * p_is_failed)
+{
+    GstSample * p_gst_sample = NULL;
+    GstBuffer * p_gst_buffer = NULL;
+
+    GstMapInfo gst_map;
+
+    p_gst_sample = gst_app_sink_pull_sample(GST_APP_SINK(p_appsink));
+
+    if (p_gst_sample == NULL)
+    {
+        p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
+        p_in_buf->nFilledLen = 0;
+    }
+    else
+    {
+        p_gst_buffer = gst_sample_get_buffer(p_gst_sample);
+        assert(gst_buffer_map(p_gst_buffer, &gst_map, GST_MAP_READ) == TRUE);
+
+        if (gst_map.size > p_in_buf->nAllocLen)
+        {
+            /* Stop the stream instead of overflowing the buffer */
+            printf("Error: H.264 frame of %zu bytes exceeds input buffer "
+                   "(%u bytes)\n", gst_map.size, p_in_buf->nAllocLen);
+
+            *p_is_failed = true;
+
+            p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
+            p_in_buf->nFilledLen = 0;
+        }
+        else
+        {
+            /* Put H.264 data to input buffer */
+            memcpy(p_in_buf->pBuffer, gst_map.data, gst_map.size);
+
+            p_in_buf->nFilledLen = gst_map.size;
+            p_in_buf->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+        }
+
+        /* Unmap the buffer data */
+        gst_buffer_unmap(p_gst_buffer, &gst_map);
+
+        /* Release the sample pulled from 'appsink' */
+        gst_sample_unref(p_gst_sample);
+    }
+
+    return p_in_buf->nFlags;
+}
+#else
+OMX_U32 setup_in_buf(annexb_t * p_annexb, OMX_BUFFERHEADERTYPE * p_in_buf,
+                     bool * p_is_failed)
+{
+    const uint8_t * p_au = NULL;
+    size_t au_len = 0;
+
+    p_in_buf->nOffset = 0;
+
+    if (annexb_next_au(p_annexb, &p_au, &au_len) == false)
+    {
+        p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
+        p_in_buf->nFilledLen = 0;
+    }
+    else if (au_len > p_in_buf->nAllocLen)
+    {
+        /* An access unit must fit in a single input buffer. Stop the stream
+         * instead of overflowing the buffer */
+        printf("Error: Access unit of %zu bytes exceeds input buffer "
+               "(%u bytes)\n", au_len, p_in_buf->nAllocLen);
+
+        *p_is_failed = true;
+
+        p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
+        p_in_buf->nFilledLen = 0;
+    }
+    else
+    {
+        /* Put H.264 data to input buffer (straight from input file) */
+        memcpy(p_in_buf->pBuffer, p_au, au_len);
+
+        p_in_buf->nFilledLen = au_len;
+        p_in_buf->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    }
+
+    return p_in_buf->nFlags;
+}
+#endif
+
+void release_out_buf(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    omx_data_t * p_data = (omx_data_t *)p_ctx;
+
+    /* Check parameters */
+    assert((p_data != NULL) && (p_buf != NULL));
+
+    omx_buf_move(p_buf, OMX_BUF_OWNER_IO, OMX_BUF_OWNER_APP);
+
+    pthread_mutex_lock(&p_data->out_mutex);
+
+    if (p_data->out_port_ready == false)
+    {
+        /* Output port is being disabled: keep the buffer until it is freed
+         * ('reconfig_out_port') */
+        sem_post(&p_data->smp_out_buf_returned);
+    }
+    else if (p_data->eos == false)
+    {
+        p_buf->nFlags     = 0;
+        p_buf->nFilledLen = 0;
+
+        bench_on_fill_this_buffer(p_data->p_bench, p_buf);
+
+        omx_buf_move(p_buf, OMX_BUF_OWNER_APP, OMX_BUF_OWNER_MC);
+
+        assert(OMX_FillThisBuffer(p_data->handle, p_buf) == OMX_ErrorNone);
+    }
+
+    pthread_mutex_unlock(&p_data->out_mutex);
+}
+
+void * feeder_thread_func(void * p_param)
+{
+    omx_data_t * p_data = (omx_data_t *)p_param;
+
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+
+    /* Start of 'setup_in_buf' in the trace */
+    uint64_t trace_ns = 0;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    trace_name_thread("feeder");
+
+    while (true)
+    {
+        /* Wait until a buffer is added to the queue or 'main' asks to exit */
+        sem_wait(&p_data->smp_in_buf);
+
+        if (atomic_load(&p_data->feeder_stop) || (p_data->eos == true))
+        {
+            break;
+        }
+
+        p_buf = (OMX_BUFFERHEADERTYPE *)queue_pop(&p_data->in_buf_queue);
+        if (p_buf == NULL)
+        {
+            continue;
+        }
+
+        trace_ns = trace_now();
+
+#ifdef USE_GSTREAMER
+        /* This call may block until 'appsink' has a new H.264 frame,
+         * but only this thread waits, not the MC */
+        setup_in_buf(p_data->p_appsink, p_buf, &p_data->in_failed);
+#else
+        setup_in_buf(&p_data->annexb, p_buf, &p_data->in_failed);
+#endif
+
+        trace_record(TRACE_EVENT_SETUP_IN_BUF, trace_ns,
+                     (uintptr_t)p_buf, p_buf->nFilledLen);
+
+        bench_on_empty_this_buffer(p_data->p_bench, p_buf);
+
+        omx_buf_move(p_buf, OMX_BUF_OWNER_APP, OMX_BUF_OWNER_MC);
+
+        assert(OMX_EmptyThisBuffer(p_data->handle, p_buf) == OMX_ErrorNone);
+
+        if (p_buf->nFlags & OMX_BUFFERFLAG_EOS)
+        {
+            /* No more data to send to input port */
+            break;
+        }
+    }
+
+    return NULL;
 }
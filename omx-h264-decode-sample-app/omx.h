@@ -8,18 +8,31 @@
  *   OMX functions.
  *
  * PUBLIC FUNCTIONS:
+ *   omx_state_init
+ *   omx_state_deinit
+ *   omx_state_notify
+ *   omx_state_notify_error
  *   omx_wait_state
  *
+ *   omx_get_time_ns
+ *
  *   omx_state_to_str
  *
  *   omx_get_port
  *   omx_set_port_buf_cnt
  *   omx_set_out_port_fmt
+ *   omx_set_out_port_size
  *
  *   omx_alloc_buffers
+ *   omx_use_buffers
  *   omx_dealloc_port_bufs
  *   omx_dealloc_all_port_bufs
  *
+ *   omx_get_buf_meta
+ *   omx_buf_move
+ *   omx_add_buf_stats
+ *   omx_print_buf_stats
+ *
  *   omx_fill_buffers
  *
  * AUTHOR: RVC       START DATE: 14/03/2023
@@ -37,6 +50,7 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include <OMX_Core.h>
 #include <OMX_Types.h>
@@ -45,6 +59,9 @@
 #include <OMXR_Extension_vecmn.h>
 #include <OMXR_Extension_h264e.h>
 
+/* Replace the OMX macros which send calls to the MC with traced versions */
+#include "trace.h"
+
 /******************************************************************************
  *                              MACRO VARIABLES                               *
  ******************************************************************************/
@@ -52,6 +69,13 @@
 /* The component name for H.264 decoder media component */
 #define RENESAS_VIDEO_DECODER_NAME "OMX.RENESAS.VIDEO.DECODER.H264"
 
+/* Set to 1 (build with 'make BUF_CHECK=1') to check each change of owner of
+ * a buffer ('omx_buf_move'). For example, a buffer sent twice to the MC, or
+ * freed while the MC owns it, then stops the application with an error */
+#ifndef OMX_BUF_CHECK
+#define OMX_BUF_CHECK 0
+#endif
+
 /******************************************************************************
  *                              FUNCTION MACROS                               *
  ******************************************************************************/
@@ -98,19 +122,126 @@
 /* Get slice height from frame height */
 #define OMX_SLICE_HEIGHT(HEIGHT) ROUND_UP(HEIGHT, 2)
 
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+/* State of a component as reported by its 'OMX_EventCmdComplete' and
+ * 'OMX_EventError' events. The event handler updates it with
+ * 'omx_state_notify' and 'omx_state_notify_error', so 'omx_wait_state'
+ * sleeps until the transition completes instead of polling 'OMX_GetState' */
+typedef struct
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    /* Last state reported by 'OMX_EventCmdComplete' */
+    OMX_STATETYPE state;
+
+    /* Error which prevents the pending state transition (if any) */
+    OMX_ERRORTYPE error;
+
+} omx_state_t;
+
+/* Owner of a buffer */
+typedef enum
+{
+    /* The application fills or reads the buffer */
+    OMX_BUF_OWNER_APP = 0,
+
+    /* The buffer was sent with 'OMX_EmptyThisBuffer' or 'OMX_FillThisBuffer'
+     * and the MC has not returned it yet */
+    OMX_BUF_OWNER_MC,
+
+    /* The buffer waits for I/O of the application (the output writer or the
+     * consumer of the exporter) */
+    OMX_BUF_OWNER_IO,
+
+    OMX_BUF_OWNER_COUNT
+
+} omx_buf_owner_t;
+
+/* Metadata of a buffer. 'omx_alloc_buffers' and 'omx_use_buffers' hang one
+ * on 'pAppPrivate' of each buffer header, so any callback finds it in O(1)
+ * with 'omx_get_buf_meta'.
+ *
+ * Only the current owner of the buffer changes its metadata, so it needs no
+ * lock: the OMX calls and queues which hand the buffer over also order the
+ * accesses */
+typedef struct
+{
+    /* Index of the buffer in the array of its port and index of the port */
+    uint32_t index;
+    OMX_U32 port_idx;
+
+    /* Current owner and time (in ns) it got the buffer */
+    omx_buf_owner_t owner;
+    uint64_t owner_ns;
+
+    /* Time (in ns) spent with each owner before the current one */
+    uint64_t time_ns[OMX_BUF_OWNER_COUNT];
+
+    /* Time (in ns) the buffer was last sent to and returned by the MC */
+    uint64_t sent_ns;
+    uint64_t returned_ns;
+
+    /* The number of times the buffer was sent to the MC */
+    uint32_t use_count;
+
+} omx_buf_meta_t;
+
+/* Statistics of the buffers of a port (see 'omx_add_buf_stats') */
+typedef struct
+{
+    /* The number of buffers */
+    uint32_t buf_count;
+
+    /* The number of times buffers were sent to the MC, in total and the
+     * lowest and highest numbers for a buffer */
+    uint64_t use_count;
+    uint32_t use_min;
+    uint32_t use_max;
+
+    /* Time (in ns) spent by all buffers with each owner */
+    uint64_t time_ns[OMX_BUF_OWNER_COUNT];
+
+} omx_buf_stats_t;
+
 /******************************************************************************
  *                            FUNCTION DECLARATION                            *
  ******************************************************************************/
 
+/* Initialize 'p_state'. A component is in state LOADED after 'OMX_GetHandle' */
+void omx_state_init(omx_state_t * p_state);
+
+/* Free resources of 'p_state' */
+void omx_state_deinit(omx_state_t * p_state);
+
+/* Record that the component is now in state 'state'.
+ * Call it when 'OMX_EventCmdComplete' occurs for 'OMX_CommandStateSet' */
+void omx_state_notify(omx_state_t * p_state, OMX_STATETYPE state);
+
+/* Record error 'error' reported by 'OMX_EventError'. Errors which prevent
+ * a state transition make the pending 'omx_wait_state' fail at once */
+void omx_state_notify_error(omx_state_t * p_state, OMX_ERRORTYPE error);
+
 /* Block calling thread until the component is in state 'state'
- * (based on section 3.2.2.13.2 in OMX IL specification 1.1.2) */
-void omx_wait_state(OMX_HANDLETYPE handle, OMX_STATETYPE state);
+ * (based on section 3.2.2.13.2 in OMX IL specification 1.1.2).
+ * Return true if successful. Otherwise (error or no transition within
+ * 'timeout_ms' milliseconds), return false */
+bool omx_wait_state(OMX_HANDLETYPE handle, omx_state_t * p_state,
+                    OMX_STATETYPE state, uint32_t timeout_ms);
+
+/* Get current time (in ns) of the monotonic clock */
+uint64_t omx_get_time_ns(void);
 
 /* Convert 'OMX_STATETYPE' to string.
- * Return the string (useful when passing the function to 'printf').
+ * Return the string (useful when passing the function to 'printf'), or NULL
+ * if 'state' is unknown.
  *
- * Note: The string must be freed when no longer used */
-char * omx_state_to_str(OMX_STATETYPE state);
+ * Note: The string is static, so it can be used in callbacks (nothing is
+ * allocated) and must not be freed */
+const char * omx_state_to_str(OMX_STATETYPE state);
 
 /* Get port's structure 'OMX_PARAM_PORTDEFINITIONTYPE'.
  * Return true if successful. Otherwise, return false.
@@ -128,11 +259,27 @@ bool omx_set_port_buf_cnt(OMX_HANDLETYPE handle,
  * Return true if successful. Otherwise, return false */
 bool omx_set_out_port_fmt(OMX_HANDLETYPE handle, OMX_COLOR_FORMATTYPE fmt);
 
+/* Set frame size 'width' x 'height' to output port, with stride
+ * 'OMX_STRIDE(width)' and slice height 'slice_height', so that its
+ * 'nBufferSize' fits the decoded frames before any buffer is allocated.
+ * Return true if successful. Otherwise, return false */
+bool omx_set_out_port_size(OMX_HANDLETYPE handle, OMX_U32 width,
+                           OMX_U32 height, OMX_U32 slice_height);
+
 /* Allocate buffers and buffer headers for port at 'port_idx'.
  * Return non-NULL value if successful. Otherwise, return NULL */
 OMX_BUFFERHEADERTYPE ** omx_alloc_buffers(OMX_HANDLETYPE handle,
                                           OMX_U32 port_idx);
 
+/* Create buffer headers for port at 'port_idx' which use the memory
+ * allocated by the application ('pp_data[i]' for buffer 'i', 'size' bytes).
+ * The array 'pp_data' must have 'nBufferCountActual' elements.
+ * Return non-NULL value if successful. Otherwise, return NULL.
+ *
+ * Note: The memory must not be freed before its buffer header */
+OMX_BUFFERHEADERTYPE ** omx_use_buffers(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                                        OMX_U8 ** pp_data, OMX_U32 size);
+
 /* Free 'count' elements in 'pp_bufs' */
 void omx_dealloc_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
                            OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count);
@@ -142,6 +289,28 @@ void omx_dealloc_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
 void omx_dealloc_all_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
                                OMX_BUFFERHEADERTYPE ** pp_bufs);
 
+/* Get metadata of buffer 'p_buf' (allocated by 'omx_alloc_buffers' or
+ * 'omx_use_buffers') */
+omx_buf_meta_t * omx_get_buf_meta(const OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Hand buffer 'p_buf' over from owner 'from' to owner 'to'. Call it just
+ * before the handover (for example, before 'OMX_FillThisBuffer' or
+ * 'writer_push') and at the start of 'EmptyBufferDone'/'FillBufferDone'.
+ *
+ * Note: If 'OMX_BUF_CHECK' is 1 and 'from' is not the current owner, the
+ * function prints an error and aborts the application */
+void omx_buf_move(OMX_BUFFERHEADERTYPE * p_buf,
+                  omx_buf_owner_t from, omx_buf_owner_t to);
+
+/* Add statistics of 'count' buffers in 'pp_bufs' to 'p_stats'. Call it
+ * before the buffers are freed */
+void omx_add_buf_stats(OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count,
+                       omx_buf_stats_t * p_stats);
+
+/* Print statistics 'p_stats' of the buffers of port 'p_name' */
+void omx_print_buf_stats(const char * p_name,
+                         const omx_buf_stats_t * p_stats);
+
 /* Send buffers in 'pp_bufs' to output port.
  * Return true if successful. Otherwise, return false */
 bool omx_fill_buffers(OMX_HANDLETYPE handle,
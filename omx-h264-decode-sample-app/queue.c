@@ -0,0 +1,131 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: queue.c
+ *
+ * DESCRIPTION:
+ *   SPSC lock-free queue definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'queue.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "queue.h"
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool queue_init(queue_t * p_queue, uint32_t capacity)
+{
+    uint32_t size = 1;
+
+    /* Check parameters */
+    assert(p_queue != NULL);
+    assert(capacity > 0);
+
+    /* Round 'capacity' up to a power of 2 so that indexes can be masked */
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+
+    p_queue->pp_items = (void **)calloc(size, sizeof(void *));
+    if (p_queue->pp_items == NULL)
+    {
+        return false;
+    }
+
+    p_queue->capacity = size;
+
+    atomic_init(&p_queue->head, 0);
+    atomic_init(&p_queue->tail, 0);
+
+    return true;
+}
+
+void queue_deinit(queue_t * p_queue)
+{
+    /* Check parameter */
+    assert(p_queue != NULL);
+
+    free(p_queue->pp_items);
+
+    p_queue->pp_items = NULL;
+    p_queue->capacity = 0;
+}
+
+bool queue_push(queue_t * p_queue, void * p_item)
+{
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    /* Check parameter */
+    assert(p_queue != NULL);
+
+    /* Only the producer writes 'tail', so a relaxed load is enough */
+    tail = atomic_load_explicit(&p_queue->tail, memory_order_relaxed);
+    head = atomic_load_explicit(&p_queue->head, memory_order_acquire);
+
+    if ((tail - head) == p_queue->capacity)
+    {
+        /* The queue is full */
+        return false;
+    }
+
+    p_queue->pp_items[tail & (p_queue->capacity - 1)] = p_item;
+
+    /* Publish the element to the consumer */
+    atomic_store_explicit(&p_queue->tail, tail + 1, memory_order_release);
+
+    return true;
+}
+
+void * queue_pop(queue_t * p_queue)
+{
+    void * p_item = NULL;
+
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    /* Check parameter */
+    assert(p_queue != NULL);
+
+    /* Only the consumer writes 'head', so a relaxed load is enough */
+    head = atomic_load_explicit(&p_queue->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&p_queue->tail, memory_order_acquire);
+
+    if (head == tail)
+    {
+        /* The queue is empty */
+        return NULL;
+    }
+
+    p_item = p_queue->pp_items[head & (p_queue->capacity - 1)];
+
+    /* Give the slot back to the producer */
+    atomic_store_explicit(&p_queue->head, head + 1, memory_order_release);
+
+    return p_item;
+}
+
+uint32_t queue_size(queue_t * p_queue)
+{
+    uint32_t head = 0;
+    uint32_t tail = 0;
+
+    /* Check parameter */
+    assert(p_queue != NULL);
+
+    head = atomic_load_explicit(&p_queue->head, memory_order_acquire);
+    tail = atomic_load_explicit(&p_queue->tail, memory_order_acquire);
+
+    return tail - head;
+}
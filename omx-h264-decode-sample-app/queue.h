@@ -0,0 +1,86 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: queue.h
+ *
+ * DESCRIPTION:
+ *   Bounded single-producer/single-consumer (SPSC) lock-free queue.
+ *
+ *   The queue is used to hand buffer headers from an OMX callback (producer)
+ *   to a worker thread (consumer) without taking any lock in the callback.
+ *
+ *   Only one thread may call 'queue_push' and only one thread may call
+ *   'queue_pop' at any given time.
+ *
+ * PUBLIC FUNCTIONS:
+ *   queue_init
+ *   queue_deinit
+ *
+ *   queue_push
+ *   queue_pop
+ *   queue_size
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _QUEUE_H_
+#define _QUEUE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Size of a cache line. 'head' and 'tail' are placed on different cache lines
+ * so that the producer and the consumer do not invalidate each other */
+#define QUEUE_CACHE_LINE_SIZE 64
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Ring of elements. Its length is 'capacity' */
+    void ** pp_items;
+
+    /* Capacity of the ring (always a power of 2) */
+    uint32_t capacity;
+
+    /* Index of the next element to be popped (only written by consumer) */
+    _Alignas(QUEUE_CACHE_LINE_SIZE) _Atomic uint32_t head;
+
+    /* Index of the next element to be pushed (only written by producer) */
+    _Alignas(QUEUE_CACHE_LINE_SIZE) _Atomic uint32_t tail;
+
+} queue_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Initialize 'p_queue' so that it can hold at least 'capacity' elements.
+ * Return true if successful. Otherwise, return false */
+bool queue_init(queue_t * p_queue, uint32_t capacity);
+
+/* Free memory of 'p_queue'. Elements still in the queue are discarded */
+void queue_deinit(queue_t * p_queue);
+
+/* Add 'p_item' to the end of 'p_queue' (producer side).
+ * Return true if successful. Otherwise (queue is full), return false */
+bool queue_push(queue_t * p_queue, void * p_item);
+
+/* Remove the first element of 'p_queue' (consumer side).
+ * Return the element if successful. Otherwise (queue is empty), return NULL */
+void * queue_pop(queue_t * p_queue);
+
+/* Get the number of elements in 'p_queue'.
+ * Note: The value is only a snapshot when other threads use the queue */
+uint32_t queue_size(queue_t * p_queue);
+
+#endif /* _QUEUE_H_ */
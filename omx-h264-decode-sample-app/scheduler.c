@@ -0,0 +1,348 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: scheduler.c
+ *
+ * DESCRIPTION:
+ *   Scheduler of decode jobs definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'scheduler.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include "omx.h"
+#include "scheduler.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get the frame rate of 'p_job' (0 if it failed) */
+static double scheduler_get_fps(const scheduler_job_t * p_job);
+
+/* Thread function which runs jobs until the list is empty */
+static void * scheduler_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+void scheduler_init(scheduler_t * p_scheduler)
+{
+    /* Check parameter */
+    assert(p_scheduler != NULL);
+
+    memset(p_scheduler, 0, sizeof(scheduler_t));
+
+    atomic_init(&p_scheduler->next_job, 0);
+    atomic_init(&p_scheduler->active_count, 0);
+    atomic_init(&p_scheduler->active_max, 0);
+}
+
+bool scheduler_add_job(scheduler_t * p_scheduler,
+                       const char * p_in_file_name,
+                       const char * p_out_file_name)
+{
+    scheduler_job_t * p_jobs = NULL;
+    scheduler_job_t * p_job = NULL;
+    uint32_t capacity = 0;
+
+    /* Check parameters */
+    assert((p_scheduler != NULL) && (p_in_file_name != NULL));
+    assert(p_out_file_name != NULL);
+
+    if ((strlen(p_in_file_name) >= SCHEDULER_NAME_LEN) ||
+        (strlen(p_out_file_name) >= SCHEDULER_NAME_LEN))
+    {
+        printf("Error: File name '%s' is too long\n", p_in_file_name);
+        return false;
+    }
+
+    if (p_scheduler->job_count == p_scheduler->job_capacity)
+    {
+        capacity = (p_scheduler->job_capacity == 0) ?
+                   8 : (2 * p_scheduler->job_capacity);
+
+        p_jobs = (scheduler_job_t *)realloc(p_scheduler->p_jobs,
+                                            capacity * sizeof(scheduler_job_t));
+        if (p_jobs == NULL)
+        {
+            printf("Error: Failed to allocate list of jobs\n");
+            return false;
+        }
+
+        p_scheduler->p_jobs       = p_jobs;
+        p_scheduler->job_capacity = capacity;
+    }
+
+    p_job = &p_scheduler->p_jobs[p_scheduler->job_count];
+    memset(p_job, 0, sizeof(scheduler_job_t));
+
+    p_job->index = p_scheduler->job_count;
+
+    strcpy(p_job->in_file_name, p_in_file_name);
+    strcpy(p_job->out_file_name, p_out_file_name);
+
+    p_scheduler->job_count++;
+
+    return true;
+}
+
+bool scheduler_load_jobs(scheduler_t * p_scheduler,
+                         const char * p_list_file_name,
+                         const char * p_out_pattern)
+{
+    FILE * p_list_file = NULL;
+
+    char line[2 * SCHEDULER_NAME_LEN];
+    char in_file_name[SCHEDULER_NAME_LEN];
+    char out_file_name[SCHEDULER_NAME_LEN];
+    int field_count = 0;
+    bool is_success = true;
+
+    /* Check parameters */
+    assert((p_scheduler != NULL) && (p_list_file_name != NULL));
+    assert(p_out_pattern != NULL);
+
+    p_list_file = fopen(p_list_file_name, "r");
+    if (p_list_file == NULL)
+    {
+        printf("Error: Failed to open '%s'\n", p_list_file_name);
+        return false;
+    }
+
+    while (is_success && (fgets(line, sizeof(line), p_list_file) != NULL))
+    {
+        /* The widths match 'SCHEDULER_NAME_LEN' */
+        field_count = sscanf(line, "%255s %255s", in_file_name, out_file_name);
+
+        if ((field_count < 1) || (in_file_name[0] == '#'))
+        {
+            /* Empty line or comment */
+            continue;
+        }
+
+        if (field_count == 1)
+        {
+            snprintf(out_file_name, sizeof(out_file_name), p_out_pattern,
+                     p_scheduler->job_count);
+        }
+
+        is_success = scheduler_add_job(p_scheduler,
+                                       in_file_name, out_file_name);
+    }
+
+    fclose(p_list_file);
+
+    if (is_success && (p_scheduler->job_count == 0))
+    {
+        printf("Error: '%s' contains no job\n", p_list_file_name);
+        is_success = false;
+    }
+
+    return is_success;
+}
+
+bool scheduler_run(scheduler_t * p_scheduler, uint32_t max_instances,
+                   scheduler_job_fn job_fn, void * p_job_ctx)
+{
+    uint32_t index = 0;
+    uint32_t thread_count = 0;
+    bool is_success = true;
+
+    /* Check parameters */
+    assert((p_scheduler != NULL) && (job_fn != NULL));
+    assert((max_instances > 0) && (max_instances <= SCHEDULER_MAX_INSTANCES));
+
+    p_scheduler->max_instances = max_instances;
+    p_scheduler->job_fn        = job_fn;
+    p_scheduler->p_job_ctx     = p_job_ctx;
+
+    atomic_store(&p_scheduler->next_job, 0);
+    atomic_store(&p_scheduler->active_count, 0);
+    atomic_store(&p_scheduler->active_max, 0);
+
+    for (index = 0; index < p_scheduler->job_count; index++)
+    {
+        p_scheduler->p_jobs[index].success     = false;
+        p_scheduler->p_jobs[index].frame_count = 0;
+        p_scheduler->p_jobs[index].start_ns    = 0;
+        p_scheduler->p_jobs[index].end_ns      = 0;
+    }
+
+    p_scheduler->start_ns = omx_get_time_ns();
+
+    /* More threads than jobs would have nothing to do */
+    for (index = 0;
+         (index < max_instances) && (index < p_scheduler->job_count); index++)
+    {
+        if (pthread_create(&p_scheduler->threads[index], NULL,
+                           scheduler_thread, p_scheduler) != 0)
+        {
+            printf("Error: Failed to create thread '%d' of scheduler\n", index);
+            break;
+        }
+
+        thread_count++;
+    }
+
+    for (index = 0; index < thread_count; index++)
+    {
+        pthread_join(p_scheduler->threads[index], NULL);
+    }
+
+    p_scheduler->end_ns = omx_get_time_ns();
+
+    for (index = 0; index < p_scheduler->job_count; index++)
+    {
+        is_success = is_success && p_scheduler->p_jobs[index].success;
+    }
+
+    return is_success;
+}
+
+void scheduler_deinit(scheduler_t * p_scheduler)
+{
+    /* Check parameter */
+    assert(p_scheduler != NULL);
+
+    free(p_scheduler->p_jobs);
+
+    p_scheduler->p_jobs       = NULL;
+    p_scheduler->job_count    = 0;
+    p_scheduler->job_capacity = 0;
+}
+
+void scheduler_print_report(scheduler_t * p_scheduler, bool per_job)
+{
+    scheduler_job_t * p_job = NULL;
+
+    uint32_t index = 0;
+    uint32_t success_count = 0;
+    uint64_t frame_count = 0;
+
+    double fps = 0.0;
+    double fps_sum = 0.0;
+    double fps_sq_sum = 0.0;
+    double fps_min = 0.0;
+    double fps_max = 0.0;
+    double wall_ms = 0.0;
+
+    /* Check parameter */
+    assert(p_scheduler != NULL);
+
+    wall_ms = (p_scheduler->end_ns - p_scheduler->start_ns) / 1e6;
+
+    for (index = 0; index < p_scheduler->job_count; index++)
+    {
+        p_job = &p_scheduler->p_jobs[index];
+        fps   = scheduler_get_fps(p_job);
+
+        if (per_job)
+        {
+            printf("Scheduler: job %u '%s': %s, %llu frames in %.3f ms "
+                   "(%.1f fps)\n",
+                   p_job->index, p_job->in_file_name,
+                   p_job->success ? "done" : "failed",
+                   (unsigned long long)p_job->frame_count,
+                   (p_job->end_ns - p_job->start_ns) / 1e6, fps);
+        }
+
+        if (!p_job->success)
+        {
+            continue;
+        }
+
+        if ((success_count == 0) || (fps < fps_min))
+        {
+            fps_min = fps;
+        }
+
+        if ((success_count == 0) || (fps > fps_max))
+        {
+            fps_max = fps;
+        }
+
+        success_count++;
+        frame_count += p_job->frame_count;
+        fps_sum     += fps;
+        fps_sq_sum  += fps * fps;
+    }
+
+    printf("Scheduler: %u instances max (%u used), %u/%u jobs done, "
+           "%llu frames in %.3f ms\n",
+           p_scheduler->max_instances,
+           atomic_load(&p_scheduler->active_max),
+           success_count, p_scheduler->job_count,
+           (unsigned long long)frame_count, wall_ms);
+
+    if (success_count > 0)
+    {
+        /* Jain's fairness index: (sum x)^2 / (n * sum x^2) */
+        printf("Scheduler: aggregate %.1f fps, per-job fps min %.1f / "
+               "avg %.1f / max %.1f, fairness %.3f\n",
+               (wall_ms > 0.0) ? (frame_count * 1000.0) / wall_ms : 0.0,
+               fps_min, fps_sum / success_count, fps_max,
+               (fps_sq_sum > 0.0) ?
+               (fps_sum * fps_sum) / (success_count * fps_sq_sum) : 1.0);
+    }
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static double scheduler_get_fps(const scheduler_job_t * p_job)
+{
+    if (!p_job->success || (p_job->end_ns <= p_job->start_ns))
+    {
+        return 0.0;
+    }
+
+    return (p_job->frame_count * 1e9) / (p_job->end_ns - p_job->start_ns);
+}
+
+static void * scheduler_thread(void * p_param)
+{
+    scheduler_t * p_scheduler = (scheduler_t *)p_param;
+    scheduler_job_t * p_job = NULL;
+
+    uint32_t job_idx = 0;
+    uint32_t active = 0;
+    uint32_t active_max = 0;
+
+    while (true)
+    {
+        job_idx = atomic_fetch_add(&p_scheduler->next_job, 1);
+        if (job_idx >= p_scheduler->job_count)
+        {
+            /* No more job */
+            break;
+        }
+
+        p_job = &p_scheduler->p_jobs[job_idx];
+
+        active = atomic_fetch_add(&p_scheduler->active_count, 1) + 1;
+
+        /* Record the highest number of jobs running at the same time */
+        active_max = atomic_load(&p_scheduler->active_max);
+        while ((active > active_max) &&
+               !atomic_compare_exchange_weak(&p_scheduler->active_max,
+                                             &active_max, active))
+        {
+            /* 'active_max' was reloaded by the failed exchange */
+        }
+
+        p_job->start_ns = omx_get_time_ns();
+        p_job->success  = p_scheduler->job_fn(p_job, p_scheduler->p_job_ctx);
+        p_job->end_ns   = omx_get_time_ns();
+
+        atomic_fetch_sub(&p_scheduler->active_count, 1);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,150 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: scheduler.h
+ *
+ * DESCRIPTION:
+ *   Scheduler of decode jobs.
+ *
+ *   A job decodes an input file to an output file with its own media
+ *   component (MC) instance. The scheduler runs the jobs of its list on up to
+ *   'max_instances' threads, so that no more than 'max_instances' MCs exist
+ *   at the same time. As soon as a job ends, its thread takes the next job of
+ *   the list, which keeps the hardware busy until the list is empty.
+ *
+ *   After a run, 'scheduler_print_report' shows the frame rate of each job,
+ *   the aggregate frame rate and how fairly the jobs shared the hardware
+ *   (Jain's fairness index of the per-job frame rates: 1.0 means all jobs
+ *   ran at the same speed).
+ *
+ * PUBLIC FUNCTIONS:
+ *   scheduler_init
+ *   scheduler_add_job
+ *   scheduler_load_jobs
+ *   scheduler_run
+ *   scheduler_deinit
+ *
+ *   scheduler_print_report
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The maximum number of jobs running at the same time */
+#define SCHEDULER_MAX_INSTANCES 16
+
+/* The maximum length of file names (including '\0') */
+#define SCHEDULER_NAME_LEN 256
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Index of the job in the list */
+    uint32_t index;
+
+    /* Input and output files */
+    char in_file_name[SCHEDULER_NAME_LEN];
+    char out_file_name[SCHEDULER_NAME_LEN];
+
+    /* Results (set by the job function) */
+
+    /* True if the job decoded its input file */
+    bool success;
+
+    /* The number of decoded frames */
+    uint64_t frame_count;
+
+    /* Time (in ns) when the job started and ended */
+    uint64_t start_ns;
+    uint64_t end_ns;
+
+} scheduler_job_t;
+
+/* Run 'p_job'. Return true if successful. Otherwise, return false */
+typedef bool (*scheduler_job_fn)(scheduler_job_t * p_job, void * p_ctx);
+
+typedef struct
+{
+    /* List of jobs */
+    scheduler_job_t * p_jobs;
+    uint32_t job_count;
+    uint32_t job_capacity;
+
+    /* The maximum number of jobs running at the same time */
+    uint32_t max_instances;
+
+    /* Function (and its context) which runs a job */
+    scheduler_job_fn job_fn;
+    void * p_job_ctx;
+
+    /* Index of the next job to be started */
+    atomic_uint next_job;
+
+    /* The number of jobs running now and its maximum during the run */
+    atomic_uint active_count;
+    atomic_uint active_max;
+
+    /* Threads which run the jobs */
+    pthread_t threads[SCHEDULER_MAX_INSTANCES];
+
+    /* Time (in ns) when the run started and ended */
+    uint64_t start_ns;
+    uint64_t end_ns;
+
+} scheduler_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Initialize 'p_scheduler' with an empty list of jobs */
+void scheduler_init(scheduler_t * p_scheduler);
+
+/* Add a job which decodes 'p_in_file_name' to 'p_out_file_name'.
+ * Return true if successful. Otherwise, return false */
+bool scheduler_add_job(scheduler_t * p_scheduler,
+                       const char * p_in_file_name,
+                       const char * p_out_file_name);
+
+/* Add the jobs of list file 'p_list_file_name'. Each line contains an input
+ * file and, optionally, an output file separated by spaces. Empty lines and
+ * lines starting with '#' are ignored.
+ *
+ * If a line has no output file, its name is made from 'p_out_pattern'
+ * (a 'printf' format with '%u', which is replaced by the index of the job).
+ *
+ * Return true if successful. Otherwise, return false */
+bool scheduler_load_jobs(scheduler_t * p_scheduler,
+                         const char * p_list_file_name,
+                         const char * p_out_pattern);
+
+/* Run all jobs of 'p_scheduler' with 'job_fn(job, p_job_ctx)', with up to
+ * 'max_instances' jobs at the same time. Wait until all of them end.
+ * Return true if all jobs succeeded. Otherwise, return false */
+bool scheduler_run(scheduler_t * p_scheduler, uint32_t max_instances,
+                   scheduler_job_fn job_fn, void * p_job_ctx);
+
+/* Free the list of jobs of 'p_scheduler' */
+void scheduler_deinit(scheduler_t * p_scheduler);
+
+/* Print the results of the last run. If 'per_job' is true, also print
+ * a line for each job */
+void scheduler_print_report(scheduler_t * p_scheduler, bool per_job);
+
+#endif /* _SCHEDULER_H_ */
@@ -0,0 +1,684 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: shmring.c
+ *
+ * DESCRIPTION:
+ *   Shared-memory ring of decoded frames definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'shmring.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+/* Needed for 'memfd_create' */
+#define _GNU_SOURCE
+
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
+#include <assert.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "shmring.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Time (in ms) the producer waits for a released frame before it checks
+ * whether the processes of consumers are still alive */
+#define SHMRING_REAP_MS 100
+
+/******************************************************************************
+ *                              FUNCTION MACROS                               *
+ ******************************************************************************/
+
+/* Round 'VAL' up to a multiple of 'RND' (a power of 2) */
+#define SHMRING_ROUND_UP(VAL, RND) (((VAL) + (RND) - 1) & (~((RND) - 1)))
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get current time (in ns) of the monotonic clock */
+static uint64_t shmring_now_ns(void);
+
+/* Wait up to 'timeout_ms' ms (-1 to wait forever) while futex word
+ * '*p_word' is 'val'.
+ * Return false on timeout. Otherwise, return true */
+static bool shmring_futex_wait(_Atomic uint32_t * p_word, uint32_t val,
+                               int32_t timeout_ms);
+
+/* Wake all processes waiting on futex word '*p_word' */
+static void shmring_futex_wake(_Atomic uint32_t * p_word);
+
+/* Return true if a consumer holds the frame of sequence number 'seq' */
+static bool shmring_is_held(shmring_header_t * p_header, uint64_t seq);
+
+/* Return true if all consumers have released the frame of sequence number
+ * 'seq' (or a newer frame) */
+static bool shmring_is_read(shmring_header_t * p_header, uint64_t seq);
+
+/* Free the entries of consumers whose process has exited */
+static void shmring_reap_readers(shmring_t * p_ring);
+
+/* Take a slot which the producer can write, so that its sequence number is 0
+ * and no consumer can hold it. Wait for consumers if there is none.
+ * Return the index of the slot */
+static uint32_t shmring_claim_slot(shmring_t * p_ring);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool shmring_create(shmring_t * p_ring, uint32_t slot_count, size_t slot_size,
+                    shmring_policy_t policy)
+{
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    shmring_header_t * p_header = NULL;
+
+    /* Check parameters */
+    assert(p_ring != NULL);
+    assert((slot_count >= 2) && (slot_count <= SHMRING_MAX_SLOTS));
+    assert(slot_size > 0);
+
+    memset(p_ring, 0, sizeof(shmring_t));
+
+    p_ring->reader_idx = -1;
+
+    slot_size = SHMRING_ROUND_UP(slot_size, page_size);
+
+    p_ring->map_size = SHMRING_ROUND_UP(sizeof(shmring_header_t), page_size) +
+                       ((size_t)slot_count * slot_size);
+
+    p_ring->fd = memfd_create("decoder-ring", MFD_ALLOW_SEALING);
+    if (p_ring->fd < 0)
+    {
+        printf("Error: Failed to create memfd of ring (errno %d)\n", errno);
+        return false;
+    }
+
+    /* The size is sealed, so that consumers can always access their mapping */
+    if ((ftruncate(p_ring->fd, (off_t)p_ring->map_size) != 0) ||
+        (fcntl(p_ring->fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW) != 0))
+    {
+        printf("Error: Failed to size memfd of ring (errno %d)\n", errno);
+        close(p_ring->fd);
+        return false;
+    }
+
+    p_header = (shmring_header_t *)mmap(NULL, p_ring->map_size,
+                                        PROT_READ | PROT_WRITE, MAP_SHARED,
+                                        p_ring->fd, 0);
+    if (p_header == MAP_FAILED)
+    {
+        printf("Error: Failed to map ring (errno %d)\n", errno);
+        close(p_ring->fd);
+        return false;
+    }
+
+    /* A new memfd is filled with zeros: all slots are empty and all entries
+     * of consumers are free */
+    p_header->slot_count  = slot_count;
+    p_header->policy      = (uint32_t)policy;
+    p_header->slot_size   = slot_size;
+    p_header->data_offset = SHMRING_ROUND_UP(sizeof(shmring_header_t),
+                                             page_size);
+    p_header->version     = SHMRING_VERSION;
+
+    /* Consumers check the magic number last */
+    atomic_thread_fence(memory_order_release);
+    p_header->magic = SHMRING_MAGIC;
+
+    p_ring->p_header = p_header;
+
+    return true;
+}
+
+bool shmring_wait_reader(shmring_t * p_ring, uint32_t timeout_ms)
+{
+    shmring_header_t * p_header = NULL;
+
+    uint64_t end_ns = 0;
+    uint64_t now_ns = 0;
+    uint32_t tail   = 0;
+    uint32_t index  = 0;
+
+    /* Check parameter */
+    assert((p_ring != NULL) && (p_ring->p_header != NULL));
+
+    p_header = p_ring->p_header;
+    end_ns   = shmring_now_ns() + ((uint64_t)timeout_ms * 1000000ULL);
+
+    while (true)
+    {
+        /* Read the futex word first, so that no attachment is missed */
+        tail = atomic_load(&p_header->tail);
+
+        for (index = 0; index < SHMRING_MAX_READERS; index++)
+        {
+            if (atomic_load(&p_header->readers[index].pid) != 0)
+            {
+                return true;
+            }
+        }
+
+        now_ns = shmring_now_ns();
+        if (now_ns >= end_ns)
+        {
+            return false;
+        }
+
+        shmring_futex_wait(&p_header->tail, tail,
+                           (int32_t)((end_ns - now_ns + 999999) / 1000000));
+    }
+}
+
+bool shmring_publish(shmring_t * p_ring, const uint8_t * p_data, size_t len,
+                     const shmring_slot_t * p_geometry, int64_t timestamp_us)
+{
+    shmring_header_t * p_header = NULL;
+    shmring_slot_t * p_slot = NULL;
+
+    uint32_t index = 0;
+    uint64_t seq   = 0;
+
+    /* Check parameters */
+    assert((p_ring != NULL) && (p_ring->p_header != NULL));
+    assert((p_data != NULL) && (p_geometry != NULL));
+
+    p_header = p_ring->p_header;
+
+    if (len > p_header->slot_size)
+    {
+        p_ring->stats.too_big_count++;
+        return false;
+    }
+
+    index  = shmring_claim_slot(p_ring);
+    p_slot = &p_header->slots[index];
+
+    memcpy((uint8_t *)p_header + p_header->data_offset +
+           ((size_t)index * p_header->slot_size), p_data, len);
+
+    p_slot->timestamp_us = timestamp_us;
+    p_slot->width        = p_geometry->width;
+    p_slot->height       = p_geometry->height;
+    p_slot->stride       = p_geometry->stride;
+    p_slot->slice_height = p_geometry->slice_height;
+    p_slot->len          = (uint32_t)len;
+
+    /* The frame becomes visible to consumers with its sequence number */
+    seq = atomic_load(&p_header->write_seq) + 1;
+
+    atomic_store(&p_slot->seq, seq);
+    atomic_store(&p_header->write_seq, seq);
+
+    atomic_fetch_add(&p_header->head, 1);
+    shmring_futex_wake(&p_header->head);
+
+    p_ring->stats.publish_count++;
+
+    return true;
+}
+
+void shmring_close(shmring_t * p_ring)
+{
+    /* Check parameter */
+    assert(p_ring != NULL);
+
+    if (p_ring->p_header != NULL)
+    {
+        atomic_store(&p_ring->p_header->closed, 1);
+
+        atomic_fetch_add(&p_ring->p_header->head, 1);
+        shmring_futex_wake(&p_ring->p_header->head);
+
+        munmap(p_ring->p_header, p_ring->map_size);
+        p_ring->p_header = NULL;
+    }
+
+    if (p_ring->fd >= 0)
+    {
+        close(p_ring->fd);
+        p_ring->fd = -1;
+    }
+}
+
+void shmring_print_stats(shmring_t * p_ring)
+{
+    shmring_stats_t * p_stats = NULL;
+
+    /* Check parameter */
+    assert(p_ring != NULL);
+
+    p_stats = &p_ring->stats;
+
+    printf("Ring: %llu frames published, %llu overwritten unread, "
+           "%llu too big for a slot\n",
+           (unsigned long long)p_stats->publish_count,
+           (unsigned long long)p_stats->drop_count,
+           (unsigned long long)p_stats->too_big_count);
+
+    printf("Ring: wait for consumers %.3f ms / max %.3f ms, "
+           "%u consumers exited while attached\n",
+           p_stats->wait_ns / 1e6, p_stats->wait_ns_max / 1e6,
+           p_stats->dead_readers);
+}
+
+bool shmring_attach(shmring_t * p_ring, const char * p_path)
+{
+    shmring_header_t * p_header = NULL;
+    struct stat file_stat;
+
+    int32_t expected = 0;
+    int32_t index    = 0;
+
+    /* Check parameters */
+    assert((p_ring != NULL) && (p_path != NULL));
+
+    memset(p_ring, 0, sizeof(shmring_t));
+
+    p_ring->reader_idx = -1;
+
+    p_ring->fd = open(p_path, O_RDWR);
+    if (p_ring->fd < 0)
+    {
+        printf("Error: Failed to open ring '%s' (errno %d)\n", p_path, errno);
+        return false;
+    }
+
+    if ((fstat(p_ring->fd, &file_stat) != 0) ||
+        ((size_t)file_stat.st_size < sizeof(shmring_header_t)))
+    {
+        printf("Error: '%s' is not a ring\n", p_path);
+        close(p_ring->fd);
+        return false;
+    }
+
+    p_ring->map_size = (size_t)file_stat.st_size;
+
+    p_header = (shmring_header_t *)mmap(NULL, p_ring->map_size,
+                                        PROT_READ | PROT_WRITE, MAP_SHARED,
+                                        p_ring->fd, 0);
+    if (p_header == MAP_FAILED)
+    {
+        printf("Error: Failed to map ring '%s' (errno %d)\n", p_path, errno);
+        close(p_ring->fd);
+        return false;
+    }
+
+    p_ring->p_header = p_header;
+
+    if ((p_header->magic != SHMRING_MAGIC) ||
+        (p_header->version != SHMRING_VERSION) ||
+        (p_ring->map_size < (p_header->data_offset +
+                             (p_header->slot_count * p_header->slot_size))))
+    {
+        printf("Error: '%s' is not a ring of version %u\n",
+               p_path, SHMRING_VERSION);
+        shmring_detach(p_ring);
+        return false;
+    }
+
+    /* Take a free entry. Free entries have 'read_seq' and 'held_seq' at 0 */
+    for (index = 0; index < SHMRING_MAX_READERS; index++)
+    {
+        expected = 0;
+
+        if (atomic_compare_exchange_strong(&p_header->readers[index].pid,
+                                           &expected, (int32_t)getpid()))
+        {
+            p_ring->reader_idx = index;
+            break;
+        }
+    }
+
+    if (p_ring->reader_idx < 0)
+    {
+        printf("Error: Ring '%s' already has %d consumers\n",
+               p_path, SHMRING_MAX_READERS);
+        shmring_detach(p_ring);
+        return false;
+    }
+
+    /* Tell the producer (in 'shmring_wait_reader') */
+    atomic_fetch_add(&p_header->tail, 1);
+    shmring_futex_wake(&p_header->tail);
+
+    return true;
+}
+
+bool shmring_next(shmring_t * p_ring, shmring_frame_t * p_frame,
+                  int32_t timeout_ms)
+{
+    shmring_header_t * p_header = NULL;
+    shmring_reader_t * p_reader = NULL;
+
+    uint64_t end_ns   = 0;
+    uint64_t now_ns   = 0;
+    uint64_t read_seq = 0;
+    uint64_t seq      = 0;
+    uint64_t best_seq = 0;
+    uint32_t best_idx = 0;
+    uint32_t head     = 0;
+    uint32_t index    = 0;
+
+    /* Check parameters */
+    assert((p_ring != NULL) && (p_ring->p_header != NULL));
+    assert((p_ring->reader_idx >= 0) && (p_frame != NULL));
+
+    p_header = p_ring->p_header;
+    p_reader = &p_header->readers[p_ring->reader_idx];
+    read_seq = atomic_load(&p_reader->read_seq);
+
+    if (timeout_ms >= 0)
+    {
+        end_ns = shmring_now_ns() + ((uint64_t)timeout_ms * 1000000ULL);
+    }
+
+    while (true)
+    {
+        /* Read the futex word first, so that no publication is missed */
+        head = atomic_load(&p_header->head);
+
+        /* Find the oldest frame newer than the last released one */
+        best_seq = UINT64_MAX;
+
+        for (index = 0; index < p_header->slot_count; index++)
+        {
+            seq = atomic_load(&p_header->slots[index].seq);
+
+            if ((seq > read_seq) && (seq < best_seq))
+            {
+                best_seq = seq;
+                best_idx = index;
+            }
+        }
+
+        if (best_seq != UINT64_MAX)
+        {
+            /* Hold the frame, then make sure the producer has not started to
+             * overwrite it in the meantime (it checks 'held_seq' after it
+             * clears the sequence number of the slot) */
+            atomic_store(&p_reader->held_seq, best_seq);
+
+            if (atomic_load(&p_header->slots[best_idx].seq) == best_seq)
+            {
+                p_frame->p_slot = &p_header->slots[best_idx];
+                p_frame->p_data = (const uint8_t *)p_header +
+                                  p_header->data_offset +
+                                  ((size_t)best_idx * p_header->slot_size);
+                p_frame->seq    = best_seq;
+
+                return true;
+            }
+
+            atomic_store(&p_reader->held_seq, 0);
+            continue;
+        }
+
+        if (atomic_load(&p_header->closed) != 0)
+        {
+            return false;
+        }
+
+        if (timeout_ms < 0)
+        {
+            shmring_futex_wait(&p_header->head, head, -1);
+            continue;
+        }
+
+        now_ns = shmring_now_ns();
+        if (now_ns >= end_ns)
+        {
+            return false;
+        }
+
+        shmring_futex_wait(&p_header->head, head,
+                           (int32_t)((end_ns - now_ns + 999999) / 1000000));
+    }
+}
+
+void shmring_release(shmring_t * p_ring, const shmring_frame_t * p_frame)
+{
+    shmring_reader_t * p_reader = NULL;
+
+    /* Check parameters */
+    assert((p_ring != NULL) && (p_ring->p_header != NULL));
+    assert((p_ring->reader_idx >= 0) && (p_frame != NULL));
+
+    p_reader = &p_ring->p_header->readers[p_ring->reader_idx];
+
+    atomic_store(&p_reader->read_seq, p_frame->seq);
+    atomic_store(&p_reader->held_seq, 0);
+
+    atomic_fetch_add(&p_ring->p_header->tail, 1);
+    shmring_futex_wake(&p_ring->p_header->tail);
+}
+
+void shmring_detach(shmring_t * p_ring)
+{
+    shmring_reader_t * p_reader = NULL;
+
+    /* Check parameter */
+    assert(p_ring != NULL);
+
+    if ((p_ring->p_header != NULL) && (p_ring->reader_idx >= 0))
+    {
+        p_reader = &p_ring->p_header->readers[p_ring->reader_idx];
+
+        /* Leave the entry as a free one */
+        atomic_store(&p_reader->held_seq, 0);
+        atomic_store(&p_reader->read_seq, 0);
+        atomic_store(&p_reader->pid, 0);
+
+        atomic_fetch_add(&p_ring->p_header->tail, 1);
+        shmring_futex_wake(&p_ring->p_header->tail);
+
+        p_ring->reader_idx = -1;
+    }
+
+    if (p_ring->p_header != NULL)
+    {
+        munmap(p_ring->p_header, p_ring->map_size);
+        p_ring->p_header = NULL;
+    }
+
+    if (p_ring->fd >= 0)
+    {
+        close(p_ring->fd);
+        p_ring->fd = -1;
+    }
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static uint64_t shmring_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static bool shmring_futex_wait(_Atomic uint32_t * p_word, uint32_t val,
+                               int32_t timeout_ms)
+{
+    struct timespec timeout;
+    long ret = 0;
+
+    timeout.tv_sec  = timeout_ms / 1000;
+    timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+
+    /* 'FUTEX_WAIT' (not 'FUTEX_WAIT_PRIVATE'): the word is shared by
+     * processes */
+    ret = syscall(SYS_futex, (uint32_t *)p_word, FUTEX_WAIT, val,
+                  (timeout_ms >= 0) ? &timeout : NULL, NULL, 0);
+
+    return (ret == 0) || (errno != ETIMEDOUT);
+}
+
+static void shmring_futex_wake(_Atomic uint32_t * p_word)
+{
+    syscall(SYS_futex, (uint32_t *)p_word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+static bool shmring_is_held(shmring_header_t * p_header, uint64_t seq)
+{
+    uint32_t index = 0;
+
+    /* 'held_seq' is 0 when a consumer holds no frame */
+    if (seq == 0)
+    {
+        return false;
+    }
+
+    for (index = 0; index < SHMRING_MAX_READERS; index++)
+    {
+        if ((atomic_load(&p_header->readers[index].pid) != 0) &&
+            (atomic_load(&p_header->readers[index].held_seq) == seq))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool shmring_is_read(shmring_header_t * p_header, uint64_t seq)
+{
+    uint32_t index = 0;
+
+    for (index = 0; index < SHMRING_MAX_READERS; index++)
+    {
+        if ((atomic_load(&p_header->readers[index].pid) != 0) &&
+            (atomic_load(&p_header->readers[index].read_seq) < seq))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void shmring_reap_readers(shmring_t * p_ring)
+{
+    shmring_reader_t * p_reader = NULL;
+
+    int32_t  pid   = 0;
+    uint32_t index = 0;
+
+    for (index = 0; index < SHMRING_MAX_READERS; index++)
+    {
+        p_reader = &p_ring->p_header->readers[index];
+        pid      = atomic_load(&p_reader->pid);
+
+        if ((pid != 0) && (kill(pid, 0) != 0) && (errno == ESRCH))
+        {
+            atomic_store(&p_reader->held_seq, 0);
+            atomic_store(&p_reader->read_seq, 0);
+            atomic_store(&p_reader->pid, 0);
+
+            p_ring->stats.dead_readers++;
+        }
+    }
+}
+
+static uint32_t shmring_claim_slot(shmring_t * p_ring)
+{
+    shmring_header_t * p_header = p_ring->p_header;
+    bool block = (p_header->policy == SHMRING_POLICY_BLOCK);
+
+    uint64_t start_ns = 0;
+    uint64_t wait_ns  = 0;
+    uint64_t seq      = 0;
+    uint64_t best_seq = 0;
+    uint32_t best_idx = 0;
+    uint32_t tail     = 0;
+    uint32_t index    = 0;
+
+    while (true)
+    {
+        /* Read the futex word first, so that no release is missed */
+        tail = atomic_load(&p_header->tail);
+
+        /* Find the oldest frame (or an empty slot) which can be replaced */
+        best_seq = UINT64_MAX;
+
+        for (index = 0; index < p_header->slot_count; index++)
+        {
+            seq = atomic_load(&p_header->slots[index].seq);
+
+            if ((seq < best_seq) && !shmring_is_held(p_header, seq) &&
+                (!block || shmring_is_read(p_header, seq)))
+            {
+                best_seq = seq;
+                best_idx = index;
+            }
+        }
+
+        if (best_seq != UINT64_MAX)
+        {
+            if (best_seq == 0)
+            {
+                break;
+            }
+
+            /* Hide the frame from consumers, then make sure none of them
+             * has held it in the meantime (see 'shmring_next') */
+            atomic_store(&p_header->slots[best_idx].seq, 0);
+
+            if (!shmring_is_held(p_header, best_seq))
+            {
+                if (!shmring_is_read(p_header, best_seq))
+                {
+                    p_ring->stats.drop_count++;
+                }
+
+                break;
+            }
+
+            atomic_store(&p_header->slots[best_idx].seq, best_seq);
+            continue;
+        }
+
+        /* All slots are held or not read yet: wait for consumers */
+        if (start_ns == 0)
+        {
+            start_ns = shmring_now_ns();
+        }
+
+        if (!shmring_futex_wait(&p_header->tail, tail, SHMRING_REAP_MS))
+        {
+            shmring_reap_readers(p_ring);
+        }
+    }
+
+    if (start_ns != 0)
+    {
+        wait_ns = shmring_now_ns() - start_ns;
+
+        p_ring->stats.wait_ns += wait_ns;
+        if (wait_ns > p_ring->stats.wait_ns_max)
+        {
+            p_ring->stats.wait_ns_max = wait_ns;
+        }
+    }
+
+    return best_idx;
+}
@@ -0,0 +1,272 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: shmring.h
+ *
+ * DESCRIPTION:
+ *   Shared-memory ring of decoded frames.
+ *
+ *   The producer (the decoder) creates the ring in a memfd ('memfd_create').
+ *   Consumer processes open it through '/proc/<pid>/fd/<fd>' and map it, so
+ *   they read frames straight from the ring, without any copy.
+ *
+ *   The memory of the ring starts with 'shmring_header_t' (which holds the
+ *   header of each slot), followed by the data of the slots. Each data area
+ *   is page-aligned and holds one frame as it was in the output buffer (NV12
+ *   with the padding of stride and slice height, see 'shmring_slot_t').
+ *
+ *   Frames get sequence numbers 1, 2, 3... A consumer takes the oldest frame
+ *   newer than the last one it released ('shmring_next'), reads it in place
+ *   and releases it ('shmring_release'). The producer never writes a slot
+ *   while a consumer holds it. When all slots are in use, the policy decides:
+ *     - SHMRING_POLICY_BLOCK: the producer waits until each consumer has
+ *       released the oldest frame (backpressure up to the MC).
+ *     - SHMRING_POLICY_DROP: the producer overwrites the oldest frame which
+ *       is not held, even if a consumer has not read it yet.
+ *
+ *   Consumers wait for frames on futex 'head', the producer waits for
+ *   released frames on futex 'tail'. Futex words are shared (not private)
+ *   because the ring is mapped by several processes.
+ *
+ * PUBLIC FUNCTIONS:
+ *   shmring_create
+ *   shmring_wait_reader
+ *   shmring_publish
+ *   shmring_close
+ *   shmring_print_stats
+ *
+ *   shmring_attach
+ *   shmring_next
+ *   shmring_release
+ *   shmring_detach
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _SHMRING_H_
+#define _SHMRING_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Magic number ("SRNG") and version of the memory layout of the ring */
+#define SHMRING_MAGIC   0x474E5253u
+#define SHMRING_VERSION 1u
+
+/* The maximum number of slots of a ring */
+#define SHMRING_MAX_SLOTS 16
+
+/* The maximum number of consumers attached to a ring at the same time */
+#define SHMRING_MAX_READERS 8
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef enum
+{
+    /* The producer waits for consumers when all slots are in use */
+    SHMRING_POLICY_BLOCK = 0,
+
+    /* The producer overwrites the oldest frame which is not held */
+    SHMRING_POLICY_DROP
+
+} shmring_policy_t;
+
+typedef struct
+{
+    /* Sequence number of the frame in the slot. 0 if the slot is empty or
+     * being written by the producer */
+    _Atomic uint64_t seq;
+
+    /* Timestamp of the frame ('nTimeStamp' of the output buffer, in us) */
+    int64_t timestamp_us;
+
+    /* Visible size of the frame (in pixels) */
+    uint32_t width;
+    uint32_t height;
+
+    /* The number of bytes from a row to the next one */
+    uint32_t stride;
+
+    /* The number of rows from the start of Y plane to the start of UV plane */
+    uint32_t slice_height;
+
+    /* The number of bytes of the frame in the data area of the slot */
+    uint32_t len;
+
+    uint32_t reserved;
+
+} shmring_slot_t;
+
+typedef struct
+{
+    /* PID of the consumer (0 if this entry is free) */
+    _Atomic int32_t pid;
+
+    uint32_t reserved;
+
+    /* Sequence number of the last frame released by the consumer */
+    _Atomic uint64_t read_seq;
+
+    /* Sequence number of the frame held by the consumer (0 if none) */
+    _Atomic uint64_t held_seq;
+
+} shmring_reader_t;
+
+typedef struct
+{
+    /* 'SHMRING_MAGIC' and 'SHMRING_VERSION' */
+    uint32_t magic;
+    uint32_t version;
+
+    /* The number of slots and the policy ('shmring_policy_t') */
+    uint32_t slot_count;
+    uint32_t policy;
+
+    /* Size of the data area of each slot (multiple of the page size) and
+     * offset of the data area of slot 0 from the start of the ring */
+    uint64_t slot_size;
+    uint64_t data_offset;
+
+    /* Sequence number of the last published frame */
+    _Atomic uint64_t write_seq;
+
+    /* Futex words: 'head' is incremented when a frame is published (or the
+     * ring is closed), 'tail' when a consumer releases a frame or detaches */
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+
+    /* Non-zero after the last frame has been published */
+    _Atomic uint32_t closed;
+
+    uint32_t reserved;
+
+    /* Consumers attached to the ring */
+    shmring_reader_t readers[SHMRING_MAX_READERS];
+
+    /* Headers of the slots */
+    shmring_slot_t slots[SHMRING_MAX_SLOTS];
+
+} shmring_header_t;
+
+typedef struct
+{
+    /* Statistics of the producer */
+
+    /* The number of frames published */
+    uint64_t publish_count;
+
+    /* The number of frames overwritten before a consumer read them
+     * ('SHMRING_POLICY_DROP') */
+    uint64_t drop_count;
+
+    /* The number of frames not published because they do not fit in a slot */
+    uint64_t too_big_count;
+
+    /* The number of consumers detached by the producer because their process
+     * has exited without 'shmring_detach' */
+    uint32_t dead_readers;
+
+    /* Time (in ns) the producer waited for consumers (policy 'block') */
+    uint64_t wait_ns;
+    uint64_t wait_ns_max;
+
+} shmring_stats_t;
+
+typedef struct
+{
+    /* memfd of the ring */
+    int fd;
+
+    /* Mapping of the whole ring and its size */
+    shmring_header_t * p_header;
+    size_t map_size;
+
+    /* Index of the entry of 'readers' of this consumer (consumers only) */
+    int32_t reader_idx;
+
+    /* Statistics (producer only) */
+    shmring_stats_t stats;
+
+} shmring_t;
+
+typedef struct
+{
+    /* Header of the slot which holds the frame */
+    const shmring_slot_t * p_slot;
+
+    /* Data of the frame ('p_slot->len' bytes) */
+    const uint8_t * p_data;
+
+    /* Sequence number of the frame */
+    uint64_t seq;
+
+} shmring_frame_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Functions of the producer */
+
+/* Create a ring of 'slot_count' slots in a new memfd. Each slot holds a frame
+ * of up to 'slot_size' bytes. Pages of the memfd are only allocated when
+ * they are first written, so 'slot_size' can be as large as the largest
+ * frame expected.
+ * Return true if successful. Otherwise, return false */
+bool shmring_create(shmring_t * p_ring, uint32_t slot_count, size_t slot_size,
+                    shmring_policy_t policy);
+
+/* Wait up to 'timeout_ms' ms until a consumer attaches to 'p_ring'.
+ * Return true if a consumer is attached. Otherwise, return false */
+bool shmring_wait_reader(shmring_t * p_ring, uint32_t timeout_ms);
+
+/* Copy a frame of 'len' bytes at 'p_data' to a slot of 'p_ring' and notify
+ * consumers. 'p_geometry' gives the width, height, stride and slice height
+ * of the frame (its other members are ignored).
+ * Return true if successful. Otherwise (the frame does not fit in a slot),
+ * return false */
+bool shmring_publish(shmring_t * p_ring, const uint8_t * p_data, size_t len,
+                     const shmring_slot_t * p_geometry, int64_t timestamp_us);
+
+/* Tell consumers that no more frame will be published, then unmap and
+ * close the ring (consumers keep their own mapping) */
+void shmring_close(shmring_t * p_ring);
+
+/* Print statistics of 'p_ring' (call it after 'shmring_close') */
+void shmring_print_stats(shmring_t * p_ring);
+
+/* Functions of the consumers */
+
+/* Open the ring at 'p_path' (for example, "/proc/<pid>/fd/<fd>" as printed by
+ * the producer), map it and register as a consumer.
+ * Return true if successful. Otherwise, return false */
+bool shmring_attach(shmring_t * p_ring, const char * p_path);
+
+/* Wait up to 'timeout_ms' ms (-1 to wait forever) for the oldest frame newer
+ * than the last released one, and hold it in '*p_frame' until
+ * 'shmring_release' is called. A consumer holds one frame at a time.
+ * Return true if successful. Otherwise (timeout or the ring is closed and
+ * all its frames have been read), return false */
+bool shmring_next(shmring_t * p_ring, shmring_frame_t * p_frame,
+                  int32_t timeout_ms);
+
+/* Release the frame held in 'p_frame', so that the producer can reuse its
+ * slot */
+void shmring_release(shmring_t * p_ring, const shmring_frame_t * p_frame);
+
+/* Unregister the consumer, then unmap and close the ring */
+void shmring_detach(shmring_t * p_ring);
+
+#endif /* _SHMRING_H_ */
@@ -0,0 +1,379 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: trace.c
+ *
+ * DESCRIPTION:
+ *   Low-overhead tracer of OMX calls, OMX callbacks and application work
+ *   definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'trace.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <time.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/syscall.h>
+
+#include "trace.h"
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Records (the oldest ones are overwritten when the ring is full) */
+    trace_record_t records[TRACE_RING_SIZE];
+
+    /* The number of records written so far. Only the owner thread writes
+     * it; 'trace_write_chrome' reads it */
+    atomic_uint_fast64_t head;
+
+    /* Thread ID of the owner and its name (empty if not named) */
+    long tid;
+    char name[TRACE_NAME_LEN];
+
+} trace_ring_t;
+
+typedef struct
+{
+    /* Name and category of the event in the trace */
+    const char * p_name;
+    const char * p_cat;
+
+    /* Names of 'arg0' and 'arg1' (NULL if unused) */
+    const char * p_arg0;
+    const char * p_arg1;
+
+    /* True if 'arg0' is a buffer header */
+    bool arg0_is_buf;
+
+} trace_desc_t;
+
+/******************************************************************************
+ *                                 VARIABLES                                  *
+ ******************************************************************************/
+
+bool trace_enabled = false;
+
+/* Description of each 'trace_event_t' */
+static const trace_desc_t trace_descs[TRACE_EVENT_COUNT] =
+{
+    [TRACE_EVENT_SEND_COMMAND]      = { "OMX_SendCommand", "omx",
+                                        "cmd", "param", false },
+    [TRACE_EVENT_GET_STATE]         = { "OMX_GetState", "omx",
+                                        NULL, "state", false },
+    [TRACE_EVENT_ALLOCATE_BUFFER]   = { "OMX_AllocateBuffer", "omx",
+                                        "buf", "port", true },
+    [TRACE_EVENT_USE_BUFFER]        = { "OMX_UseBuffer", "omx",
+                                        "buf", "port", true },
+    [TRACE_EVENT_FREE_BUFFER]       = { "OMX_FreeBuffer", "omx",
+                                        "buf", "port", true },
+    [TRACE_EVENT_EMPTY_THIS_BUFFER] = { "OMX_EmptyThisBuffer", "omx",
+                                        "buf", "filled", true },
+    [TRACE_EVENT_FILL_THIS_BUFFER]  = { "OMX_FillThisBuffer", "omx",
+                                        "buf", NULL, true },
+    [TRACE_EVENT_EVENT_HANDLER]     = { "EventHandler", "callback",
+                                        "event", "data1", false },
+    [TRACE_EVENT_EMPTY_BUFFER_DONE] = { "EmptyBufferDone", "callback",
+                                        "buf", NULL, true },
+    [TRACE_EVENT_FILL_BUFFER_DONE]  = { "FillBufferDone", "callback",
+                                        "buf", "filled", true },
+    [TRACE_EVENT_SETUP_IN_BUF]      = { "setup_in_buf", "app",
+                                        "buf", "filled", true },
+    [TRACE_EVENT_WRITER_COPY]       = { "writer copy", "app",
+                                        "buf", "filled", true },
+    [TRACE_EVENT_WRITER_WRITE]      = { "writer write", "app",
+                                        "bytes", NULL, false },
+    [TRACE_EVENT_READER_READ]       = { "reader read", "app",
+                                        "bytes", NULL, false },
+};
+
+/* Rings of all traced threads. A ring is never freed */
+static _Atomic(trace_ring_t *) trace_rings[TRACE_MAX_THREADS];
+static atomic_uint trace_ring_count;
+
+/* Time (in ns) at which tracing was enabled (origin of the trace) */
+static uint64_t trace_origin_ns;
+
+/* Ring of the calling thread (NULL until its first record) */
+static __thread trace_ring_t * p_thread_ring;
+
+/* True if the calling thread could not get a ring */
+static __thread bool thread_untraced;
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get the ring of the calling thread. Create it at the first call.
+ * Return NULL if the thread cannot be traced */
+static trace_ring_t * trace_get_ring(void);
+
+/* Write 'p_record' of the thread 'tid' as Chrome trace events */
+static void trace_write_record(FILE * p_file, long tid,
+                               const trace_record_t * p_record);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+void trace_enable(void)
+{
+    trace_origin_ns = trace_clock_ns();
+    trace_enabled   = true;
+}
+
+uint64_t trace_clock_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+void trace_push(trace_event_t event, uint64_t start_ns,
+                uint64_t arg0, uint32_t arg1)
+{
+    trace_ring_t * p_ring = trace_get_ring();
+    trace_record_t * p_record = NULL;
+
+    uint64_t head = 0;
+
+    if (p_ring == NULL)
+    {
+        return;
+    }
+
+    head = atomic_load_explicit(&p_ring->head, memory_order_relaxed);
+
+    p_record = &p_ring->records[head & (TRACE_RING_SIZE - 1)];
+
+    p_record->start_ns    = start_ns;
+    p_record->duration_ns = trace_clock_ns() - start_ns;
+    p_record->arg0        = arg0;
+    p_record->arg1        = arg1;
+    p_record->event       = (uint32_t)event;
+
+    /* Publish the record after its content */
+    atomic_store_explicit(&p_ring->head, head + 1, memory_order_release);
+}
+
+void trace_name_thread(const char * p_name)
+{
+    trace_ring_t * p_ring = NULL;
+
+    if (!trace_enabled || (p_name == NULL))
+    {
+        return;
+    }
+
+    p_ring = trace_get_ring();
+    if (p_ring != NULL)
+    {
+        strncpy(p_ring->name, p_name, TRACE_NAME_LEN - 1);
+    }
+}
+
+bool trace_write_chrome(const char * p_file_name)
+{
+    FILE * p_file = NULL;
+    trace_ring_t * p_ring = NULL;
+
+    uint32_t ring_count = 0;
+    uint32_t index      = 0;
+
+    uint64_t head  = 0;
+    uint64_t first = 0;
+    uint64_t pos   = 0;
+
+    uint64_t record_count = 0;
+    uint64_t lost_count   = 0;
+
+    if (p_file_name == NULL)
+    {
+        return false;
+    }
+
+    p_file = fopen(p_file_name, "w");
+    if (p_file == NULL)
+    {
+        printf("Error: Failed to open file '%s'\n", p_file_name);
+        return false;
+    }
+
+    fprintf(p_file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    fprintf(p_file, "{\"name\": \"process_name\", \"ph\": \"M\", "
+            "\"pid\": %d, \"args\": {\"name\": \"omx\"}},\n", (int)getpid());
+
+    ring_count = atomic_load(&trace_ring_count);
+    if (ring_count > TRACE_MAX_THREADS)
+    {
+        ring_count = TRACE_MAX_THREADS;
+    }
+
+    for (index = 0; index < ring_count; index++)
+    {
+        p_ring = atomic_load(&trace_rings[index]);
+        if (p_ring == NULL)
+        {
+            continue;
+        }
+
+        if (p_ring->name[0] != '\0')
+        {
+            fprintf(p_file, "{\"name\": \"thread_name\", \"ph\": \"M\", "
+                    "\"pid\": %d, \"tid\": %ld, \"args\": {\"name\": \"%s\"}},\n",
+                    (int)getpid(), p_ring->tid, p_ring->name);
+        }
+
+        head  = atomic_load_explicit(&p_ring->head, memory_order_acquire);
+        first = (head > TRACE_RING_SIZE) ? (head - TRACE_RING_SIZE) : 0;
+
+        for (pos = first; pos < head; pos++)
+        {
+            trace_write_record(p_file, p_ring->tid,
+                               &p_ring->records[pos & (TRACE_RING_SIZE - 1)]);
+        }
+
+        record_count += head - first;
+        lost_count   += first;
+    }
+
+    /* Every event ends with a comma, so the list is closed by a metadata
+     * event without one */
+    fprintf(p_file, "{\"name\": \"trace_end\", \"ph\": \"M\", \"pid\": %d}\n"
+            "]}\n", (int)getpid());
+
+    fclose(p_file);
+
+    printf("Trace: %llu records of %u threads written to '%s' "
+           "(%llu overwritten)\n", (unsigned long long)record_count,
+           ring_count, p_file_name, (unsigned long long)lost_count);
+
+    return true;
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static trace_ring_t * trace_get_ring(void)
+{
+    uint32_t index = 0;
+
+    if ((p_thread_ring != NULL) || thread_untraced)
+    {
+        return p_thread_ring;
+    }
+
+    /* Only the first record of a thread allocates */
+    index = atomic_fetch_add(&trace_ring_count, 1);
+    if (index >= TRACE_MAX_THREADS)
+    {
+        thread_untraced = true;
+        return NULL;
+    }
+
+    p_thread_ring = (trace_ring_t *)calloc(1, sizeof(trace_ring_t));
+    if (p_thread_ring == NULL)
+    {
+        thread_untraced = true;
+        return NULL;
+    }
+
+    p_thread_ring->tid = syscall(SYS_gettid);
+    atomic_init(&p_thread_ring->head, 0);
+
+    atomic_store(&trace_rings[index], p_thread_ring);
+
+    return p_thread_ring;
+}
+
+static void trace_write_record(FILE * p_file, long tid,
+                               const trace_record_t * p_record)
+{
+    const trace_desc_t * p_desc = NULL;
+
+    int pid = (int)getpid();
+
+    double ts_us  = 0;
+    double dur_us = 0;
+
+    if (p_record->event >= TRACE_EVENT_COUNT)
+    {
+        return;
+    }
+
+    p_desc = &trace_descs[p_record->event];
+
+    ts_us  = (double)(int64_t)(p_record->start_ns - trace_origin_ns) / 1e3;
+    dur_us = p_record->duration_ns / 1e3;
+
+    fprintf(p_file, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+            "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %ld, "
+            "\"args\": {", p_desc->p_name, p_desc->p_cat, ts_us, dur_us,
+            pid, tid);
+
+    if (p_desc->p_arg0 != NULL)
+    {
+        if (p_desc->arg0_is_buf)
+        {
+            fprintf(p_file, "\"%s\": \"0x%llx\"", p_desc->p_arg0,
+                    (unsigned long long)p_record->arg0);
+        }
+        else
+        {
+            fprintf(p_file, "\"%s\": %llu", p_desc->p_arg0,
+                    (unsigned long long)p_record->arg0);
+        }
+    }
+
+    if (p_desc->p_arg1 != NULL)
+    {
+        fprintf(p_file, "%s\"%s\": %u", (p_desc->p_arg0 != NULL) ? ", " : "",
+                p_desc->p_arg1, p_record->arg1);
+    }
+
+    fprintf(p_file, "}},\n");
+
+    /* A buffer is owned by the MC from 'OMX_EmptyThisBuffer' to
+     * EmptyBufferDone (or 'OMX_FillThisBuffer' to FillBufferDone) */
+    switch (p_record->event)
+    {
+        case TRACE_EVENT_EMPTY_THIS_BUFFER:
+        case TRACE_EVENT_FILL_THIS_BUFFER:
+        case TRACE_EVENT_EMPTY_BUFFER_DONE:
+        case TRACE_EVENT_FILL_BUFFER_DONE:
+        {
+            fprintf(p_file, "{\"name\": \"%s buffer in MC\", \"cat\": "
+                    "\"buffer\", \"ph\": \"%s\", \"id\": \"0x%llx\", "
+                    "\"ts\": %.3f, \"pid\": %d, \"tid\": %ld},\n",
+                    ((p_record->event == TRACE_EVENT_EMPTY_THIS_BUFFER) ||
+                     (p_record->event == TRACE_EVENT_EMPTY_BUFFER_DONE)) ?
+                    "input" : "output",
+                    ((p_record->event == TRACE_EVENT_EMPTY_THIS_BUFFER) ||
+                     (p_record->event == TRACE_EVENT_FILL_THIS_BUFFER)) ?
+                    "b" : "e",
+                    (unsigned long long)p_record->arg0, ts_us, pid, tid);
+        }
+        break;
+
+        default:
+        {
+            /* Not a buffer exchange */
+        }
+        break;
+    }
+}
@@ -0,0 +1,127 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: tuner.h
+ *
+ * DESCRIPTION:
+ *   Tuner of the buffer counts of input and output ports.
+ *
+ *   'tuner_sweep' runs the pipeline (through a function of the application)
+ *   with more and more buffers, starting from 'nBufferCountMin' of each
+ *   port, and measures its frame rate, p99 latency and buffer memory:
+ *     1. The output count goes up while the input count stays at its
+ *        minimum.
+ *     2. The input count goes up while the output count stays at the
+ *        count chosen in step 1.
+ *
+ *   For each port, the chosen count is the smallest one whose frame rate is
+ *   within 'TUNER_FPS_TOLERANCE' of the best frame rate of its sweep. More
+ *   buffers would only add memory (and latency). A sweep stops two counts
+ *   after the last significant gain.
+ *
+ *   The chosen counts are saved to a text profile, which later runs load
+ *   with 'tuner_load_profile' instead of the default counts:
+ *
+ *     # Comment
+ *     in_buffer_count = 2
+ *     out_buffer_count = 3
+ *
+ * PUBLIC FUNCTIONS:
+ *   tuner_sweep
+ *   tuner_print_report
+ *   tuner_save_profile
+ *   tuner_load_profile
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _TUNER_H_
+#define _TUNER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The maximum number of measured configurations */
+#define TUNER_MAX_RESULTS 64
+
+/* The number of runs of each configuration (the fastest one is kept, so that
+ * a run slowed down by other processes does not mislead the tuner) */
+#define TUNER_REPEAT 3
+
+/* Relative loss of frame rate accepted to save buffers (0.03 = 3%) */
+#define TUNER_FPS_TOLERANCE 0.03
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* The number of buffers of input and output ports */
+    uint32_t in_buf_cnt;
+    uint32_t out_buf_cnt;
+
+} tuner_profile_t;
+
+typedef struct
+{
+    /* Buffer counts of the run */
+    tuner_profile_t profile;
+
+    /* Frame rate and 99th percentile of end-to-end latency (in ms) */
+    double fps;
+    double p99_ms;
+
+    /* Memory (in bytes) of the buffers of both ports */
+    uint64_t mem_bytes;
+
+} tuner_result_t;
+
+/* Run the pipeline with the buffer counts of 'p_profile' and store its
+ * measurements to 'p_result'.
+ * Return true if successful. Otherwise, return false */
+typedef bool (*tuner_run_fn)(const tuner_profile_t * p_profile,
+                             tuner_result_t * p_result, void * p_ctx);
+
+typedef struct
+{
+    /* Measured configurations (in order of measurement) */
+    tuner_result_t results[TUNER_MAX_RESULTS];
+    uint32_t result_count;
+
+    /* Index of the chosen configuration in 'results' */
+    uint32_t best_index;
+
+} tuner_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Sweep the buffer counts from 'p_min' up to 'p_max' (see above) by calling
+ * 'run_fn(profile, result, p_run_ctx)'.
+ * Return true if successful. Otherwise, return false */
+bool tuner_sweep(tuner_t * p_tuner, const tuner_profile_t * p_min,
+                 const tuner_profile_t * p_max,
+                 tuner_run_fn run_fn, void * p_run_ctx);
+
+/* Print the chosen configuration */
+void tuner_print_report(const tuner_t * p_tuner);
+
+/* Save the chosen configuration (and the measurements as comments) to
+ * 'p_file_name'. 'p_app_name' is written to the header comment.
+ * Return true if successful. Otherwise, return false */
+bool tuner_save_profile(const tuner_t * p_tuner, const char * p_file_name,
+                        const char * p_app_name);
+
+/* Load buffer counts from profile 'p_file_name' to 'p_profile'.
+ * Return true if successful. Otherwise, return false */
+bool tuner_load_profile(const char * p_file_name, tuner_profile_t * p_profile);
+
+#endif /* _TUNER_H_ */
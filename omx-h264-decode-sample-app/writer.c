@@ -0,0 +1,802 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: writer.c
+ *
+ * DESCRIPTION:
+ *   Asynchronous output writer definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'writer.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+/* Needed for 'O_DIRECT' */
+#define _GNU_SOURCE
+
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "writer.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get current time (in ns) of the monotonic clock */
+static uint64_t writer_now_ns(void);
+
+/* Open 'p_file_name' and allocate staging buffers ('stage_size' bytes each).
+ * Return true if successful. Otherwise, return false */
+static bool writer_open_file(writer_t * p_writer, const char * p_file_name,
+                             size_t stage_size, bool direct_io);
+
+/* Make sure the copy thread owns a staging buffer. Wait for the I/O thread
+ * if all staging buffers are being written */
+static writer_stage_t * writer_get_stage(writer_t * p_writer);
+
+/* Pass the staging buffer being filled to the I/O thread */
+static void writer_submit_stage(writer_t * p_writer);
+
+/* Copy 'len' bytes at 'p_src' to staging buffers */
+static void writer_copy(writer_t * p_writer, const uint8_t * p_src, size_t len);
+
+/* Copy 'len' bytes of a row at 'p_src' to 'p_dst' */
+static void writer_copy_row(uint8_t * p_dst, const uint8_t * p_src, size_t len);
+
+/* Copy the first 'width' bytes of 'rows' rows at 'p_src' (rows are 'stride'
+ * bytes apart) to staging buffers */
+static void writer_copy_rows(writer_t * p_writer, const uint8_t * p_src,
+                             uint32_t rows, uint32_t width, uint32_t stride);
+
+/* Convert the frame in 'p_buf' to staging buffers with 'p_convert'.
+ * Return true if successful. Otherwise (the buffer is smaller than the frame),
+ * return false */
+static bool writer_convert(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Copy the visible part of NV12 frame in 'p_buf' to staging buffers.
+ * Return true if successful. Otherwise (the buffer is smaller than the frame
+ * described by 'layout'), return false */
+static bool writer_copy_nv12(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Publish the frame in 'p_buf' to the ring. Frames which do not fit in a
+ * slot are dropped */
+static void writer_publish(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Write 'len' bytes at 'p_data' to output file.
+ * Return true if successful. Otherwise, return false */
+static bool writer_write_all(writer_t * p_writer,
+                             const uint8_t * p_data, size_t len);
+
+/* Thread functions */
+static void * writer_copy_thread(void * p_param);
+static void * writer_io_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool writer_open(writer_t * p_writer, const char * p_file_name,
+                 uint32_t buf_count, size_t stage_size, bool direct_io)
+{
+    /* Check parameters */
+    assert(p_writer != NULL);
+    assert((buf_count > 0) && (stage_size > 0));
+
+    memset(p_writer, 0, sizeof(writer_t));
+
+    p_writer->fd = -1;
+
+    /* Without output file, staging buffers are not allocated. The copy
+     * thread still passes an empty one to the I/O thread to ask it to exit */
+    if ((p_file_name != NULL) &&
+        !writer_open_file(p_writer, p_file_name, stage_size, direct_io))
+    {
+        writer_close(p_writer);
+        return false;
+    }
+
+    if (!queue_init(&p_writer->buf_queue, buf_count))
+    {
+        printf("Error: Failed to allocate queue of writer\n");
+        writer_close(p_writer);
+        return false;
+    }
+
+    sem_init(&p_writer->smp_buf, 0, 0);
+    sem_init(&p_writer->smp_stage_full, 0, 0);
+    sem_init(&p_writer->smp_stage_free, 0, WRITER_STAGE_COUNT);
+
+    atomic_init(&p_writer->stop, false);
+
+    return true;
+}
+
+void writer_set_nv12_layout(writer_t * p_writer,
+                            uint32_t width, uint32_t height,
+                            uint32_t stride, uint32_t slice_height)
+{
+    /* Check parameters */
+    assert(p_writer != NULL);
+    assert((width > 0) && (width <= stride) && (height <= slice_height));
+
+    p_writer->layout.width        = width;
+    p_writer->layout.height       = height;
+    p_writer->layout.stride       = stride;
+    p_writer->layout.slice_height = slice_height;
+
+    /* Frames without padding are copied as a whole */
+    p_writer->pack_nv12 = (width != stride) || (height != slice_height);
+}
+
+void writer_set_convert(writer_t * p_writer, convert_t * p_convert)
+{
+    /* Check parameter */
+    assert(p_writer != NULL);
+
+    p_writer->p_convert = p_convert;
+
+    if ((p_convert != NULL) &&
+        (convert_get_frame_size(p_convert) > p_writer->stage_size))
+    {
+        printf("Warning: Converted frames (%zu bytes) do not fit in staging "
+               "buffers, they are copied once more\n",
+               convert_get_frame_size(p_convert));
+    }
+}
+
+void writer_set_ring(writer_t * p_writer, shmring_t * p_ring)
+{
+    /* Check parameter */
+    assert(p_writer != NULL);
+
+    p_writer->p_ring = p_ring;
+}
+
+bool writer_start(writer_t * p_writer,
+                  writer_release_fn release_fn, void * p_release_ctx)
+{
+    /* Check parameters */
+    assert((p_writer != NULL) && (release_fn != NULL));
+
+    p_writer->release_fn    = release_fn;
+    p_writer->p_release_ctx = p_release_ctx;
+
+    if (pthread_create(&p_writer->io_thread, NULL,
+                       writer_io_thread, p_writer) != 0)
+    {
+        printf("Error: Failed to create I/O thread of writer\n");
+        return false;
+    }
+
+    if (pthread_create(&p_writer->copy_thread, NULL,
+                       writer_copy_thread, p_writer) != 0)
+    {
+        printf("Error: Failed to create copy thread of writer\n");
+
+        /* Let the I/O thread exit with an empty staging buffer */
+        p_writer->stages[0].len = 0;
+        sem_post(&p_writer->smp_stage_full);
+        pthread_join(p_writer->io_thread, NULL);
+
+        p_writer->release_fn = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void writer_push(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    /* Check parameters */
+    assert((p_writer != NULL) && (p_buf != NULL));
+
+    /* The queue is never full because it can hold all output buffers */
+    assert(queue_push(&p_writer->buf_queue, p_buf));
+    sem_post(&p_writer->smp_buf);
+}
+
+bool writer_close(writer_t * p_writer)
+{
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_writer != NULL);
+
+    if (p_writer->release_fn != NULL)
+    {
+        /* The copy thread drains the queue, submits the last staging buffer
+         * and then asks the I/O thread to exit */
+        atomic_store(&p_writer->stop, true);
+        sem_post(&p_writer->smp_buf);
+
+        pthread_join(p_writer->copy_thread, NULL);
+        pthread_join(p_writer->io_thread, NULL);
+
+        p_writer->release_fn = NULL;
+    }
+
+    if (p_writer->buf_queue.pp_items != NULL)
+    {
+        queue_deinit(&p_writer->buf_queue);
+
+        sem_destroy(&p_writer->smp_buf);
+        sem_destroy(&p_writer->smp_stage_full);
+        sem_destroy(&p_writer->smp_stage_free);
+    }
+
+    for (index = 0; index < WRITER_STAGE_COUNT; index++)
+    {
+        free(p_writer->stages[index].p_data);
+        p_writer->stages[index].p_data = NULL;
+    }
+
+    free(p_writer->p_frame);
+    p_writer->p_frame = NULL;
+
+    if (p_writer->fd >= 0)
+    {
+        /* Data written through the page cache may only fail now */
+        if (close(p_writer->fd) != 0)
+        {
+            printf("Error: Failed to close output file (errno %d)\n", errno);
+            p_writer->write_failed = true;
+        }
+
+        p_writer->fd = -1;
+    }
+
+    return !p_writer->write_failed;
+}
+
+void writer_print_stats(writer_t * p_writer)
+{
+    writer_stats_t * p_stats = NULL;
+
+    /* Check parameter */
+    assert(p_writer != NULL);
+
+    p_stats = &p_writer->stats;
+
+    printf("Writer: %llu buffers, queue depth avg %.2f / max %u\n",
+           (unsigned long long)p_stats->buf_count,
+           (p_stats->buf_count > 0) ?
+           (double)p_stats->queue_depth_sum / p_stats->buf_count : 0.0,
+           p_stats->queue_depth_max);
+
+    if (p_writer->p_ring != NULL)
+    {
+        /* Frames were published to the ring, not written to output file */
+        return;
+    }
+
+    printf("Writer: %llu writes, %llu bytes, write time %.3f ms / max %.3f ms\n",
+           (unsigned long long)p_stats->write_count,
+           (unsigned long long)p_stats->write_bytes,
+           p_stats->write_ns / 1e6, p_stats->write_ns_max / 1e6);
+
+    printf("Writer: stall time %.3f ms / max %.3f ms%s\n",
+           p_stats->stall_ns / 1e6, p_stats->stall_ns_max / 1e6,
+           p_writer->direct_io ? " (O_DIRECT)" : "");
+
+    if (p_writer->pack_nv12)
+    {
+        printf("Writer: packed NV12 %ux%u (stride %u, slice height %u), "
+               "%llu padding bytes dropped\n",
+               p_writer->layout.width, p_writer->layout.height,
+               p_writer->layout.stride, p_writer->layout.slice_height,
+               (unsigned long long)p_stats->pad_bytes);
+    }
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static uint64_t writer_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static bool writer_open_file(writer_t * p_writer, const char * p_file_name,
+                             size_t stage_size, bool direct_io)
+{
+    uint32_t index = 0;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    if (direct_io)
+    {
+        p_writer->fd = open(p_file_name,
+                            O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (p_writer->fd < 0)
+        {
+            printf("Warning: 'O_DIRECT' is not supported for '%s'\n",
+                   p_file_name);
+        }
+    }
+
+    p_writer->direct_io = (p_writer->fd >= 0);
+
+    if (p_writer->fd < 0)
+    {
+        p_writer->fd = open(p_file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (p_writer->fd < 0)
+        {
+            printf("Error: Failed to open '%s'\n", p_file_name);
+            return false;
+        }
+    }
+
+    /* 'O_DIRECT' requires page-aligned addresses and lengths */
+    p_writer->stage_size = ROUND_UP(stage_size, page_size);
+
+    for (index = 0; index < WRITER_STAGE_COUNT; index++)
+    {
+        if (posix_memalign((void **)&p_writer->stages[index].p_data,
+                           page_size, p_writer->stage_size) != 0)
+        {
+            printf("Error: Failed to allocate staging buffer '%d'\n", index);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static writer_stage_t * writer_get_stage(writer_t * p_writer)
+{
+    uint64_t start_ns = 0;
+    uint64_t stall_ns = 0;
+
+    if (!p_writer->fill_busy)
+    {
+        if (sem_trywait(&p_writer->smp_stage_free) != 0)
+        {
+            /* All staging buffers are being written, so the storage is
+             * holding the pipeline back */
+            start_ns = writer_now_ns();
+            sem_wait(&p_writer->smp_stage_free);
+            stall_ns = writer_now_ns() - start_ns;
+
+            p_writer->stats.stall_ns += stall_ns;
+            if (stall_ns > p_writer->stats.stall_ns_max)
+            {
+                p_writer->stats.stall_ns_max = stall_ns;
+            }
+        }
+
+        p_writer->stages[p_writer->fill_idx].len = 0;
+        p_writer->fill_busy = true;
+    }
+
+    return &p_writer->stages[p_writer->fill_idx];
+}
+
+static void writer_submit_stage(writer_t * p_writer)
+{
+    p_writer->fill_busy = false;
+    p_writer->fill_idx  = (p_writer->fill_idx + 1) % WRITER_STAGE_COUNT;
+
+    sem_post(&p_writer->smp_stage_full);
+}
+
+static void writer_copy(writer_t * p_writer, const uint8_t * p_src, size_t len)
+{
+    size_t chunk = 0;
+    writer_stage_t * p_stage = NULL;
+
+    while (len > 0)
+    {
+        p_stage = writer_get_stage(p_writer);
+
+        chunk = p_writer->stage_size - p_stage->len;
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+
+        memcpy(p_stage->p_data + p_stage->len, p_src, chunk);
+
+        p_stage->len += chunk;
+        p_src        += chunk;
+        len          -= chunk;
+
+        if (p_stage->len == p_writer->stage_size)
+        {
+            writer_submit_stage(p_writer);
+        }
+    }
+}
+
+static void writer_copy_row(uint8_t * p_dst, const uint8_t * p_src, size_t len)
+{
+#if defined(__SSE2__)
+    __m128i bytes0;
+    __m128i bytes1;
+    __m128i bytes2;
+    __m128i bytes3;
+
+    while (len >= 64)
+    {
+        bytes0 = _mm_loadu_si128((const __m128i *)(p_src));
+        bytes1 = _mm_loadu_si128((const __m128i *)(p_src + 16));
+        bytes2 = _mm_loadu_si128((const __m128i *)(p_src + 32));
+        bytes3 = _mm_loadu_si128((const __m128i *)(p_src + 48));
+
+        _mm_storeu_si128((__m128i *)(p_dst),      bytes0);
+        _mm_storeu_si128((__m128i *)(p_dst + 16), bytes1);
+        _mm_storeu_si128((__m128i *)(p_dst + 32), bytes2);
+        _mm_storeu_si128((__m128i *)(p_dst + 48), bytes3);
+
+        p_src += 64;
+        p_dst += 64;
+        len   -= 64;
+    }
+
+    while (len >= 16)
+    {
+        _mm_storeu_si128((__m128i *)p_dst,
+                         _mm_loadu_si128((const __m128i *)p_src));
+
+        p_src += 16;
+        p_dst += 16;
+        len   -= 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16_t bytes0;
+    uint8x16_t bytes1;
+    uint8x16_t bytes2;
+    uint8x16_t bytes3;
+
+    while (len >= 64)
+    {
+        bytes0 = vld1q_u8(p_src);
+        bytes1 = vld1q_u8(p_src + 16);
+        bytes2 = vld1q_u8(p_src + 32);
+        bytes3 = vld1q_u8(p_src + 48);
+
+        vst1q_u8(p_dst,      bytes0);
+        vst1q_u8(p_dst + 16, bytes1);
+        vst1q_u8(p_dst + 32, bytes2);
+        vst1q_u8(p_dst + 48, bytes3);
+
+        p_src += 64;
+        p_dst += 64;
+        len   -= 64;
+    }
+
+    while (len >= 16)
+    {
+        vst1q_u8(p_dst, vld1q_u8(p_src));
+
+        p_src += 16;
+        p_dst += 16;
+        len   -= 16;
+    }
+#endif
+
+    /* The last bytes (or the whole row without SIMD) */
+    if (len > 0)
+    {
+        memcpy(p_dst, p_src, len);
+    }
+}
+
+static void writer_copy_rows(writer_t * p_writer, const uint8_t * p_src,
+                             uint32_t rows, uint32_t width, uint32_t stride)
+{
+    uint32_t row = 0;
+    writer_stage_t * p_stage = NULL;
+
+    for (row = 0; row < rows; row++)
+    {
+        p_stage = writer_get_stage(p_writer);
+
+        if ((p_writer->stage_size - p_stage->len) > width)
+        {
+            /* The row fits in the staging buffer (which is not full after) */
+            writer_copy_row(p_stage->p_data + p_stage->len, p_src, width);
+            p_stage->len += width;
+        }
+        else
+        {
+            /* The row fills the staging buffer up and goes on in the next one */
+            writer_copy(p_writer, p_src, width);
+        }
+
+        p_src += stride;
+    }
+}
+
+static bool writer_convert(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    convert_t * p_convert = p_writer->p_convert;
+    writer_stage_t * p_stage = NULL;
+
+    const uint8_t * p_src = p_buf->pBuffer + p_buf->nOffset;
+
+    size_t frame_len = convert_get_frame_size(p_convert);
+    size_t uv_start  = (size_t)p_convert->stride * p_convert->slice_height;
+
+    if (p_buf->nFilledLen < (uv_start + ((size_t)p_convert->stride *
+                                         ((p_convert->height + 1) / 2))))
+    {
+        printf("Warning: Output buffer (%u bytes) is smaller than NV12 frame\n",
+               (unsigned int)p_buf->nFilledLen);
+        return false;
+    }
+
+    p_stage = writer_get_stage(p_writer);
+
+    if ((p_writer->stage_size - p_stage->len) < frame_len)
+    {
+        /* The frame does not fit in the rest of the staging buffer: convert
+         * it aside, then copy it across staging buffers. Writing the staging
+         * buffer early would leave output file unaligned for 'O_DIRECT' */
+        if (p_writer->frame_size < frame_len)
+        {
+            free(p_writer->p_frame);
+
+            p_writer->p_frame    = (uint8_t *)malloc(frame_len);
+            p_writer->frame_size = (p_writer->p_frame != NULL) ? frame_len : 0;
+            assert(p_writer->p_frame != NULL);
+        }
+
+        convert_frame(p_convert, p_src, p_writer->p_frame);
+        writer_copy(p_writer, p_writer->p_frame, frame_len);
+
+        return true;
+    }
+
+    convert_frame(p_convert, p_src, p_stage->p_data + p_stage->len);
+    p_stage->len += frame_len;
+
+    if (p_stage->len == p_writer->stage_size)
+    {
+        writer_submit_stage(p_writer);
+    }
+
+    return true;
+}
+
+static bool writer_copy_nv12(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    writer_nv12_layout_t * p_layout = &p_writer->layout;
+
+    const uint8_t * p_y  = p_buf->pBuffer + p_buf->nOffset;
+    const uint8_t * p_uv = NULL;
+
+    /* UV plane has a row of interleaved U and V samples per 2 rows of Y */
+    uint32_t uv_rows  = (p_layout->height + 1) / 2;
+    uint32_t uv_width = ROUND_UP(p_layout->width, 2);
+    size_t   uv_start = (size_t)p_layout->stride * p_layout->slice_height;
+
+    size_t frame_len = (size_t)p_layout->width * p_layout->height +
+                       (size_t)uv_width * uv_rows;
+
+    if (p_buf->nFilledLen < (uv_start + ((size_t)p_layout->stride * uv_rows)))
+    {
+        printf("Warning: Output buffer (%u bytes) is smaller than NV12 frame\n",
+               (unsigned int)p_buf->nFilledLen);
+        return false;
+    }
+
+    p_uv = p_y + uv_start;
+
+    writer_copy_rows(p_writer, p_y, p_layout->height,
+                     p_layout->width, p_layout->stride);
+
+    writer_copy_rows(p_writer, p_uv, uv_rows, uv_width, p_layout->stride);
+
+    p_writer->stats.pad_bytes += p_buf->nFilledLen - frame_len;
+
+    return true;
+}
+
+static void writer_publish(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    shmring_slot_t geometry;
+
+    memset(&geometry, 0, sizeof(geometry));
+
+    geometry.width        = p_writer->layout.width;
+    geometry.height       = p_writer->layout.height;
+    geometry.stride       = p_writer->layout.stride;
+    geometry.slice_height = p_writer->layout.slice_height;
+
+    if (!shmring_publish(p_writer->p_ring, p_buf->pBuffer + p_buf->nOffset,
+                         p_buf->nFilledLen, &geometry,
+                         (int64_t)p_buf->nTimeStamp))
+    {
+        printf("Warning: Output buffer (%u bytes) does not fit in a slot "
+               "of the ring\n", (unsigned int)p_buf->nFilledLen);
+    }
+}
+
+static bool writer_write_all(writer_t * p_writer,
+                             const uint8_t * p_data, size_t len)
+{
+    bool is_success = true;
+
+    ssize_t ret = 0;
+    int flags   = 0;
+
+    if (p_writer->direct_io && ((len % p_writer->stage_size) != 0))
+    {
+        /* Only the last staging buffer can be partially filled. Its length
+         * may not be aligned, so write it through the page cache */
+        flags = fcntl(p_writer->fd, F_GETFL);
+        fcntl(p_writer->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+    while (len > 0)
+    {
+        ret = write(p_writer->fd, p_data, len);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            printf("Error: Failed to write output file (errno %d)\n", errno);
+            is_success = false;
+            break;
+        }
+
+        p_data += ret;
+        len    -= (size_t)ret;
+    }
+
+    if ((flags != -1) && ((flags & O_DIRECT) != 0))
+    {
+        /* Bypass the page cache again for the next staging buffers */
+        fcntl(p_writer->fd, F_SETFL, flags);
+    }
+
+    return is_success;
+}
+
+static void * writer_copy_thread(void * p_param)
+{
+    writer_t * p_writer = (writer_t *)p_param;
+    writer_stage_t * p_stage = NULL;
+
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+    uint32_t depth = 0;
+
+    /* Start of the copy of 'p_buf' in the trace */
+    uint64_t trace_ns = 0;
+
+    trace_name_thread("writer copy");
+
+    while (true)
+    {
+        sem_wait(&p_writer->smp_buf);
+
+        depth = queue_size(&p_writer->buf_queue);
+
+        p_buf = (OMX_BUFFERHEADERTYPE *)queue_pop(&p_writer->buf_queue);
+        if (p_buf == NULL)
+        {
+            if (atomic_load(&p_writer->stop))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        p_writer->stats.buf_count++;
+        p_writer->stats.queue_depth_sum += depth;
+        if (depth > p_writer->stats.queue_depth_max)
+        {
+            p_writer->stats.queue_depth_max = depth;
+        }
+
+        trace_ns = trace_now();
+
+        if (p_buf->nFilledLen > 0)
+        {
+            if (p_writer->p_ring != NULL)
+            {
+                writer_publish(p_writer, p_buf);
+            }
+            else if (p_writer->p_convert != NULL)
+            {
+                /* A buffer which is too small is dropped */
+                writer_convert(p_writer, p_buf);
+            }
+            else if (!p_writer->pack_nv12 || !writer_copy_nv12(p_writer, p_buf))
+            {
+                writer_copy(p_writer, p_buf->pBuffer + p_buf->nOffset,
+                            p_buf->nFilledLen);
+            }
+        }
+
+        trace_record(TRACE_EVENT_WRITER_COPY, trace_ns, (uintptr_t)p_buf,
+                     p_buf->nFilledLen);
+
+        /* The data is in a staging buffer, so 'p_buf' can be reused */
+        p_writer->release_fn(p_writer->p_release_ctx, p_buf);
+    }
+
+    /* Submit the last (partially filled) staging buffer */
+    if (p_writer->fill_busy && (p_writer->stages[p_writer->fill_idx].len > 0))
+    {
+        writer_submit_stage(p_writer);
+    }
+
+    /* Submit an empty staging buffer to ask the I/O thread to exit */
+    p_stage = writer_get_stage(p_writer);
+    p_stage->len = 0;
+    writer_submit_stage(p_writer);
+
+    return NULL;
+}
+
+static void * writer_io_thread(void * p_param)
+{
+    writer_t * p_writer = (writer_t *)p_param;
+    writer_stage_t * p_stage = NULL;
+
+    uint64_t start_ns = 0;
+    uint64_t write_ns = 0;
+
+    /* Start of the write in the trace */
+    uint64_t trace_ns = 0;
+
+    trace_name_thread("writer io");
+
+    while (true)
+    {
+        sem_wait(&p_writer->smp_stage_full);
+
+        p_stage = &p_writer->stages[p_writer->write_idx];
+        p_writer->write_idx = (p_writer->write_idx + 1) % WRITER_STAGE_COUNT;
+
+        if (p_stage->len == 0)
+        {
+            /* Empty staging buffer: the copy thread has exited */
+            break;
+        }
+
+        trace_ns = trace_now();
+
+        start_ns = writer_now_ns();
+        if (!p_writer->write_failed &&
+            !writer_write_all(p_writer, p_stage->p_data, p_stage->len))
+        {
+            p_writer->write_failed = true;
+        }
+        write_ns = writer_now_ns() - start_ns;
+
+        trace_record(TRACE_EVENT_WRITER_WRITE, trace_ns, p_stage->len, 0);
+
+        p_writer->stats.write_count++;
+        p_writer->stats.write_bytes += p_stage->len;
+        p_writer->stats.write_ns    += write_ns;
+        if (write_ns > p_writer->stats.write_ns_max)
+        {
+            p_writer->stats.write_ns_max = write_ns;
+        }
+
+        sem_post(&p_writer->smp_stage_free);
+    }
+
+    return NULL;
+}
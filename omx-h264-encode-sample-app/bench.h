@@ -0,0 +1,183 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: bench.h
+ *
+ * DESCRIPTION:
+ *   Benchmark harness for a media component (MC).
+ *
+ *   The application calls a 'bench_on_*' function next to each
+ *   'OMX_EmptyThisBuffer', EmptyBufferDone, 'OMX_FillThisBuffer' and
+ *   FillBufferDone. Each call only takes a timestamp and updates counters
+ *   (nothing is printed), so the harness does not disturb the measured
+ *   pipeline.
+ *
+ *   'bench_on_empty_this_buffer' numbers input buffers through 'nTimeStamp'.
+ *   The MC copies 'nTimeStamp' to the output buffer of the frame, so that
+ *   FillBufferDone can find when the input of the frame was sent. The
+ *   difference is the end-to-end latency of the frame.
+ *
+ *   'bench_write_report' writes a JSON report with:
+ *     - Throughput: frames per second and MB/s of input and output data.
+ *     - End-to-end latency: p50/p95/p99/max and a log2 histogram.
+ *     - Time buffers spend in the MC (input and output ports).
+ *     - Buffer occupancy: average (over time) and maximum number of buffers
+ *       held by the MC on each port.
+ *     - Cost of the application: CPU time of the process per frame (since
+ *       'bench_init') and its peak resident memory.
+ *
+ *   All functions accept a NULL 'p_bench' and then do nothing, so the
+ *   application can call them unconditionally.
+ *
+ * PUBLIC FUNCTIONS:
+ *   bench_init
+ *   bench_deinit
+ *
+ *   bench_on_empty_this_buffer
+ *   bench_on_empty_buffer_done
+ *   bench_on_fill_this_buffer
+ *   bench_on_fill_buffer_done
+ *
+ *   bench_write_report
+ *   bench_get_summary
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <pthread.h>
+
+#include "omx.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The maximum number of buffers per port */
+#define BENCH_MAX_BUFFERS 32
+
+/* The number of buckets of the latency histogram. Bucket 'i' counts
+ * latencies from 2^i to 2^(i+1) microseconds (bucket 0 also counts
+ * latencies below 1 microsecond) */
+#define BENCH_HISTOGRAM_BUCKETS 32
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Buffer sent to the MC and when it was sent */
+    OMX_BUFFERHEADERTYPE * p_buf;
+    uint64_t sent_ns;
+
+} bench_pending_t;
+
+typedef struct
+{
+    /* Buffers sent to the MC and not returned yet */
+    bench_pending_t pending[BENCH_MAX_BUFFERS];
+
+    /* The number of buffers held by the MC now and its maximum */
+    uint32_t held;
+    uint32_t held_max;
+
+    /* Sum of 'held' over time (in buffers x ns) and last time it changed */
+    uint64_t held_area;
+    uint64_t held_last_ns;
+
+    /* Time (in ns) buffers spent in the MC ('sample_count' samples) */
+    uint64_t * p_hold_ns;
+    uint32_t sample_count;
+
+    /* The number of buffers and bytes that went through the port */
+    uint64_t buf_count;
+    uint64_t bytes;
+
+} bench_port_t;
+
+typedef struct
+{
+    /* Name of the application (written to the report) */
+    const char * p_app_name;
+
+    /* If true, a frame ends with an output buffer which has flag
+     * 'OMX_BUFFERFLAG_ENDOFFRAME' (a frame may take several buffers).
+     * Otherwise, each output buffer with data is a frame */
+    bool frame_end_flag;
+
+    /* The maximum number of samples of each kind */
+    uint32_t capacity;
+
+    /* Lock this mutex while updating the statistics (they are updated by
+     * callbacks and application threads) */
+    pthread_mutex_t mutex;
+
+    /* Input and output ports */
+    bench_port_t ports[2];
+
+    /* Time (in ns) each input buffer was sent (indexed by 'nTimeStamp') */
+    uint64_t * p_etb_ns;
+
+    /* The number of input buffers sent */
+    uint64_t etb_count;
+
+    /* End-to-end latency (in ns) of each frame and its histogram */
+    uint64_t * p_latency_ns;
+    uint32_t latency_count;
+    uint64_t histogram[BENCH_HISTOGRAM_BUCKETS];
+
+    /* The number of frames output by the MC */
+    uint64_t frame_count;
+
+    /* The number of samples dropped because 'capacity' was reached */
+    uint64_t dropped;
+
+    /* Time (in ns) of the first 'OMX_EmptyThisBuffer' and of the last
+     * FillBufferDone */
+    uint64_t first_ns;
+    uint64_t last_ns;
+
+    /* CPU time (in ns) of the process at 'bench_init' */
+    uint64_t cpu_start_ns;
+
+} bench_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Initialize 'p_bench' for 'capacity' samples of each kind.
+ * Return true if successful. Otherwise, return false */
+bool bench_init(bench_t * p_bench, const char * p_app_name,
+                uint32_t capacity, bool frame_end_flag);
+
+/* Free the samples of 'p_bench' */
+void bench_deinit(bench_t * p_bench);
+
+/* Call right before 'OMX_EmptyThisBuffer(p_buf)'. It sets 'nTimeStamp' of
+ * 'p_buf' to the index of the input buffer */
+void bench_on_empty_this_buffer(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Call at the beginning of EmptyBufferDone */
+void bench_on_empty_buffer_done(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Call right before 'OMX_FillThisBuffer(p_buf)' */
+void bench_on_fill_this_buffer(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Call at the beginning of FillBufferDone */
+void bench_on_fill_buffer_done(bench_t * p_bench, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Write the JSON report of 'p_bench' to 'p_file_name' ("-" for stdout).
+ * Return true if successful. Otherwise, return false */
+bool bench_write_report(bench_t * p_bench, const char * p_file_name);
+
+/* Get the frame rate and the 99th percentile of end-to-end latency (in ms)
+ * of 'p_bench' (0 if there is no sample) */
+void bench_get_summary(bench_t * p_bench, double * p_fps, double * p_p99_ms);
+
+#endif /* _BENCH_H_ */
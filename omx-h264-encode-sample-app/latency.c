@@ -0,0 +1,238 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: latency.c
+ *
+ * DESCRIPTION:
+ *   Glass-to-bitstream latency of each encoded frame definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'latency.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <time.h>
+
+#include "latency.h"
+#include "logger.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Compare two 'uint64_t' for 'qsort' */
+static int latency_compare(const void * p_a, const void * p_b);
+
+/* Print p50/p99/max of 'count' samples 'p_samples' (sorted in place) */
+static void latency_print_samples(const char * p_name, uint64_t * p_samples,
+                                  uint32_t count);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool latency_init(latency_t * p_latency, uint32_t fps, uint32_t capacity)
+{
+    /* Check parameters */
+    assert((p_latency != NULL) && (fps > 0) && (capacity > 0));
+
+    memset(p_latency, 0, sizeof(latency_t));
+
+    p_latency->period_ns = 1000000000ULL / fps;
+    p_latency->capacity  = capacity;
+
+    atomic_init(&p_latency->capture_count, 0);
+
+    p_latency->p_first_ns = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+    p_latency->p_frame_ns = (uint64_t *)malloc(capacity * sizeof(uint64_t));
+
+    if ((p_latency->p_first_ns == NULL) || (p_latency->p_frame_ns == NULL))
+    {
+        printf("Error: Failed to allocate samples of latency\n");
+        latency_deinit(p_latency);
+        return false;
+    }
+
+    return true;
+}
+
+void latency_deinit(latency_t * p_latency)
+{
+    if (p_latency == NULL)
+    {
+        return;
+    }
+
+    free(p_latency->p_first_ns);
+    free(p_latency->p_frame_ns);
+
+    p_latency->p_first_ns = NULL;
+    p_latency->p_frame_ns = NULL;
+}
+
+void latency_capture(latency_t * p_latency, uint32_t skip_cnt,
+                     OMX_BUFFERHEADERTYPE * p_buf)
+{
+    struct timespec deadline;
+
+    uint64_t now_ns     = 0;
+    uint64_t capture_ns = 0;
+    uint64_t count      = 0;
+
+    if (p_latency == NULL)
+    {
+        return;
+    }
+
+    /* Only this thread stores 'capture_count' */
+    count = atomic_load_explicit(&p_latency->capture_count,
+                                 memory_order_relaxed);
+
+    now_ns = omx_get_time_ns();
+
+    if (count == 0)
+    {
+        p_latency->start_ns = now_ns;
+    }
+    else
+    {
+        p_latency->source_index += (uint64_t)skip_cnt + 1;
+    }
+
+    capture_ns = p_latency->start_ns +
+                 (p_latency->source_index * p_latency->period_ns);
+
+    if (capture_ns > now_ns)
+    {
+        /* The frame has not been captured yet */
+        deadline.tv_sec  = (time_t)(capture_ns / 1000000000ULL);
+        deadline.tv_nsec = (long)(capture_ns % 1000000000ULL);
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                               &deadline, NULL) != 0)
+        {
+            /* Interrupted by a signal */
+        }
+    }
+
+    /* The benchmark numbers input buffers the same way */
+    p_buf->nTimeStamp = (OMX_TICKS)count;
+
+    /* Publish the slot to FillBufferDone */
+    p_latency->capture_ns[count % LATENCY_RING_SIZE] = capture_ns;
+    atomic_store_explicit(&p_latency->capture_count, count + 1,
+                          memory_order_release);
+}
+
+void latency_on_fill_buffer_done(latency_t * p_latency,
+                                 const OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t now_ns     = 0;
+    uint64_t index      = 0;
+    uint64_t count      = 0;
+    uint64_t capture_ns = 0;
+    uint64_t first_ns   = 0;
+    uint64_t frame_ns   = 0;
+
+    if ((p_latency == NULL) || (p_buf->nFilledLen == 0))
+    {
+        return;
+    }
+
+    now_ns = omx_get_time_ns();
+
+    if (p_latency->slice_count == 0)
+    {
+        p_latency->first_ns = now_ns;
+    }
+
+    p_latency->slice_count++;
+
+    if ((p_buf->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) == 0)
+    {
+        /* The next buffers carry the rest of the frame */
+        return;
+    }
+
+    index = (uint64_t)p_buf->nTimeStamp;
+
+    /* Slots below 'count' are written by the feeder thread */
+    count = atomic_load_explicit(&p_latency->capture_count,
+                                 memory_order_acquire);
+
+    if ((index < count) && ((index + LATENCY_RING_SIZE) >= count) &&
+        (p_latency->count < p_latency->capacity))
+    {
+        capture_ns = p_latency->capture_ns[index % LATENCY_RING_SIZE];
+
+        first_ns = p_latency->first_ns - capture_ns;
+        frame_ns = now_ns - capture_ns;
+
+        p_latency->p_first_ns[p_latency->count] = first_ns;
+        p_latency->p_frame_ns[p_latency->count] = frame_ns;
+        p_latency->count++;
+
+        LOG_INFO("Frame %llu: first slice %.3f ms, frame %.3f ms "
+                 "(%u buffers)\n", (unsigned long long)index,
+                 first_ns / 1e6, frame_ns / 1e6, p_latency->slice_count);
+    }
+    else
+    {
+        p_latency->dropped++;
+    }
+
+    p_latency->slice_count = 0;
+}
+
+void latency_print_stats(latency_t * p_latency)
+{
+    if (p_latency == NULL)
+    {
+        return;
+    }
+
+    latency_print_samples("first slice", p_latency->p_first_ns,
+                          p_latency->count);
+    latency_print_samples("frame", p_latency->p_frame_ns, p_latency->count);
+
+    if (p_latency->dropped > 0)
+    {
+        printf("Latency: %llu frames not measured\n",
+               (unsigned long long)p_latency->dropped);
+    }
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static int latency_compare(const void * p_a, const void * p_b)
+{
+    uint64_t a = *(const uint64_t *)p_a;
+    uint64_t b = *(const uint64_t *)p_b;
+
+    return (a > b) - (a < b);
+}
+
+static void latency_print_samples(const char * p_name, uint64_t * p_samples,
+                                  uint32_t count)
+{
+    /* Nearest-rank percentiles */
+    uint32_t p50 = (count + 1) / 2;
+    uint32_t p99 = (uint32_t)((count * 99ULL + 99) / 100);
+
+    if (count == 0)
+    {
+        return;
+    }
+
+    qsort(p_samples, count, sizeof(uint64_t), latency_compare);
+
+    printf("Latency: %s (capture to FillBufferDone) p50 %.3f ms, "
+           "p99 %.3f ms, max %.3f ms (%u frames)\n", p_name,
+           p_samples[p50 - 1] / 1e6, p_samples[p99 - 1] / 1e6,
+           p_samples[count - 1] / 1e6, count);
+}
@@ -0,0 +1,124 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: latency.h
+ *
+ * DESCRIPTION:
+ *   Glass-to-bitstream latency of each encoded frame.
+ *
+ *   Input file has no capture time, so the feeder plays the role of a camera:
+ *   'latency_capture' releases frames at the frame rate of input file and
+ *   stamps each input buffer with its capture time. A frame which waits for
+ *   a free input buffer keeps the time it would have been captured, so the
+ *   wait counts as latency.
+ *
+ *   'latency_on_fill_buffer_done' finds the capture time of each output
+ *   buffer through 'nTimeStamp' (the index of the frame, as numbered by the
+ *   benchmark) and measures:
+ *     - First slice: capture to FillBufferDone of the first buffer of the
+ *       frame. It is when the frame can start to be sent.
+ *     - Frame: capture to FillBufferDone of the buffer which ends the frame
+ *       ('OMX_BUFFERFLAG_ENDOFFRAME').
+ *   Both are logged for each frame and summarized by 'latency_print_stats'.
+ *
+ *   All functions accept a NULL 'p_latency' and then do nothing, so the
+ *   application can call them unconditionally.
+ *
+ * PUBLIC FUNCTIONS:
+ *   latency_init
+ *   latency_deinit
+ *
+ *   latency_capture
+ *   latency_on_fill_buffer_done
+ *
+ *   latency_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <stdatomic.h>
+
+#include "omx.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The number of capture times kept. It must exceed the number of frames in
+ * the encoder (at most the number of input buffers) */
+#define LATENCY_RING_SIZE 64
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Time (in ns) between two frames of input file */
+    uint64_t period_ns;
+
+    /* Capture time (in ns) of the first frame */
+    uint64_t start_ns;
+
+    /* Index of the next frame of input file (dropped frames included) */
+    uint64_t source_index;
+
+    /* The number of frames stamped by 'latency_capture'. The feeder thread
+     * stores it (release) after the slot of the frame in 'capture_ns', and
+     * FillBufferDone loads it (acquire) before reading the slot */
+    atomic_uint_least64_t capture_count;
+
+    /* Capture times (in ns) of the last frames, by index modulo
+     * 'LATENCY_RING_SIZE' */
+    uint64_t capture_ns[LATENCY_RING_SIZE];
+
+    /* FillBufferDone of the first buffer of the current frame (in ns) and
+     * the number of its buffers so far */
+    uint64_t first_ns;
+    uint32_t slice_count;
+
+    /* Latencies (in ns) of the first slice and of the whole frame */
+    uint64_t * p_first_ns;
+    uint64_t * p_frame_ns;
+
+    /* The number of samples and the maximum number of samples */
+    uint32_t count;
+    uint32_t capacity;
+
+    /* The number of frames whose samples could not be kept */
+    uint64_t dropped;
+
+} latency_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Initialize 'p_latency' to release frames at 'fps' frames per second and
+ * to keep up to 'capacity' samples of each kind.
+ * Return true if successful. Otherwise, return false */
+bool latency_init(latency_t * p_latency, uint32_t fps, uint32_t capacity);
+
+/* Free samples of 'p_latency' */
+void latency_deinit(latency_t * p_latency);
+
+/* Wait until the capture time of the next frame, after 'skip_cnt' dropped
+ * frames, and stamp input buffer 'p_buf' with its index (in 'nTimeStamp').
+ * Call it for each input buffer, just before filling it */
+void latency_capture(latency_t * p_latency, uint32_t skip_cnt,
+                     OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Measure the latency of output buffer 'p_buf' and log the latencies of its
+ * frame if it is the last buffer of the frame */
+void latency_on_fill_buffer_done(latency_t * p_latency,
+                                 const OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Print p50/p99/max latencies of 'p_latency' */
+void latency_print_stats(latency_t * p_latency);
+
+#endif /* _LATENCY_H_ */
@@ -0,0 +1,280 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: logger.c
+ *
+ * DESCRIPTION:
+ *   Asynchronous leveled logger definition.
+ *
+ *   The queue is a bounded multi-producer/single-consumer ring. Each record
+ *   has a sequence number which tells whether it is free for the producer
+ *   which reserved its position or full for the consumer.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'logger.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#include "logger.h"
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Equal to the position of the record when it is free, and to the
+     * position + 1 when it holds a message */
+    atomic_size_t seq;
+
+    /* Formatted message */
+    char text[LOGGER_MSG_LEN];
+
+} logger_record_t;
+
+/******************************************************************************
+ *                                 VARIABLES                                  *
+ ******************************************************************************/
+
+int logger_level = LOG_LEVEL_INFO;
+
+/* Queue of records */
+static logger_record_t logger_records[LOGGER_QUEUE_SIZE];
+
+/* Next position to be reserved by a producer */
+static atomic_size_t logger_push_pos;
+
+/* Next position to be written by the thread */
+static atomic_size_t logger_pop_pos;
+
+/* Post this semaphore whenever a record is queued */
+static sem_t logger_smp;
+
+/* True while the thread is running */
+static atomic_bool logger_running;
+
+/* True if the thread must exit once the queue is empty */
+static atomic_bool logger_stop;
+
+/* The number of messages dropped because the queue was full */
+static atomic_ulong logger_dropped;
+
+static pthread_t logger_thread;
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Write all queued messages to stdout */
+static void logger_drain(void);
+
+/* Thread function which writes queued messages */
+static void * logger_thread_func(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool logger_init(void)
+{
+    size_t index = 0;
+
+    for (index = 0; index < LOGGER_QUEUE_SIZE; index++)
+    {
+        atomic_init(&logger_records[index].seq, index);
+    }
+
+    atomic_init(&logger_push_pos, 0);
+    atomic_init(&logger_pop_pos, 0);
+
+    atomic_init(&logger_stop, false);
+    atomic_init(&logger_dropped, 0);
+
+    sem_init(&logger_smp, 0, 0);
+
+    if (pthread_create(&logger_thread, NULL, logger_thread_func, NULL) != 0)
+    {
+        printf("Error: Failed to create logger thread\n");
+
+        sem_destroy(&logger_smp);
+        return false;
+    }
+
+    atomic_store(&logger_running, true);
+
+    return true;
+}
+
+void logger_deinit(void)
+{
+    if (!atomic_load(&logger_running))
+    {
+        return;
+    }
+
+    atomic_store(&logger_stop, true);
+    sem_post(&logger_smp);
+
+    pthread_join(logger_thread, NULL);
+
+    /* From now, messages are written directly */
+    atomic_store(&logger_running, false);
+
+    sem_destroy(&logger_smp);
+
+    if (atomic_load(&logger_dropped) > 0)
+    {
+        printf("Logger: %lu messages dropped (queue full)\n",
+               atomic_load(&logger_dropped));
+    }
+}
+
+void logger_flush(void)
+{
+    size_t pos = 0;
+
+    if (!atomic_load(&logger_running))
+    {
+        return;
+    }
+
+    /* Wait until the thread has written every message queued so far */
+    pos = atomic_load(&logger_push_pos);
+
+    while (atomic_load(&logger_pop_pos) < pos)
+    {
+        usleep(1000);
+    }
+}
+
+void logger_set_level(int level)
+{
+    logger_level = (level > LOG_COMPILE_LEVEL) ? LOG_COMPILE_LEVEL : level;
+}
+
+void logger_push(const char * p_format, ...)
+{
+    logger_record_t * p_record = NULL;
+    va_list args;
+
+    size_t pos = 0;
+    size_t seq = 0;
+
+    char text[LOGGER_MSG_LEN];
+
+    if (!atomic_load_explicit(&logger_running, memory_order_acquire))
+    {
+        va_start(args, p_format);
+        vsnprintf(text, sizeof(text), p_format, args);
+        va_end(args);
+
+        fputs(text, stdout);
+        return;
+    }
+
+    /* Reserve a free record */
+    pos = atomic_load_explicit(&logger_push_pos, memory_order_relaxed);
+
+    while (true)
+    {
+        p_record = &logger_records[pos & (LOGGER_QUEUE_SIZE - 1)];
+        seq = atomic_load_explicit(&p_record->seq, memory_order_acquire);
+
+        if (seq == pos)
+        {
+            if (atomic_compare_exchange_weak_explicit(&logger_push_pos, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (seq < pos)
+        {
+            /* The queue is full: never block the caller */
+            atomic_fetch_add(&logger_dropped, 1);
+            return;
+        }
+        else
+        {
+            /* Another producer took this record */
+            pos = atomic_load_explicit(&logger_push_pos, memory_order_relaxed);
+        }
+    }
+
+    va_start(args, p_format);
+    vsnprintf(p_record->text, LOGGER_MSG_LEN, p_format, args);
+    va_end(args);
+
+    /* Hand the record to the thread */
+    atomic_store_explicit(&p_record->seq, pos + 1, memory_order_release);
+    sem_post(&logger_smp);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static void logger_drain(void)
+{
+    logger_record_t * p_record = NULL;
+
+    size_t pos = atomic_load_explicit(&logger_pop_pos, memory_order_relaxed);
+
+    while (true)
+    {
+        p_record = &logger_records[pos & (LOGGER_QUEUE_SIZE - 1)];
+
+        if (atomic_load_explicit(&p_record->seq, memory_order_acquire) !=
+            (pos + 1))
+        {
+            /* Empty (or the producer is still formatting the message) */
+            break;
+        }
+
+        fputs(p_record->text, stdout);
+
+        /* The record is free for the next round of the ring */
+        atomic_store_explicit(&p_record->seq, pos + LOGGER_QUEUE_SIZE,
+                              memory_order_release);
+        pos++;
+    }
+
+    fflush(stdout);
+
+    /* Messages up to 'pos' are on stdout ('logger_flush') */
+    atomic_store(&logger_pop_pos, pos);
+}
+
+static void * logger_thread_func(void * p_param)
+{
+    (void)p_param;
+
+    while (true)
+    {
+        sem_wait(&logger_smp);
+
+        logger_drain();
+
+        /* Queued messages are written before exiting. Each message posts
+         * the semaphore, so one still being formatted is not missed */
+        if (atomic_load(&logger_stop) &&
+            (atomic_load(&logger_push_pos) == atomic_load(&logger_pop_pos)))
+        {
+            break;
+        }
+    }
+
+    return NULL;
+}
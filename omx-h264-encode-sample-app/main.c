@@ -1,35 +1,93 @@
 /* Copyright (c) 2024 Renesas Electronics Corp.
  * SPDX-License-Identifier: MIT-0 */
 
+#include <signal.h>
+#include <pthread.h>
 #include <semaphore.h>
 
 #include "omx.h"
+#include "queue.h"
+#include "packer.h"
+#include "reader.h"
+#include "writer.h"
+#include "bench.h"
+#include "logger.h"
+#include "tuner.h"
+#include "ratectl.h"
+#include "latency.h"
 
 /******************************************************************************
  *                                   MACROS                                   *
  ******************************************************************************/
 
+/* Size of the frames of input file. Another size can be set at compile time
+ * (for example, 'make CPPFLAGS="-DFRAME_WIDTH_IN_PIXELS=1280
+ * -DFRAME_HEIGHT_IN_PIXELS=720"'). The names of the files do not change */
+#ifndef FRAME_WIDTH_IN_PIXELS
 #define FRAME_WIDTH_IN_PIXELS  640
+#endif
 
+#ifndef FRAME_HEIGHT_IN_PIXELS
 #define FRAME_HEIGHT_IN_PIXELS 480
+#endif
 
-#define NV12_FRAME_SIZE_IN_BYTES (FRAME_WIDTH_IN_PIXELS  * \
-                                  FRAME_HEIGHT_IN_PIXELS * 1.5f)
+/* Frames of input file are tightly packed (no padding). For odd sizes,
+ * UV plane has 'ROUND_UP(width, 2)' bytes per row and
+ * 'ROUND_UP(height, 2) / 2' rows */
+#define NV12_FRAME_SIZE_IN_BYTES                                        \
+    ((FRAME_WIDTH_IN_PIXELS * FRAME_HEIGHT_IN_PIXELS) +                 \
+     (ROUND_UP(FRAME_WIDTH_IN_PIXELS, 2) *                              \
+      (ROUND_UP(FRAME_HEIGHT_IN_PIXELS, 2) / 2)))
 
 #define FRAMERATE 30 /* FPS */
 
 /* Input file which contains NV12 frames */
 #define IN_FILE_NAME "in-nv12-640x480.raw"
 
+/* The number of NV12 frames read from input file in advance. Each of them
+ * takes 'NV12_FRAME_SIZE_IN_BYTES' bytes of memory */
+#define IN_PREFETCH_DEPTH 4
+
+/* Set to 'true' to map input file into memory and let input port read
+ * NV12 frames directly from it (no copy). The buffer headers are created
+ * with 'OMX_UseBuffer' and 'pBuffer' is moved to the next frame of the
+ * mapping before each 'OMX_EmptyThisBuffer'. It can also be set at compile
+ * time ('make ZERO_COPY=1').
+ *
+ * If the frames of input file do not meet the stride, slice height and
+ * alignment rules of input port, or if the component rejects the memory,
+ * the app falls back to copying the frames. Every frame must start at a
+ * multiple of 'nBufferAlignment': with a page-sized alignment (4096), no
+ * NV12 frame of 640x480, 1280x720 or 1920x1080 does, so they are copied */
+#ifndef IN_ZERO_COPY
+#define IN_ZERO_COPY false
+#endif
+
 /* Output file which contains H.264 frames */
 #define OUT_FILE_NAME "out-h264-640x480.264"
 
-/* The number of buffers to be allocated for input port of media component */
+/* The number of buffers to be allocated for input port of media component.
+ * It can be changed for a run with a buffer profile (option '-p') */
 #define NV12_BUFFER_COUNT 2
 
-/* The number of buffers to be allocated for output port of media component */
+/* The number of buffers to be allocated for output port of media component.
+ * It can be changed for a run with a buffer profile (option '-p') */
 #define H264_BUFFER_COUNT 2
 
+/* The buffer tuner (option '-a') tries up to 'nBufferCountMin' +
+ * 'TUNE_EXTRA_BUFFERS' buffers on each port */
+#define TUNE_EXTRA_BUFFERS 4
+
+/* Size of each staging buffer of the output writer. H.264 frames are
+ * gathered in staging buffers and written to output file in large blocks */
+#define OUT_STAGE_SIZE (1024 * 1024)
+
+/* Set to 'true' to write output file with 'O_DIRECT' (bypass page cache) */
+#define OUT_DIRECT_IO false
+
+/* Maximum time (in ms) to wait for the MC to complete a state transition */
+#define STATE_TIMEOUT_MS 3000
+
 /* The bitrate is related to the quality of output file and compression level
  * of video encoder. For example:
  *   - With 1 Mbit/s, the encoder produces ~1.2 MB of data for 10-second video.
@@ -37,25 +95,140 @@
  *                                          and the quality should be better */
 #define H264_BITRATE 5000000 /* 5 Mbit/s */
 
+/* Limits of the rate control (option '-r'). The bitrate follows the budget
+ * between 'RC_MIN_BITRATE' and 'RC_MAX_BITRATE'. When the budget leaves
+ * less than 'RC_MIN_FRAME_BITS' bits per frame, the frame rate is lowered
+ * (down to 'RC_MIN_FPS') instead of encoding blurry frames */
+#define RC_MIN_BITRATE    100000   /* 100 kbit/s */
+#define RC_MAX_BITRATE    20000000 /* 20 Mbit/s */
+#define RC_MIN_FPS        5
+#define RC_MIN_FRAME_BITS 16000
+
+/* Settings of the low-latency mode (option '-l'):
+ *   - 'LL_SLICE_ROWS': rows of macroblocks per slice. Each slice is returned
+ *     in its own output buffer as soon as it is encoded.
+ *   - 'LL_REFRESH_FRAMES': the number of frames in which cyclic intra refresh
+ *     covers the whole picture. Only the first frame is an IDR frame, so no
+ *     large IDR frame delays the stream later */
+#define LL_SLICE_ROWS     6
+#define LL_REFRESH_FRAMES FRAMERATE
+
+/* Signal which asks the encoder for an IDR frame (for example, when a viewer
+ * joins or loses packets): 'kill -USR1 <pid of encoder>' */
+#define IDR_REQUEST_SIGNAL SIGUSR1
+
+/* The maximum number of samples of each kind (latency, time in the MC)
+ * recorded by the benchmark (option '-b') */
+#define BENCH_MAX_SAMPLES 100000
+
 /******************************************************************************
  *                                 STRUCTURES                                 *
  ******************************************************************************/
 
+typedef struct
+{
+    /* File to which the benchmark report is written (NULL if disabled) */
+    const char * p_bench_file;
+
+    /* True if the encode prints its statistics */
+    bool verbose;
+
+    /* The number of buffers of input and output ports */
+    tuner_profile_t bufs;
+
+    /* If not NULL, the encode is benchmarked and its frame rate, p99
+     * latency and buffer memory are stored to it (option '-a') */
+    tuner_result_t * p_tune_result;
+
+    /* File which contains the bandwidth budget (NULL if the bitrate is
+     * fixed) */
+    const char * p_budget_file;
+
+    /* True if the encoder is set up for low latency (option '-l') */
+    bool low_latency;
+
+} encode_cfg_t;
+
 /* This structure is shared between OMX's callbacks */
 typedef struct
 {
     /* End-of-Stream flag */
     bool eos;
 
-    /* File descriptor of input file */
-    FILE * p_in_file;
+    /* Benchmark of the encode (NULL if disabled) */
+    bench_t * p_bench;
+
+    /* Rate control of the encode (NULL if disabled) */
+    ratectl_t * p_ratectl;
+
+    /* Glass-to-bitstream latency of the encode (NULL if disabled) */
+    latency_t * p_latency;
+
+    /* Reader which prefetches NV12 frames from input file */
+    reader_t reader;
+
+    /* True if input buffers point to the mapping of input file */
+    bool zero_copy;
+
+    /* Packer which copies NV12 frames to the layout of input buffers */
+    packer_t packer;
+
+    /* Writer which writes H.264 frames to output file */
+    writer_t writer;
+
+    /* State of the MC (updated by the event handler) */
+    omx_state_t state;
 
-    /* File descriptor of output file */
-    FILE * p_out_file;
+    /* Handle of media component */
+    OMX_HANDLETYPE handle;
 
     /* A semaphore which will be locked until End-of-Stream event occurs */
     sem_t smp_eos;
 
+    /* Input buffers returned by EmptyBufferDone and waiting to be refilled */
+    queue_t in_buf_queue;
+
+    /* Post this semaphore whenever a buffer is added to 'in_buf_queue' */
+    sem_t smp_in_buf;
+
+    /* True if 'feeder_thread' must exit */
+    atomic_bool feeder_stop;
+
+    /* Thread which refills input buffers and sends them to input port */
+    pthread_t feeder_thread;
+
+    /* True if an IDR frame has been asked for with 'IDR_REQUEST_SIGNAL'.
+     * The feeder sends the request with the next input frame */
+    atomic_bool idr_requested;
+
+    /* True if 'control_thread' must exit */
+    atomic_bool control_stop;
+
+    /* Thread which waits for 'IDR_REQUEST_SIGNAL' */
+    pthread_t control_thread;
+
+    /* The number of frames returned by FillBufferDone */
+    atomic_uint out_frame_count;
+
+    /* Time (in ns) at which the pending IDR request was sent to the MC
+     * (0 if there is none) and 'out_frame_count' at that time */
+    atomic_uint_fast64_t idr_request_ns;
+    uint32_t idr_out_frame;
+
+    /* The number of IDR requests sent to the MC and of requests merged into
+     * a pending one */
+    uint32_t idr_count;
+    uint32_t idr_merged;
+
+    /* Frames returned by FillBufferDone until the IDR frame (included):
+     * sum and maximum */
+    uint64_t idr_frames_sum;
+    uint32_t idr_frames_max;
+
+    /* Time (in ns) from the requests to the IDR frames: sum and maximum */
+    uint64_t idr_ns_sum;
+    uint64_t idr_ns_max;
+
 } omx_data_t;
 
 /******************************************************************************
@@ -104,183 +277,239 @@ OMX_ERRORTYPE omx_fill_buffer_done(OMX_HANDLETYPE hComponent,
                                    OMX_BUFFERHEADERTYPE * pBuffer);
 
 /******************************************************************************
- *                               MAIN FUNCTION                                *
+ *                                 FUNCTIONS                                  *
  ******************************************************************************/
 
-int main()
-{
-    /* Handle of media component */
-    OMX_HANDLETYPE handle;
-
-    /* Callbacks used by media component */
-    OMX_CALLBACKTYPE callbacks =
-    {
-        .EventHandler    = omx_event_handler,
-        .EmptyBufferDone = omx_empty_buffer_done,
-        .FillBufferDone  = omx_fill_buffer_done
-    };
-
-    /* Buffers for input and output ports */
-    OMX_BUFFERHEADERTYPE ** pp_in_bufs  = NULL;
-    OMX_BUFFERHEADERTYPE ** pp_out_bufs = NULL;
-
-    /* Iterator */
-    int index = 0;
-
-    /* Shared data between OMX's callbacks */
-    omx_data_t omx_data;
-
-    /* At startup, End-of-Stream flag is set to false */
-    omx_data.eos = false;
-
-    /* Initialize semaphore */
-    sem_init(&omx_data.smp_eos, 0, 0);
-
-    /**************************************************************************
-     *                  STEP 1: OPEN INPUT AND OUTPUT FILES                   *
-     **************************************************************************/
-
-    /* Open input file */
-    omx_data.p_in_file = fopen(IN_FILE_NAME, "rb");
-    assert(omx_data.p_in_file != NULL);
-
-    /* Open output file */
-    omx_data.p_out_file = fopen(OUT_FILE_NAME, "wb");
-    assert(omx_data.p_out_file != NULL);
-
-    /* Set file position indicator of input file to the end of file */
-    fseek(omx_data.p_in_file, 0, SEEK_END);
-
-    /* Check if the input file contains at least 1 NV12 frame? */
-    assert(ftell(omx_data.p_in_file) >= NV12_FRAME_SIZE_IN_BYTES);
-
-    /* Set file position indicator of input file to the beginning of file */
-    fseek(omx_data.p_in_file, 0, SEEK_SET);
-
-    /**************************************************************************
-     *                         STEP 2: SET UP OMX IL                          *
-     **************************************************************************/
-
-    /* Initialize OMX IL core */
-    assert(OMX_Init() == OMX_ErrorNone);
-
-    /* Locate Renesas's H.264 encoder.
-     * If successful, the component will be in state LOADED */
-    assert(OMX_ErrorNone == OMX_GetHandle(&handle,
-                                          RENESAS_VIDEO_ENCODER_NAME,
-                                          (OMX_PTR)&omx_data, &callbacks));
-
-    /* Config input port */
-    assert(omx_set_in_port_fmt(handle,
-                               FRAME_WIDTH_IN_PIXELS,
-                               FRAME_HEIGHT_IN_PIXELS,
-                               OMX_COLOR_FormatYUV420SemiPlanar));
-
-    assert(omx_set_port_buf_cnt(handle, 0, NV12_BUFFER_COUNT));
-
-    /* Config output port */
-    assert(omx_set_out_port_fmt(handle, H264_BITRATE,
-                                OMX_VIDEO_CodingAVC, FRAMERATE));
-
-    assert(omx_set_port_buf_cnt(handle, 1, H264_BUFFER_COUNT));
-
-    /* Transition into state IDLE */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle,
-                                            OMX_CommandStateSet,
-                                            OMX_StateIdle, NULL));
-
-    /**************************************************************************
-     *                STEP 3: ALLOCATE BUFFERS FOR INPUT PORT                 *
-     **************************************************************************/
+/* Encode 'IN_FILE_NAME' to 'OUT_FILE_NAME' with the settings of 'p_cfg'.
+ * Return true if successful. Otherwise, return false */
+bool encode_file(const encode_cfg_t * p_cfg);
+
+/* Get 'nBufferCountMin' of input and output ports from a new MC, configured
+ * as in 'encode_file'.
+ * Return true if successful. Otherwise, return false */
+bool get_min_buf_counts(tuner_profile_t * p_min);
+
+/* Encode 'IN_FILE_NAME' with more and more buffers (see 'tuner.h') and save
+ * the recommended buffer counts to profile 'p_profile_file'.
+ * Return true if successful. Otherwise, return false */
+bool tune_buffers(const encode_cfg_t * p_cfg, const char * p_profile_file);
+
+/* Run function of the tuner. 'p_ctx' points to an 'encode_cfg_t' */
+bool tune_run(const tuner_profile_t * p_profile, tuner_result_t * p_result,
+              void * p_ctx);
+
+/* Called by the writer when the data of output buffer 'p_buf' has been copied.
+ * Send 'p_buf' back to output port when End-of-Stream event does not occur */
+void release_out_buf(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Drop 'skip_cnt' prefetched NV12 frames, then copy the next one to
+ * 'p_in_buf' (in the layout of input port, with 'p_packer').
+ * If there is no more frame, mark 'p_in_buf' as an End-of-Stream buffer */
+void setup_in_buf(reader_t * p_reader, packer_t * p_packer,
+                  uint32_t skip_cnt, OMX_BUFFERHEADERTYPE * p_in_buf);
+
+/* Initialize 'p_packer' from the stride and slice height of input port.
+ * Return true if successful. Otherwise, return false */
+bool init_packer(OMX_HANDLETYPE handle, packer_t * p_packer);
+
+/* Check if input port can read NV12 frames straight from input file, that is
+ * the frames have no padding and each of them meets the buffer alignment.
+ * Return true if successful. Otherwise, return false */
+bool can_use_in_file(OMX_HANDLETYPE handle);
+
+/* Map input file of 'p_reader' and create 'buf_cnt' buffer headers for input
+ * port which point to its first frames.
+ * Return non-NULL value if successful. Otherwise, return NULL */
+OMX_BUFFERHEADERTYPE ** use_in_file_bufs(OMX_HANDLETYPE handle,
+                                         reader_t * p_reader,
+                                         uint32_t buf_cnt);
+
+/* Send the pending IDR request of 'p_data' (if any) to the MC before the
+ * next input frame */
+void send_idr_request(omx_data_t * p_data);
+
+/* Called by FillBufferDone for each filled buffer 'p_buf'. Report how many
+ * frames the IDR frame took to arrive if 'p_buf' answers the pending request
+ * and count the frames */
+void check_idr_frame(omx_data_t * p_data, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Thread function which waits for 'IDR_REQUEST_SIGNAL' and sets
+ * 'idr_requested'. The signal must be blocked in all threads.
+ *
+ * It exits when 'control_stop' is set (and the signal is sent to it) */
+void * control_thread_func(void * p_param);
 
-    pp_in_bufs = omx_alloc_buffers(handle, 0);
-    assert(pp_in_bufs != NULL);
+/* Thread function which takes buffers from 'in_buf_queue', refills them
+ * with 'setup_in_buf' and sends them to input port.
+ *
+ * It exits after sending the End-of-Stream buffer or
+ * when 'feeder_stop' is set */
+void * feeder_thread_func(void * p_param);
 
-    /**************************************************************************
-     *                STEP 4: ALLOCATE BUFFERS FOR OUTPUT PORT                *
-     **************************************************************************/
+/******************************************************************************
+ *                               MAIN FUNCTION                                *
+ ******************************************************************************/
 
-    pp_out_bufs = omx_alloc_buffers(handle, 1);
-    assert(pp_out_bufs != NULL);
+int main(int argc, char * p_argv[])
+{
+    /* Settings of the encode */
+    encode_cfg_t cfg;
+
+    /* Command-line options */
+    const char * p_bench_file = NULL;
+    const char * p_trace_file = NULL;
+    const char * p_tune_file = NULL;
+    const char * p_profile_file = NULL;
+    const char * p_budget_file = NULL;
+    bool low_latency = false;
+    sigset_t signals;
+    bool debug = false;
+    int option = 0;
+
+    bool is_success = true;
+
+    /* Usage: encoder [-b report] [-t trace] [-v] [-a profile | -p profile]
+     *                [-r budget] [-l]
+     *   -b: Benchmark the encode and write a JSON report to 'report'
+     *       ("-" for stdout).
+     *   -t: Trace OMX calls and callbacks, then write them to 'trace'
+     *       (Chrome trace-event JSON).
+     *   -v: Also print buffer events (EmptyBufferDone, FillBufferDone).
+     *   -a: Tune the buffer counts of both ports and save the recommended
+     *       counts to 'profile'. It cannot be used with '-b'.
+     *   -p: Use the buffer counts of 'profile' (written by '-a').
+     *   -r: Adapt the bitrate and frame rate of the encoder to the bandwidth
+     *       budget (in bit/s) written in file 'budget' by another process.
+     *   -l: Set the encoder up for low latency, release input frames at
+     *       'FRAMERATE' and print the latency of each frame */
+    while ((option = getopt(argc, p_argv, "b:t:va:p:r:l")) != -1)
+    {
+        switch (option)
+        {
+            case 'b':
+            {
+                p_bench_file = optarg;
+            }
+            break;
 
-    omx_wait_state(handle, OMX_StateIdle);
+            case 't':
+            {
+                p_trace_file = optarg;
+            }
+            break;
 
-    /**************************************************************************
-     *             STEP 5: MAKE OMX READY TO SEND/RECEIVE BUFFERS             *
-     **************************************************************************/
+            case 'v':
+            {
+                debug = true;
+            }
+            break;
 
-    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
-                                            OMX_StateExecuting, NULL));
-    omx_wait_state(handle, OMX_StateExecuting);
+            case 'a':
+            {
+                p_tune_file = optarg;
+            }
+            break;
 
-    /**************************************************************************
-     *          STEP 6: SEND BUFFERS IN 'PP_OUT_BUFS' TO OUTPUT PORT          *
-     **************************************************************************/
+            case 'p':
+            {
+                p_profile_file = optarg;
+            }
+            break;
 
-    assert(omx_fill_buffers(handle, pp_out_bufs, H264_BUFFER_COUNT));
+            case 'r':
+            {
+                p_budget_file = optarg;
+            }
+            break;
 
-    /**************************************************************************
-     *           STEP 7: SEND BUFFERS IN 'PP_IN_BUFS' TO INPUT PORT           *
-     **************************************************************************/
+            case 'l':
+            {
+                low_latency = true;
+            }
+            break;
 
-    for (index = 0; index < NV12_BUFFER_COUNT; index++)
-    {
-        if (OMX_BUFFERFLAG_EOS & omx_empty_buffer(handle,
-                                                  omx_data.p_in_file,
-                                                  pp_in_bufs[index],
-                                                  NV12_FRAME_SIZE_IN_BYTES))
-        {
-            /* Stop sending next buffers if the current buffer is marked as
-             * OMX_BUFFERFLAG_EOS */
+            default:
+            {
+                printf("Usage: %s [-b report] [-t trace] [-v] "
+                       "[-a profile | -p profile] [-r budget] [-l]\n",
+                       p_argv[0]);
+                return -1;
+            }
             break;
         }
     }
 
-    /**************************************************************************
-     *             STEP 8: WAIT UNTIL END-OF-STREAM EVENT OCCURS              *
-     **************************************************************************/
+    if ((p_tune_file != NULL) &&
+        ((p_bench_file != NULL) || (p_profile_file != NULL)))
+    {
+        printf("Error: Option '-a' cannot be used with option '-b' "
+               "or '-p'\n");
+        return -1;
+    }
 
-    sem_wait(&omx_data.smp_eos);
+    cfg.p_bench_file  = p_bench_file;
+    cfg.verbose       = (p_tune_file == NULL);
+    cfg.p_tune_result = NULL;
+    cfg.p_budget_file = p_budget_file;
+    cfg.low_latency   = low_latency;
 
-    /**************************************************************************
-     *                          STEP 9: CLEAN UP OMX                          *
-     **************************************************************************/
+    cfg.bufs.in_buf_cnt  = NV12_BUFFER_COUNT;
+    cfg.bufs.out_buf_cnt = H264_BUFFER_COUNT;
 
-    /* Transition back to idle state */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
-                                            OMX_StateIdle, NULL));
-    omx_wait_state(handle, OMX_StateIdle);
+    if ((p_profile_file != NULL) &&
+        (tuner_load_profile(p_profile_file, &cfg.bufs) == false))
+    {
+        return -1;
+    }
 
-    /* Transition back to loaded state */
-    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
-                                            OMX_StateLoaded, NULL));
+    if ((cfg.bufs.in_buf_cnt == 0) || (cfg.bufs.out_buf_cnt == 0))
+    {
+        printf("Error: Each port needs at least 1 buffer\n");
+        return -1;
+    }
 
-    /* Free output buffers */
-    omx_dealloc_all_port_bufs(handle, 1, pp_out_bufs);
+    /* Only the control thread of 'encode_file' receives the IDR signal.
+     * Threads created from now on inherit the mask */
+    sigemptyset(&signals);
+    sigaddset(&signals, IDR_REQUEST_SIGNAL);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
 
-    /* Free input buffers */
-    omx_dealloc_all_port_bufs(handle, 0, pp_in_bufs);
+    /* Callbacks queue their messages to the logger thread */
+    if (debug)
+    {
+        logger_set_level(LOG_LEVEL_DEBUG);
+    }
 
-    /* Wait until the component is in state LOADED */
-    omx_wait_state(handle, OMX_StateLoaded);
+    assert(logger_init());
 
-    /* Free the component's handle */
-    assert(OMX_FreeHandle(handle) == OMX_ErrorNone);
+    if (p_trace_file != NULL)
+    {
+        /* Record from now on (all threads are started later) */
+        trace_enable();
+        trace_name_thread("main");
+    }
 
-    /* Deinitialize OMX IL core */
-    assert(OMX_Deinit() == OMX_ErrorNone);
+    if (p_tune_file != NULL)
+    {
+        /* Only errors are printed while the tuner encodes */
+        logger_set_level(LOG_LEVEL_ERROR);
 
-    /**************************************************************************
-     *                 STEP 10: CLOSE INPUT AND OUTPUT FILES                  *
-     **************************************************************************/
+        is_success = tune_buffers(&cfg, p_tune_file);
+    }
+    else
+    {
+        is_success = encode_file(&cfg);
+    }
 
-    /* Close output file */
-    fclose(omx_data.p_out_file);
+    logger_deinit();
 
-    /* Close input file */
-    fclose(omx_data.p_in_file);
+    /* All traced threads have exited */
+    if ((p_trace_file != NULL) && (trace_write_chrome(p_trace_file) == false))
+    {
+        is_success = false;
+    }
 
-    return 0;
+    return is_success ? 0 : -1;
 }
 
 /******************************************************************************
@@ -297,7 +526,10 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
 
     omx_data_t * p_data = (omx_data_t *)pAppData;
 
-    char * p_state_str = NULL;
+    const char * p_state_str = NULL;
+
+    /* Start of the callback in the trace (0 if tracing is disabled) */
+    uint64_t trace_ns = trace_now();
 
     switch (eEvent)
     {
@@ -305,12 +537,14 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
         {
             if (nData1 == OMX_CommandStateSet)
             {
+                /* Wake up 'omx_wait_state' */
+                omx_state_notify(&p_data->state, (OMX_STATETYPE)nData2);
+
                 p_state_str = omx_state_to_str((OMX_STATETYPE)nData2);
                 if (p_state_str != NULL)
                 {
                     /* Print OMX state */
-                    printf("OMX state: '%s'\n", p_state_str);
-                    free(p_state_str);
+                    LOG_INFO("OMX state: '%s'\n", p_state_str);
                 }
             }
         }
@@ -324,14 +558,17 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
                 p_data->eos = true;
             }
             /* The buffer contains the last output picture data */
-            printf("OMX event: 'End-of-Stream'\n");
+            LOG_INFO("OMX event: 'End-of-Stream'\n");
         break;
         }
 
         case OMX_EventError:
         {
             /* Section 2.1.2 in document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
-            printf("OMX error event: '0x%x'\n", nData1);
+            LOG_ERROR("OMX error event: '0x%x'\n", nData1);
+
+            /* Wake up 'omx_wait_state' if the error fails a transition */
+            omx_state_notify_error(&p_data->state, (OMX_ERRORTYPE)nData1);
         }
         break;
 
@@ -342,6 +579,8 @@ OMX_ERRORTYPE omx_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
         break;
     }
 
+    trace_record(TRACE_EVENT_EVENT_HANDLER, trace_ns, eEvent, nData1);
+
     return OMX_ErrorNone;
 }
 
@@ -351,18 +590,35 @@ OMX_ERRORTYPE omx_empty_buffer_done(OMX_HANDLETYPE hComponent,
 {
     omx_data_t * p_data = (omx_data_t *)pAppData;
 
+    /* Start of the callback in the trace (0 if tracing is disabled) */
+    uint64_t trace_ns = trace_now();
+
     /* Check parameter */
     assert(p_data != NULL);
 
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    bench_on_empty_buffer_done(p_data->p_bench, pBuffer);
+
+    if (pBuffer != NULL)
+    {
+        omx_buf_move(pBuffer, OMX_BUF_OWNER_MC, OMX_BUF_OWNER_APP);
+    }
+
     if (p_data->eos == false)
     {
-        /* The 'pBuffer' is now avaiable to use. Try to add it back
-         * to the input port when End-of-Stream event does not occur */
-        omx_empty_buffer(hComponent, p_data->p_in_file,
-                         pBuffer, NV12_FRAME_SIZE_IN_BYTES);
+        /* Hand the buffer to the feeder thread when EOS event does not occur.
+         * The queue is never full because it can hold all input buffers */
+        assert(queue_push(&p_data->in_buf_queue, pBuffer));
+        sem_post(&p_data->smp_in_buf);
     }
 
-    printf("EmptyBufferDone exited\n");
+    LOG_DEBUG("EmptyBufferDone exited\n");
+
+    trace_record(TRACE_EVENT_EMPTY_BUFFER_DONE, trace_ns,
+                 (uintptr_t)pBuffer, 0);
+
     return OMX_ErrorNone;
 }
 
@@ -372,24 +628,988 @@ OMX_ERRORTYPE omx_fill_buffer_done(OMX_HANDLETYPE hComponent,
 {
     omx_data_t * p_data = (omx_data_t *)pAppData;
 
+    /* Start of the callback in the trace (0 if tracing is disabled) and
+     * length of the frame (the buffer may be refilled before returning) */
+    uint64_t trace_ns   = trace_now();
+    OMX_U32  filled_len = (pBuffer != NULL) ? pBuffer->nFilledLen : 0;
+
     /* Check parameter */
     assert(p_data != NULL);
 
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    bench_on_fill_buffer_done(p_data->p_bench, pBuffer);
+
+    if (pBuffer != NULL)
+    {
+        omx_buf_move(pBuffer, OMX_BUF_OWNER_MC, OMX_BUF_OWNER_APP);
+    }
+
     if ((p_data->eos == false) && (pBuffer != NULL))
     {
-        if (pBuffer->nFilledLen > 0)
+        if (p_data->p_ratectl != NULL)
         {
-            fwrite(pBuffer->pBuffer, 1, pBuffer->nFilledLen, p_data->p_out_file);
+            ratectl_on_fill_buffer_done(p_data->p_ratectl, pBuffer);
         }
 
-        pBuffer->nFlags     = 0;
-        pBuffer->nFilledLen = 0;
+        latency_on_fill_buffer_done(p_data->p_latency, pBuffer);
 
-        /* The 'pBuffer' is now avaiable to use. Try to add it back
-         * to the output port when End-of-Stream event does not occur */
-        assert(OMX_FillThisBuffer(hComponent, pBuffer) == OMX_ErrorNone);
+        check_idr_frame(p_data, pBuffer);
+
+        /* The writer copies the frame and then calls 'release_out_buf'
+         * to add the buffer back to the output port */
+        omx_buf_move(pBuffer, OMX_BUF_OWNER_APP, OMX_BUF_OWNER_IO);
+        writer_push(&p_data->writer, pBuffer);
     }
 
-    printf("FillBufferDone exited\n");
+    LOG_DEBUG("FillBufferDone exited\n");
+
+    trace_record(TRACE_EVENT_FILL_BUFFER_DONE, trace_ns,
+                 (uintptr_t)pBuffer, filled_len);
+
     return OMX_ErrorNone;
 }
+
+/******************************************************************************
+ *                                 FUNCTIONS                                  *
+ ******************************************************************************/
+
+bool encode_file(const encode_cfg_t * p_cfg)
+{
+    /* Handle of media component */
+    OMX_HANDLETYPE handle;
+
+    /* Callbacks used by media component */
+    OMX_CALLBACKTYPE callbacks =
+    {
+        .EventHandler    = omx_event_handler,
+        .EmptyBufferDone = omx_empty_buffer_done,
+        .FillBufferDone  = omx_fill_buffer_done
+    };
+
+    /* Buffers for input and output ports */
+    OMX_BUFFERHEADERTYPE ** pp_in_bufs  = NULL;
+    OMX_BUFFERHEADERTYPE ** pp_out_bufs = NULL;
+
+    /* Iterator */
+    int index = 0;
+
+    /* Shared data between OMX's callbacks */
+    omx_data_t omx_data;
+
+    /* False if output file could not be written completely */
+    bool is_success = true;
+
+    /* Benchmark of the encode (if 'p_bench_file' or 'p_tune_result' is
+     * set) */
+    bench_t bench;
+
+    /* Rate control of the encode (if 'p_budget_file' is set) */
+    ratectl_t ratectl;
+
+    /* Latency of the encode (if 'low_latency' is set) */
+    latency_t latency;
+
+    /* Macroblocks of a row and of a frame */
+    uint32_t row_mbs   = ROUND_UP(FRAME_WIDTH_IN_PIXELS, 16) / 16;
+    uint32_t frame_mbs = row_mbs * (ROUND_UP(FRAME_HEIGHT_IN_PIXELS, 16) / 16);
+
+    /* Bitrate set to output port before state IDLE */
+    uint32_t bitrate = H264_BITRATE;
+
+    /* Limits of the rate control */
+    ratectl_limits_t limits =
+    {
+        .min_bitrate    = RC_MIN_BITRATE,
+        .max_bitrate    = RC_MAX_BITRATE,
+        .min_fps        = RC_MIN_FPS,
+        .max_fps        = FRAMERATE,
+        .min_frame_bits = RC_MIN_FRAME_BITS
+    };
+
+    /* The number of buffers of input and output ports */
+    uint32_t in_buf_cnt  = 0;
+    uint32_t out_buf_cnt = 0;
+
+    /* Statistics of the buffers of input and output ports */
+    omx_buf_stats_t in_buf_stats  = { 0 };
+    omx_buf_stats_t out_buf_stats = { 0 };
+
+    /* Definitions of input and output ports */
+    OMX_PARAM_PORTDEFINITIONTYPE in_port;
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+
+    /* Time (in ns) taken to start and to tear down OMX IL */
+    uint64_t start_ns    = 0;
+    uint64_t startup_ns  = 0;
+    uint64_t teardown_ns = 0;
+
+    /* Check parameter */
+    assert(p_cfg != NULL);
+
+    in_buf_cnt  = p_cfg->bufs.in_buf_cnt;
+    out_buf_cnt = p_cfg->bufs.out_buf_cnt;
+
+    /* At startup, End-of-Stream flag is set to false */
+    omx_data.eos = false;
+    omx_data.zero_copy = false;
+    omx_data.p_bench = NULL;
+
+    if ((p_cfg->p_bench_file != NULL) || (p_cfg->p_tune_result != NULL))
+    {
+        /* A frame may be split into several output buffers (slices) */
+        assert(bench_init(&bench, "encoder", BENCH_MAX_SAMPLES, true));
+        omx_data.p_bench = &bench;
+    }
+
+    omx_data.p_ratectl = NULL;
+
+    if (p_cfg->p_budget_file != NULL)
+    {
+        /* The initial bitrate is derived from the budget (if known) */
+        assert(ratectl_init(&ratectl, p_cfg->p_budget_file,
+                            &limits, H264_BITRATE));
+
+        omx_data.p_ratectl = &ratectl;
+        bitrate = ratectl.bitrate;
+    }
+
+    omx_data.p_latency = NULL;
+
+    if (p_cfg->low_latency)
+    {
+        /* Frames are released at the frame rate, like from a camera */
+        assert(latency_init(&latency, FRAMERATE, BENCH_MAX_SAMPLES));
+        omx_data.p_latency = &latency;
+    }
+
+    atomic_init(&omx_data.feeder_stop, false);
+
+    atomic_init(&omx_data.idr_requested, false);
+    atomic_init(&omx_data.control_stop, false);
+    atomic_init(&omx_data.out_frame_count, 0);
+    atomic_init(&omx_data.idr_request_ns, 0);
+
+    omx_data.idr_out_frame  = 0;
+    omx_data.idr_count      = 0;
+    omx_data.idr_merged     = 0;
+    omx_data.idr_frames_sum = 0;
+    omx_data.idr_frames_max = 0;
+    omx_data.idr_ns_sum     = 0;
+    omx_data.idr_ns_max     = 0;
+
+    omx_state_init(&omx_data.state);
+
+    /* Initialize semaphores */
+    sem_init(&omx_data.smp_eos, 0, 0);
+    sem_init(&omx_data.smp_in_buf, 0, 0);
+
+    /* The queue never holds more than 'in_buf_cnt' buffers */
+    assert(queue_init(&omx_data.in_buf_queue, in_buf_cnt));
+
+    /**************************************************************************
+     *                  STEP 1: OPEN INPUT AND OUTPUT FILES                   *
+     **************************************************************************/
+
+    /* Open input file */
+    assert(reader_open(&omx_data.reader, IN_FILE_NAME,
+                       NV12_FRAME_SIZE_IN_BYTES, IN_PREFETCH_DEPTH));
+
+    /* Open output file */
+    assert(writer_open(&omx_data.writer, OUT_FILE_NAME,
+                       out_buf_cnt, OUT_STAGE_SIZE, OUT_DIRECT_IO));
+
+    /* Check if the input file contains at least 1 NV12 frame? */
+    assert(omx_data.reader.file_size >= NV12_FRAME_SIZE_IN_BYTES);
+
+    /**************************************************************************
+     *                         STEP 2: SET UP OMX IL                          *
+     **************************************************************************/
+
+    /* Initialize OMX IL core */
+    start_ns = omx_get_time_ns();
+    assert(OMX_Init() == OMX_ErrorNone);
+
+    /* Locate Renesas's H.264 encoder.
+     * If successful, the component will be in state LOADED */
+    assert(OMX_ErrorNone == OMX_GetHandle(&handle,
+                                          RENESAS_VIDEO_ENCODER_NAME,
+                                          (OMX_PTR)&omx_data, &callbacks));
+
+    omx_data.handle = handle;
+
+    /* From now, FillBufferDone can hand H.264 frames to the writer */
+    assert(writer_start(&omx_data.writer, release_out_buf, &omx_data));
+
+    /* Config input port */
+    assert(omx_set_in_port_fmt(handle,
+                               FRAME_WIDTH_IN_PIXELS,
+                               FRAME_HEIGHT_IN_PIXELS,
+                               OMX_COLOR_FormatYUV420SemiPlanar));
+
+    assert(omx_set_port_buf_cnt(handle, 0, in_buf_cnt));
+
+    /* Rows of input buffers may be longer than rows of input file */
+    assert(init_packer(handle, &omx_data.packer));
+
+    /* Config output port */
+    assert(omx_set_out_port_fmt(handle, bitrate,
+                                OMX_VIDEO_CodingAVC, FRAMERATE));
+
+    if (p_cfg->low_latency)
+    {
+        /* Intra refresh covers the picture in 'LL_REFRESH_FRAMES' frames */
+        assert(omx_set_low_latency(handle, OMX_VIDEO_AVC_INFINITE_GOP,
+                                   LL_SLICE_ROWS * row_mbs,
+                                   (frame_mbs + LL_REFRESH_FRAMES - 1) /
+                                   LL_REFRESH_FRAMES));
+    }
+
+    assert(omx_set_port_buf_cnt(handle, 1, out_buf_cnt));
+
+    /* Transition into state IDLE */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+
+    /**************************************************************************
+     *                STEP 3: ALLOCATE BUFFERS FOR INPUT PORT                 *
+     **************************************************************************/
+
+    if (IN_ZERO_COPY && can_use_in_file(handle))
+    {
+        pp_in_bufs = use_in_file_bufs(handle, &omx_data.reader, in_buf_cnt);
+        if (pp_in_bufs == NULL)
+        {
+            printf("Warning: Input port cannot use input file directly\n");
+            reader_unmap(&omx_data.reader);
+        }
+    }
+
+    if (pp_in_bufs != NULL)
+    {
+        omx_data.zero_copy = true;
+    }
+    else
+    {
+        /* Frames will be copied from the slots of the reader */
+        assert(reader_start(&omx_data.reader));
+
+        pp_in_bufs = omx_alloc_buffers(handle, 0);
+        assert(pp_in_bufs != NULL);
+    }
+
+    /**************************************************************************
+     *                STEP 4: ALLOCATE BUFFERS FOR OUTPUT PORT                *
+     **************************************************************************/
+
+    pp_out_bufs = omx_alloc_buffers(handle, 1);
+    assert(pp_out_bufs != NULL);
+
+    assert(omx_wait_state(handle, &omx_data.state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    /**************************************************************************
+     *             STEP 5: MAKE OMX READY TO SEND/RECEIVE BUFFERS             *
+     **************************************************************************/
+
+    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
+                                            OMX_StateExecuting, NULL));
+    assert(omx_wait_state(handle, &omx_data.state,
+                          OMX_StateExecuting, STATE_TIMEOUT_MS));
+
+    startup_ns = omx_get_time_ns() - start_ns;
+
+    /**************************************************************************
+     *          STEP 6: SEND BUFFERS IN 'PP_OUT_BUFS' TO OUTPUT PORT          *
+     **************************************************************************/
+
+    for (index = 0; index < (int)out_buf_cnt; index++)
+    {
+        bench_on_fill_this_buffer(omx_data.p_bench, pp_out_bufs[index]);
+    }
+
+    assert(omx_fill_buffers(handle, pp_out_bufs, out_buf_cnt));
+
+    /**************************************************************************
+     *           STEP 7: SEND BUFFERS IN 'PP_IN_BUFS' TO INPUT PORT           *
+     **************************************************************************/
+
+    /* Hand all input buffers to the feeder thread. It fills them with
+     * prefetched frames and sends them to input port */
+    for (index = 0; index < (int)in_buf_cnt; index++)
+    {
+        assert(queue_push(&omx_data.in_buf_queue, pp_in_bufs[index]));
+        sem_post(&omx_data.smp_in_buf);
+    }
+
+    assert(pthread_create(&omx_data.feeder_thread, NULL,
+                          feeder_thread_func, &omx_data) == 0);
+
+    if (omx_data.p_ratectl != NULL)
+    {
+        /* From now, the bitrate and frame rate follow the budget */
+        assert(ratectl_start(omx_data.p_ratectl, handle));
+    }
+
+    /* From now, 'IDR_REQUEST_SIGNAL' asks for an IDR frame */
+    assert(pthread_create(&omx_data.control_thread, NULL,
+                          control_thread_func, &omx_data) == 0);
+
+    /**************************************************************************
+     *             STEP 8: WAIT UNTIL END-OF-STREAM EVENT OCCURS              *
+     **************************************************************************/
+
+    sem_wait(&omx_data.smp_eos);
+
+    if (omx_data.p_ratectl != NULL)
+    {
+        /* No more setting is sent to the encoder */
+        ratectl_stop(omx_data.p_ratectl);
+    }
+
+    /* Wake the control thread up so that it sees 'control_stop' */
+    atomic_store(&omx_data.control_stop, true);
+    pthread_kill(omx_data.control_thread, IDR_REQUEST_SIGNAL);
+
+    pthread_join(omx_data.control_thread, NULL);
+
+    /* Stop the feeder thread (it may still wait for a returned buffer) */
+    atomic_store(&omx_data.feeder_stop, true);
+    sem_post(&omx_data.smp_in_buf);
+
+    pthread_join(omx_data.feeder_thread, NULL);
+
+    /* Write remaining H.264 frames. The writer does not send any buffer
+     * to output port after this point */
+    if (!writer_close(&omx_data.writer))
+    {
+        is_success = false;
+    }
+
+    if (p_cfg->p_tune_result != NULL)
+    {
+        /* Memory taken by the buffers of both ports. With zero-copy input,
+         * input frames are in the mapping of input file */
+        assert(omx_get_port(handle, 0, &in_port));
+        assert(omx_get_port(handle, 1, &out_port));
+
+        p_cfg->p_tune_result->mem_bytes =
+            ((uint64_t)out_port.nBufferCountActual * out_port.nBufferSize) +
+            (omx_data.zero_copy ? 0 :
+             ((uint64_t)in_port.nBufferCountActual * in_port.nBufferSize));
+    }
+
+    /**************************************************************************
+     *                          STEP 9: CLEAN UP OMX                          *
+     **************************************************************************/
+
+    start_ns = omx_get_time_ns();
+
+    /* Transition back to idle state */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+    assert(omx_wait_state(handle, &omx_data.state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    /* Transition back to loaded state */
+    assert(OMX_ErrorNone == OMX_SendCommand(handle, OMX_CommandStateSet,
+                                            OMX_StateLoaded, NULL));
+
+    /* Statistics of the buffers (before they are freed) */
+    omx_add_buf_stats(pp_out_bufs, out_buf_cnt, &out_buf_stats);
+    omx_add_buf_stats(pp_in_bufs, in_buf_cnt, &in_buf_stats);
+
+    /* Free output buffers */
+    omx_dealloc_all_port_bufs(handle, 1, pp_out_bufs);
+
+    /* Free input buffers */
+    omx_dealloc_all_port_bufs(handle, 0, pp_in_bufs);
+
+    /* Wait until the component is in state LOADED */
+    assert(omx_wait_state(handle, &omx_data.state,
+                          OMX_StateLoaded, STATE_TIMEOUT_MS));
+
+    /* Free the component's handle */
+    assert(OMX_FreeHandle(handle) == OMX_ErrorNone);
+
+    /* Deinitialize OMX IL core */
+    assert(OMX_Deinit() == OMX_ErrorNone);
+
+    teardown_ns = omx_get_time_ns() - start_ns;
+
+    omx_state_deinit(&omx_data.state);
+
+    /* Events are printed before statistics */
+    logger_flush();
+
+    /**************************************************************************
+     *                 STEP 10: CLOSE INPUT AND OUTPUT FILES                  *
+     **************************************************************************/
+
+    /* Close input file */
+    reader_close(&omx_data.reader);
+
+    /* Output file was closed by 'writer_close' */
+    if (p_cfg->verbose)
+    {
+        writer_print_stats(&omx_data.writer);
+
+        printf("Timing: startup %.3f ms (OMX_Init to Executing), "
+               "teardown %.3f ms (Executing to OMX_Deinit)\n",
+               startup_ns / 1e6, teardown_ns / 1e6);
+
+        reader_print_stats(&omx_data.reader);
+
+        if (!omx_data.zero_copy)
+        {
+            packer_print_stats(&omx_data.packer);
+        }
+
+        if (omx_data.p_ratectl != NULL)
+        {
+            ratectl_print_stats(omx_data.p_ratectl);
+        }
+
+        latency_print_stats(omx_data.p_latency);
+
+        omx_print_buf_stats("input port", &in_buf_stats);
+        omx_print_buf_stats("output port", &out_buf_stats);
+
+        if (omx_data.idr_count > 0)
+        {
+            printf("IDR: %u requests (%u merged into a pending one), "
+                   "%.1f frames / %.3f ms on average (max %u frames / "
+                   "%.3f ms) until FillBufferDone\n",
+                   omx_data.idr_count, omx_data.idr_merged,
+                   (double)omx_data.idr_frames_sum / omx_data.idr_count,
+                   omx_data.idr_ns_sum / 1e6 / omx_data.idr_count,
+                   omx_data.idr_frames_max, omx_data.idr_ns_max / 1e6);
+        }
+    }
+
+    latency_deinit(omx_data.p_latency);
+
+    queue_deinit(&omx_data.in_buf_queue);
+
+    if (omx_data.p_bench != NULL)
+    {
+        if (p_cfg->p_tune_result != NULL)
+        {
+            bench_get_summary(omx_data.p_bench, &p_cfg->p_tune_result->fps,
+                              &p_cfg->p_tune_result->p99_ms);
+        }
+
+        if ((p_cfg->p_bench_file != NULL) &&
+            bench_write_report(omx_data.p_bench, p_cfg->p_bench_file) &&
+            (strcmp(p_cfg->p_bench_file, "-") != 0))
+        {
+            printf("Bench: report written to '%s'\n", p_cfg->p_bench_file);
+        }
+
+        bench_deinit(omx_data.p_bench);
+    }
+
+    return is_success;
+}
+
+bool get_min_buf_counts(tuner_profile_t * p_min)
+{
+    OMX_HANDLETYPE handle;
+
+    OMX_CALLBACKTYPE callbacks =
+    {
+        .EventHandler    = omx_event_handler,
+        .EmptyBufferDone = omx_empty_buffer_done,
+        .FillBufferDone  = omx_fill_buffer_done
+    };
+
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+
+    bool is_success = true;
+
+    /* Check parameter */
+    assert(p_min != NULL);
+
+    assert(OMX_Init() == OMX_ErrorNone);
+
+    /* No command is sent, so the callbacks are never called */
+    if (OMX_GetHandle(&handle, RENESAS_VIDEO_ENCODER_NAME,
+                      NULL, &callbacks) != OMX_ErrorNone)
+    {
+        printf("Error: Failed to get handle of '%s'\n",
+               RENESAS_VIDEO_ENCODER_NAME);
+
+        assert(OMX_Deinit() == OMX_ErrorNone);
+        return false;
+    }
+
+    /* Ports are configured as in 'encode_file' */
+    if (omx_set_in_port_fmt(handle,
+                            FRAME_WIDTH_IN_PIXELS,
+                            FRAME_HEIGHT_IN_PIXELS,
+                            OMX_COLOR_FormatYUV420SemiPlanar) &&
+        omx_set_out_port_fmt(handle, H264_BITRATE,
+                             OMX_VIDEO_CodingAVC, FRAMERATE) &&
+        omx_get_port(handle, 0, &port))
+    {
+        p_min->in_buf_cnt = port.nBufferCountMin;
+    }
+    else
+    {
+        is_success = false;
+    }
+
+    if (is_success && omx_get_port(handle, 1, &port))
+    {
+        p_min->out_buf_cnt = port.nBufferCountMin;
+    }
+    else
+    {
+        is_success = false;
+    }
+
+    assert(OMX_FreeHandle(handle) == OMX_ErrorNone);
+    assert(OMX_Deinit() == OMX_ErrorNone);
+
+    return is_success;
+}
+
+bool tune_buffers(const encode_cfg_t * p_cfg, const char * p_profile_file)
+{
+    tuner_t * p_tuner = NULL;
+
+    /* Range of buffer counts */
+    tuner_profile_t min;
+    tuner_profile_t max;
+
+    bool is_success = false;
+
+    /* Check parameters */
+    assert((p_cfg != NULL) && (p_profile_file != NULL));
+
+    if (get_min_buf_counts(&min) == false)
+    {
+        return false;
+    }
+
+    /* The benchmark follows up to 'BENCH_MAX_BUFFERS' buffers per port */
+    max.in_buf_cnt  = min.in_buf_cnt + TUNE_EXTRA_BUFFERS;
+    max.out_buf_cnt = min.out_buf_cnt + TUNE_EXTRA_BUFFERS;
+
+    if (max.in_buf_cnt > BENCH_MAX_BUFFERS)
+    {
+        max.in_buf_cnt = BENCH_MAX_BUFFERS;
+    }
+
+    if (max.out_buf_cnt > BENCH_MAX_BUFFERS)
+    {
+        max.out_buf_cnt = BENCH_MAX_BUFFERS;
+    }
+
+    printf("Tuner: '%s', input buffers %u-%u, output buffers %u-%u\n",
+           IN_FILE_NAME, min.in_buf_cnt, max.in_buf_cnt,
+           min.out_buf_cnt, max.out_buf_cnt);
+
+    p_tuner = (tuner_t *)malloc(sizeof(tuner_t));
+    assert(p_tuner != NULL);
+
+    if (tuner_sweep(p_tuner, &min, &max, tune_run, (void *)p_cfg))
+    {
+        tuner_print_report(p_tuner);
+
+        is_success = tuner_save_profile(p_tuner, p_profile_file, "encoder");
+        if (is_success)
+        {
+            printf("Tuner: profile written to '%s'\n", p_profile_file);
+        }
+    }
+
+    free(p_tuner);
+
+    return is_success;
+}
+
+bool tune_run(const tuner_profile_t * p_profile, tuner_result_t * p_result,
+              void * p_ctx)
+{
+    /* Settings of this encode */
+    encode_cfg_t cfg;
+
+    /* Check parameters */
+    assert((p_profile != NULL) && (p_result != NULL) && (p_ctx != NULL));
+
+    cfg = *(const encode_cfg_t *)p_ctx;
+    cfg.bufs = *p_profile;
+    cfg.p_tune_result = p_result;
+
+    return encode_file(&cfg);
+}
+
+void release_out_buf(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    omx_data_t * p_data = (omx_data_t *)p_ctx;
+
+    /* Check parameters */
+    assert((p_data != NULL) && (p_buf != NULL));
+
+    omx_buf_move(p_buf, OMX_BUF_OWNER_IO, OMX_BUF_OWNER_APP);
+
+    if (p_data->eos == false)
+    {
+        p_buf->nFlags     = 0;
+        p_buf->nFilledLen = 0;
+
+        /* The 'p_buf' is now avaiable to use. Try to add it back
+         * to the output port when End-of-Stream event does not occur */
+        bench_on_fill_this_buffer(p_data->p_bench, p_buf);
+
+        omx_buf_move(p_buf, OMX_BUF_OWNER_APP, OMX_BUF_OWNER_MC);
+
+        assert(OMX_FillThisBuffer(p_data->handle, p_buf) == OMX_ErrorNone);
+    }
+}
+
+void setup_in_buf(reader_t * p_reader, packer_t * p_packer,
+                  uint32_t skip_cnt, OMX_BUFFERHEADERTYPE * p_in_buf)
+{
+    reader_slot_t * p_slot = NULL;
+
+    /* Check parameters */
+    assert((p_reader != NULL) && (p_packer != NULL) && (p_in_buf != NULL));
+
+    /* Usually, the frame is already in memory. Otherwise, wait for it */
+    p_slot = reader_acquire(p_reader);
+
+    /* Frames dropped to lower the frame rate (see 'ratectl.h') */
+    while ((skip_cnt > 0) && (p_slot->len > 0))
+    {
+        reader_release(p_reader);
+        p_slot = reader_acquire(p_reader);
+
+        skip_cnt--;
+    }
+
+    p_in_buf->nOffset = 0;
+
+    if (p_slot->len > 0)
+    {
+        if (p_reader->p_map != NULL)
+        {
+            /* 'len' must not exceed the total size of the allocated buffer */
+            assert(p_slot->len <= p_in_buf->nAllocLen);
+
+            /* Zero-copy: point the buffer to the frame in the mapping */
+            p_in_buf->pBuffer    = p_slot->p_data;
+            p_in_buf->nFilledLen = p_slot->len;
+        }
+        else
+        {
+            /* Rows are scattered to the stride of input port (if needed).
+             * 'init_packer' checked that the frame fits in the buffer */
+            p_in_buf->nFilledLen = packer_pack_nv12(p_packer,
+                                                    p_in_buf->pBuffer,
+                                                    p_slot->p_data);
+        }
+
+        /* Since the program must store one input picture data into a single
+         * buffer for the component, all the input buffers must have this flag */
+        p_in_buf->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    }
+    else
+    {
+        /* There is no more frame (or the last one is truncated) */
+        p_in_buf->nFilledLen = 0;
+        p_in_buf->nFlags     = OMX_BUFFERFLAG_EOS;
+    }
+
+    reader_release(p_reader);
+}
+
+void send_idr_request(omx_data_t * p_data)
+{
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    atomic_store(&p_data->idr_requested, false);
+
+    if (atomic_load(&p_data->idr_request_ns) != 0)
+    {
+        /* The IDR frame of the pending request will do */
+        p_data->idr_merged++;
+        return;
+    }
+
+    if (omx_request_idr(p_data->handle) == false)
+    {
+        return;
+    }
+
+    /* FillBufferDone reads 'idr_out_frame' after 'idr_request_ns' */
+    p_data->idr_out_frame = atomic_load(&p_data->out_frame_count);
+    atomic_store(&p_data->idr_request_ns, omx_get_time_ns());
+
+    p_data->idr_count++;
+}
+
+void check_idr_frame(omx_data_t * p_data, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t request_ns = 0;
+    uint64_t delay_ns   = 0;
+    uint32_t frames     = 0;
+
+    /* Check parameters */
+    assert((p_data != NULL) && (p_buf != NULL));
+
+    if (p_buf->nFilledLen == 0)
+    {
+        return;
+    }
+
+    request_ns = atomic_load(&p_data->idr_request_ns);
+
+    if ((request_ns != 0) && (p_buf->nFlags & OMX_BUFFERFLAG_SYNCFRAME))
+    {
+        /* Frames returned since the request, this one included */
+        frames   = atomic_load(&p_data->out_frame_count) -
+                   p_data->idr_out_frame + 1;
+        delay_ns = omx_get_time_ns() - request_ns;
+
+        p_data->idr_frames_sum += frames;
+        p_data->idr_ns_sum     += delay_ns;
+
+        if (frames > p_data->idr_frames_max)
+        {
+            p_data->idr_frames_max = frames;
+        }
+
+        if (delay_ns > p_data->idr_ns_max)
+        {
+            p_data->idr_ns_max = delay_ns;
+        }
+
+        LOG_INFO("IDR: frame arrived %u frames (%.3f ms) after request\n",
+                 frames, delay_ns / 1e6);
+
+        atomic_store(&p_data->idr_request_ns, 0);
+    }
+
+    if (p_buf->nFlags & OMX_BUFFERFLAG_ENDOFFRAME)
+    {
+        atomic_fetch_add(&p_data->out_frame_count, 1);
+    }
+}
+
+void * control_thread_func(void * p_param)
+{
+    omx_data_t * p_data = (omx_data_t *)p_param;
+
+    sigset_t signals;
+    int signal_num = 0;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    trace_name_thread("control");
+
+    sigemptyset(&signals);
+    sigaddset(&signals, IDR_REQUEST_SIGNAL);
+
+    while (sigwait(&signals, &signal_num) == 0)
+    {
+        if (atomic_load(&p_data->control_stop))
+        {
+            break;
+        }
+
+        LOG_INFO("IDR: requested\n");
+
+        atomic_store(&p_data->idr_requested, true);
+    }
+
+    return NULL;
+}
+
+void * feeder_thread_func(void * p_param)
+{
+    omx_data_t * p_data = (omx_data_t *)p_param;
+
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+
+    /* Start of 'setup_in_buf' in the trace */
+    uint64_t trace_ns = 0;
+
+    /* The number of input frames to drop before the next one */
+    uint32_t skip_cnt = 0;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    trace_name_thread("feeder");
+
+    while (true)
+    {
+        /* Wait until a buffer is added to the queue or 'main' asks to exit */
+        sem_wait(&p_data->smp_in_buf);
+
+        if (atomic_load(&p_data->feeder_stop) || (p_data->eos == true))
+        {
+            break;
+        }
+
+        p_buf = (OMX_BUFFERHEADERTYPE *)queue_pop(&p_data->in_buf_queue);
+        if (p_buf == NULL)
+        {
+            continue;
+        }
+
+        if (p_data->p_ratectl != NULL)
+        {
+            skip_cnt = ratectl_skip_frames(p_data->p_ratectl);
+        }
+
+        /* In low-latency mode, wait until the frame is captured */
+        latency_capture(p_data->p_latency, skip_cnt, p_buf);
+
+        trace_ns = trace_now();
+
+        setup_in_buf(&p_data->reader, &p_data->packer, skip_cnt, p_buf);
+
+        trace_record(TRACE_EVENT_SETUP_IN_BUF, trace_ns,
+                     (uintptr_t)p_buf, p_buf->nFilledLen);
+
+        if ((p_buf->nFilledLen > 0) && atomic_load(&p_data->idr_requested))
+        {
+            /* This frame will be encoded as an IDR frame */
+            send_idr_request(p_data);
+        }
+
+        bench_on_empty_this_buffer(p_data->p_bench, p_buf);
+
+        omx_buf_move(p_buf, OMX_BUF_OWNER_APP, OMX_BUF_OWNER_MC);
+
+        assert(OMX_EmptyThisBuffer(p_data->handle, p_buf) == OMX_ErrorNone);
+
+        if (p_buf->nFlags & OMX_BUFFERFLAG_EOS)
+        {
+            /* No more data to send to input port */
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+bool init_packer(OMX_HANDLETYPE handle, packer_t * p_packer)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE in_port;
+
+    if (omx_get_port(handle, 0, &in_port) == false)
+    {
+        return false;
+    }
+
+    if (packer_init(p_packer,
+                    in_port.format.video.nFrameWidth,
+                    in_port.format.video.nFrameHeight,
+                    (uint32_t)in_port.format.video.nStride,
+                    in_port.format.video.nSliceHeight) == false)
+    {
+        return false;
+    }
+
+    /* A frame in the layout of input port must fit in an input buffer */
+    if ((((size_t)in_port.format.video.nStride *
+          in_port.format.video.nSliceHeight * 3) / 2) > in_port.nBufferSize)
+    {
+        printf("Error: Input buffers of '%d' bytes are too small\n",
+               in_port.nBufferSize);
+        return false;
+    }
+
+    return true;
+}
+
+bool can_use_in_file(OMX_HANDLETYPE handle)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE in_port;
+    OMX_U32 page_size = (OMX_U32)sysconf(_SC_PAGESIZE);
+
+    if (omx_get_port(handle, 0, &in_port) == false)
+    {
+        return false;
+    }
+
+    /* Rows and planes of NV12 frames in input file are packed. See
+     * 'OMX_STRIDE' and 'OMX_SLICE_HEIGHT' in 'omx.h' */
+    if ((in_port.format.video.nStride !=
+         (OMX_S32)in_port.format.video.nFrameWidth) ||
+        (in_port.format.video.nSliceHeight !=
+         in_port.format.video.nFrameHeight))
+    {
+        printf("Warning: Stride '%d' and slice height '%d' need padding\n",
+               (int)in_port.format.video.nStride,
+               in_port.format.video.nSliceHeight);
+        return false;
+    }
+
+    if (in_port.nBufferSize > NV12_FRAME_SIZE_IN_BYTES)
+    {
+        printf("Warning: Input buffers need '%d' bytes\n",
+               in_port.nBufferSize);
+        return false;
+    }
+
+    /* The mapping starts at a page boundary. So, each frame meets the
+     * alignment if both the page size and the frame size are multiples of it */
+    if ((in_port.nBufferAlignment > 1) &&
+        (((page_size % in_port.nBufferAlignment) != 0) ||
+         ((NV12_FRAME_SIZE_IN_BYTES % in_port.nBufferAlignment) != 0)))
+    {
+        printf("Warning: Frames of '%d' bytes do not meet buffer alignment "
+               "'%d'\n", NV12_FRAME_SIZE_IN_BYTES, in_port.nBufferAlignment);
+        return false;
+    }
+
+    return true;
+}
+
+OMX_BUFFERHEADERTYPE ** use_in_file_bufs(OMX_HANDLETYPE handle,
+                                         reader_t * p_reader,
+                                         uint32_t buf_cnt)
+{
+    OMX_BUFFERHEADERTYPE ** pp_bufs = NULL;
+
+    OMX_U8 ** pp_frames = NULL;
+    uint32_t frame_count = 0;
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_reader != NULL);
+
+    if (reader_map(p_reader) == false)
+    {
+        return NULL;
+    }
+
+    pp_frames = (OMX_U8 **)malloc(buf_cnt * sizeof(OMX_U8 *));
+    assert(pp_frames != NULL);
+
+    /* The first frames of input file. They are replaced by the next frames
+     * in 'setup_in_buf' */
+    frame_count = (uint32_t)(p_reader->file_size / NV12_FRAME_SIZE_IN_BYTES);
+
+    for (index = 0; index < buf_cnt; index++)
+    {
+        pp_frames[index] = p_reader->p_map +
+                           ((index % frame_count) * NV12_FRAME_SIZE_IN_BYTES);
+    }
+
+    pp_bufs = omx_use_buffers(handle, 0, pp_frames, NV12_FRAME_SIZE_IN_BYTES);
+
+    /* Buffer headers keep the addresses of the frames */
+    free(pp_frames);
+
+    return pp_bufs;
+}
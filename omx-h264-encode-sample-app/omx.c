@@ -15,44 +15,186 @@
  ******************************************************************************/
 
 
+#include <time.h>
+#include <errno.h>
+
 #include "omx.h"
 
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Allocate an array of 'count' buffer headers for port 'port_idx', followed
+ * by the metadata of each buffer ('omx_buf_meta_t', owned by the
+ * application). Freeing the array also frees the metadata.
+ * Return non-NULL value if successful. Otherwise, return NULL */
+static OMX_BUFFERHEADERTYPE ** omx_new_buf_array(OMX_U32 port_idx,
+                                                 uint32_t count);
+
+/* Get offset (in bytes) of the metadata in an array of 'count' buffers */
+static size_t omx_get_meta_offset(uint32_t count);
+
+/* Get metadata of buffer 'index' in array 'pp_bufs' of 'count' buffers */
+static omx_buf_meta_t * omx_get_array_meta(OMX_BUFFERHEADERTYPE ** pp_bufs,
+                                           uint32_t count, uint32_t index);
+
 /******************************************************************************
  *                            FUNCTION DEFINITION                             *
  ******************************************************************************/
 
-void omx_wait_state(OMX_HANDLETYPE handle, OMX_STATETYPE state)
+void omx_state_init(omx_state_t * p_state)
+{
+    pthread_condattr_t cond_attr;
+
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    /* Timeouts are measured with the monotonic clock, so they are not
+     * affected by changes of system time */
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&p_state->mutex, NULL);
+    pthread_cond_init(&p_state->cond, &cond_attr);
+
+    pthread_condattr_destroy(&cond_attr);
+
+    p_state->state = OMX_StateLoaded;
+    p_state->error = OMX_ErrorNone;
+}
+
+void omx_state_deinit(omx_state_t * p_state)
 {
-    OMX_ERRORTYPE omx_error = OMX_ErrorNone;
-    OMX_STATETYPE omx_cur_state = OMX_StateInvalid;
+    /* Check parameter */
+    assert(p_state != NULL);
 
-    while (true)
+    pthread_cond_destroy(&p_state->cond);
+    pthread_mutex_destroy(&p_state->mutex);
+}
+
+void omx_state_notify(omx_state_t * p_state, OMX_STATETYPE state)
+{
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    pthread_mutex_lock(&p_state->mutex);
+
+    p_state->state = state;
+    pthread_cond_broadcast(&p_state->cond);
+
+    pthread_mutex_unlock(&p_state->mutex);
+}
+
+void omx_state_notify_error(omx_state_t * p_state, OMX_ERRORTYPE error)
+{
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    switch (error)
     {
-        omx_error = OMX_GetState(handle, &omx_cur_state);
+        /* See section 3.2.2.13 in OMX IL specification 1.1.2 */
+        case OMX_ErrorSameState:
+        case OMX_ErrorIncorrectStateTransition:
+        case OMX_ErrorInsufficientResources:
+        case OMX_ErrorInvalidState:
+        {
+            pthread_mutex_lock(&p_state->mutex);
+
+            p_state->error = error;
+            pthread_cond_broadcast(&p_state->cond);
 
-        /* Exit if 'OMX_GetState' returns error */
-        if (omx_error != OMX_ErrorNone)
+            pthread_mutex_unlock(&p_state->mutex);
+        }
+        break;
+
+        default:
         {
-            printf("Error: Failed to get current state of media component\n");
-            break;
+            /* Other errors do not affect state transitions */
         }
+        break;
+    }
+}
+
+bool omx_wait_state(OMX_HANDLETYPE handle, omx_state_t * p_state,
+                    OMX_STATETYPE state, uint32_t timeout_ms)
+{
+    bool is_success = false;
+    int ret = 0;
+
+    struct timespec deadline;
+
+    const char * p_state_str = NULL;
+    OMX_STATETYPE cur_state = OMX_StateInvalid;
+
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
 
-        /* Exit if OMX has transitioned into desired state */
-        if (omx_cur_state == state)
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec  += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&p_state->mutex);
+
+    /* Sleep until the event handler reports the state (or an error) */
+    while ((p_state->state != state) && (p_state->error == OMX_ErrorNone))
+    {
+        ret = pthread_cond_timedwait(&p_state->cond, &p_state->mutex, &deadline);
+        if (ret == ETIMEDOUT)
         {
             break;
         }
+    }
+
+    is_success = (p_state->state == state);
+
+    if (!is_success)
+    {
+        p_state_str = omx_state_to_str(state);
+
+        if (p_state->error != OMX_ErrorNone)
+        {
+            printf("Error: Failed to transition into state '%s' (0x%x)\n",
+                   (p_state_str != NULL) ? p_state_str : "?", p_state->error);
+        }
+        else
+        {
+            /* The component may still be busy with the transition */
+            OMX_GetState(handle, &cur_state);
 
-        /* Wait for 10 ms to avoid wasting CPU cycles */
-        usleep(10000);
+            printf("Error: Timed out waiting for state '%s' (%u ms, "
+                   "current state 0x%x)\n",
+                   (p_state_str != NULL) ? p_state_str : "?",
+                   timeout_ms, cur_state);
+        }
     }
+
+    /* The error only applies to this transition */
+    p_state->error = OMX_ErrorNone;
+
+    pthread_mutex_unlock(&p_state->mutex);
+
+    return is_success;
 }
 
-char * omx_state_to_str(OMX_STATETYPE state)
+uint64_t omx_get_time_ns(void)
 {
-    char * p_state_str = NULL;
+    struct timespec now;
 
-    struct
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+const char * omx_state_to_str(OMX_STATETYPE state)
+{
+    static const struct
     {
         OMX_STATETYPE state;
         const char *  p_state_str;
@@ -92,14 +234,11 @@ char * omx_state_to_str(OMX_STATETYPE state)
     {
         if (state == state_mapping[index].state)
         {
-            p_state_str = malloc(strlen(state_mapping[index].p_state_str) + 1);
-            strcpy(p_state_str, state_mapping[index].p_state_str);
-
-            break;
+            return state_mapping[index].p_state_str;
         }
     }
 
-    return p_state_str;
+    return NULL;
 }
 
 bool omx_get_port(OMX_HANDLETYPE handle, OMX_U32 port_idx,
@@ -283,6 +422,135 @@ bool omx_set_port_buf_cnt(OMX_HANDLETYPE handle,
     return true;
 }
 
+bool omx_set_low_latency(OMX_HANDLETYPE handle, OMX_U32 p_frames,
+                         OMX_U32 slice_mbs, OMX_U32 cir_mbs)
+{
+    OMX_VIDEO_PARAM_AVCTYPE avc;
+    OMX_VIDEO_PARAM_INTRAREFRESHTYPE refresh;
+
+    /* Get AVC parameters of output port */
+    OMX_INIT_STRUCTURE(&avc);
+    avc.nPortIndex = 1;
+
+    if (OMX_ErrorNone !=
+        OMX_GetParameter(handle, OMX_IndexParamVideoAvc, &avc))
+    {
+        printf("Error: Failed to get AVC parameters of output port\n");
+        return false;
+    }
+
+    /* B-frames would make the encoder wait for later frames and CABAC
+     * is not part of Baseline profile */
+    avc.eProfile             = OMX_VIDEO_AVCProfileBaseline;
+    avc.nBFrames             = 0;
+    avc.nPFrames             = p_frames;
+    avc.nRefFrames           = 1;
+    avc.nAllowedPictureTypes = OMX_VIDEO_PictureTypeI |
+                               OMX_VIDEO_PictureTypeP;
+    avc.bEntropyCodingCABAC  = OMX_FALSE;
+
+    /* Each slice is returned in its own output buffer */
+    avc.nSliceHeaderSpacing  = slice_mbs;
+
+    if (OMX_ErrorNone !=
+        OMX_SetParameter(handle, OMX_IndexParamVideoAvc, &avc))
+    {
+        printf("Error: Failed to set AVC parameters of output port\n");
+        return false;
+    }
+
+    if (cir_mbs == 0)
+    {
+        return true;
+    }
+
+    /* Refresh the picture with intra macroblocks instead of IDR frames */
+    OMX_INIT_STRUCTURE(&refresh);
+    refresh.nPortIndex = 1;
+
+    if (OMX_ErrorNone !=
+        OMX_GetParameter(handle, OMX_IndexParamVideoIntraRefresh, &refresh))
+    {
+        printf("Error: Failed to get intra refresh of output port\n");
+        return false;
+    }
+
+    refresh.eRefreshMode = OMX_VIDEO_IntraRefreshCyclic;
+    refresh.nCirMBs      = cir_mbs;
+
+    if (OMX_ErrorNone !=
+        OMX_SetParameter(handle, OMX_IndexParamVideoIntraRefresh, &refresh))
+    {
+        printf("Error: Failed to set intra refresh of output port\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool omx_set_bitrate(OMX_HANDLETYPE handle, OMX_U32 bitrate)
+{
+    OMX_VIDEO_CONFIG_BITRATETYPE config;
+
+    /* Check parameter */
+    assert(bitrate > 0);
+
+    OMX_INIT_STRUCTURE(&config);
+    config.nPortIndex     = 1;
+    config.nEncodeBitrate = bitrate;
+
+    if (OMX_ErrorNone !=
+        OMX_SetConfig(handle, OMX_IndexConfigVideoBitrate, &config))
+    {
+        printf("Error: Failed to set bitrate '%d' to output port\n", bitrate);
+        return false;
+    }
+
+    return true;
+}
+
+bool omx_set_framerate(OMX_HANDLETYPE handle, OMX_U32 framerate)
+{
+    OMX_CONFIG_FRAMERATETYPE config;
+
+    /* Check parameter */
+    assert(framerate > 0);
+
+    OMX_INIT_STRUCTURE(&config);
+    config.nPortIndex = 1;
+
+    /* The frame rate is a Q16 fixed-point number */
+    config.xEncodeFramerate = framerate << 16;
+
+    if (OMX_ErrorNone !=
+        OMX_SetConfig(handle, OMX_IndexConfigVideoFramerate, &config))
+    {
+        printf("Error: Failed to set framerate '%d' to output port\n",
+               framerate);
+        return false;
+    }
+
+    return true;
+}
+
+bool omx_request_idr(OMX_HANDLETYPE handle)
+{
+    OMX_CONFIG_INTRAREFRESHVOPTYPE config;
+
+    OMX_INIT_STRUCTURE(&config);
+    config.nPortIndex      = 1;
+    config.IntraRefreshVOP = OMX_TRUE;
+
+    if (OMX_ErrorNone !=
+        OMX_SetConfig(handle, OMX_IndexConfigVideoIntraVOPRefresh, &config))
+    {
+        printf("Error: Failed to request IDR frame from output port\n");
+        return false;
+    }
+
+    return true;
+}
+
 OMX_BUFFERHEADERTYPE ** omx_alloc_buffers(OMX_HANDLETYPE handle,
                                           OMX_U32 port_idx)
 {
@@ -290,6 +558,7 @@ OMX_BUFFERHEADERTYPE ** omx_alloc_buffers(OMX_HANDLETYPE handle,
 
     OMX_PARAM_PORTDEFINITIONTYPE port;
     OMX_BUFFERHEADERTYPE ** pp_bufs = NULL;
+    omx_buf_meta_t * p_meta = NULL;
 
     /* Get port */
     if (omx_get_port(handle, port_idx, &port) == false)
@@ -298,17 +567,22 @@ OMX_BUFFERHEADERTYPE ** omx_alloc_buffers(OMX_HANDLETYPE handle,
     }
 
     /* Allocate an array of 'OMX_BUFFERHEADERTYPE *' */
-    pp_bufs = (OMX_BUFFERHEADERTYPE **)
-              malloc(port.nBufferCountActual * sizeof(OMX_BUFFERHEADERTYPE *));
-
+    pp_bufs = omx_new_buf_array(port_idx, port.nBufferCountActual);
+    if (pp_bufs == NULL)
+    {
+        return NULL;
+    }
 
     for (index = 0; index < port.nBufferCountActual; index++)
     {
+        /* The metadata of the buffer goes to 'pAppPrivate' */
+        p_meta = omx_get_array_meta(pp_bufs, port.nBufferCountActual, index);
+
         /* See section 2.2.10 in document 'R01USxxxxEJxxxx_cmn_v1.0.pdf'
          * and 'Table 6-3' in document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
         if (OMX_ErrorNone != OMX_AllocateBuffer(handle,
                                                 pp_bufs + index,
-                                                port_idx, NULL,
+                                                port_idx, p_meta,
                                                 port.nBufferSize))
         {
             printf("Error: Failed to allocate buffers at index '%d'\n", index);
@@ -325,6 +599,64 @@ OMX_BUFFERHEADERTYPE ** omx_alloc_buffers(OMX_HANDLETYPE handle,
     return pp_bufs;
 }
 
+OMX_BUFFERHEADERTYPE ** omx_use_buffers(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                                        OMX_U8 ** pp_data, OMX_U32 size)
+{
+    uint32_t index = 0;
+
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+    OMX_BUFFERHEADERTYPE ** pp_bufs = NULL;
+    omx_buf_meta_t * p_meta = NULL;
+
+    /* Check parameter */
+    assert(pp_data != NULL);
+
+    /* Get port */
+    if (omx_get_port(handle, port_idx, &port) == false)
+    {
+        return NULL;
+    }
+
+    /* Each buffer must be able to hold the data of a whole frame */
+    if (size < port.nBufferSize)
+    {
+        printf("Error: Buffers of port '%d' must have at least '%d' bytes\n",
+               port_idx, port.nBufferSize);
+        return NULL;
+    }
+
+    /* Allocate an array of 'OMX_BUFFERHEADERTYPE *' */
+    pp_bufs = omx_new_buf_array(port_idx, port.nBufferCountActual);
+    if (pp_bufs == NULL)
+    {
+        return NULL;
+    }
+
+    for (index = 0; index < port.nBufferCountActual; index++)
+    {
+        /* The metadata of the buffer goes to 'pAppPrivate' */
+        p_meta = omx_get_array_meta(pp_bufs, port.nBufferCountActual, index);
+
+        /* The component only allocates the buffer header.
+         * The memory at 'pp_data[index]' still belongs to the application */
+        if (OMX_ErrorNone != OMX_UseBuffer(handle, pp_bufs + index,
+                                           port_idx, p_meta,
+                                           size, pp_data[index]))
+        {
+            printf("Error: Failed to use buffer at index '%d'\n", index);
+            break;
+        }
+    }
+
+    if (index < port.nBufferCountActual)
+    {
+        omx_dealloc_port_bufs(handle, port_idx, pp_bufs, index);
+        return NULL;
+    }
+
+    return pp_bufs;
+}
+
 void omx_dealloc_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
                            OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count)
 {
@@ -335,6 +667,15 @@ void omx_dealloc_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
 
     for (index = 0; index < count; index++)
     {
+#if OMX_BUF_CHECK
+        if (omx_get_buf_meta(pp_bufs[index])->owner == OMX_BUF_OWNER_MC)
+        {
+            printf("Error: Buffer '%d' of port '%d' is freed while the MC "
+                   "owns it\n", index, port_idx);
+            fflush(stdout);
+            abort();
+        }
+#endif
         OMX_FreeBuffer(handle, port_idx, pp_bufs[index]);
     }
 
@@ -363,11 +704,19 @@ int omx_get_index(OMX_BUFFERHEADERTYPE * p_buf,
 {
     int ret = -1;
     uint32_t index = 0;
+    omx_buf_meta_t * p_meta = NULL;
 
     /* Check parameters */
     assert(p_buf != NULL);
     assert((pp_bufs != NULL) && (count > 0));
 
+    /* The metadata knows the index unless 'p_buf' is from another array */
+    p_meta = omx_get_buf_meta(p_buf);
+    if ((p_meta->index < count) && (pp_bufs[p_meta->index] == p_buf))
+    {
+        return (int)p_meta->index;
+    }
+
     for (index = 0; index < count; index++)
     {
         if (pp_bufs[index] == p_buf)
@@ -380,6 +729,124 @@ int omx_get_index(OMX_BUFFERHEADERTYPE * p_buf,
     return ret;
 }
 
+omx_buf_meta_t * omx_get_buf_meta(const OMX_BUFFERHEADERTYPE * p_buf)
+{
+    /* Check parameter */
+    assert((p_buf != NULL) && (p_buf->pAppPrivate != NULL));
+
+    return (omx_buf_meta_t *)p_buf->pAppPrivate;
+}
+
+void omx_buf_move(OMX_BUFFERHEADERTYPE * p_buf,
+                  omx_buf_owner_t from, omx_buf_owner_t to)
+{
+    omx_buf_meta_t * p_meta = omx_get_buf_meta(p_buf);
+    uint64_t now_ns = omx_get_time_ns();
+
+#if OMX_BUF_CHECK
+    static const char * const p_names[OMX_BUF_OWNER_COUNT] =
+    {
+        "the application", "the MC", "I/O"
+    };
+
+    if (p_meta->owner != from)
+    {
+        printf("Error: Buffer '%d' of port '%d' is owned by %s, not by %s "
+               "(handover to %s)\n", p_meta->index, p_meta->port_idx,
+               p_names[p_meta->owner], p_names[from], p_names[to]);
+        fflush(stdout);
+        abort();
+    }
+#else
+    UNUSED(from);
+#endif
+
+    p_meta->time_ns[p_meta->owner] += now_ns - p_meta->owner_ns;
+
+    if (p_meta->owner == OMX_BUF_OWNER_MC)
+    {
+        p_meta->returned_ns = now_ns;
+    }
+
+    if (to == OMX_BUF_OWNER_MC)
+    {
+        p_meta->sent_ns = now_ns;
+        p_meta->use_count++;
+    }
+
+    p_meta->owner    = to;
+    p_meta->owner_ns = now_ns;
+}
+
+void omx_add_buf_stats(OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count,
+                       omx_buf_stats_t * p_stats)
+{
+    uint32_t index = 0;
+    uint32_t owner = 0;
+    uint64_t now_ns = omx_get_time_ns();
+
+    omx_buf_meta_t * p_meta = NULL;
+
+    /* Check parameters */
+    assert((pp_bufs != NULL) && (p_stats != NULL));
+
+    for (index = 0; index < count; index++)
+    {
+        p_meta = omx_get_buf_meta(pp_bufs[index]);
+
+        if ((p_stats->buf_count == 0) || (p_meta->use_count < p_stats->use_min))
+        {
+            p_stats->use_min = p_meta->use_count;
+        }
+
+        if (p_meta->use_count > p_stats->use_max)
+        {
+            p_stats->use_max = p_meta->use_count;
+        }
+
+        p_stats->buf_count++;
+        p_stats->use_count += p_meta->use_count;
+
+        for (owner = 0; owner < OMX_BUF_OWNER_COUNT; owner++)
+        {
+            p_stats->time_ns[owner] += p_meta->time_ns[owner];
+        }
+
+        /* The current owner still has the buffer */
+        p_stats->time_ns[p_meta->owner] += now_ns - p_meta->owner_ns;
+    }
+}
+
+void omx_print_buf_stats(const char * p_name, const omx_buf_stats_t * p_stats)
+{
+    uint64_t total_ns = 0;
+    uint32_t owner = 0;
+
+    /* Check parameters */
+    assert((p_name != NULL) && (p_stats != NULL));
+
+    for (owner = 0; owner < OMX_BUF_OWNER_COUNT; owner++)
+    {
+        total_ns += p_stats->time_ns[owner];
+    }
+
+    if ((p_stats->buf_count == 0) || (total_ns == 0))
+    {
+        return;
+    }
+
+    printf("Buffers: %s: %u buffers sent %llu times to the MC "
+           "(%u to %u per buffer)\n", p_name, p_stats->buf_count,
+           (unsigned long long)p_stats->use_count,
+           p_stats->use_min, p_stats->use_max);
+
+    printf("Buffers: %s: time with the MC %.1f%%, application %.1f%%, "
+           "I/O %.1f%%\n", p_name,
+           100.0 * p_stats->time_ns[OMX_BUF_OWNER_MC] / total_ns,
+           100.0 * p_stats->time_ns[OMX_BUF_OWNER_APP] / total_ns,
+           100.0 * p_stats->time_ns[OMX_BUF_OWNER_IO] / total_ns);
+}
+
 bool omx_fill_buffers(OMX_HANDLETYPE handle,
                       OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count)
 {
@@ -394,6 +861,8 @@ bool omx_fill_buffers(OMX_HANDLETYPE handle,
         pp_bufs[index]->nFlags     = 0;
         pp_bufs[index]->nFilledLen = 0;
 
+        omx_buf_move(pp_bufs[index], OMX_BUF_OWNER_APP, OMX_BUF_OWNER_MC);
+
         if (OMX_FillThisBuffer(handle, pp_bufs[index]) != OMX_ErrorNone)
         {
             printf("Error: Failed to send buffer '%d' to output port\n", index);
@@ -406,46 +875,52 @@ bool omx_fill_buffers(OMX_HANDLETYPE handle,
     return is_success;
 }
 
-OMX_U32 omx_empty_buffer(OMX_HANDLETYPE handle, FILE * p_file,
-                         OMX_BUFFERHEADERTYPE * p_buf, uint32_t len)
-{
-    /* Contain the number of bytes read from input file */
-    size_t bytes_read = 0;
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
 
-    /* Check parameters */
-    assert(p_buf  != NULL);
-    assert(p_file != NULL);
+static OMX_BUFFERHEADERTYPE ** omx_new_buf_array(OMX_U32 port_idx,
+                                                 uint32_t count)
+{
+    uint32_t index = 0;
+    uint64_t now_ns = omx_get_time_ns();
 
-    /* 'len' must not exceed the total size of the allocated buffer */
-    assert(len <= p_buf->nAllocLen);
+    OMX_BUFFERHEADERTYPE ** pp_bufs = NULL;
+    omx_buf_meta_t * p_meta = NULL;
 
-    if (feof(p_file) != 0)
+    pp_bufs = (OMX_BUFFERHEADERTYPE **)
+              calloc(1, omx_get_meta_offset(count) +
+                        (count * sizeof(omx_buf_meta_t)));
+    if (pp_bufs == NULL)
     {
-        /* The End-of-File indicator for the input file is set */
-        p_buf->nFilledLen = 0;
-        p_buf->nFlags = OMX_BUFFERFLAG_EOS;
+        printf("Error: Failed to allocate buffer array of port '%d'\n",
+               port_idx);
+        return NULL;
     }
-    else
+
+    for (index = 0; index < count; index++)
     {
-        /* Read an NV12 frame from the input file */
-        bytes_read = fread(p_buf->pBuffer, 1, len, p_file);
+        p_meta = omx_get_array_meta(pp_bufs, count, index);
 
-        if (bytes_read == len)
-        {
-            /* Since the program must store one input picture data into a single
-             * buffer for the component, all the input buffers must have this flag */
-            p_buf->nFilledLen = len;
-            p_buf->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
-        }
-        else
-        {
-            /* In this case, the data read from 'fread()' has been corrupted.
-             * So, it will be marked as an empty and End-of-Stream buffer */
-            p_buf->nFilledLen = 0;
-            p_buf->nFlags = OMX_BUFFERFLAG_EOS;
-        }
+        p_meta->index    = index;
+        p_meta->port_idx = port_idx;
+        p_meta->owner    = OMX_BUF_OWNER_APP;
+        p_meta->owner_ns = now_ns;
     }
 
-    assert(OMX_EmptyThisBuffer(handle, p_buf) == OMX_ErrorNone);
-    return p_buf->nFlags;
+    return pp_bufs;
+}
+
+static size_t omx_get_meta_offset(uint32_t count)
+{
+    /* 'omx_buf_meta_t' holds 'uint64_t', which may need 8-byte alignment
+     * even where pointers have 4 bytes */
+    return ROUND_UP(count * sizeof(OMX_BUFFERHEADERTYPE *), sizeof(uint64_t));
+}
+
+static omx_buf_meta_t * omx_get_array_meta(OMX_BUFFERHEADERTYPE ** pp_bufs,
+                                           uint32_t count, uint32_t index)
+{
+    return (omx_buf_meta_t *)((uint8_t *)pp_bufs +
+                              omx_get_meta_offset(count)) + index;
 }
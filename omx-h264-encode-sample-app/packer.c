@@ -0,0 +1,314 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: packer.c
+ *
+ * DESCRIPTION:
+ *   NV12 input packer definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'packer.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "omx.h"
+#include "packer.h"
+
+/******************************************************************************
+ *                                   MACROS                                   *
+ ******************************************************************************/
+
+/* Define a row kernel whose length is always 'WIDTH' bytes */
+#define PACKER_DEFINE_ROW_FN(WIDTH)                                         \
+static void packer_copy_row_##WIDTH(uint8_t * p_dst, const uint8_t * p_src, \
+                                    size_t len)                             \
+{                                                                           \
+    UNUSED(len);                                                            \
+    packer_copy_row(p_dst, p_src, WIDTH);                                   \
+}
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Copy 'len' bytes of a row at 'p_src' to 'p_dst'. It is always inlined, so
+ * that the loops are unrolled when 'len' is a constant */
+static inline __attribute__((always_inline))
+void packer_copy_row(uint8_t * p_dst, const uint8_t * p_src, size_t len);
+
+/* Row kernels for any width and for common widths */
+static void packer_copy_row_any(uint8_t * p_dst, const uint8_t * p_src,
+                                size_t len);
+static void packer_copy_row_640(uint8_t * p_dst, const uint8_t * p_src,
+                                size_t len);
+static void packer_copy_row_720(uint8_t * p_dst, const uint8_t * p_src,
+                                size_t len);
+static void packer_copy_row_1280(uint8_t * p_dst, const uint8_t * p_src,
+                                 size_t len);
+static void packer_copy_row_1920(uint8_t * p_dst, const uint8_t * p_src,
+                                 size_t len);
+
+/* Get the row kernel for 'width' and its name */
+static packer_row_fn packer_get_kernel(uint32_t width, const char ** pp_name);
+
+/* Copy 'rows' rows of 'copy_row' at 'p_src' (packed) to 'p_dst' (rows are
+ * 'stride' bytes apart) */
+static void packer_copy_plane(packer_row_fn copy_row, uint8_t * p_dst,
+                              const uint8_t * p_src, uint32_t rows,
+                              uint32_t width, uint32_t stride);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool packer_init(packer_t * p_packer, uint32_t width, uint32_t height,
+                 uint32_t stride, uint32_t slice_height)
+{
+    /* Check parameter */
+    assert(p_packer != NULL);
+
+    memset(p_packer, 0, sizeof(packer_t));
+
+    /* UV rows hold 'width' rounded up to even bytes */
+    if ((width == 0) || (ROUND_UP(width, 2) > stride) ||
+        (ROUND_UP(height, 2) > slice_height))
+    {
+        printf("Error: Stride '%u' and slice height '%u' are too small for "
+               "%ux%u frames\n", stride, slice_height, width, height);
+        return false;
+    }
+
+    p_packer->width        = width;
+    p_packer->height       = height;
+    p_packer->stride       = stride;
+    p_packer->slice_height = slice_height;
+
+    p_packer->needed = (width != stride) || (height != slice_height);
+
+    p_packer->copy_y_row = packer_get_kernel(width, &p_packer->p_kernel_name);
+
+    /* Rows of UV plane have the same length as rows of Y plane if 'width'
+     * is even */
+    p_packer->copy_uv_row = ((width % 2) == 0) ? p_packer->copy_y_row :
+                                                 packer_copy_row_any;
+
+    return true;
+}
+
+size_t packer_get_frame_size(uint32_t width, uint32_t height)
+{
+    /* UV plane has a row of interleaved U and V samples per 2 rows of Y */
+    return ((size_t)width * height) +
+           ((size_t)ROUND_UP(width, 2) * ((height + 1) / 2));
+}
+
+size_t packer_pack_nv12(packer_t * p_packer,
+                        uint8_t * p_dst, const uint8_t * p_src)
+{
+    uint64_t start_ns = 0;
+    uint64_t pack_ns = 0;
+
+    size_t y_size   = 0;
+    size_t uv_start = 0;
+
+    /* Check parameters */
+    assert((p_packer != NULL) && (p_dst != NULL) && (p_src != NULL));
+
+    y_size   = (size_t)p_packer->width * p_packer->height;
+    uv_start = (size_t)p_packer->stride * p_packer->slice_height;
+
+    start_ns = omx_get_time_ns();
+
+    if (p_packer->needed)
+    {
+        /* Y plane */
+        packer_copy_plane(p_packer->copy_y_row, p_dst, p_src,
+                          p_packer->height, p_packer->width, p_packer->stride);
+
+        /* UV plane */
+        packer_copy_plane(p_packer->copy_uv_row, p_dst + uv_start,
+                          p_src + y_size, (p_packer->height + 1) / 2,
+                          ROUND_UP(p_packer->width, 2), p_packer->stride);
+    }
+    else
+    {
+        /* The layouts are the same */
+        memcpy(p_dst, p_src,
+               packer_get_frame_size(p_packer->width, p_packer->height));
+    }
+
+    pack_ns = omx_get_time_ns() - start_ns;
+
+    p_packer->frame_count++;
+    p_packer->pack_ns += pack_ns;
+    if (pack_ns > p_packer->pack_ns_max)
+    {
+        p_packer->pack_ns_max = pack_ns;
+    }
+
+    return (uv_start * 3) / 2;
+}
+
+void packer_print_stats(packer_t * p_packer)
+{
+    /* Check parameter */
+    assert(p_packer != NULL);
+
+    if (!p_packer->needed)
+    {
+        return;
+    }
+
+    printf("Packer: %llu frames %ux%u to stride %u / slice height %u "
+           "(kernel '%s'), pack time %.3f ms / max %.3f ms\n",
+           (unsigned long long)p_packer->frame_count,
+           p_packer->width, p_packer->height,
+           p_packer->stride, p_packer->slice_height, p_packer->p_kernel_name,
+           p_packer->pack_ns / 1e6, p_packer->pack_ns_max / 1e6);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static inline __attribute__((always_inline))
+void packer_copy_row(uint8_t * p_dst, const uint8_t * p_src, size_t len)
+{
+#if defined(__SSE2__)
+    __m128i bytes0;
+    __m128i bytes1;
+    __m128i bytes2;
+    __m128i bytes3;
+
+    while (len >= 64)
+    {
+        bytes0 = _mm_loadu_si128((const __m128i *)(p_src));
+        bytes1 = _mm_loadu_si128((const __m128i *)(p_src + 16));
+        bytes2 = _mm_loadu_si128((const __m128i *)(p_src + 32));
+        bytes3 = _mm_loadu_si128((const __m128i *)(p_src + 48));
+
+        _mm_storeu_si128((__m128i *)(p_dst),      bytes0);
+        _mm_storeu_si128((__m128i *)(p_dst + 16), bytes1);
+        _mm_storeu_si128((__m128i *)(p_dst + 32), bytes2);
+        _mm_storeu_si128((__m128i *)(p_dst + 48), bytes3);
+
+        p_src += 64;
+        p_dst += 64;
+        len   -= 64;
+    }
+
+    while (len >= 16)
+    {
+        _mm_storeu_si128((__m128i *)p_dst,
+                         _mm_loadu_si128((const __m128i *)p_src));
+
+        p_src += 16;
+        p_dst += 16;
+        len   -= 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16_t bytes0;
+    uint8x16_t bytes1;
+    uint8x16_t bytes2;
+    uint8x16_t bytes3;
+
+    while (len >= 64)
+    {
+        bytes0 = vld1q_u8(p_src);
+        bytes1 = vld1q_u8(p_src + 16);
+        bytes2 = vld1q_u8(p_src + 32);
+        bytes3 = vld1q_u8(p_src + 48);
+
+        vst1q_u8(p_dst,      bytes0);
+        vst1q_u8(p_dst + 16, bytes1);
+        vst1q_u8(p_dst + 32, bytes2);
+        vst1q_u8(p_dst + 48, bytes3);
+
+        p_src += 64;
+        p_dst += 64;
+        len   -= 64;
+    }
+
+    while (len >= 16)
+    {
+        vst1q_u8(p_dst, vld1q_u8(p_src));
+
+        p_src += 16;
+        p_dst += 16;
+        len   -= 16;
+    }
+#endif
+
+    /* The last bytes (or the whole row without SIMD) */
+    if (len > 0)
+    {
+        memcpy(p_dst, p_src, len);
+    }
+}
+
+static void packer_copy_row_any(uint8_t * p_dst, const uint8_t * p_src,
+                                size_t len)
+{
+    packer_copy_row(p_dst, p_src, len);
+}
+
+PACKER_DEFINE_ROW_FN(640)
+PACKER_DEFINE_ROW_FN(720)
+PACKER_DEFINE_ROW_FN(1280)
+PACKER_DEFINE_ROW_FN(1920)
+
+static packer_row_fn packer_get_kernel(uint32_t width, const char ** pp_name)
+{
+    /* Kernels specialized for common widths */
+    static const struct
+    {
+        uint32_t width;
+        packer_row_fn copy_row;
+        const char * p_name;
+
+    } kernels[] =
+    {
+        { 640,  packer_copy_row_640,  "640"  },
+        { 720,  packer_copy_row_720,  "720"  },
+        { 1280, packer_copy_row_1280, "1280" },
+        { 1920, packer_copy_row_1920, "1920" },
+    };
+
+    uint32_t index = 0;
+
+    for (index = 0; index < (sizeof(kernels) / sizeof(kernels[0])); index++)
+    {
+        if (kernels[index].width == width)
+        {
+            *pp_name = kernels[index].p_name;
+            return kernels[index].copy_row;
+        }
+    }
+
+    *pp_name = "any";
+    return packer_copy_row_any;
+}
+
+static void packer_copy_plane(packer_row_fn copy_row, uint8_t * p_dst,
+                              const uint8_t * p_src, uint32_t rows,
+                              uint32_t width, uint32_t stride)
+{
+    uint32_t row = 0;
+
+    for (row = 0; row < rows; row++)
+    {
+        copy_row(p_dst, p_src, width);
+
+        p_src += width;
+        p_dst += stride;
+    }
+}
@@ -0,0 +1,101 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: packer.h
+ *
+ * DESCRIPTION:
+ *   NV12 input packer.
+ *
+ *   Frames of input file are tightly packed: each row of Y plane is 'width'
+ *   bytes and UV plane starts right after the last row of Y plane. But input
+ *   port expects rows of 'nStride' bytes and UV plane at 'nStride' x
+ *   'nSliceHeight' bytes from the start of the buffer (see 'OMX_STRIDE' and
+ *   'OMX_SLICE_HEIGHT' in 'omx.h').
+ *
+ *   'packer_pack_nv12' scatters the rows of a packed frame to that layout
+ *   while copying it to an input buffer, so no separate conversion pass is
+ *   needed. Rows are copied 64 bytes at a time with SSE2 (x86) or NEON (Arm)
+ *   instructions. Common widths (640, 720, 1280 and 1920) use row kernels
+ *   whose length is a compile-time constant, so the compiler can unroll them.
+ *
+ * PUBLIC FUNCTIONS:
+ *   packer_init
+ *   packer_get_frame_size
+ *   packer_pack_nv12
+ *
+ *   packer_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _PACKER_H_
+#define _PACKER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+/* Copy a row of 'len' bytes at 'p_src' to 'p_dst' */
+typedef void (*packer_row_fn)(uint8_t * p_dst, const uint8_t * p_src, size_t len);
+
+typedef struct
+{
+    /* Visible size of the frame (in pixels) */
+    uint32_t width;
+    uint32_t height;
+
+    /* Layout of input buffers (in bytes and rows) */
+    uint32_t stride;
+    uint32_t slice_height;
+
+    /* True if the layout of input buffers has padding, so that frames must be
+     * scattered row by row. Otherwise, they are copied as a whole */
+    bool needed;
+
+    /* Kernels which copy a row of Y plane and a row of UV plane */
+    packer_row_fn copy_y_row;
+    packer_row_fn copy_uv_row;
+
+    /* Name of the kernels (for statistics) */
+    const char * p_kernel_name;
+
+    /* The number of packed frames */
+    uint64_t frame_count;
+
+    /* Time (in ns) spent in 'packer_pack_nv12' */
+    uint64_t pack_ns;
+    uint64_t pack_ns_max;
+
+} packer_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Initialize 'p_packer' for 'width' x 'height' frames and input buffers of
+ * 'stride' bytes per row and 'slice_height' rows per plane.
+ * Return true if successful. Otherwise (the layout is too small for
+ * the frame), return false */
+bool packer_init(packer_t * p_packer, uint32_t width, uint32_t height,
+                 uint32_t stride, uint32_t slice_height);
+
+/* Get the number of bytes of a packed NV12 frame of 'width' x 'height' */
+size_t packer_get_frame_size(uint32_t width, uint32_t height);
+
+/* Copy the packed NV12 frame at 'p_src' to 'p_dst' in the layout of input
+ * buffers. Padding bytes of 'p_dst' are left unchanged.
+ * Return the size of the frame in that layout, which is
+ * 'stride' x 'slice_height' x 3 / 2 bytes */
+size_t packer_pack_nv12(packer_t * p_packer,
+                        uint8_t * p_dst, const uint8_t * p_src);
+
+/* Print statistics of 'p_packer' */
+void packer_print_stats(packer_t * p_packer);
+
+#endif /* _PACKER_H_ */
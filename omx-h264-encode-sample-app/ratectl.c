@@ -0,0 +1,475 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: ratectl.c
+ *
+ * DESCRIPTION:
+ *   Rate controller which keeps the H.264 stream within a bandwidth budget
+ *   definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'ratectl.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+#include "ratectl.h"
+#include "logger.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Thread function which calls 'ratectl_update' every 'RATECTL_PERIOD_MS' ms
+ * until 'ratectl_stop' is called */
+static void * ratectl_thread(void * p_param);
+
+/* Read the budget file and send new settings to the encoder. 'frames' is 0
+ * if too few frames have been encoded since the last period */
+static void ratectl_update(ratectl_t * p_ctl, uint64_t bytes, uint32_t frames);
+
+/* Read the budget (in bit/s) from 'p_file_name' to 'p_budget'.
+ * Return true if successful. Otherwise, return false */
+static bool ratectl_read_budget(const char * p_file_name, uint32_t * p_budget);
+
+/* Get the frame rate for bitrate 'target' when the current frame rate is
+ * 'fps'. It is lowered as soon as frames get smaller than 'min_frame_bits',
+ * but it is only raised with a margin of 'RATECTL_DEADBAND', so that a
+ * budget close to the limit does not toggle it */
+static uint32_t ratectl_get_fps(const ratectl_limits_t * p_limits,
+                                double target, uint32_t fps);
+
+/* Limit 'bitrate' to the range of 'p_limits' */
+static double ratectl_clamp(const ratectl_limits_t * p_limits, double bitrate);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool ratectl_init(ratectl_t * p_ctl, const char * p_budget_file,
+                  const ratectl_limits_t * p_limits, uint32_t bitrate)
+{
+    pthread_condattr_t cond_attr;
+
+    double target = 0;
+    uint32_t fps  = 0;
+
+    /* Check parameters */
+    assert((p_ctl != NULL) && (p_budget_file != NULL) && (p_limits != NULL));
+
+    memset(p_ctl, 0, sizeof(ratectl_t));
+
+    if ((p_limits->min_bitrate == 0) ||
+        (p_limits->min_bitrate > p_limits->max_bitrate) ||
+        (p_limits->min_fps == 0) || (p_limits->min_fps > p_limits->max_fps) ||
+        (p_limits->min_frame_bits == 0))
+    {
+        printf("Error: Invalid limits of rate control\n");
+        return false;
+    }
+
+    p_ctl->p_budget_file = p_budget_file;
+    p_ctl->limits        = *p_limits;
+
+    fps = p_limits->max_fps;
+
+    /* Start from the budget if it is already known */
+    if (ratectl_read_budget(p_budget_file, &p_ctl->budget))
+    {
+        target  = p_ctl->budget * RATECTL_HEADROOM;
+        fps     = ratectl_get_fps(p_limits, target, fps);
+        bitrate = (uint32_t)ratectl_clamp(p_limits, target);
+    }
+    else
+    {
+        printf("Warning: Failed to read budget from '%s', start with "
+               "bitrate '%u'\n", p_budget_file, bitrate);
+
+        bitrate = (uint32_t)ratectl_clamp(p_limits, bitrate);
+    }
+
+    p_ctl->bitrate = bitrate;
+    atomic_init(&p_ctl->fps, fps);
+
+    p_ctl->stats.bitrate_min = bitrate;
+    p_ctl->stats.bitrate_max = bitrate;
+    p_ctl->stats.fps_min     = fps;
+
+    /* The period is measured with the monotonic clock, so it is not
+     * affected by changes of system time */
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&p_ctl->mutex, NULL);
+    pthread_cond_init(&p_ctl->cond, &cond_attr);
+
+    pthread_condattr_destroy(&cond_attr);
+
+    return true;
+}
+
+bool ratectl_start(ratectl_t * p_ctl, OMX_HANDLETYPE handle)
+{
+    uint32_t fps = 0;
+
+    /* Check parameter */
+    assert(p_ctl != NULL);
+
+    p_ctl->handle = handle;
+
+    /* The frame rate of output port is 'max_fps' until now */
+    fps = atomic_load(&p_ctl->fps);
+    if (fps != p_ctl->limits.max_fps)
+    {
+        if (omx_set_framerate(handle, fps) == false)
+        {
+            return false;
+        }
+
+        p_ctl->stats.fps_changes++;
+    }
+
+    if (pthread_create(&p_ctl->thread, NULL, ratectl_thread, p_ctl) != 0)
+    {
+        printf("Error: Failed to create thread of rate control\n");
+        return false;
+    }
+
+    p_ctl->started = true;
+
+    return true;
+}
+
+void ratectl_stop(ratectl_t * p_ctl)
+{
+    /* Check parameter */
+    assert(p_ctl != NULL);
+
+    if (p_ctl->started)
+    {
+        pthread_mutex_lock(&p_ctl->mutex);
+        p_ctl->stop = true;
+        pthread_cond_signal(&p_ctl->cond);
+        pthread_mutex_unlock(&p_ctl->mutex);
+
+        pthread_join(p_ctl->thread, NULL);
+
+        p_ctl->started = false;
+    }
+
+    pthread_cond_destroy(&p_ctl->cond);
+    pthread_mutex_destroy(&p_ctl->mutex);
+}
+
+void ratectl_on_fill_buffer_done(ratectl_t * p_ctl,
+                                 const OMX_BUFFERHEADERTYPE * p_buf)
+{
+    /* Check parameters */
+    assert((p_ctl != NULL) && (p_buf != NULL));
+
+    pthread_mutex_lock(&p_ctl->mutex);
+
+    p_ctl->bytes += p_buf->nFilledLen;
+
+    /* A frame may be split into several output buffers (slices) */
+    if ((p_buf->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) &&
+        (p_buf->nFilledLen > 0))
+    {
+        p_ctl->frames++;
+    }
+
+    pthread_mutex_unlock(&p_ctl->mutex);
+}
+
+uint32_t ratectl_skip_frames(ratectl_t * p_ctl)
+{
+    uint32_t fps  = 0;
+    uint32_t skip = 0;
+
+    /* Check parameter */
+    assert(p_ctl != NULL);
+
+    fps = atomic_load(&p_ctl->fps);
+
+    /* Keep 'fps' out of every 'max_fps' input frames, evenly spread */
+    while (true)
+    {
+        p_ctl->frame_acc += fps;
+
+        if (p_ctl->frame_acc >= p_ctl->limits.max_fps)
+        {
+            p_ctl->frame_acc -= p_ctl->limits.max_fps;
+            break;
+        }
+
+        skip++;
+    }
+
+    p_ctl->stats.dropped_frames += skip;
+
+    return skip;
+}
+
+void ratectl_print_stats(const ratectl_t * p_ctl)
+{
+    const ratectl_stats_t * p_stats = NULL;
+
+    /* Check parameter */
+    assert(p_ctl != NULL);
+
+    p_stats = &p_ctl->stats;
+
+    printf("Rate control: budget %u bit/s, bitrate %u bit/s "
+           "(%u changes, %u-%u bit/s)\n",
+           p_ctl->budget, p_ctl->bitrate, p_stats->bitrate_changes,
+           p_stats->bitrate_min, p_stats->bitrate_max);
+
+    printf("Rate control: %u fps (%u changes, min %u fps), "
+           "%llu input frames dropped, %u failed reads of '%s'\n",
+           atomic_load(&p_ctl->fps), p_stats->fps_changes, p_stats->fps_min,
+           (unsigned long long)p_stats->dropped_frames,
+           p_stats->read_errors, p_ctl->p_budget_file);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static void * ratectl_thread(void * p_param)
+{
+    ratectl_t * p_ctl = (ratectl_t *)p_param;
+
+    struct timespec deadline;
+
+    /* Data taken from the counters of FillBufferDone */
+    uint64_t bytes  = 0;
+    uint32_t frames = 0;
+
+    trace_name_thread("ratectl");
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    pthread_mutex_lock(&p_ctl->mutex);
+
+    while (!p_ctl->stop)
+    {
+        deadline.tv_sec  += RATECTL_PERIOD_MS / 1000;
+        deadline.tv_nsec += (RATECTL_PERIOD_MS % 1000) * 1000000L;
+
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec  += 1;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        while (!p_ctl->stop &&
+               (pthread_cond_timedwait(&p_ctl->cond, &p_ctl->mutex,
+                                       &deadline) != ETIMEDOUT))
+        {
+            /* Spurious wake-up */
+        }
+
+        if (p_ctl->stop)
+        {
+            break;
+        }
+
+        /* With too few frames, the measurement waits for the next period */
+        bytes  = 0;
+        frames = 0;
+
+        if (p_ctl->frames >= RATECTL_MIN_FRAMES)
+        {
+            bytes  = p_ctl->bytes;
+            frames = p_ctl->frames;
+
+            p_ctl->bytes  = 0;
+            p_ctl->frames = 0;
+        }
+
+        /* FillBufferDone must not wait for 'OMX_SetConfig' */
+        pthread_mutex_unlock(&p_ctl->mutex);
+
+        ratectl_update(p_ctl, bytes, frames);
+
+        pthread_mutex_lock(&p_ctl->mutex);
+    }
+
+    pthread_mutex_unlock(&p_ctl->mutex);
+
+    return NULL;
+}
+
+static void ratectl_update(ratectl_t * p_ctl, uint64_t bytes, uint32_t frames)
+{
+    uint32_t fps     = atomic_load(&p_ctl->fps);
+    uint32_t new_fps = 0;
+
+    /* Bitrates in bit/s */
+    double target   = 0;
+    double measured = 0;
+    double error    = 0;
+    double bitrate  = p_ctl->bitrate;
+
+    if (ratectl_read_budget(p_ctl->p_budget_file, &p_ctl->budget) == false)
+    {
+        /* Keep the last budget */
+        p_ctl->stats.read_errors++;
+    }
+
+    if (p_ctl->budget == 0)
+    {
+        /* No budget has been read yet */
+        return;
+    }
+
+    target  = p_ctl->budget * RATECTL_HEADROOM;
+    new_fps = ratectl_get_fps(&p_ctl->limits, target, fps);
+
+    if (frames > 0)
+    {
+        /* Bitrate of the stream at the current frame rate */
+        measured = ((double)bytes * 8 * fps) / frames;
+    }
+
+    if ((frames > 0) && (new_fps == fps))
+    {
+        error = (target / measured) - 1;
+
+        bitrate *= 1 + ((error < 0) ? error : (RATECTL_UP_GAIN * error));
+    }
+    else if (bitrate > target)
+    {
+        /* Without a measurement, follow a lower budget at once */
+        bitrate = target;
+    }
+
+    if (bitrate > (target * RATECTL_MAX_BOOST))
+    {
+        bitrate = target * RATECTL_MAX_BOOST;
+    }
+
+    bitrate = ratectl_clamp(&p_ctl->limits, bitrate);
+
+    if (new_fps != fps)
+    {
+        if (omx_set_framerate(p_ctl->handle, new_fps) == false)
+        {
+            return;
+        }
+
+        atomic_store(&p_ctl->fps, new_fps);
+
+        p_ctl->stats.fps_changes++;
+        if (new_fps < p_ctl->stats.fps_min)
+        {
+            p_ctl->stats.fps_min = new_fps;
+        }
+    }
+    else if (fabs(bitrate - p_ctl->bitrate) <
+             (p_ctl->bitrate * RATECTL_DEADBAND))
+    {
+        return;
+    }
+
+    if ((uint32_t)bitrate != p_ctl->bitrate)
+    {
+        if (omx_set_bitrate(p_ctl->handle, (OMX_U32)bitrate) == false)
+        {
+            return;
+        }
+
+        p_ctl->bitrate = (uint32_t)bitrate;
+
+        p_ctl->stats.bitrate_changes++;
+        if (p_ctl->bitrate < p_ctl->stats.bitrate_min)
+        {
+            p_ctl->stats.bitrate_min = p_ctl->bitrate;
+        }
+        if (p_ctl->bitrate > p_ctl->stats.bitrate_max)
+        {
+            p_ctl->stats.bitrate_max = p_ctl->bitrate;
+        }
+    }
+
+    if (frames > 0)
+    {
+        LOG_INFO("Rate control: budget %u bit/s, stream %u bit/s, "
+                 "bitrate %u bit/s, %u fps\n", p_ctl->budget,
+                 (uint32_t)measured, p_ctl->bitrate, new_fps);
+    }
+    else
+    {
+        LOG_INFO("Rate control: budget %u bit/s, bitrate %u bit/s, %u fps\n",
+                 p_ctl->budget, p_ctl->bitrate, new_fps);
+    }
+}
+
+static bool ratectl_read_budget(const char * p_file_name, uint32_t * p_budget)
+{
+    FILE * p_file = NULL;
+    unsigned long long value = 0;
+
+    bool is_success = false;
+
+    p_file = fopen(p_file_name, "r");
+    if (p_file == NULL)
+    {
+        return false;
+    }
+
+    if ((fscanf(p_file, "%llu", &value) == 1) &&
+        (value > 0) && (value <= UINT32_MAX))
+    {
+        *p_budget  = (uint32_t)value;
+        is_success = true;
+    }
+
+    fclose(p_file);
+
+    return is_success;
+}
+
+static uint32_t ratectl_get_fps(const ratectl_limits_t * p_limits,
+                                double target, uint32_t fps)
+{
+    /* Frame rate at which each frame gets 'min_frame_bits' */
+    double frames = target / p_limits->min_frame_bits;
+
+    if (frames >= p_limits->max_fps)
+    {
+        return p_limits->max_fps;
+    }
+
+    if (frames < fps)
+    {
+        fps = (uint32_t)frames;
+    }
+    else if ((frames / (1 + RATECTL_DEADBAND)) >= (fps + 1))
+    {
+        fps = (uint32_t)(frames / (1 + RATECTL_DEADBAND));
+    }
+
+    return (fps < p_limits->min_fps) ? p_limits->min_fps : fps;
+}
+
+static double ratectl_clamp(const ratectl_limits_t * p_limits, double bitrate)
+{
+    if (bitrate < p_limits->min_bitrate)
+    {
+        bitrate = p_limits->min_bitrate;
+    }
+
+    if (bitrate > p_limits->max_bitrate)
+    {
+        bitrate = p_limits->max_bitrate;
+    }
+
+    return bitrate;
+}
@@ -0,0 +1,207 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: ratectl.h
+ *
+ * DESCRIPTION:
+ *   Rate controller which keeps the H.264 stream within a bandwidth budget.
+ *
+ *   The budget (in bit/s) is the first number of a text file which another
+ *   process (for example, a monitor of the uplink) rewrites at any time.
+ *   The controller thread reads it every 'RATECTL_PERIOD_MS' ms. The other
+ *   process should replace the file at once (write a temporary file and
+ *   rename it), so that a partly written number is never read.
+ *
+ *   FillBufferDone reports the size of each output buffer with
+ *   'ratectl_on_fill_buffer_done'. Every period, the controller turns the
+ *   bytes of the frames encoded since the last period into a bitrate of the
+ *   stream (bits per frame * frame rate, so it does not depend on how fast
+ *   the frames are encoded) and compares it with
+ *   'budget * RATECTL_HEADROOM':
+ *     - Above the target, the bitrate of the encoder is lowered by the whole
+ *       error at once, so the uplink does not overflow.
+ *     - Below the target, it is raised by 'RATECTL_UP_GAIN' of the error, so
+ *       the stream approaches the budget without overshooting it.
+ *     - Changes smaller than 'RATECTL_DEADBAND' are not applied.
+ *   The bitrate never exceeds 'RATECTL_MAX_BOOST' times the target. So, a
+ *   static scene (which needs fewer bits than asked) does not let it grow
+ *   until the next complex scene overflows the uplink.
+ *
+ *   If the target leaves less than 'min_frame_bits' per frame at the full
+ *   frame rate, the frame rate is lowered (down to 'min_fps') to keep the
+ *   quality of each frame. The feeder then drops input frames as told by
+ *   'ratectl_skip_frames'.
+ *
+ *   New settings are sent to the running encoder with 'OMX_SetConfig'
+ *   ('omx_set_bitrate' and 'omx_set_framerate'), never from a callback.
+ *
+ * PUBLIC FUNCTIONS:
+ *   ratectl_init
+ *   ratectl_start
+ *   ratectl_stop
+ *
+ *   ratectl_on_fill_buffer_done
+ *   ratectl_skip_frames
+ *
+ *   ratectl_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _RATECTL_H_
+#define _RATECTL_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "omx.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* Period (in ms) of the controller */
+#define RATECTL_PERIOD_MS 500
+
+/* The minimum number of frames measured before the bitrate is corrected */
+#define RATECTL_MIN_FRAMES 8
+
+/* Part of the budget targeted by the stream (0.95 = 95%) */
+#define RATECTL_HEADROOM 0.95
+
+/* Part of the error corrected in one period when the stream is below the
+ * target (above the target, the whole error is corrected) */
+#define RATECTL_UP_GAIN 0.5
+
+/* Relative changes of bitrate below this value are not applied */
+#define RATECTL_DEADBAND 0.05
+
+/* The bitrate is at most this number of times the target */
+#define RATECTL_MAX_BOOST 1.5
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Range of the bitrate (in bit/s) of the encoder */
+    uint32_t min_bitrate;
+    uint32_t max_bitrate;
+
+    /* Range of the frame rate (in FPS). 'max_fps' is the frame rate of the
+     * input file */
+    uint32_t min_fps;
+    uint32_t max_fps;
+
+    /* Bits per frame under which the frame rate is lowered */
+    uint32_t min_frame_bits;
+
+} ratectl_limits_t;
+
+typedef struct
+{
+    /* The number of changes of bitrate and frame rate sent to the encoder */
+    uint32_t bitrate_changes;
+    uint32_t fps_changes;
+
+    /* Lowest and highest bitrates sent to the encoder */
+    uint32_t bitrate_min;
+    uint32_t bitrate_max;
+
+    /* Lowest frame rate sent to the encoder */
+    uint32_t fps_min;
+
+    /* The number of periods in which the budget file could not be read */
+    uint32_t read_errors;
+
+    /* The number of input frames dropped to lower the frame rate */
+    uint64_t dropped_frames;
+
+} ratectl_stats_t;
+
+typedef struct
+{
+    /* File which contains the budget (in bit/s) */
+    const char * p_budget_file;
+
+    /* Limits of the settings */
+    ratectl_limits_t limits;
+
+    /* Handle of the encoder (set by 'ratectl_start') */
+    OMX_HANDLETYPE handle;
+
+    /* Last budget read from 'p_budget_file' (in bit/s) */
+    uint32_t budget;
+
+    /* Bitrate (in bit/s) currently set to the encoder */
+    uint32_t bitrate;
+
+    /* Frame rate currently set to the encoder (read by the feeder) */
+    atomic_uint fps;
+
+    /* Bytes and frames output since the last period (protected by 'mutex') */
+    uint64_t bytes;
+    uint32_t frames;
+
+    /* Accumulator of 'ratectl_skip_frames' (only used by the feeder) */
+    uint32_t frame_acc;
+
+    /* Protect 'bytes', 'frames' and 'stop' */
+    pthread_mutex_t mutex;
+
+    /* Signaled by 'ratectl_stop' to wake the controller thread up */
+    pthread_cond_t cond;
+
+    /* True if the controller thread must exit */
+    bool stop;
+
+    /* True if the controller thread is running */
+    bool started;
+
+    /* Thread which reads the budget and updates the encoder */
+    pthread_t thread;
+
+    /* Statistics (only valid after 'ratectl_stop') */
+    ratectl_stats_t stats;
+
+} ratectl_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Initialize 'p_ctl' with budget file 'p_budget_file' and 'p_limits'.
+ *
+ * The budget file is read once. If it can be read, the initial bitrate
+ * (to be set to output port before state IDLE) is derived from it.
+ * Otherwise, it is 'bitrate'. Either way, it is stored to 'p_ctl->bitrate'.
+ *
+ * Return true if successful. Otherwise, return false */
+bool ratectl_init(ratectl_t * p_ctl, const char * p_budget_file,
+                  const ratectl_limits_t * p_limits, uint32_t bitrate);
+
+/* Start the controller thread of 'p_ctl' which updates encoder 'handle'.
+ * The encoder should be in state EXECUTING.
+ * Return true if successful. Otherwise, return false */
+bool ratectl_start(ratectl_t * p_ctl, OMX_HANDLETYPE handle);
+
+/* Stop the controller thread and release the resources of 'p_ctl' */
+void ratectl_stop(ratectl_t * p_ctl);
+
+/* Count the data of output buffer 'p_buf'. The function only takes a mutex
+ * for a few instructions, so it can be called from FillBufferDone */
+void ratectl_on_fill_buffer_done(ratectl_t * p_ctl,
+                                 const OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Return the number of input frames to drop before the next encoded frame,
+ * so that the frames sent to the encoder follow its current frame rate.
+ * It is 0 while the frame rate is 'max_fps' */
+uint32_t ratectl_skip_frames(ratectl_t * p_ctl);
+
+/* Print statistics of 'p_ctl' (call it after 'ratectl_stop') */
+void ratectl_print_stats(const ratectl_t * p_ctl);
+
+#endif /* _RATECTL_H_ */
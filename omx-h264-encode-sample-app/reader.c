@@ -0,0 +1,449 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: reader.c
+ *
+ * DESCRIPTION:
+ *   Read-ahead input reader definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'reader.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "reader.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get current time (in ns) of the monotonic clock */
+static uint64_t reader_now_ns(void);
+
+/* Read 'len' bytes of input file to 'p_data'.
+ * Return the number of bytes actually read */
+static size_t reader_read_all(reader_t * p_reader, uint8_t * p_data, size_t len);
+
+/* Get the next frame of the mapping of input file */
+static reader_slot_t * reader_map_acquire(reader_t * p_reader);
+
+/* Thread function */
+static void * reader_prefetch_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool reader_open(reader_t * p_reader, const char * p_file_name,
+                 size_t frame_size, uint32_t depth)
+{
+    struct stat file_stat;
+
+    /* Check parameters */
+    assert((p_reader != NULL) && (p_file_name != NULL));
+    assert((frame_size > 0) && (depth > 0));
+
+    memset(p_reader, 0, sizeof(reader_t));
+
+    p_reader->fd = open(p_file_name, O_RDONLY);
+    if (p_reader->fd < 0)
+    {
+        printf("Error: Failed to open '%s'\n", p_file_name);
+        return false;
+    }
+
+    if (fstat(p_reader->fd, &file_stat) != 0)
+    {
+        printf("Error: Failed to get size of '%s'\n", p_file_name);
+        reader_close(p_reader);
+        return false;
+    }
+
+    p_reader->file_size  = file_stat.st_size;
+    p_reader->frame_size = frame_size;
+    p_reader->depth      = depth;
+
+    /* The file is read once from start to end, so the kernel can use
+     * a larger read-ahead window */
+    posix_fadvise(p_reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    atomic_init(&p_reader->stop, false);
+
+    return true;
+}
+
+bool reader_start(reader_t * p_reader)
+{
+    uint32_t index = 0;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* Check parameter */
+    assert((p_reader != NULL) && (p_reader->p_map == NULL));
+
+    p_reader->p_slots = (reader_slot_t *)calloc(p_reader->depth,
+                                                sizeof(reader_slot_t));
+    if (p_reader->p_slots == NULL)
+    {
+        printf("Error: Failed to allocate slots of reader\n");
+        return false;
+    }
+
+    sem_init(&p_reader->smp_slot_free, 0, p_reader->depth);
+    sem_init(&p_reader->smp_slot_full, 0, 0);
+
+    for (index = 0; index < p_reader->depth; index++)
+    {
+        if (posix_memalign((void **)&p_reader->p_slots[index].p_data, page_size,
+                           ROUND_UP(p_reader->frame_size, page_size)) != 0)
+        {
+            printf("Error: Failed to allocate slot '%d' of reader\n", index);
+            return false;
+        }
+    }
+
+    if (pthread_create(&p_reader->thread, NULL,
+                       reader_prefetch_thread, p_reader) != 0)
+    {
+        printf("Error: Failed to create prefetch thread of reader\n");
+        return false;
+    }
+
+    p_reader->started = true;
+
+    return true;
+}
+
+bool reader_map(reader_t * p_reader)
+{
+    void * p_map = NULL;
+
+    /* Check parameter */
+    assert((p_reader != NULL) && (p_reader->p_slots == NULL));
+
+    if (p_reader->file_size <= 0)
+    {
+        return false;
+    }
+
+    p_map = mmap(NULL, (size_t)p_reader->file_size, PROT_READ, MAP_PRIVATE,
+                 p_reader->fd, 0);
+    if (p_map == MAP_FAILED)
+    {
+        printf("Error: Failed to map input file into memory\n");
+        return false;
+    }
+
+    p_reader->p_map   = (uint8_t *)p_map;
+    p_reader->map_len = (size_t)p_reader->file_size;
+
+    /* Pages are accessed in order, so the kernel can read them ahead */
+    madvise(p_reader->p_map, p_reader->map_len, MADV_SEQUENTIAL);
+
+    return true;
+}
+
+void reader_unmap(reader_t * p_reader)
+{
+    /* Check parameter */
+    assert(p_reader != NULL);
+
+    if (p_reader->p_map != NULL)
+    {
+        munmap(p_reader->p_map, p_reader->map_len);
+
+        p_reader->p_map       = NULL;
+        p_reader->map_len     = 0;
+        p_reader->read_offset = 0;
+    }
+}
+
+reader_slot_t * reader_acquire(reader_t * p_reader)
+{
+    uint64_t start_ns = 0;
+    uint64_t starve_ns = 0;
+
+    /* Check parameter */
+    assert(p_reader != NULL);
+
+    if (p_reader->p_map != NULL)
+    {
+        return reader_map_acquire(p_reader);
+    }
+
+    if (sem_trywait(&p_reader->smp_slot_full) != 0)
+    {
+        /* No frame is ready, so the storage is holding the component back */
+        start_ns = reader_now_ns();
+        sem_wait(&p_reader->smp_slot_full);
+        starve_ns = reader_now_ns() - start_ns;
+
+        p_reader->stats.starve_count++;
+        p_reader->stats.starve_ns += starve_ns;
+        if (starve_ns > p_reader->stats.starve_ns_max)
+        {
+            p_reader->stats.starve_ns_max = starve_ns;
+        }
+    }
+
+    if (p_reader->p_slots[p_reader->acquire_idx].len > 0)
+    {
+        p_reader->stats.frame_count++;
+    }
+
+    return &p_reader->p_slots[p_reader->acquire_idx];
+}
+
+void reader_release(reader_t * p_reader)
+{
+    /* Check parameter */
+    assert(p_reader != NULL);
+
+    if (p_reader->p_map != NULL)
+    {
+        /* Move to the next frame of the mapping */
+        p_reader->read_offset += (off_t)p_reader->map_slot.len;
+        return;
+    }
+
+    p_reader->acquire_idx = (p_reader->acquire_idx + 1) % p_reader->depth;
+
+    sem_post(&p_reader->smp_slot_free);
+}
+
+void reader_close(reader_t * p_reader)
+{
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_reader != NULL);
+
+    if (p_reader->started)
+    {
+        /* Wake the prefetch thread up in case all slots are in use */
+        atomic_store(&p_reader->stop, true);
+        sem_post(&p_reader->smp_slot_free);
+
+        pthread_join(p_reader->thread, NULL);
+
+        p_reader->started = false;
+    }
+
+    if (p_reader->p_slots != NULL)
+    {
+        sem_destroy(&p_reader->smp_slot_free);
+        sem_destroy(&p_reader->smp_slot_full);
+
+        for (index = 0; index < p_reader->depth; index++)
+        {
+            free(p_reader->p_slots[index].p_data);
+        }
+
+        free(p_reader->p_slots);
+        p_reader->p_slots = NULL;
+    }
+
+    if (p_reader->p_map != NULL)
+    {
+        /* Keep 'map_len' for 'reader_print_stats' */
+        munmap(p_reader->p_map, p_reader->map_len);
+        p_reader->p_map = NULL;
+    }
+
+    if (p_reader->fd >= 0)
+    {
+        close(p_reader->fd);
+        p_reader->fd = -1;
+    }
+}
+
+void reader_print_stats(reader_t * p_reader)
+{
+    reader_stats_t * p_stats = NULL;
+
+    /* Check parameter */
+    assert(p_reader != NULL);
+
+    p_stats = &p_reader->stats;
+
+    if (p_reader->map_len > 0)
+    {
+        /* Frames were taken from the mapping of input file */
+        printf("Reader: %llu frames, memory-mapped (no copy)\n",
+               (unsigned long long)p_stats->frame_count);
+        return;
+    }
+
+    printf("Reader: %llu frames, prefetch depth %u, read time %.3f ms / "
+           "max %.3f ms\n",
+           (unsigned long long)p_stats->frame_count, p_reader->depth,
+           p_stats->read_ns / 1e6, p_stats->read_ns_max / 1e6);
+
+    printf("Reader: starved %llu times (%.1f%%), starve time %.3f ms / "
+           "max %.3f ms\n",
+           (unsigned long long)p_stats->starve_count,
+           (p_stats->frame_count > 0) ?
+           (100.0 * p_stats->starve_count) / p_stats->frame_count : 0.0,
+           p_stats->starve_ns / 1e6, p_stats->starve_ns_max / 1e6);
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static uint64_t reader_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static reader_slot_t * reader_map_acquire(reader_t * p_reader)
+{
+    reader_slot_t * p_slot = &p_reader->map_slot;
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t ahead = 0;
+
+    p_slot->len    = 0;
+    p_slot->p_data = p_reader->p_map;
+
+    if ((p_reader->read_offset + (off_t)p_reader->frame_size) >
+        p_reader->file_size)
+    {
+        /* No more frame (or the last one is truncated) */
+        return p_slot;
+    }
+
+    p_slot->p_data = p_reader->p_map + p_reader->read_offset;
+    p_slot->len    = p_reader->frame_size;
+
+    p_reader->stats.frame_count++;
+
+    /* Ask the kernel to load the frame which is 'depth' frames ahead, so that
+     * the component does not wait for page faults */
+    ahead = ((size_t)p_reader->read_offset +
+             (p_reader->frame_size * p_reader->depth)) & ~(page_size - 1);
+
+    if (ahead < p_reader->map_len)
+    {
+        madvise(p_reader->p_map + ahead,
+                ROUND_UP(p_reader->frame_size, page_size) + page_size,
+                MADV_WILLNEED);
+    }
+
+    return p_slot;
+}
+
+static size_t reader_read_all(reader_t * p_reader, uint8_t * p_data, size_t len)
+{
+    ssize_t ret = 0;
+    size_t total = 0;
+
+    while (total < len)
+    {
+        ret = read(p_reader->fd, p_data + total, len - total);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            printf("Error: Failed to read input file (errno %d)\n", errno);
+            break;
+        }
+
+        if (ret == 0)
+        {
+            /* End of file */
+            break;
+        }
+
+        total += (size_t)ret;
+    }
+
+    return total;
+}
+
+static void * reader_prefetch_thread(void * p_param)
+{
+    reader_t * p_reader = (reader_t *)p_param;
+    reader_slot_t * p_slot = NULL;
+
+    uint64_t start_ns = 0;
+    uint64_t read_ns = 0;
+    off_t window = (off_t)(p_reader->frame_size * p_reader->depth);
+
+    /* Start of the read in the trace */
+    uint64_t trace_ns = 0;
+
+    trace_name_thread("reader");
+
+    /* Ask the kernel to load the first frames now */
+    posix_fadvise(p_reader->fd, 0, window, POSIX_FADV_WILLNEED);
+
+    while (true)
+    {
+        sem_wait(&p_reader->smp_slot_free);
+
+        if (atomic_load(&p_reader->stop))
+        {
+            break;
+        }
+
+        p_slot = &p_reader->p_slots[p_reader->fill_idx];
+        p_reader->fill_idx = (p_reader->fill_idx + 1) % p_reader->depth;
+
+        trace_ns = trace_now();
+
+        start_ns = reader_now_ns();
+        p_slot->len = reader_read_all(p_reader, p_slot->p_data,
+                                      p_reader->frame_size);
+        read_ns = reader_now_ns() - start_ns;
+
+        trace_record(TRACE_EVENT_READER_READ, trace_ns, p_slot->len, 0);
+
+        p_reader->stats.read_ns += read_ns;
+        if (read_ns > p_reader->stats.read_ns_max)
+        {
+            p_reader->stats.read_ns_max = read_ns;
+        }
+
+        if (p_slot->len != p_reader->frame_size)
+        {
+            /* A truncated frame is dropped and marks the end of input */
+            p_slot->len = 0;
+        }
+
+        p_reader->read_offset += (off_t)p_slot->len;
+
+        /* Keep the next 'depth' frames loading in the background while
+         * the slots are busy */
+        if (p_slot->len > 0)
+        {
+            posix_fadvise(p_reader->fd, p_reader->read_offset + window,
+                          (off_t)p_reader->frame_size, POSIX_FADV_WILLNEED);
+        }
+
+        sem_post(&p_reader->smp_slot_full);
+
+        if (p_slot->len == 0)
+        {
+            /* No more frame to read */
+            break;
+        }
+    }
+
+    return NULL;
+}
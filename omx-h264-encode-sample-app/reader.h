@@ -0,0 +1,171 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: reader.h
+ *
+ * DESCRIPTION:
+ *   Read-ahead input reader.
+ *
+ *   A prefetch thread reads fixed-size frames from the input file into a ring
+ *   of page-aligned slots and keeps up to 'depth' frames ready in advance.
+ *   It also asks the kernel to read the next frames of the file ahead of time
+ *   ('posix_fadvise'), so most reads are served from the page cache.
+ *
+ *   The consumer takes the oldest ready frame with 'reader_acquire' and gives
+ *   its slot back with 'reader_release'. It only waits (is starved) when the
+ *   storage cannot keep up with the component.
+ *
+ *   Instead of starting the prefetch thread, the input file can also be
+ *   mapped into memory with 'reader_map'. Then, 'reader_acquire' returns
+ *   frames directly from the mapping, without any read or copy.
+ *
+ * PUBLIC FUNCTIONS:
+ *   reader_open
+ *   reader_start
+ *   reader_map
+ *   reader_unmap
+ *   reader_acquire
+ *   reader_release
+ *   reader_close
+ *
+ *   reader_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _READER_H_
+#define _READER_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <sys/types.h>
+
+#include "omx.h"
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Start address of the slot (page-aligned) */
+    uint8_t * p_data;
+
+    /* The number of bytes of the frame in the slot.
+     * 0 means there is no more frame in the input file */
+    size_t len;
+
+} reader_slot_t;
+
+typedef struct
+{
+    /* The number of frames returned by 'reader_acquire' */
+    uint64_t frame_count;
+
+    /* The number of times 'reader_acquire' found no ready frame */
+    uint64_t starve_count;
+
+    /* Time (in ns) the consumer waited for the prefetch thread */
+    uint64_t starve_ns;
+    uint64_t starve_ns_max;
+
+    /* Time (in ns) the prefetch thread spent in 'read()' */
+    uint64_t read_ns;
+    uint64_t read_ns_max;
+
+} reader_stats_t;
+
+typedef struct
+{
+    /* File descriptor of input file */
+    int fd;
+
+    /* Size of input file (in bytes) */
+    off_t file_size;
+
+    /* Size of each frame (in bytes) */
+    size_t frame_size;
+
+    /* Offset of the next frame to be read by the prefetch thread */
+    off_t read_offset;
+
+    /* Start address and length of the mapping of input file ('reader_map') */
+    uint8_t * p_map;
+    size_t map_len;
+
+    /* Slot returned by 'reader_acquire' when input file is mapped */
+    reader_slot_t map_slot;
+
+    /* Ring of 'depth' slots */
+    reader_slot_t * p_slots;
+    uint32_t depth;
+
+    /* Index of the next slot to be filled by the prefetch thread */
+    uint32_t fill_idx;
+
+    /* Index of the next slot to be returned by 'reader_acquire' */
+    uint32_t acquire_idx;
+
+    /* Post this semaphore when a slot becomes free */
+    sem_t smp_slot_free;
+
+    /* Post this semaphore when a slot holds a frame */
+    sem_t smp_slot_full;
+
+    /* True if the prefetch thread must exit */
+    atomic_bool stop;
+
+    /* True if the prefetch thread is running */
+    bool started;
+
+    /* Thread which reads frames to the slots */
+    pthread_t thread;
+
+    /* Statistics (only valid after 'reader_close') */
+    reader_stats_t stats;
+
+} reader_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Open 'p_file_name' for 'p_reader'. Frames are 'frame_size' bytes and
+ * up to 'depth' frames are read in advance.
+ * Return true if successful. Otherwise, return false */
+bool reader_open(reader_t * p_reader, const char * p_file_name,
+                 size_t frame_size, uint32_t depth);
+
+/* Allocate the slots and start the prefetch thread of 'p_reader'.
+ * Return true if successful. Otherwise, return false */
+bool reader_start(reader_t * p_reader);
+
+/* Map input file of 'p_reader' into memory (read-only). Use it instead of
+ * 'reader_start' so that frames are not copied to slots.
+ * Return true if successful. Otherwise, return false */
+bool reader_map(reader_t * p_reader);
+
+/* Unmap input file of 'p_reader' (after 'reader_map'). Then, the prefetch
+ * thread can be started with 'reader_start' */
+void reader_unmap(reader_t * p_reader);
+
+/* Get the oldest prefetched frame. Wait if it is not read yet.
+ * Return the slot of the frame. Its 'len' is 0 at the end of input file.
+ *
+ * Note: The slot must be given back with 'reader_release' before
+ *       calling this function again */
+reader_slot_t * reader_acquire(reader_t * p_reader);
+
+/* Give back the slot returned by 'reader_acquire' */
+void reader_release(reader_t * p_reader);
+
+/* Stop the prefetch thread and close input file */
+void reader_close(reader_t * p_reader);
+
+/* Print statistics of 'p_reader' (call it after 'reader_close') */
+void reader_print_stats(reader_t * p_reader);
+
+#endif /* _READER_H_ */
@@ -0,0 +1,305 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: trace.h
+ *
+ * DESCRIPTION:
+ *   Low-overhead tracer of OMX calls, OMX callbacks and application work.
+ *
+ *   Each traced operation is a fixed-size binary record (start time,
+ *   duration, event and two arguments) written to a ring buffer owned by the
+ *   calling thread. Rings are never shared between writers, so recording
+ *   takes no lock. When a ring is full, the oldest records are overwritten.
+ *
+ *   This header replaces the OMX macros 'OMX_SendCommand', 'OMX_GetState',
+ *   'OMX_AllocateBuffer', 'OMX_UseBuffer', 'OMX_FreeBuffer',
+ *   'OMX_EmptyThisBuffer' and 'OMX_FillThisBuffer' of 'OMX_Core.h' with
+ *   wrappers which record each call. It is included by 'omx.h', so every
+ *   file of the application is traced. Callbacks and application work are
+ *   recorded with 'trace_now' and 'trace_record'.
+ *
+ *   Until 'trace_enable' is called, each wrapper only tests a flag (the
+ *   inline functions 'trace_now' and 'trace_record').
+ *
+ *   'trace_write_chrome' exports all records as a Chrome trace-event JSON
+ *   file, which can be opened with 'chrome://tracing' or Perfetto UI
+ *   (https://ui.perfetto.dev). Buffers sent to the MC are also shown as
+ *   asynchronous spans (from 'OMX_EmptyThisBuffer'/'OMX_FillThisBuffer' to
+ *   EmptyBufferDone/FillBufferDone), so that pipeline bubbles are visible.
+ *
+ * PUBLIC FUNCTIONS:
+ *   trace_enable
+ *   trace_clock_ns
+ *   trace_push
+ *   trace_name_thread
+ *   trace_write_chrome
+ *
+ *   trace_now
+ *   trace_record
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The number of records of each ring (power of 2) */
+#define TRACE_RING_SIZE 16384
+
+/* The maximum number of traced threads */
+#define TRACE_MAX_THREADS 64
+
+/* The maximum length of a thread name */
+#define TRACE_NAME_LEN 16
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef enum
+{
+    /* OMX calls (arguments are listed in 'trace.c') */
+    TRACE_EVENT_SEND_COMMAND = 0,
+    TRACE_EVENT_GET_STATE,
+    TRACE_EVENT_ALLOCATE_BUFFER,
+    TRACE_EVENT_USE_BUFFER,
+    TRACE_EVENT_FREE_BUFFER,
+    TRACE_EVENT_EMPTY_THIS_BUFFER,
+    TRACE_EVENT_FILL_THIS_BUFFER,
+
+    /* OMX callbacks */
+    TRACE_EVENT_EVENT_HANDLER,
+    TRACE_EVENT_EMPTY_BUFFER_DONE,
+    TRACE_EVENT_FILL_BUFFER_DONE,
+
+    /* Application work */
+    TRACE_EVENT_SETUP_IN_BUF,
+    TRACE_EVENT_WRITER_COPY,
+    TRACE_EVENT_WRITER_WRITE,
+    TRACE_EVENT_READER_READ,
+
+    TRACE_EVENT_COUNT,
+
+} trace_event_t;
+
+typedef struct
+{
+    /* Start time and duration (in ns) */
+    uint64_t start_ns;
+    uint64_t duration_ns;
+
+    /* Arguments (meaning depends on 'event') */
+    uint64_t arg0;
+    uint32_t arg1;
+
+    /* Event ('trace_event_t') */
+    uint32_t event;
+
+} trace_record_t;
+
+/******************************************************************************
+ *                                 VARIABLES                                  *
+ ******************************************************************************/
+
+/* True once 'trace_enable' has been called */
+extern bool trace_enabled;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Start recording. Call it before the threads to be traced start */
+void trace_enable(void);
+
+/* Return the current time (in ns) of the trace clock */
+uint64_t trace_clock_ns(void);
+
+/* Add a record to the ring of the calling thread. Use 'trace_record' */
+void trace_push(trace_event_t event, uint64_t start_ns,
+                uint64_t arg0, uint32_t arg1);
+
+/* Give a name to the calling thread in the trace */
+void trace_name_thread(const char * p_name);
+
+/* Write all records to 'p_file_name' as Chrome trace-event JSON.
+ * Traced threads should be idle.
+ * Return true if successful. Otherwise, return false */
+bool trace_write_chrome(const char * p_file_name);
+
+/* Return the current time (in ns), or 0 if tracing is disabled */
+static inline uint64_t trace_now(void)
+{
+    return trace_enabled ? trace_clock_ns() : 0;
+}
+
+/* Record 'event' which started at 'start_ns' (returned by 'trace_now') and
+ * ends now. Nothing is recorded if 'start_ns' is 0 */
+static inline void trace_record(trace_event_t event, uint64_t start_ns,
+                                uint64_t arg0, uint32_t arg1)
+{
+    if (start_ns != 0)
+    {
+        trace_push(event, start_ns, arg0, arg1);
+    }
+}
+
+/******************************************************************************
+ *                                OMX WRAPPERS                                *
+ ******************************************************************************/
+
+static inline OMX_ERRORTYPE trace_send_command(OMX_HANDLETYPE handle,
+                                               OMX_COMMANDTYPE cmd,
+                                               OMX_U32 param,
+                                               OMX_PTR p_cmd_data)
+{
+    uint64_t start_ns = trace_now();
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->SendCommand(
+                            handle, cmd, param, p_cmd_data);
+
+    trace_record(TRACE_EVENT_SEND_COMMAND, start_ns, cmd, param);
+
+    return err;
+}
+
+static inline OMX_ERRORTYPE trace_get_state(OMX_HANDLETYPE handle,
+                                            OMX_STATETYPE * p_state)
+{
+    uint64_t start_ns = trace_now();
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->GetState(handle,
+                                                                p_state);
+
+    trace_record(TRACE_EVENT_GET_STATE, start_ns, 0,
+                 (err == OMX_ErrorNone) ? *p_state : 0);
+
+    return err;
+}
+
+static inline OMX_ERRORTYPE trace_allocate_buffer(OMX_HANDLETYPE handle,
+                                                  OMX_BUFFERHEADERTYPE ** pp_buf,
+                                                  OMX_U32 port_idx,
+                                                  OMX_PTR p_app_private,
+                                                  OMX_U32 size)
+{
+    uint64_t start_ns = trace_now();
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->AllocateBuffer(
+                            handle, pp_buf, port_idx, p_app_private, size);
+
+    trace_record(TRACE_EVENT_ALLOCATE_BUFFER, start_ns,
+                 (err == OMX_ErrorNone) ? (uintptr_t)*pp_buf : 0, port_idx);
+
+    return err;
+}
+
+static inline OMX_ERRORTYPE trace_use_buffer(OMX_HANDLETYPE handle,
+                                             OMX_BUFFERHEADERTYPE ** pp_buf,
+                                             OMX_U32 port_idx,
+                                             OMX_PTR p_app_private,
+                                             OMX_U32 size,
+                                             OMX_U8 * p_buffer)
+{
+    uint64_t start_ns = trace_now();
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->UseBuffer(
+                            handle, pp_buf, port_idx, p_app_private,
+                            size, p_buffer);
+
+    trace_record(TRACE_EVENT_USE_BUFFER, start_ns,
+                 (err == OMX_ErrorNone) ? (uintptr_t)*pp_buf : 0, port_idx);
+
+    return err;
+}
+
+static inline OMX_ERRORTYPE trace_free_buffer(OMX_HANDLETYPE handle,
+                                              OMX_U32 port_idx,
+                                              OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t start_ns = trace_now();
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->FreeBuffer(
+                            handle, port_idx, p_buf);
+
+    trace_record(TRACE_EVENT_FREE_BUFFER, start_ns, (uintptr_t)p_buf,
+                 port_idx);
+
+    return err;
+}
+
+static inline OMX_ERRORTYPE trace_empty_this_buffer(OMX_HANDLETYPE handle,
+                                                    OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t start_ns = trace_now();
+
+    /* The MC may return the buffer before this call returns, so its length
+     * is read first */
+    OMX_U32 len = p_buf->nFilledLen;
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->EmptyThisBuffer(
+                            handle, p_buf);
+
+    trace_record(TRACE_EVENT_EMPTY_THIS_BUFFER, start_ns, (uintptr_t)p_buf,
+                 len);
+
+    return err;
+}
+
+static inline OMX_ERRORTYPE trace_fill_this_buffer(OMX_HANDLETYPE handle,
+                                                   OMX_BUFFERHEADERTYPE * p_buf)
+{
+    uint64_t start_ns = trace_now();
+
+    OMX_ERRORTYPE err = ((OMX_COMPONENTTYPE *)handle)->FillThisBuffer(
+                            handle, p_buf);
+
+    trace_record(TRACE_EVENT_FILL_THIS_BUFFER, start_ns, (uintptr_t)p_buf, 0);
+
+    return err;
+}
+
+#undef  OMX_SendCommand
+#define OMX_SendCommand(hComponent, Cmd, nParam, pCmdData)                    \
+        trace_send_command(hComponent, Cmd, nParam, pCmdData)
+
+#undef  OMX_GetState
+#define OMX_GetState(hComponent, pState)                                      \
+        trace_get_state(hComponent, pState)
+
+#undef  OMX_AllocateBuffer
+#define OMX_AllocateBuffer(hComponent, ppBuffer, nPortIndex, pAppPrivate,     \
+                           nSizeBytes)                                        \
+        trace_allocate_buffer(hComponent, ppBuffer, nPortIndex, pAppPrivate,  \
+                              nSizeBytes)
+
+#undef  OMX_UseBuffer
+#define OMX_UseBuffer(hComponent, ppBufferHdr, nPortIndex, pAppPrivate,       \
+                      nSizeBytes, pBuffer)                                    \
+        trace_use_buffer(hComponent, ppBufferHdr, nPortIndex, pAppPrivate,    \
+                         nSizeBytes, pBuffer)
+
+#undef  OMX_FreeBuffer
+#define OMX_FreeBuffer(hComponent, nPortIndex, pBuffer)                       \
+        trace_free_buffer(hComponent, nPortIndex, pBuffer)
+
+#undef  OMX_EmptyThisBuffer
+#define OMX_EmptyThisBuffer(hComponent, pBuffer)                              \
+        trace_empty_this_buffer(hComponent, pBuffer)
+
+#undef  OMX_FillThisBuffer
+#define OMX_FillThisBuffer(hComponent, pBuffer)                               \
+        trace_fill_this_buffer(hComponent, pBuffer)
+
+#endif /* _TRACE_H_ */
@@ -0,0 +1,347 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: tuner.c
+ *
+ * DESCRIPTION:
+ *   Tuner of the buffer counts of input and output ports definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'tuner.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include "tuner.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Run the configuration 'p_profile' 'TUNER_REPEAT' times and add the fastest
+ * run to the results. Its index is stored to 'p_index'.
+ * Return true if successful. Otherwise, return false */
+static bool tuner_measure(tuner_t * p_tuner, const tuner_profile_t * p_profile,
+                          tuner_run_fn run_fn, void * p_run_ctx,
+                          uint32_t * p_index);
+
+/* Sweep '*p_count' (a field of 'p_profile') from 'min' to 'max'. The result
+ * of 'min' is 'first_index' if it has already been measured (otherwise,
+ * 'TUNER_MAX_RESULTS'). The chosen count is stored to '*p_count' and the
+ * index of its result to 'p_best_index'.
+ * Return true if successful. Otherwise, return false */
+static bool tuner_sweep_port(tuner_t * p_tuner, tuner_profile_t * p_profile,
+                             uint32_t * p_count, uint32_t min, uint32_t max,
+                             uint32_t first_index,
+                             tuner_run_fn run_fn, void * p_run_ctx,
+                             uint32_t * p_best_index);
+
+/* Write 'p_result' (buffer counts and measurements) to 'p_file' */
+static void tuner_write_result(FILE * p_file, const char * p_prefix,
+                               const tuner_result_t * p_result);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool tuner_sweep(tuner_t * p_tuner, const tuner_profile_t * p_min,
+                 const tuner_profile_t * p_max,
+                 tuner_run_fn run_fn, void * p_run_ctx)
+{
+    tuner_profile_t profile;
+    uint32_t out_index = 0;
+
+    /* Check parameters */
+    assert((p_tuner != NULL) && (run_fn != NULL));
+    assert((p_min != NULL) && (p_max != NULL));
+
+    memset(p_tuner, 0, sizeof(tuner_t));
+
+    if ((p_min->in_buf_cnt > p_max->in_buf_cnt) ||
+        (p_min->out_buf_cnt > p_max->out_buf_cnt))
+    {
+        printf("Error: Minimum buffer counts exceed maximum buffer counts\n");
+        return false;
+    }
+
+    profile = *p_min;
+
+    /* Step 1: output port (input port at its minimum) */
+    if (tuner_sweep_port(p_tuner, &profile, &profile.out_buf_cnt,
+                         p_min->out_buf_cnt, p_max->out_buf_cnt,
+                         TUNER_MAX_RESULTS, run_fn, p_run_ctx,
+                         &out_index) == false)
+    {
+        return false;
+    }
+
+    /* Step 2: input port (output port at its chosen count). The minimum
+     * input count has just been measured with this output count */
+    return tuner_sweep_port(p_tuner, &profile, &profile.in_buf_cnt,
+                            p_min->in_buf_cnt, p_max->in_buf_cnt,
+                            out_index, run_fn, p_run_ctx,
+                            &p_tuner->best_index);
+}
+
+void tuner_print_report(const tuner_t * p_tuner)
+{
+    const tuner_result_t * p_best = NULL;
+
+    /* Check parameter */
+    assert(p_tuner != NULL);
+
+    if (p_tuner->result_count == 0)
+    {
+        return;
+    }
+
+    /* Each configuration has been printed when it was measured */
+    p_best = &p_tuner->results[p_tuner->best_index];
+
+    printf("Tuner: %u configurations measured, recommended %u input buffers "
+           "and %u output buffers\n", p_tuner->result_count,
+           p_best->profile.in_buf_cnt, p_best->profile.out_buf_cnt);
+
+    tuner_write_result(stdout, "Tuner: * ", p_best);
+}
+
+bool tuner_save_profile(const tuner_t * p_tuner, const char * p_file_name,
+                        const char * p_app_name)
+{
+    FILE * p_file = NULL;
+    const tuner_result_t * p_best = NULL;
+
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert((p_tuner != NULL) && (p_file_name != NULL));
+    assert(p_app_name != NULL);
+
+    if (p_tuner->result_count == 0)
+    {
+        printf("Error: No configuration has been measured\n");
+        return false;
+    }
+
+    p_file = fopen(p_file_name, "w");
+    if (p_file == NULL)
+    {
+        printf("Error: Failed to open file '%s'\n", p_file_name);
+        return false;
+    }
+
+    p_best = &p_tuner->results[p_tuner->best_index];
+
+    fprintf(p_file, "# Buffer profile of '%s' (chosen: '*')\n", p_app_name);
+
+    for (index = 0; index < p_tuner->result_count; index++)
+    {
+        tuner_write_result(p_file, (index == p_tuner->best_index) ?
+                                   "# * " : "#   ",
+                           &p_tuner->results[index]);
+    }
+
+    fprintf(p_file, "in_buffer_count = %u\n", p_best->profile.in_buf_cnt);
+    fprintf(p_file, "out_buffer_count = %u\n", p_best->profile.out_buf_cnt);
+
+    fclose(p_file);
+
+    return true;
+}
+
+bool tuner_load_profile(const char * p_file_name, tuner_profile_t * p_profile)
+{
+    FILE * p_file = NULL;
+
+    char line[128];
+    char key[32];
+    unsigned int value = 0;
+
+    /* True once each count has been read */
+    bool has_in  = false;
+    bool has_out = false;
+
+    bool is_success = true;
+
+    /* Check parameters */
+    assert((p_file_name != NULL) && (p_profile != NULL));
+
+    p_file = fopen(p_file_name, "r");
+    if (p_file == NULL)
+    {
+        printf("Error: Failed to open '%s'\n", p_file_name);
+        return false;
+    }
+
+    while (is_success && (fgets(line, sizeof(line), p_file) != NULL))
+    {
+        /* The width matches 'key' */
+        if (sscanf(line, " %31[^ =#\n] = %u", key, &value) != 2)
+        {
+            if ((sscanf(line, " %31s", key) == 1) && (key[0] != '#'))
+            {
+                printf("Error: Invalid line in '%s': %s", p_file_name, line);
+                is_success = false;
+            }
+
+            /* Otherwise, empty line or comment */
+            continue;
+        }
+
+        if (strcmp(key, "in_buffer_count") == 0)
+        {
+            p_profile->in_buf_cnt = value;
+            has_in = true;
+        }
+        else if (strcmp(key, "out_buffer_count") == 0)
+        {
+            p_profile->out_buf_cnt = value;
+            has_out = true;
+        }
+        else
+        {
+            printf("Error: Unknown key '%s' in '%s'\n", key, p_file_name);
+            is_success = false;
+        }
+    }
+
+    fclose(p_file);
+
+    if (is_success && !(has_in && has_out))
+    {
+        printf("Error: '%s' must set 'in_buffer_count' and "
+               "'out_buffer_count'\n", p_file_name);
+        is_success = false;
+    }
+
+    return is_success;
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static bool tuner_measure(tuner_t * p_tuner, const tuner_profile_t * p_profile,
+                          tuner_run_fn run_fn, void * p_run_ctx,
+                          uint32_t * p_index)
+{
+    tuner_result_t result;
+    tuner_result_t * p_best = NULL;
+
+    uint32_t repeat = 0;
+
+    if (p_tuner->result_count == TUNER_MAX_RESULTS)
+    {
+        printf("Error: Too many configurations (max: %d)\n",
+               TUNER_MAX_RESULTS);
+        return false;
+    }
+
+    p_best = &p_tuner->results[p_tuner->result_count];
+
+    for (repeat = 0; repeat < TUNER_REPEAT; repeat++)
+    {
+        memset(&result, 0, sizeof(result));
+
+        if (run_fn(p_profile, &result, p_run_ctx) == false)
+        {
+            printf("Error: Run with %u input buffers and %u output buffers "
+                   "failed\n", p_profile->in_buf_cnt, p_profile->out_buf_cnt);
+            return false;
+        }
+
+        if ((repeat == 0) || (result.fps > p_best->fps))
+        {
+            *p_best = result;
+        }
+    }
+
+    p_best->profile = *p_profile;
+
+    tuner_write_result(stdout, "Tuner: ", p_best);
+
+    *p_index = p_tuner->result_count;
+    p_tuner->result_count++;
+
+    return true;
+}
+
+static bool tuner_sweep_port(tuner_t * p_tuner, tuner_profile_t * p_profile,
+                             uint32_t * p_count, uint32_t min, uint32_t max,
+                             uint32_t first_index,
+                             tuner_run_fn run_fn, void * p_run_ctx,
+                             uint32_t * p_best_index)
+{
+    /* Results of the sweep (index 'i' is count 'min + i') */
+    uint32_t indices[TUNER_MAX_RESULTS];
+    uint32_t count = 0;
+
+    /* Best frame rate and the count which last raised it significantly */
+    double best_fps    = 0;
+    uint32_t gain_count = min;
+
+    double fps = 0;
+
+    for (*p_count = min; *p_count <= max; (*p_count)++)
+    {
+        count = *p_count - min;
+
+        if ((*p_count == min) && (first_index < TUNER_MAX_RESULTS))
+        {
+            indices[count] = first_index;
+        }
+        else if (tuner_measure(p_tuner, p_profile, run_fn, p_run_ctx,
+                               &indices[count]) == false)
+        {
+            return false;
+        }
+
+        fps = p_tuner->results[indices[count]].fps;
+
+        if (fps > (best_fps * (1.0 + TUNER_FPS_TOLERANCE)))
+        {
+            gain_count = *p_count;
+        }
+
+        if (fps > best_fps)
+        {
+            best_fps = fps;
+        }
+
+        /* More buffers have not helped for two counts */
+        if (*p_count >= (gain_count + 2))
+        {
+            break;
+        }
+    }
+
+    /* The smallest count close enough to the best frame rate ('min + count'
+     * is the last count measured) */
+    for (*p_count = min; *p_count <= (min + count); (*p_count)++)
+    {
+        *p_best_index = indices[*p_count - min];
+
+        if (p_tuner->results[*p_best_index].fps >=
+            (best_fps * (1.0 - TUNER_FPS_TOLERANCE)))
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+static void tuner_write_result(FILE * p_file, const char * p_prefix,
+                               const tuner_result_t * p_result)
+{
+    fprintf(p_file, "%sin %2u, out %2u: %8.2f fps, p99 %8.3f ms, %8llu KiB\n",
+            p_prefix, p_result->profile.in_buf_cnt,
+            p_result->profile.out_buf_cnt, p_result->fps, p_result->p99_ms,
+            (unsigned long long)(p_result->mem_bytes / 1024));
+}
@@ -0,0 +1,184 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: writer.h
+ *
+ * DESCRIPTION:
+ *   Asynchronous output writer.
+ *
+ *   FillBufferDone hands filled buffers to the writer with 'writer_push'.
+ *   The copy thread of the writer copies their payload to page-aligned
+ *   staging buffers and returns each buffer to the application (through
+ *   'writer_release_fn') as soon as its data is copied.
+ *
+ *   When a staging buffer is full, it is passed to the I/O thread which writes
+ *   it to the output file with a single 'write()' call. So, a slow storage
+ *   only blocks the I/O thread until all staging buffers are in use.
+ *
+ * PUBLIC FUNCTIONS:
+ *   writer_open
+ *   writer_start
+ *   writer_push
+ *   writer_close
+ *
+ *   writer_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _WRITER_H_
+#define _WRITER_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "omx.h"
+#include "queue.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The number of staging buffers. While the I/O thread writes one of them,
+ * the copy thread fills the others */
+#define WRITER_STAGE_COUNT 2
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+/* Called by the copy thread when the data of 'p_buf' is no longer needed.
+ * Usually, it sends 'p_buf' back to output port with 'OMX_FillThisBuffer' */
+typedef void (*writer_release_fn)(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf);
+
+typedef struct
+{
+    /* Start address of the staging buffer (page-aligned) */
+    uint8_t * p_data;
+
+    /* The number of bytes stored in the staging buffer */
+    size_t len;
+
+} writer_stage_t;
+
+typedef struct
+{
+    /* Statistics of the copy thread */
+
+    /* The number of buffers received from 'writer_push' */
+    uint64_t buf_count;
+
+    /* Sum and maximum of queue depth seen when the copy thread pops a buffer */
+    uint64_t queue_depth_sum;
+    uint32_t queue_depth_max;
+
+    /* Time (in ns) the copy thread waited for a free staging buffer.
+     * It is the time the storage actually held output buffers back */
+    uint64_t stall_ns;
+    uint64_t stall_ns_max;
+
+    /* Statistics of the I/O thread */
+
+    /* The number of 'write()' calls and bytes written to output file */
+    uint64_t write_count;
+    uint64_t write_bytes;
+
+    /* Time (in ns) spent in 'write()' */
+    uint64_t write_ns;
+    uint64_t write_ns_max;
+
+} writer_stats_t;
+
+typedef struct
+{
+    /* File descriptor of output file */
+    int fd;
+
+    /* True if output file is opened with 'O_DIRECT' */
+    bool direct_io;
+
+    /* Size of each staging buffer (multiple of the page size) */
+    size_t stage_size;
+
+    /* Staging buffers */
+    writer_stage_t stages[WRITER_STAGE_COUNT];
+
+    /* Index of the staging buffer being filled by the copy thread */
+    uint32_t fill_idx;
+
+    /* True if the copy thread owns staging buffer 'fill_idx' */
+    bool fill_busy;
+
+    /* Index of the next staging buffer to be written by the I/O thread */
+    uint32_t write_idx;
+
+    /* Post this semaphore when a staging buffer becomes free */
+    sem_t smp_stage_free;
+
+    /* Post this semaphore when a staging buffer is ready to be written */
+    sem_t smp_stage_full;
+
+    /* Buffers pushed by FillBufferDone and waiting to be copied */
+    queue_t buf_queue;
+
+    /* Post this semaphore whenever a buffer is added to 'buf_queue' */
+    sem_t smp_buf;
+
+    /* True if the threads must exit after 'buf_queue' is drained */
+    atomic_bool stop;
+
+    /* Thread which copies buffers to staging buffers */
+    pthread_t copy_thread;
+
+    /* Thread which writes staging buffers to output file */
+    pthread_t io_thread;
+
+    /* Function (and its context) used to return buffers to the application */
+    writer_release_fn release_fn;
+    void * p_release_ctx;
+
+    /* True if writing output file failed. The following staging buffers
+     * are not written (the file is incomplete anyway) */
+    bool write_failed;
+
+    /* Statistics (only valid after 'writer_close') */
+    writer_stats_t stats;
+
+} writer_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Open (create or truncate) 'p_file_name' for 'p_writer' and allocate
+ * its staging buffers ('stage_size' bytes each).
+ *
+ * 'buf_count' is the maximum number of buffers pushed but not yet released.
+ * If 'direct_io' is true, the function tries to bypass the page cache with
+ * 'O_DIRECT' (it falls back to buffered I/O if the file system refuses).
+ *
+ * Return true if successful. Otherwise, return false */
+bool writer_open(writer_t * p_writer, const char * p_file_name,
+                 uint32_t buf_count, size_t stage_size, bool direct_io);
+
+/* Start the threads of 'p_writer'. Buffers will be returned by calling
+ * 'release_fn(p_release_ctx, buffer)'.
+ * Return true if successful. Otherwise, return false */
+bool writer_start(writer_t * p_writer,
+                  writer_release_fn release_fn, void * p_release_ctx);
+
+/* Hand 'p_buf' to 'p_writer'. The function never blocks, so it can be
+ * called from FillBufferDone */
+void writer_push(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Write all pending data, stop the threads and close output file.
+ * Return true if all data was written to output file. Otherwise, return
+ * false */
+bool writer_close(writer_t * p_writer);
+
+/* Print statistics of 'p_writer' (call it after 'writer_close') */
+void writer_print_stats(writer_t * p_writer);
+
+#endif /* _WRITER_H_ */
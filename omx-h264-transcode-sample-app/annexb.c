@@ -0,0 +1,309 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: annexb.c
+ *
+ * DESCRIPTION:
+ *   H.264 Annex-B byte stream parser definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'annexb.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "annexb.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Check if the NAL unit whose header is at 'hdr' starts a new AU.
+ * 'has_vcl' is true if the current AU already contains a slice */
+static bool annexb_is_au_start(const annexb_t * p_annexb,
+                               size_t hdr, bool has_vcl);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool annexb_open(annexb_t * p_annexb, const char * p_file_name)
+{
+    struct stat file_stat;
+    void * p_map = NULL;
+
+    /* Check parameters */
+    assert((p_annexb != NULL) && (p_file_name != NULL));
+
+    memset(p_annexb, 0, sizeof(annexb_t));
+
+    p_annexb->fd = open(p_file_name, O_RDONLY);
+    if (p_annexb->fd < 0)
+    {
+        printf("Error: Failed to open '%s'\n", p_file_name);
+        return false;
+    }
+
+    if ((fstat(p_annexb->fd, &file_stat) != 0) || (file_stat.st_size == 0))
+    {
+        printf("Error: '%s' is empty\n", p_file_name);
+        annexb_close(p_annexb);
+        return false;
+    }
+
+    p_map = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE,
+                 p_annexb->fd, 0);
+    if (p_map == MAP_FAILED)
+    {
+        printf("Error: Failed to map '%s' into memory\n", p_file_name);
+        annexb_close(p_annexb);
+        return false;
+    }
+
+    p_annexb->p_data = (const uint8_t *)p_map;
+    p_annexb->len    = (size_t)file_stat.st_size;
+
+    /* The stream is parsed once from start to end */
+    madvise(p_map, p_annexb->len, MADV_SEQUENTIAL);
+
+    return true;
+}
+
+bool annexb_next_au(annexb_t * p_annexb, const uint8_t ** pp_au, size_t * p_len)
+{
+    const uint8_t * p_data = NULL;
+
+    size_t au_start = 0;
+    size_t au_end = 0;
+    size_t start_code = 0;
+    size_t hdr = 0;
+    uint8_t nal_type = 0;
+    bool has_vcl = false;
+
+    /* Check parameters */
+    assert((p_annexb != NULL) && (pp_au != NULL) && (p_len != NULL));
+
+    p_data   = p_annexb->p_data;
+    au_start = p_annexb->pos;
+    au_end   = p_annexb->len;
+
+    start_code = annexb_find_start_code(p_data, p_annexb->len, au_start);
+
+    if (start_code == p_annexb->len)
+    {
+        /* No more NAL unit */
+        p_annexb->pos = p_annexb->len;
+        return false;
+    }
+
+    while (start_code < p_annexb->len)
+    {
+        hdr = start_code + 3;
+        if (hdr >= p_annexb->len)
+        {
+            break;
+        }
+
+        if (annexb_is_au_start(p_annexb, hdr, has_vcl))
+        {
+            /* Zero bytes before the start code are the 'zero_byte' of
+             * a 4-byte start code, so they go to the next AU */
+            au_end = start_code;
+            while ((au_end > au_start) && (p_data[au_end - 1] == 0))
+            {
+                au_end--;
+            }
+
+            break;
+        }
+
+        p_annexb->nal_count++;
+
+        nal_type = p_data[hdr] & 0x1F;
+        if ((nal_type == ANNEXB_NAL_SLICE) || (nal_type == ANNEXB_NAL_IDR_SLICE))
+        {
+            has_vcl = true;
+        }
+
+        start_code = annexb_find_start_code(p_data, p_annexb->len, hdr);
+    }
+
+    p_annexb->pos = au_end;
+
+    *pp_au = p_data + au_start;
+    *p_len = au_end - au_start;
+
+    p_annexb->au_count++;
+    if (*p_len > p_annexb->au_size_max)
+    {
+        p_annexb->au_size_max = *p_len;
+    }
+
+    return true;
+}
+
+void annexb_close(annexb_t * p_annexb)
+{
+    /* Check parameter */
+    assert(p_annexb != NULL);
+
+    if (p_annexb->p_data != NULL)
+    {
+        munmap((void *)p_annexb->p_data, p_annexb->len);
+        p_annexb->p_data = NULL;
+    }
+
+    if (p_annexb->fd >= 0)
+    {
+        close(p_annexb->fd);
+        p_annexb->fd = -1;
+    }
+}
+
+size_t annexb_find_start_code(const uint8_t * p_data, size_t len, size_t pos)
+{
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i bytes0;
+    __m128i bytes1;
+    uint32_t mask = 0;
+    uint32_t bit = 0;
+
+    /* Find pairs of zero bytes 16 positions at a time. The 3rd byte of each
+     * pair is only checked for the (rare) candidates */
+    while ((pos + 18) <= len)
+    {
+        bytes0 = _mm_loadu_si128((const __m128i *)(p_data + pos));
+        bytes1 = _mm_loadu_si128((const __m128i *)(p_data + pos + 1));
+
+        mask = (uint32_t)_mm_movemask_epi8(
+                   _mm_and_si128(_mm_cmpeq_epi8(bytes0, zero),
+                                 _mm_cmpeq_epi8(bytes1, zero)));
+
+        while (mask != 0)
+        {
+            bit = (uint32_t)__builtin_ctz(mask);
+            if (p_data[pos + bit + 2] == 1)
+            {
+                return pos + bit;
+            }
+
+            mask &= mask - 1;
+        }
+
+        pos += 16;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const uint8x16_t zero = vdupq_n_u8(0);
+
+    uint8x16_t pairs;
+    uint32_t index = 0;
+
+    /* Find pairs of zero bytes 16 positions at a time. The block is only
+     * scanned byte by byte when it contains a candidate */
+    while ((pos + 18) <= len)
+    {
+        pairs = vandq_u8(vceqq_u8(vld1q_u8(p_data + pos), zero),
+                         vceqq_u8(vld1q_u8(p_data + pos + 1), zero));
+
+        if (vmaxvq_u8(pairs) != 0)
+        {
+            for (index = 0; index < 16; index++)
+            {
+                if ((p_data[pos + index] == 0) &&
+                    (p_data[pos + index + 1] == 0) &&
+                    (p_data[pos + index + 2] == 1))
+                {
+                    return pos + index;
+                }
+            }
+        }
+
+        pos += 16;
+    }
+#endif
+
+    /* Scalar search (the last bytes, or the whole buffer without SIMD) */
+    while ((pos + 3) <= len)
+    {
+        if (p_data[pos + 2] > 1)
+        {
+            /* None of the 3 bytes can start a start code at 'pos' */
+            pos += 3;
+        }
+        else if ((p_data[pos] == 0) && (p_data[pos + 1] == 0) &&
+                 (p_data[pos + 2] == 1))
+        {
+            return pos;
+        }
+        else
+        {
+            pos++;
+        }
+    }
+
+    return len;
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static bool annexb_is_au_start(const annexb_t * p_annexb,
+                               size_t hdr, bool has_vcl)
+{
+    uint8_t nal_type = p_annexb->p_data[hdr] & 0x1F;
+
+    if (!has_vcl)
+    {
+        /* NAL units before the first slice belong to the current AU */
+        return false;
+    }
+
+    switch (nal_type)
+    {
+        case ANNEXB_NAL_SEI:
+        case ANNEXB_NAL_SPS:
+        case ANNEXB_NAL_PPS:
+        case ANNEXB_NAL_AUD:
+        case 14:
+        case 15:
+        case 16:
+        case 17:
+        case 18:
+        {
+            return true;
+        }
+
+        case ANNEXB_NAL_SLICE:
+        case ANNEXB_NAL_IDR_SLICE:
+        {
+            /* 'first_mb_in_slice' is ue(v) coded. Its value is 0 if and only
+             * if the first bit of the slice header is 1 */
+            return ((hdr + 1) < p_annexb->len) &&
+                   ((p_annexb->p_data[hdr + 1] & 0x80) != 0);
+        }
+
+        default:
+        {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,1015 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "omx.h"
+#include "queue.h"
+#include "annexb.h"
+#include "relay.h"
+#include "writer.h"
+
+/******************************************************************************
+ *                                   MACROS                                   *
+ ******************************************************************************/
+
+/* Input file which contains H.264 frames */
+#define IN_FILE_NAME "in-h264-640x480.264"
+
+/* Output file which contains re-encoded H.264 frames */
+#define OUT_FILE_NAME "out-h264-640x480.264"
+
+/* The number of buffers for input port of the decoder */
+#define DEC_IN_BUFFER_COUNT 2
+
+/* The number of buffers for output port of the decoder. They are also the
+ * buffers of input port of the encoder (decoded frames are never copied) */
+#define DEC_OUT_BUFFER_COUNT 4
+
+/* The number of buffers for output port of the encoder */
+#define ENC_OUT_BUFFER_COUNT 2
+
+/* Framerate (FPS) and bitrate of output file. For example, re-encode
+ * with a lower bitrate to reduce the size of a video before uploading it */
+#define FRAMERATE 30
+
+#define H264_BITRATE 2000000 /* 2 Mbit/s */
+
+/* Size of each staging buffer of the output writer */
+#define OUT_STAGE_SIZE (1024 * 1024)
+
+/* Set to 'true' to write output file with 'O_DIRECT' (bypass page cache) */
+#define OUT_DIRECT_IO false
+
+/* Maximum time (in ms) to wait for a MC to complete a state transition */
+#define STATE_TIMEOUT_MS 3000
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+/* This structure is shared between OMX's callbacks of both MCs */
+typedef struct
+{
+    /* Handles of the decoder and the encoder */
+    OMX_HANDLETYPE dec_handle;
+    OMX_HANDLETYPE enc_handle;
+
+    /* States of the MCs (updated by the event handlers) */
+    omx_state_t dec_state;
+    omx_state_t enc_state;
+
+    /* End-of-Stream flags of the decoder and the encoder */
+    bool dec_eos;
+    bool enc_eos;
+
+    /* Lock this semaphore in main() until the encoder outputs End-of-Stream
+     * (or the transcoding fails) */
+    sem_t smp_eos;
+
+    /* True if the transcoding failed: an access unit did not fit in an
+     * input buffer, the decoder changed output port settings again
+     * (resolution change) after the relay was set up, or output file could
+     * not be written */
+    atomic_bool is_failed;
+
+    /* True if output port of the decoder has been completely disabled */
+    bool port_disabled;
+
+    /* Lock these semaphores in main() until output port of the decoder
+     * changes settings, is completely disabled or is completely enabled */
+    sem_t smp_port_settings_changed;
+    sem_t smp_port_disabled;
+    sem_t smp_port_enabled;
+
+    /* Parser which splits input file into H.264 access units */
+    annexb_t annexb;
+
+    /* Input buffers of the decoder returned by EmptyBufferDone */
+    queue_t in_buf_queue;
+
+    /* Post this semaphore whenever a buffer is added to 'in_buf_queue' */
+    sem_t smp_in_buf;
+
+    /* True if 'feeder_thread' must exit */
+    atomic_bool feeder_stop;
+
+    /* Thread which refills input buffers and sends them to the decoder */
+    pthread_t feeder_thread;
+
+    /* Relay which hands decoded frames to the encoder */
+    relay_t relay;
+
+    /* True if 'relay' is running */
+    bool relay_started;
+
+    /* Writer which writes H.264 frames of the encoder to output file */
+    writer_t writer;
+
+    /* True once main() closes the writer (after a failure, the encoder may
+     * still return frames). Lock 'writer_mutex' to access it */
+    bool writer_closed;
+    pthread_mutex_t writer_mutex;
+
+} omx_data_t;
+
+/******************************************************************************
+ *                               OMX CALLBACKS                                *
+ ******************************************************************************/
+
+/* Event handlers of the decoder and the encoder.
+ *
+ * Events are defined in the 'OMX_EVENTTYPE' enumeration.
+ * Callbacks should not return an error to the MC, so if an error occurs,
+ * the application shall handle it internally.
+ *
+ * Note: These are blocking calls */
+OMX_ERRORTYPE dec_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                OMX_EVENTTYPE eEvent, OMX_U32 nData1,
+                                OMX_U32 nData2, OMX_PTR pEventData);
+
+OMX_ERRORTYPE enc_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                OMX_EVENTTYPE eEvent, OMX_U32 nData1,
+                                OMX_U32 nData2, OMX_PTR pEventData);
+
+/* EmptyBufferDone of the decoder returns H.264 input buffers (refilled by
+ * the feeder thread). EmptyBufferDone of the encoder returns decoded frames
+ * (handed back to the decoder by the relay).
+ *
+ * These are blocking calls, so buffers are queued and handled in another
+ * thread */
+OMX_ERRORTYPE dec_empty_buffer_done(OMX_HANDLETYPE hComponent,
+                                    OMX_PTR pAppData,
+                                    OMX_BUFFERHEADERTYPE * pBuffer);
+
+OMX_ERRORTYPE enc_empty_buffer_done(OMX_HANDLETYPE hComponent,
+                                    OMX_PTR pAppData,
+                                    OMX_BUFFERHEADERTYPE * pBuffer);
+
+/* FillBufferDone of the decoder returns decoded frames (handed to the encoder
+ * by the relay). FillBufferDone of the encoder returns H.264 frames (written
+ * to output file by the writer).
+ *
+ * These are blocking calls, so buffers are queued and handled in another
+ * thread */
+OMX_ERRORTYPE dec_fill_buffer_done(OMX_HANDLETYPE hComponent,
+                                   OMX_PTR pAppData,
+                                   OMX_BUFFERHEADERTYPE * pBuffer);
+
+OMX_ERRORTYPE enc_fill_buffer_done(OMX_HANDLETYPE hComponent,
+                                   OMX_PTR pAppData,
+                                   OMX_BUFFERHEADERTYPE * pBuffer);
+
+/******************************************************************************
+ *                                 FUNCTIONS                                  *
+ ******************************************************************************/
+
+/* Fill data to input buffer of the decoder (if possible). Then, set its
+ * nFilledLen and nFlags. If the data does not fit in the buffer,
+ * '*p_is_failed' is set to true and the buffer becomes the End-of-Stream
+ * buffer. Return nFlags of the input buffer */
+OMX_U32 setup_in_buf(annexb_t * p_annexb, OMX_BUFFERHEADERTYPE * p_in_buf,
+                     bool * p_is_failed);
+
+/* Called by the writer when the data of output buffer 'p_buf' of the encoder
+ * has been copied. Send 'p_buf' back to the encoder when End-of-Stream event
+ * does not occur */
+void release_out_buf(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf);
+
+/* Configure input port of the encoder with the frame size and layout of
+ * output port of the decoder, so that both ports can share buffers.
+ * Return true if successful. Otherwise, return false */
+bool setup_enc_in_port(OMX_HANDLETYPE enc_handle,
+                       const OMX_PARAM_PORTDEFINITIONTYPE * p_dec_out_port);
+
+/* Create buffer headers for input port of the encoder which use the memory
+ * of the 'count' decoder's output buffers 'pp_dec_bufs'.
+ * Return non-NULL value if successful. Otherwise, return NULL */
+OMX_BUFFERHEADERTYPE ** use_dec_out_bufs(OMX_HANDLETYPE enc_handle,
+                                         OMX_BUFFERHEADERTYPE ** pp_dec_bufs,
+                                         uint32_t count);
+
+/* Thread function which takes buffers from 'in_buf_queue', refills them
+ * with 'setup_in_buf' and sends them back to the decoder.
+ *
+ * It exits after the End-of-Stream buffer has been sent to the decoder or
+ * when 'feeder_stop' is set */
+void * feeder_thread_func(void * p_param);
+
+/******************************************************************************
+ *                               MAIN FUNCTION                                *
+ ******************************************************************************/
+
+int main()
+{
+    /* Callbacks used by the decoder and the encoder */
+    OMX_CALLBACKTYPE dec_callbacks =
+    {
+        .EventHandler    = dec_event_handler,
+        .EmptyBufferDone = dec_empty_buffer_done,
+        .FillBufferDone  = dec_fill_buffer_done
+    };
+
+    OMX_CALLBACKTYPE enc_callbacks =
+    {
+        .EventHandler    = enc_event_handler,
+        .EmptyBufferDone = enc_empty_buffer_done,
+        .FillBufferDone  = enc_fill_buffer_done
+    };
+
+    /* Buffers of the decoder */
+    OMX_BUFFERHEADERTYPE ** pp_dec_in_bufs  = NULL;
+    OMX_BUFFERHEADERTYPE ** pp_dec_out_bufs = NULL;
+
+    /* Buffers of the encoder ('pp_enc_in_bufs' use 'pp_dec_out_bufs') */
+    OMX_BUFFERHEADERTYPE ** pp_enc_in_bufs  = NULL;
+    OMX_BUFFERHEADERTYPE ** pp_enc_out_bufs = NULL;
+
+    /* Definition of output port of the decoder (after its settings changed) */
+    OMX_PARAM_PORTDEFINITIONTYPE dec_out_port;
+
+    /* Iterator */
+    int index = 0;
+
+    /* Shared data between OMX's callbacks */
+    omx_data_t omx_data;
+
+    /* Time (in ns) taken to transcode the whole input file */
+    uint64_t start_ns = 0;
+    uint64_t total_ns = 0;
+
+    memset(&omx_data, 0, sizeof(omx_data_t));
+
+    atomic_init(&omx_data.feeder_stop, false);
+    atomic_init(&omx_data.is_failed, false);
+
+    omx_state_init(&omx_data.dec_state);
+    omx_state_init(&omx_data.enc_state);
+
+    /* Prepare the semaphores */
+    sem_init(&omx_data.smp_eos, 0, 0);
+    sem_init(&omx_data.smp_port_settings_changed, 0, 0);
+    sem_init(&omx_data.smp_port_disabled, 0, 0);
+    sem_init(&omx_data.smp_port_enabled, 0, 0);
+    sem_init(&omx_data.smp_in_buf, 0, 0);
+
+    pthread_mutex_init(&omx_data.writer_mutex, NULL);
+
+    /* The queue never holds more than 'DEC_IN_BUFFER_COUNT' buffers */
+    assert(queue_init(&omx_data.in_buf_queue, DEC_IN_BUFFER_COUNT));
+
+    /**************************************************************************
+     *                  STEP 1: OPEN INPUT AND OUTPUT FILES                   *
+     **************************************************************************/
+
+    /* Map input file. Exit program if it is empty */
+    assert(annexb_open(&omx_data.annexb, IN_FILE_NAME));
+
+    assert(writer_open(&omx_data.writer, OUT_FILE_NAME,
+                       ENC_OUT_BUFFER_COUNT, OUT_STAGE_SIZE, OUT_DIRECT_IO));
+
+    /**************************************************************************
+     *                     STEP 2: SET UP OMX IL AND MCS                      *
+     **************************************************************************/
+
+    start_ns = omx_get_time_ns();
+
+    /* Initialize OMX IL core */
+    assert(OMX_Init() == OMX_ErrorNone);
+
+    /* Locate Renesas's H.264 decoder and encoder.
+     * If successful, both MCs will be in state LOADED */
+    assert(OMX_ErrorNone == OMX_GetHandle(&omx_data.dec_handle,
+                                          RENESAS_VIDEO_DECODER_NAME,
+                                          (OMX_PTR)&omx_data, &dec_callbacks));
+
+    assert(OMX_ErrorNone == OMX_GetHandle(&omx_data.enc_handle,
+                                          RENESAS_VIDEO_ENCODER_NAME,
+                                          (OMX_PTR)&omx_data, &enc_callbacks));
+
+    /* Configure the decoder. The encoder is configured when the frame size
+     * is known (after 'OMX_EventPortSettingsChanged' of the decoder) */
+    assert(omx_set_port_buf_cnt(omx_data.dec_handle, 0, DEC_IN_BUFFER_COUNT));
+
+    assert(omx_set_out_port_color_fmt(omx_data.dec_handle,
+                                      OMX_COLOR_FormatYUV420SemiPlanar));
+
+    assert(omx_set_port_buf_cnt(omx_data.dec_handle, 1, DEC_OUT_BUFFER_COUNT));
+
+    /**************************************************************************
+     *                      STEP 3: START THE DECODER                         *
+     **************************************************************************/
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.dec_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+
+    pp_dec_in_bufs = omx_alloc_buffers(omx_data.dec_handle, 0);
+    assert(pp_dec_in_bufs != NULL);
+
+    pp_dec_out_bufs = omx_alloc_buffers(omx_data.dec_handle, 1);
+    assert(pp_dec_out_bufs != NULL);
+
+    assert(omx_wait_state(omx_data.dec_handle, &omx_data.dec_state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.dec_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateExecuting, NULL));
+    assert(omx_wait_state(omx_data.dec_handle, &omx_data.dec_state,
+                          OMX_StateExecuting, STATE_TIMEOUT_MS));
+
+    /* Send output buffers to the decoder. They are returned (and freed)
+     * when its output port is disabled */
+    assert(omx_fill_buffers(omx_data.dec_handle, pp_dec_out_bufs,
+                            DEC_OUT_BUFFER_COUNT));
+
+    /* Hand all input buffers to the feeder thread */
+    for (index = 0; index < DEC_IN_BUFFER_COUNT; index++)
+    {
+        assert(queue_push(&omx_data.in_buf_queue, pp_dec_in_bufs[index]));
+        sem_post(&omx_data.smp_in_buf);
+    }
+
+    assert(pthread_create(&omx_data.feeder_thread, NULL,
+                          feeder_thread_func, &omx_data) == 0);
+
+    /**************************************************************************
+     *          STEP 4: REALLOCATE OUTPUT BUFFERS OF THE DECODER              *
+     **************************************************************************/
+
+    sem_wait(&omx_data.smp_port_settings_changed);
+
+    /* Section 3.4.4.2: "Non-tunneled Port Disablement and Enablement" in
+     * OMX IL specification 1.1.2 */
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.dec_handle,
+                                            OMX_CommandPortDisable, 1, NULL));
+
+    sem_wait(&omx_data.smp_port_disabled);
+
+    /* From now, FillBufferDone of the decoder hands frames to the relay */
+    omx_data.port_disabled = true;
+
+    assert(omx_get_port(omx_data.dec_handle, 1, &dec_out_port));
+
+    /* The decoder may ask for more buffers than 'DEC_OUT_BUFFER_COUNT', but
+     * the relay circulates at most 'RELAY_MAX_SLOTS' shared buffers */
+    if ((dec_out_port.nBufferCountActual > RELAY_MAX_SLOTS) &&
+        (dec_out_port.nBufferCountMin <= RELAY_MAX_SLOTS))
+    {
+        assert(omx_set_port_buf_cnt(omx_data.dec_handle, 1, RELAY_MAX_SLOTS));
+        assert(omx_get_port(omx_data.dec_handle, 1, &dec_out_port));
+    }
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.dec_handle,
+                                            OMX_CommandPortEnable, 1, NULL));
+
+    pp_dec_out_bufs = omx_alloc_buffers(omx_data.dec_handle, 1);
+    assert(pp_dec_out_bufs != NULL);
+
+    sem_wait(&omx_data.smp_port_enabled);
+
+    /**************************************************************************
+     *     STEP 5: SET UP THE ENCODER ON THE OUTPUT BUFFERS OF THE DECODER    *
+     **************************************************************************/
+
+    assert(setup_enc_in_port(omx_data.enc_handle, &dec_out_port));
+
+    assert(omx_set_out_port_fmt(omx_data.enc_handle, H264_BITRATE,
+                                OMX_VIDEO_CodingAVC, FRAMERATE));
+
+    assert(omx_set_port_buf_cnt(omx_data.enc_handle, 1, ENC_OUT_BUFFER_COUNT));
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.enc_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+
+    /* Input port of the encoder reads the frames where the decoder
+     * writes them */
+    pp_enc_in_bufs = use_dec_out_bufs(omx_data.enc_handle, pp_dec_out_bufs,
+                                      dec_out_port.nBufferCountActual);
+    assert(pp_enc_in_bufs != NULL);
+
+    pp_enc_out_bufs = omx_alloc_buffers(omx_data.enc_handle, 1);
+    assert(pp_enc_out_bufs != NULL);
+
+    assert(omx_wait_state(omx_data.enc_handle, &omx_data.enc_state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.enc_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateExecuting, NULL));
+    assert(omx_wait_state(omx_data.enc_handle, &omx_data.enc_state,
+                          OMX_StateExecuting, STATE_TIMEOUT_MS));
+
+    /**************************************************************************
+     *                         STEP 6: START TRANSCODING                      *
+     **************************************************************************/
+
+    /* From now, FillBufferDone of the encoder can hand H.264 frames to
+     * the writer */
+    assert(writer_start(&omx_data.writer, release_out_buf, &omx_data));
+
+    assert(omx_fill_buffers(omx_data.enc_handle, pp_enc_out_bufs,
+                            ENC_OUT_BUFFER_COUNT));
+
+    /* Send the shared buffers to the decoder */
+    assert(relay_init(&omx_data.relay,
+                      omx_data.dec_handle, pp_dec_out_bufs,
+                      omx_data.enc_handle, pp_enc_in_bufs,
+                      dec_out_port.nBufferCountActual));
+
+    omx_data.relay_started = true;
+    assert(relay_start(&omx_data.relay));
+
+    /* Wait until the encoder outputs End-of-Stream (or the transcoding
+     * fails) */
+    sem_wait(&omx_data.smp_eos);
+
+    total_ns = omx_get_time_ns() - start_ns;
+
+    /* Stop the feeder thread (it may still wait for a returned buffer) */
+    atomic_store(&omx_data.feeder_stop, true);
+    sem_post(&omx_data.smp_in_buf);
+
+    pthread_join(omx_data.feeder_thread, NULL);
+
+    /* Buffers returned from now stay with the relay */
+    relay_stop(&omx_data.relay);
+
+    /* From now, FillBufferDone of the encoder drops its frames */
+    pthread_mutex_lock(&omx_data.writer_mutex);
+    omx_data.writer_closed = true;
+    pthread_mutex_unlock(&omx_data.writer_mutex);
+
+    /* Write remaining H.264 frames. The writer does not send any buffer
+     * to the encoder after this point */
+    if (!writer_close(&omx_data.writer))
+    {
+        atomic_store(&omx_data.is_failed, true);
+    }
+
+    /**************************************************************************
+     *                          STEP 7: CLEAN UP OMX                          *
+     **************************************************************************/
+
+    /* Transition both MCs back to state IDLE. They return all buffers */
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.enc_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+    assert(omx_wait_state(omx_data.enc_handle, &omx_data.enc_state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.dec_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateIdle, NULL));
+    assert(omx_wait_state(omx_data.dec_handle, &omx_data.dec_state,
+                          OMX_StateIdle, STATE_TIMEOUT_MS));
+
+    /* The encoder releases its headers first: they point to the memory of
+     * the decoder's output buffers */
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.enc_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateLoaded, NULL));
+
+    omx_dealloc_all_port_bufs(omx_data.enc_handle, 1, pp_enc_out_bufs);
+    omx_dealloc_all_port_bufs(omx_data.enc_handle, 0, pp_enc_in_bufs);
+
+    assert(omx_wait_state(omx_data.enc_handle, &omx_data.enc_state,
+                          OMX_StateLoaded, STATE_TIMEOUT_MS));
+
+    assert(OMX_ErrorNone == OMX_SendCommand(omx_data.dec_handle,
+                                            OMX_CommandStateSet,
+                                            OMX_StateLoaded, NULL));
+
+    omx_dealloc_all_port_bufs(omx_data.dec_handle, 1, pp_dec_out_bufs);
+    omx_dealloc_all_port_bufs(omx_data.dec_handle, 0, pp_dec_in_bufs);
+
+    assert(omx_wait_state(omx_data.dec_handle, &omx_data.dec_state,
+                          OMX_StateLoaded, STATE_TIMEOUT_MS));
+
+    /* Free the handles of the MCs */
+    assert(OMX_FreeHandle(omx_data.enc_handle) == OMX_ErrorNone);
+    assert(OMX_FreeHandle(omx_data.dec_handle) == OMX_ErrorNone);
+
+    /* Deinitialize OMX IL core */
+    assert(OMX_Deinit() == OMX_ErrorNone);
+
+    omx_state_deinit(&omx_data.enc_state);
+    omx_state_deinit(&omx_data.dec_state);
+
+    relay_deinit(&omx_data.relay);
+    queue_deinit(&omx_data.in_buf_queue);
+
+    /**************************************************************************
+     *                 STEP 8: CLOSE INPUT AND OUTPUT FILES                   *
+     **************************************************************************/
+
+    /* Output file was closed by 'writer_close' */
+    writer_print_stats(&omx_data.writer);
+    relay_print_stats(&omx_data.relay);
+
+    printf("Timing: %.3f ms (OMX_Init to End-of-Stream of the encoder), "
+           "%.1f fps\n", total_ns / 1e6,
+           (total_ns > 0) ? (omx_data.relay.frame_count * 1e9) / total_ns : 0.0);
+
+    annexb_close(&omx_data.annexb);
+
+    printf("Parser: %llu access units, %llu NAL units, largest AU %zu bytes\n",
+           (unsigned long long)omx_data.annexb.au_count,
+           (unsigned long long)omx_data.annexb.nal_count,
+           omx_data.annexb.au_size_max);
+
+    if (atomic_load(&omx_data.is_failed))
+    {
+        printf("Error: Transcoding failed, '%s' is incomplete\n",
+               OUT_FILE_NAME);
+        return EXIT_FAILURE;
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+ *                           OMX CALLBACK HANDLERS                            *
+ ******************************************************************************/
+
+OMX_ERRORTYPE dec_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                OMX_EVENTTYPE eEvent, OMX_U32 nData1,
+                                OMX_U32 nData2, OMX_PTR pEventData)
+{
+    /* Mark parameters as unused */
+    UNUSED(hComponent);
+    UNUSED(pEventData);
+
+    omx_data_t * p_data = (omx_data_t *)pAppData;
+
+    const char * p_state_str = NULL;
+
+    switch (eEvent)
+    {
+        case OMX_EventCmdComplete:
+        {
+            if (nData1 == OMX_CommandStateSet)
+            {
+                /* Wake up 'omx_wait_state' */
+                omx_state_notify(&p_data->dec_state, (OMX_STATETYPE)nData2);
+
+                p_state_str = omx_state_to_str((OMX_STATETYPE)nData2);
+                if (p_state_str != NULL)
+                {
+                    printf("Decoder state: '%s'\n", p_state_str);
+                }
+            }
+            else if ((nData1 == OMX_CommandPortEnable) && (nData2 == 1))
+            {
+                printf("Decoder output port is enabled\n");
+                sem_post(&p_data->smp_port_enabled);
+            }
+            else if ((nData1 == OMX_CommandPortDisable) && (nData2 == 1))
+            {
+                printf("Decoder output port is disabled\n");
+                sem_post(&p_data->smp_port_disabled);
+            }
+        }
+        break;
+
+        case OMX_EventPortSettingsChanged:
+        {
+            if ((nData1 == 1) && p_data->port_disabled)
+            {
+                /* The buffers of the decoder are shared with the encoder,
+                 * which cannot be reconfigured in the middle of the stream.
+                 * Stop the transcoding */
+                printf("Error: Decoder output port settings changed again, "
+                       "resolution change not supported\n");
+
+                atomic_store(&p_data->is_failed, true);
+                sem_post(&p_data->smp_eos);
+            }
+            else if (nData1 == 1) /* Output port */
+            {
+                printf("Decoder event: 'Output port settings changed'\n");
+                sem_post(&p_data->smp_port_settings_changed);
+            }
+        }
+        break;
+
+        case OMX_EventBufferFlag:
+        {
+            if (nData1 == OMX_BUFFERFLAG_EOS)
+            {
+                /* The End-of-Stream buffer is passed on to the encoder
+                 * by the relay */
+                printf("Decoder event: 'End-of-Stream'\n");
+                p_data->dec_eos = true;
+            }
+        }
+        break;
+
+        case OMX_EventError:
+        {
+            /* Section 2.1.2 in document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
+            printf("Decoder error event: '0x%x'\n", nData1);
+
+            /* Wake up 'omx_wait_state' if the error fails a transition */
+            omx_state_notify_error(&p_data->dec_state, (OMX_ERRORTYPE)nData1);
+        }
+        break;
+
+        default:
+        {
+            /* Intentionally left blank */
+        }
+        break;
+    }
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE enc_event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData,
+                                OMX_EVENTTYPE eEvent, OMX_U32 nData1,
+                                OMX_U32 nData2, OMX_PTR pEventData)
+{
+    /* Mark parameters as unused */
+    UNUSED(hComponent);
+    UNUSED(pEventData);
+
+    omx_data_t * p_data = (omx_data_t *)pAppData;
+
+    const char * p_state_str = NULL;
+
+    switch (eEvent)
+    {
+        case OMX_EventCmdComplete:
+        {
+            if (nData1 == OMX_CommandStateSet)
+            {
+                /* Wake up 'omx_wait_state' */
+                omx_state_notify(&p_data->enc_state, (OMX_STATETYPE)nData2);
+
+                p_state_str = omx_state_to_str((OMX_STATETYPE)nData2);
+                if (p_state_str != NULL)
+                {
+                    printf("Encoder state: '%s'\n", p_state_str);
+                }
+            }
+        }
+        break;
+
+        case OMX_EventBufferFlag:
+        {
+            if (nData1 == OMX_BUFFERFLAG_EOS)
+            {
+                /* The buffer contains the last H.264 frame */
+                printf("Encoder event: 'End-of-Stream'\n");
+
+                p_data->enc_eos = true;
+                sem_post(&p_data->smp_eos);
+            }
+        }
+        break;
+
+        case OMX_EventError:
+        {
+            /* Section 2.1.2 in document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
+            printf("Encoder error event: '0x%x'\n", nData1);
+
+            /* Wake up 'omx_wait_state' if the error fails a transition */
+            omx_state_notify_error(&p_data->enc_state, (OMX_ERRORTYPE)nData1);
+        }
+        break;
+
+        default:
+        {
+            /* Intentionally left blank */
+        }
+        break;
+    }
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE dec_empty_buffer_done(OMX_HANDLETYPE hComponent,
+                                    OMX_PTR pAppData,
+                                    OMX_BUFFERHEADERTYPE * pBuffer)
+{
+    omx_data_t * p_data = (omx_data_t *)pAppData;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    if ((p_data->dec_eos == false) && (pBuffer != NULL))
+    {
+        /* Hand the buffer to the feeder thread. The queue is never full
+         * because it can hold all input buffers */
+        assert(queue_push(&p_data->in_buf_queue, pBuffer));
+        sem_post(&p_data->smp_in_buf);
+    }
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE enc_empty_buffer_done(OMX_HANDLETYPE hComponent,
+                                    OMX_PTR pAppData,
+                                    OMX_BUFFERHEADERTYPE * pBuffer)
+{
+    omx_data_t * p_data = (omx_data_t *)pAppData;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    if ((pBuffer != NULL) && p_data->relay_started)
+    {
+        /* The encoder has consumed the frame: the decoder may reuse
+         * the buffer */
+        relay_on_encoded(&p_data->relay, pBuffer);
+    }
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE dec_fill_buffer_done(OMX_HANDLETYPE hComponent,
+                                   OMX_PTR pAppData,
+                                   OMX_BUFFERHEADERTYPE * pBuffer)
+{
+    omx_data_t * p_data = (omx_data_t *)pAppData;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    if (p_data->port_disabled == false)
+    {
+        /* Output port of the decoder is being disabled: free each buffer
+         * it returns */
+        OMX_FreeBuffer(hComponent, 1, pBuffer);
+    }
+    else if ((pBuffer != NULL) && p_data->relay_started)
+    {
+        /* The relay hands the frame to the encoder */
+        relay_on_decoded(&p_data->relay, pBuffer);
+    }
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE enc_fill_buffer_done(OMX_HANDLETYPE hComponent,
+                                   OMX_PTR pAppData,
+                                   OMX_BUFFERHEADERTYPE * pBuffer)
+{
+    omx_data_t * p_data = (omx_data_t *)pAppData;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    /* Mark parameter as unused */
+    UNUSED(hComponent);
+
+    pthread_mutex_lock(&p_data->writer_mutex);
+
+    if ((p_data->enc_eos == false) && (pBuffer != NULL) &&
+        (p_data->writer_closed == false))
+    {
+        /* The writer copies the frame and then calls 'release_out_buf'
+         * to add the buffer back to the encoder */
+        writer_push(&p_data->writer, pBuffer);
+    }
+
+    pthread_mutex_unlock(&p_data->writer_mutex);
+
+    return OMX_ErrorNone;
+}
+
+/******************************************************************************
+ *                                 FUNCTIONS                                  *
+ ******************************************************************************/
+
+OMX_U32 setup_in_buf(annexb_t * p_annexb, OMX_BUFFERHEADERTYPE * p_in_buf,
+                     bool * p_is_failed)
+{
+    const uint8_t * p_au = NULL;
+    size_t au_len = 0;
+
+    p_in_buf->nOffset = 0;
+
+    if (annexb_next_au(p_annexb, &p_au, &au_len) == false)
+    {
+        p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
+        p_in_buf->nFilledLen = 0;
+    }
+    else if (au_len > p_in_buf->nAllocLen)
+    {
+        /* An access unit must fit in a single input buffer. Stop the stream
+         * instead of overflowing the buffer */
+        printf("Error: Access unit of %zu bytes exceeds input buffer "
+               "(%u bytes)\n", au_len, p_in_buf->nAllocLen);
+
+        *p_is_failed = true;
+
+        p_in_buf->nFlags = OMX_BUFFERFLAG_EOS;
+        p_in_buf->nFilledLen = 0;
+    }
+    else
+    {
+        memcpy(p_in_buf->pBuffer, p_au, au_len);
+
+        p_in_buf->nFilledLen = au_len;
+        p_in_buf->nFlags = OMX_BUFFERFLAG_ENDOFFRAME;
+    }
+
+    return p_in_buf->nFlags;
+}
+
+void release_out_buf(void * p_ctx, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    omx_data_t * p_data = (omx_data_t *)p_ctx;
+
+    /* Check parameters */
+    assert((p_data != NULL) && (p_buf != NULL));
+
+    if (p_data->enc_eos == false)
+    {
+        p_buf->nFlags     = 0;
+        p_buf->nFilledLen = 0;
+
+        assert(OMX_FillThisBuffer(p_data->enc_handle, p_buf) == OMX_ErrorNone);
+    }
+}
+
+bool setup_enc_in_port(OMX_HANDLETYPE enc_handle,
+                       const OMX_PARAM_PORTDEFINITIONTYPE * p_dec_out_port)
+{
+    const OMX_VIDEO_PORTDEFINITIONTYPE * p_dec_video = NULL;
+    OMX_PARAM_PORTDEFINITIONTYPE enc_in_port;
+
+    /* Check parameter */
+    assert(p_dec_out_port != NULL);
+
+    p_dec_video = &p_dec_out_port->format.video;
+
+    if (!omx_set_in_port_fmt(enc_handle,
+                             p_dec_video->nFrameWidth,
+                             p_dec_video->nFrameHeight,
+                             p_dec_video->nStride,
+                             p_dec_video->nSliceHeight,
+                             OMX_COLOR_FormatYUV420SemiPlanar) ||
+        !omx_set_port_buf_cnt(enc_handle, 0,
+                              p_dec_out_port->nBufferCountActual))
+    {
+        return false;
+    }
+
+    if (omx_get_port(enc_handle, 0, &enc_in_port) == false)
+    {
+        return false;
+    }
+
+    /* The encoder must read frames in the layout the decoder writes them */
+    if ((enc_in_port.format.video.nStride != p_dec_video->nStride) ||
+        (enc_in_port.format.video.nSliceHeight != p_dec_video->nSliceHeight))
+    {
+        printf("Error: Encoder changed stride/slice height %d/%d to %d/%d\n",
+               (int)p_dec_video->nStride, p_dec_video->nSliceHeight,
+               (int)enc_in_port.format.video.nStride,
+               enc_in_port.format.video.nSliceHeight);
+        return false;
+    }
+
+    /* A decoder buffer must be able to hold an encoder input frame */
+    if (enc_in_port.nBufferSize > p_dec_out_port->nBufferSize)
+    {
+        printf("Error: Encoder needs input buffers of '%d' bytes, decoder "
+               "buffers have '%d' bytes\n",
+               enc_in_port.nBufferSize, p_dec_out_port->nBufferSize);
+        return false;
+    }
+
+    printf("Transcode: %ux%u frames, stride %d, slice height %u, "
+           "%u shared buffers\n",
+           p_dec_video->nFrameWidth, p_dec_video->nFrameHeight,
+           (int)p_dec_video->nStride, p_dec_video->nSliceHeight,
+           p_dec_out_port->nBufferCountActual);
+
+    return true;
+}
+
+OMX_BUFFERHEADERTYPE ** use_dec_out_bufs(OMX_HANDLETYPE enc_handle,
+                                         OMX_BUFFERHEADERTYPE ** pp_dec_bufs,
+                                         uint32_t count)
+{
+    OMX_BUFFERHEADERTYPE ** pp_enc_bufs = NULL;
+    OMX_U8 ** pp_frames = NULL;
+    OMX_PARAM_PORTDEFINITIONTYPE enc_in_port;
+    OMX_U32 size = 0;
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert((pp_dec_bufs != NULL) && (count > 0));
+
+    if (omx_get_port(enc_handle, 0, &enc_in_port) == false)
+    {
+        return NULL;
+    }
+
+    /* Each encoder buffer header uses one decoder buffer */
+    if (enc_in_port.nBufferCountActual != count)
+    {
+        printf("Error: Encoder has '%u' input buffers, decoder has '%u' "
+               "output buffers\n", enc_in_port.nBufferCountActual, count);
+        return NULL;
+    }
+
+    pp_frames = (OMX_U8 **)malloc(count * sizeof(OMX_U8 *));
+    if (pp_frames == NULL)
+    {
+        return NULL;
+    }
+
+    size = pp_dec_bufs[0]->nAllocLen;
+
+    for (index = 0; index < count; index++)
+    {
+        /* Buffers allocated by the decoder are physically contiguous, but
+         * they must also meet the alignment of the encoder */
+        if ((enc_in_port.nBufferAlignment > 1) &&
+            (((uintptr_t)pp_dec_bufs[index]->pBuffer %
+              enc_in_port.nBufferAlignment) != 0))
+        {
+            printf("Error: Decoder buffer '%u' does not meet alignment '%d' "
+                   "of the encoder\n", index, enc_in_port.nBufferAlignment);
+
+            free(pp_frames);
+            return NULL;
+        }
+
+        pp_frames[index] = pp_dec_bufs[index]->pBuffer;
+
+        if (pp_dec_bufs[index]->nAllocLen < size)
+        {
+            size = pp_dec_bufs[index]->nAllocLen;
+        }
+    }
+
+    /* The encoder only keeps the addresses, not the array */
+    pp_enc_bufs = omx_use_buffers(enc_handle, 0, pp_frames, size);
+
+    free(pp_frames);
+
+    return pp_enc_bufs;
+}
+
+void * feeder_thread_func(void * p_param)
+{
+    omx_data_t * p_data = (omx_data_t *)p_param;
+
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+
+    /* True if an access unit did not fit in an input buffer */
+    bool is_failed = false;
+
+    /* Check parameter */
+    assert(p_data != NULL);
+
+    while (true)
+    {
+        /* Wait until a buffer is added to the queue or 'main' asks to exit */
+        sem_wait(&p_data->smp_in_buf);
+
+        if (atomic_load(&p_data->feeder_stop) || (p_data->dec_eos == true))
+        {
+            break;
+        }
+
+        p_buf = (OMX_BUFFERHEADERTYPE *)queue_pop(&p_data->in_buf_queue);
+        if (p_buf == NULL)
+        {
+            continue;
+        }
+
+        setup_in_buf(&p_data->annexb, p_buf, &is_failed);
+
+        if (is_failed)
+        {
+            /* The End-of-Stream buffer below ends the transcoding early */
+            atomic_store(&p_data->is_failed, true);
+        }
+
+        assert(OMX_EmptyThisBuffer(p_data->dec_handle, p_buf) ==
+               OMX_ErrorNone);
+
+        if (p_buf->nFlags & OMX_BUFFERFLAG_EOS)
+        {
+            /* No more data to send to the decoder */
+            break;
+        }
+    }
+
+    return NULL;
+}
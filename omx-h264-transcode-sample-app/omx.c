@@ -0,0 +1,611 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: omx.c
+ *
+ * DESCRIPTION:
+ *   OMX function definition.
+ * 
+ * NOTE:
+ *   For function usage, please refer to 'omx.h'.
+ * 
+ * AUTHOR: RVC       START DATE: 14/03/2023
+ *
+ ******************************************************************************/
+
+
+#include <time.h>
+#include <errno.h>
+
+#include "omx.h"
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+void omx_state_init(omx_state_t * p_state)
+{
+    pthread_condattr_t cond_attr;
+
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    /* Timeouts are measured with the monotonic clock, so they are not
+     * affected by changes of system time */
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+
+    pthread_mutex_init(&p_state->mutex, NULL);
+    pthread_cond_init(&p_state->cond, &cond_attr);
+
+    pthread_condattr_destroy(&cond_attr);
+
+    p_state->state = OMX_StateLoaded;
+    p_state->error = OMX_ErrorNone;
+}
+
+void omx_state_deinit(omx_state_t * p_state)
+{
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    pthread_cond_destroy(&p_state->cond);
+    pthread_mutex_destroy(&p_state->mutex);
+}
+
+void omx_state_notify(omx_state_t * p_state, OMX_STATETYPE state)
+{
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    pthread_mutex_lock(&p_state->mutex);
+
+    p_state->state = state;
+    pthread_cond_broadcast(&p_state->cond);
+
+    pthread_mutex_unlock(&p_state->mutex);
+}
+
+void omx_state_notify_error(omx_state_t * p_state, OMX_ERRORTYPE error)
+{
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    switch (error)
+    {
+        /* See section 3.2.2.13 in OMX IL specification 1.1.2 */
+        case OMX_ErrorSameState:
+        case OMX_ErrorIncorrectStateTransition:
+        case OMX_ErrorInsufficientResources:
+        case OMX_ErrorInvalidState:
+        {
+            pthread_mutex_lock(&p_state->mutex);
+
+            p_state->error = error;
+            pthread_cond_broadcast(&p_state->cond);
+
+            pthread_mutex_unlock(&p_state->mutex);
+        }
+        break;
+
+        default:
+        {
+            /* Other errors do not affect state transitions */
+        }
+        break;
+    }
+}
+
+bool omx_wait_state(OMX_HANDLETYPE handle, omx_state_t * p_state,
+                    OMX_STATETYPE state, uint32_t timeout_ms)
+{
+    bool is_success = false;
+    int ret = 0;
+
+    struct timespec deadline;
+
+    const char * p_state_str = NULL;
+    OMX_STATETYPE cur_state = OMX_StateInvalid;
+
+    /* Check parameter */
+    assert(p_state != NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec  += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&p_state->mutex);
+
+    /* Sleep until the event handler reports the state (or an error) */
+    while ((p_state->state != state) && (p_state->error == OMX_ErrorNone))
+    {
+        ret = pthread_cond_timedwait(&p_state->cond, &p_state->mutex, &deadline);
+        if (ret == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    is_success = (p_state->state == state);
+
+    if (!is_success)
+    {
+        p_state_str = omx_state_to_str(state);
+
+        if (p_state->error != OMX_ErrorNone)
+        {
+            printf("Error: Failed to transition into state '%s' (0x%x)\n",
+                   (p_state_str != NULL) ? p_state_str : "?", p_state->error);
+        }
+        else
+        {
+            /* The component may still be busy with the transition */
+            OMX_GetState(handle, &cur_state);
+
+            printf("Error: Timed out waiting for state '%s' (%u ms, "
+                   "current state 0x%x)\n",
+                   (p_state_str != NULL) ? p_state_str : "?",
+                   timeout_ms, cur_state);
+        }
+    }
+
+    /* The error only applies to this transition */
+    p_state->error = OMX_ErrorNone;
+
+    pthread_mutex_unlock(&p_state->mutex);
+
+    return is_success;
+}
+
+uint64_t omx_get_time_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+const char * omx_state_to_str(OMX_STATETYPE state)
+{
+    static const struct
+    {
+        OMX_STATETYPE state;
+        const char *  p_state_str;
+    }
+    state_mapping[] =
+    {
+        /* The component has detected that its internal data structures are
+         * corrupted to the point that it cannot determine its state properly */
+        { OMX_StateInvalid, "OMX_StateInvalid" },
+
+        /* The component has been loaded but has not completed initialization.
+         * The 'OMX_SetParameter' macro and the 'OMX_GetParameter' macro are
+         * the only macros allowed to be sent to the component in this state */
+        { OMX_StateLoaded, "OMX_StateLoaded" },
+
+        /* The component initialization has been completed successfully and
+         * the component is ready to start */
+        { OMX_StateIdle, "OMX_StateIdle" },
+
+        /* The component has accepted the start command and is processing data
+         * (if data is available) */
+        { OMX_StateExecuting, "OMX_StateExecuting" },
+
+        /* The component has received pause command */
+        { OMX_StatePause, "OMX_StatePause" },
+
+        /* The component is waiting for resources, either after preemption or
+         * before it gets the resources requested.
+         * See OMX IL specification 1.1.2 for complete details */
+        { OMX_StateWaitForResources, "OMX_StateWaitForResources" },
+    };
+
+    uint32_t len   = sizeof(state_mapping) / sizeof(state_mapping[0]);
+    uint32_t index = 0;
+
+    for (index = 0; index < len; index++)
+    {
+        if (state == state_mapping[index].state)
+        {
+            return state_mapping[index].p_state_str;
+        }
+    }
+
+    return NULL;
+}
+
+bool omx_get_port(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                  OMX_PARAM_PORTDEFINITIONTYPE * p_port)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+
+    /* Check parameter */
+    assert(p_port != NULL);
+
+    OMX_INIT_STRUCTURE(&port);
+    port.nPortIndex = port_idx;
+
+    if (OMX_ErrorNone !=
+        OMX_GetParameter(handle, OMX_IndexParamPortDefinition, &port))
+    {
+        printf("Error: Failed to get port at index '%d'\n", port_idx);
+        return false;
+    }
+
+    /* Copy data from 'port' to 'p_port' */
+    memcpy(p_port, &port, sizeof(struct OMX_PARAM_PORTDEFINITIONTYPE));
+
+    return true;
+}
+
+bool omx_get_bitrate_ctrl(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                          OMX_VIDEO_PARAM_BITRATETYPE * p_ctrl)
+{
+    OMX_VIDEO_PARAM_BITRATETYPE ctrl;
+
+    /* Check parameter */
+    assert(p_ctrl != NULL);
+
+    OMX_INIT_STRUCTURE(&ctrl);
+    ctrl.nPortIndex = port_idx;
+
+    if (OMX_ErrorNone !=
+        OMX_GetParameter(handle, OMX_IndexParamVideoBitrate, &ctrl))
+    {
+        printf("Error: Failed to get bitrate control of port '%d'\n", port_idx);
+        return false;
+    }
+
+    /* Copy data from 'ctrl' to 'p_ctrl' */
+    memcpy(p_ctrl, &ctrl, sizeof(struct OMX_VIDEO_PARAM_BITRATETYPE));
+
+    return true;
+}
+
+bool omx_set_in_port_fmt(OMX_HANDLETYPE handle,
+                         OMX_U32 frame_width, OMX_U32 frame_height,
+                         OMX_S32 stride, OMX_U32 slice_height,
+                         OMX_COLOR_FORMATTYPE color_fmt)
+{
+    bool is_success = false;
+    OMX_PARAM_PORTDEFINITIONTYPE in_port;
+
+    /* Get input port */
+    if (omx_get_port(handle, 0, &in_port) == true)
+    {
+        /* Configure and set new parameters to input port */
+        in_port.format.video.nFrameWidth   = frame_width;
+        in_port.format.video.nFrameHeight  = frame_height;
+        in_port.format.video.nStride       = stride;
+        in_port.format.video.nSliceHeight  = slice_height;
+        in_port.format.video.eColorFormat  = color_fmt;
+
+        if (OMX_ErrorNone ==
+            OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &in_port))
+        {
+            is_success = true;
+        }
+    }
+
+    if (!is_success)
+    {
+        printf("Error: Failed to set input port\n");
+    }
+
+    return is_success;
+}
+
+bool omx_set_out_port_fmt(OMX_HANDLETYPE handle, OMX_U32 bitrate,
+                          OMX_VIDEO_CODINGTYPE compression_fmt,
+                          OMX_U32 framerate)
+{
+    bool b_set_fmt_ok       = false;
+    bool b_set_bitrate_ok   = false;
+    bool b_set_framerate_ok = false;
+
+    OMX_VIDEO_PARAM_BITRATETYPE ctrl;
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+    OMXR_MC_VIDEO_PARAM_AVC_VUI_PROPERTY vui;
+
+    /* Check parameter */
+    assert(bitrate > 0);
+
+    /* Get output port */
+    if (omx_get_port(handle, 1, &out_port) == true)
+    {
+        out_port.format.video.eCompressionFormat = compression_fmt;
+        /* Configure and set compression format to output port */
+
+        if (OMX_ErrorNone ==
+            OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &out_port))
+        {
+            b_set_fmt_ok = true;
+        }
+    }
+
+    /* Get video encode bitrate control for output port */
+    if (omx_get_bitrate_ctrl(handle, 1, &ctrl) == true)
+    {
+        /* Configure and set bitrate to output port */
+        ctrl.nTargetBitrate = bitrate;
+        ctrl.eControlRate   = OMX_Video_ControlRateConstant;
+
+        if (OMX_ErrorNone ==
+            OMX_SetParameter(handle, OMX_IndexParamVideoBitrate, &ctrl))
+        {
+            b_set_bitrate_ok = true;
+        }
+    }
+
+    /* Set framerate for output port */
+    OMX_INIT_STRUCTURE(&vui);
+
+    /* The 'bFixedFrameRateFlag' field is twice the framerate */
+    vui.nPortIndex             = 1;
+    vui.u32TimeScale           = framerate * 2;
+    vui.u32NumUnitsInTick      = 1;
+    vui.bFixedFrameRateFlag    = OMX_TRUE;
+    vui.bTimingInfoPresentFlag = OMX_TRUE;
+
+    if (OMX_ErrorNone ==
+        OMX_SetParameter(handle, OMXR_MC_IndexParamVideoAVCVuiProperty, &vui))
+    {
+        b_set_framerate_ok = true;
+    }
+
+    if (!b_set_fmt_ok || !b_set_bitrate_ok || !b_set_framerate_ok)
+    {
+        printf("Error: Failed to set output port\n");
+    }
+
+    return (b_set_fmt_ok && b_set_bitrate_ok);
+}
+
+bool omx_set_out_port_color_fmt(OMX_HANDLETYPE handle,
+                                OMX_COLOR_FORMATTYPE color_fmt)
+{
+    bool is_success = false;
+    OMX_PARAM_PORTDEFINITIONTYPE out_port;
+
+    /* Get output port */
+    if (omx_get_port(handle, 1, &out_port) == true)
+    {
+        /* Configure and set new parameters to output port */
+        out_port.format.video.eColorFormat = color_fmt;
+
+        if (OMX_ErrorNone ==
+            OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &out_port))
+        {
+            is_success = true;
+        }
+    }
+
+    if (!is_success)
+    {
+        printf("Error: Failed to set output port\n");
+    }
+
+    return is_success;
+}
+
+bool omx_set_port_buf_cnt(OMX_HANDLETYPE handle,
+                          OMX_U32 port_idx, OMX_U32 buf_cnt)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+
+    /* Check parameter */
+    assert(buf_cnt > 0);
+
+    /* Get port 'port_idx' */
+    if (omx_get_port(handle, port_idx, &port) == false)
+    {
+        return false;
+    }
+
+    /* Value 'buf_cnt' must not be less than 'nBufferCountMin' */
+    if (buf_cnt < port.nBufferCountMin)
+    {
+        printf("Error: Port '%d' requires no less than '%d' buffers\n",
+                                        port_idx, port.nBufferCountMin);
+        return false;
+    }
+
+    /* Set the number of buffers that are required on port 'port_idx' */
+    port.nBufferCountActual = buf_cnt;
+
+    if (OMX_ErrorNone !=
+        OMX_SetParameter(handle, OMX_IndexParamPortDefinition, &port))
+    {
+        printf("Error: Failed to set port at index '%d'\n", port_idx);
+        return false;
+    }
+
+    return true;
+}
+
+OMX_BUFFERHEADERTYPE ** omx_alloc_buffers(OMX_HANDLETYPE handle,
+                                          OMX_U32 port_idx)
+{
+    uint32_t index = 0;
+
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+    OMX_BUFFERHEADERTYPE ** pp_bufs = NULL;
+
+    /* Get port */
+    if (omx_get_port(handle, port_idx, &port) == false)
+    {
+        return NULL;
+    }
+
+    /* Allocate an array of 'OMX_BUFFERHEADERTYPE *' */
+    pp_bufs = (OMX_BUFFERHEADERTYPE **)
+              malloc(port.nBufferCountActual * sizeof(OMX_BUFFERHEADERTYPE *));
+
+
+    for (index = 0; index < port.nBufferCountActual; index++)
+    {
+        /* See section 2.2.10 in document 'R01USxxxxEJxxxx_cmn_v1.0.pdf'
+         * and 'Table 6-3' in document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
+        if (OMX_ErrorNone != OMX_AllocateBuffer(handle,
+                                                pp_bufs + index,
+                                                port_idx, NULL,
+                                                port.nBufferSize))
+        {
+            printf("Error: Failed to allocate buffers at index '%d'\n", index);
+            break;
+        }
+    }
+
+    if (index < port.nBufferCountActual)
+    {
+        omx_dealloc_port_bufs(handle, port_idx, pp_bufs, index);
+        return NULL;
+    }
+
+    return pp_bufs;
+}
+
+OMX_BUFFERHEADERTYPE ** omx_use_buffers(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                                        OMX_U8 ** pp_data, OMX_U32 size)
+{
+    uint32_t index = 0;
+
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+    OMX_BUFFERHEADERTYPE ** pp_bufs = NULL;
+
+    /* Check parameter */
+    assert(pp_data != NULL);
+
+    /* Get port */
+    if (omx_get_port(handle, port_idx, &port) == false)
+    {
+        return NULL;
+    }
+
+    /* Each buffer must be able to hold the data of a whole frame */
+    if (size < port.nBufferSize)
+    {
+        printf("Error: Buffers of port '%d' must have at least '%d' bytes\n",
+               port_idx, port.nBufferSize);
+        return NULL;
+    }
+
+    /* Allocate an array of 'OMX_BUFFERHEADERTYPE *' */
+    pp_bufs = (OMX_BUFFERHEADERTYPE **)
+              malloc(port.nBufferCountActual * sizeof(OMX_BUFFERHEADERTYPE *));
+    if (pp_bufs == NULL)
+    {
+        return NULL;
+    }
+
+    for (index = 0; index < port.nBufferCountActual; index++)
+    {
+        /* The component only allocates the buffer header.
+         * The memory at 'pp_data[index]' still belongs to the application */
+        if (OMX_ErrorNone != OMX_UseBuffer(handle, pp_bufs + index,
+                                           port_idx, NULL,
+                                           size, pp_data[index]))
+        {
+            printf("Error: Failed to use buffer at index '%d'\n", index);
+            break;
+        }
+    }
+
+    if (index < port.nBufferCountActual)
+    {
+        omx_dealloc_port_bufs(handle, port_idx, pp_bufs, index);
+        return NULL;
+    }
+
+    return pp_bufs;
+}
+
+void omx_dealloc_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                           OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count)
+{
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(pp_bufs != NULL);
+
+    for (index = 0; index < count; index++)
+    {
+        OMX_FreeBuffer(handle, port_idx, pp_bufs[index]);
+    }
+
+    /* Free entire array */
+    free (pp_bufs);
+}
+
+void omx_dealloc_all_port_bufs(OMX_HANDLETYPE handle, OMX_U32 port_idx,
+                               OMX_BUFFERHEADERTYPE ** pp_bufs)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE port;
+
+    /* Check parameter */
+    assert(pp_bufs != NULL);
+
+    /* Get port */
+    if (omx_get_port(handle, port_idx, &port) == true)
+    {
+        omx_dealloc_port_bufs(handle, port_idx, pp_bufs,
+                              port.nBufferCountActual);
+    }
+}
+
+int omx_get_index(OMX_BUFFERHEADERTYPE * p_buf,
+                  OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count)
+{
+    int ret = -1;
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert(p_buf != NULL);
+    assert((pp_bufs != NULL) && (count > 0));
+
+    for (index = 0; index < count; index++)
+    {
+        if (pp_bufs[index] == p_buf)
+        {
+            ret = index;
+            break;
+        }
+    }
+
+    return ret;
+}
+
+bool omx_fill_buffers(OMX_HANDLETYPE handle,
+                      OMX_BUFFERHEADERTYPE ** pp_bufs, uint32_t count)
+{
+    bool is_success = true;
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert((pp_bufs != NULL) && (count > 0));
+
+    for (index = 0; index < count; index++)
+    {
+        pp_bufs[index]->nFlags     = 0;
+        pp_bufs[index]->nFilledLen = 0;
+
+        if (OMX_FillThisBuffer(handle, pp_bufs[index]) != OMX_ErrorNone)
+        {
+            printf("Error: Failed to send buffer '%d' to output port\n", index);
+
+            is_success = false;
+            break;
+        }
+    }
+
+    return is_success;
+}
@@ -0,0 +1,359 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: relay.c
+ *
+ * DESCRIPTION:
+ *   Relay of decoded frames from the decoder to the encoder definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'relay.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#include "relay.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get the slot whose decoder (if 'is_dec' is true) or encoder buffer header
+ * is 'p_buf'. Return NULL if there is no such slot */
+static relay_slot_t * relay_find_slot(relay_t * p_relay,
+                                      OMX_BUFFERHEADERTYPE * p_buf,
+                                      bool is_dec);
+
+/* Move 'p_slot' from 'from' to the relay. If the relay is running, add the
+ * slot to 'p_queue' for the relay thread */
+static void relay_take_slot(relay_t * p_relay, relay_slot_t * p_slot,
+                            relay_owner_t from, queue_t * p_queue);
+
+/* Send the frame of 'p_slot' (returned by the decoder) to the encoder */
+static void relay_send_to_encoder(relay_t * p_relay, relay_slot_t * p_slot);
+
+/* Send 'p_slot' back to the decoder, unless End-of-Stream was reached */
+static void relay_send_to_decoder(relay_t * p_relay, relay_slot_t * p_slot);
+
+/* Thread function which sends the queued slots to the next component */
+static void * relay_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool relay_init(relay_t * p_relay,
+                OMX_HANDLETYPE dec_handle, OMX_BUFFERHEADERTYPE ** pp_dec_bufs,
+                OMX_HANDLETYPE enc_handle, OMX_BUFFERHEADERTYPE ** pp_enc_bufs,
+                uint32_t count)
+{
+    uint32_t index = 0;
+
+    /* Check parameters */
+    assert((p_relay != NULL) && (pp_dec_bufs != NULL) && (pp_enc_bufs != NULL));
+
+    memset(p_relay, 0, sizeof(relay_t));
+
+    if ((count == 0) || (count > RELAY_MAX_SLOTS))
+    {
+        printf("Error: Relay cannot handle '%u' buffers\n", count);
+        return false;
+    }
+
+    for (index = 0; index < count; index++)
+    {
+        /* Both headers must describe the same memory */
+        if (pp_enc_bufs[index]->pBuffer != pp_dec_bufs[index]->pBuffer)
+        {
+            printf("Error: Encoder buffer '%u' does not use decoder buffer\n",
+                   index);
+            return false;
+        }
+
+        p_relay->slots[index].p_dec_buf = pp_dec_bufs[index];
+        p_relay->slots[index].p_enc_buf = pp_enc_bufs[index];
+
+        atomic_init(&p_relay->slots[index].owner, RELAY_OWNER_RELAY);
+    }
+
+    p_relay->dec_handle = dec_handle;
+    p_relay->enc_handle = enc_handle;
+    p_relay->slot_count = count;
+
+    atomic_init(&p_relay->stop, false);
+    atomic_init(&p_relay->bad_transitions, 0);
+
+    /* Each queue never holds more than all slots */
+    if (!queue_init(&p_relay->decoded_queue, count) ||
+        !queue_init(&p_relay->encoded_queue, count))
+    {
+        queue_deinit(&p_relay->decoded_queue);
+        return false;
+    }
+
+    sem_init(&p_relay->smp_slot, 0, 0);
+
+    return true;
+}
+
+bool relay_start(relay_t * p_relay)
+{
+    relay_slot_t * p_slot = NULL;
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_relay != NULL);
+
+    if (pthread_create(&p_relay->thread, NULL, relay_thread, p_relay) != 0)
+    {
+        printf("Error: Failed to create relay thread\n");
+        return false;
+    }
+
+    /* The decoder fills all slots first */
+    for (index = 0; index < p_relay->slot_count; index++)
+    {
+        p_slot = &p_relay->slots[index];
+
+        p_slot->p_dec_buf->nFlags     = 0;
+        p_slot->p_dec_buf->nFilledLen = 0;
+
+        atomic_store(&p_slot->owner, RELAY_OWNER_DECODER);
+
+        if (OMX_FillThisBuffer(p_relay->dec_handle,
+                               p_slot->p_dec_buf) != OMX_ErrorNone)
+        {
+            printf("Error: Failed to send buffer '%u' to decoder\n", index);
+
+            atomic_store(&p_slot->owner, RELAY_OWNER_RELAY);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void relay_on_decoded(relay_t * p_relay, OMX_BUFFERHEADERTYPE * p_dec_buf)
+{
+    relay_slot_t * p_slot = NULL;
+
+    /* Check parameters */
+    assert((p_relay != NULL) && (p_dec_buf != NULL));
+
+    p_slot = relay_find_slot(p_relay, p_dec_buf, true);
+    if (p_slot == NULL)
+    {
+        printf("Error: Decoder returned an unknown buffer\n");
+        atomic_fetch_add(&p_relay->bad_transitions, 1);
+        return;
+    }
+
+    relay_take_slot(p_relay, p_slot, RELAY_OWNER_DECODER,
+                    &p_relay->decoded_queue);
+}
+
+void relay_on_encoded(relay_t * p_relay, OMX_BUFFERHEADERTYPE * p_enc_buf)
+{
+    relay_slot_t * p_slot = NULL;
+
+    /* Check parameters */
+    assert((p_relay != NULL) && (p_enc_buf != NULL));
+
+    p_slot = relay_find_slot(p_relay, p_enc_buf, false);
+    if (p_slot == NULL)
+    {
+        printf("Error: Encoder returned an unknown buffer\n");
+        atomic_fetch_add(&p_relay->bad_transitions, 1);
+        return;
+    }
+
+    relay_take_slot(p_relay, p_slot, RELAY_OWNER_ENCODER,
+                    &p_relay->encoded_queue);
+}
+
+void relay_stop(relay_t * p_relay)
+{
+    /* Check parameter */
+    assert(p_relay != NULL);
+
+    atomic_store(&p_relay->stop, true);
+    sem_post(&p_relay->smp_slot);
+
+    pthread_join(p_relay->thread, NULL);
+}
+
+void relay_deinit(relay_t * p_relay)
+{
+    /* Check parameter */
+    assert(p_relay != NULL);
+
+    queue_deinit(&p_relay->decoded_queue);
+    queue_deinit(&p_relay->encoded_queue);
+
+    sem_destroy(&p_relay->smp_slot);
+}
+
+void relay_print_stats(relay_t * p_relay)
+{
+    /* Check parameter */
+    assert(p_relay != NULL);
+
+    printf("Relay: %llu frames (%.1f MB) handed to the encoder without copy, "
+           "up to %u of %u buffers in the encoder, %u bad transitions\n",
+           (unsigned long long)p_relay->frame_count,
+           p_relay->frame_bytes / (1024.0 * 1024.0),
+           p_relay->enc_owned_max, p_relay->slot_count,
+           atomic_load(&p_relay->bad_transitions));
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static relay_slot_t * relay_find_slot(relay_t * p_relay,
+                                      OMX_BUFFERHEADERTYPE * p_buf,
+                                      bool is_dec)
+{
+    uint32_t index = 0;
+
+    for (index = 0; index < p_relay->slot_count; index++)
+    {
+        if ((is_dec ? p_relay->slots[index].p_dec_buf :
+                      p_relay->slots[index].p_enc_buf) == p_buf)
+        {
+            return &p_relay->slots[index];
+        }
+    }
+
+    return NULL;
+}
+
+static void relay_take_slot(relay_t * p_relay, relay_slot_t * p_slot,
+                            relay_owner_t from, queue_t * p_queue)
+{
+    int expected = from;
+
+    if (!atomic_compare_exchange_strong(&p_slot->owner, &expected,
+                                        RELAY_OWNER_RELAY))
+    {
+        /* The component returned a buffer it did not own */
+        printf("Error: Buffer returned by owner '%d' instead of '%d'\n",
+               expected, (int)from);
+        atomic_fetch_add(&p_relay->bad_transitions, 1);
+        return;
+    }
+
+    if (atomic_load(&p_relay->stop))
+    {
+        /* The components are being stopped: keep the slot */
+        return;
+    }
+
+    /* The queue is never full because it can hold all slots */
+    assert(queue_push(p_queue, p_slot));
+    sem_post(&p_relay->smp_slot);
+}
+
+static void relay_send_to_encoder(relay_t * p_relay, relay_slot_t * p_slot)
+{
+    OMX_BUFFERHEADERTYPE * p_dec_buf = p_slot->p_dec_buf;
+    OMX_BUFFERHEADERTYPE * p_enc_buf = p_slot->p_enc_buf;
+
+    if (p_relay->eos)
+    {
+        /* The decoder should not return anything after End-of-Stream */
+        return;
+    }
+
+    if ((p_dec_buf->nFilledLen == 0) &&
+        ((p_dec_buf->nFlags & OMX_BUFFERFLAG_EOS) == 0))
+    {
+        /* Nothing was decoded into the buffer */
+        relay_send_to_decoder(p_relay, p_slot);
+        return;
+    }
+
+    /* Only the header is updated: the frame stays where the decoder put it */
+    p_enc_buf->nOffset    = p_dec_buf->nOffset;
+    p_enc_buf->nFilledLen = p_dec_buf->nFilledLen;
+    p_enc_buf->nFlags     = p_dec_buf->nFlags;
+    p_enc_buf->nTimeStamp = p_dec_buf->nTimeStamp;
+
+    if (p_dec_buf->nFlags & OMX_BUFFERFLAG_EOS)
+    {
+        /* The encoder will signal End-of-Stream after this buffer */
+        p_relay->eos = true;
+    }
+
+    if (p_dec_buf->nFilledLen > 0)
+    {
+        p_relay->frame_count++;
+        p_relay->frame_bytes += p_dec_buf->nFilledLen;
+    }
+
+    p_relay->enc_owned++;
+    if (p_relay->enc_owned > p_relay->enc_owned_max)
+    {
+        p_relay->enc_owned_max = p_relay->enc_owned;
+    }
+
+    /* The owner must be set before EmptyBufferDone can occur */
+    atomic_store(&p_slot->owner, RELAY_OWNER_ENCODER);
+
+    assert(OMX_EmptyThisBuffer(p_relay->enc_handle, p_enc_buf) ==
+           OMX_ErrorNone);
+}
+
+static void relay_send_to_decoder(relay_t * p_relay, relay_slot_t * p_slot)
+{
+    if (p_relay->eos)
+    {
+        /* The decoder has no more frame to output */
+        return;
+    }
+
+    p_slot->p_dec_buf->nFlags     = 0;
+    p_slot->p_dec_buf->nFilledLen = 0;
+
+    /* The owner must be set before FillBufferDone can occur */
+    atomic_store(&p_slot->owner, RELAY_OWNER_DECODER);
+
+    assert(OMX_FillThisBuffer(p_relay->dec_handle, p_slot->p_dec_buf) ==
+           OMX_ErrorNone);
+}
+
+static void * relay_thread(void * p_param)
+{
+    relay_t * p_relay = (relay_t *)p_param;
+    relay_slot_t * p_slot = NULL;
+
+    while (true)
+    {
+        /* Wait until a slot is queued or 'relay_stop' asks to exit */
+        sem_wait(&p_relay->smp_slot);
+
+        if (atomic_load(&p_relay->stop))
+        {
+            break;
+        }
+
+        /* Each post matches exactly one queued slot */
+        p_slot = (relay_slot_t *)queue_pop(&p_relay->decoded_queue);
+        if (p_slot != NULL)
+        {
+            relay_send_to_encoder(p_relay, p_slot);
+            continue;
+        }
+
+        p_slot = (relay_slot_t *)queue_pop(&p_relay->encoded_queue);
+        if (p_slot != NULL)
+        {
+            p_relay->enc_owned--;
+            relay_send_to_decoder(p_relay, p_slot);
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,167 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: relay.h
+ *
+ * DESCRIPTION:
+ *   Relay of decoded frames from the decoder to the encoder (zero copy).
+ *
+ *   Each output buffer of the decoder is also an input buffer of the encoder:
+ *   the encoder's buffer header is created with 'OMX_UseBuffer' on the
+ *   'pBuffer' of the decoder's buffer header. The two headers form a slot.
+ *
+ *   A slot is always owned by exactly one of:
+ *     - The decoder: it was sent with 'OMX_FillThisBuffer'.
+ *     - The relay:   it was returned by FillBufferDone (decoder) or by
+ *                    EmptyBufferDone (encoder) and waits for the relay thread.
+ *     - The encoder: it was sent with 'OMX_EmptyThisBuffer'.
+ *
+ *   The transitions are:
+ *
+ *     DECODER --(FillBufferDone)--> RELAY --(OMX_EmptyThisBuffer)--> ENCODER
+ *        ^                                                              |
+ *        +----(OMX_FillThisBuffer)---- RELAY <---(EmptyBufferDone)------+
+ *
+ *   So a frame is never overwritten by the decoder before the encoder has
+ *   consumed it. Callbacks only change the owner and queue the slot; the
+ *   relay thread sends it to the next component.
+ *
+ *   Once the End-of-Stream buffer has been sent to the encoder, slots
+ *   returned by the encoder stay with the relay.
+ *
+ * PUBLIC FUNCTIONS:
+ *   relay_init
+ *   relay_start
+ *   relay_on_decoded
+ *   relay_on_encoded
+ *   relay_stop
+ *   relay_deinit
+ *
+ *   relay_print_stats
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#ifndef _RELAY_H_
+#define _RELAY_H_
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+#include "omx.h"
+#include "queue.h"
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+/* The maximum number of slots (output buffers of the decoder) */
+#define RELAY_MAX_SLOTS 16
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef enum
+{
+    RELAY_OWNER_RELAY = 0,
+    RELAY_OWNER_DECODER,
+    RELAY_OWNER_ENCODER,
+
+} relay_owner_t;
+
+typedef struct
+{
+    /* Buffer header of the decoder's output port */
+    OMX_BUFFERHEADERTYPE * p_dec_buf;
+
+    /* Buffer header of the encoder's input port (same 'pBuffer') */
+    OMX_BUFFERHEADERTYPE * p_enc_buf;
+
+    /* Current owner of the slot ('relay_owner_t') */
+    atomic_int owner;
+
+} relay_slot_t;
+
+typedef struct
+{
+    /* Handles of the decoder and the encoder */
+    OMX_HANDLETYPE dec_handle;
+    OMX_HANDLETYPE enc_handle;
+
+    /* Slots (pairs of buffer headers sharing the same memory) */
+    relay_slot_t slots[RELAY_MAX_SLOTS];
+    uint32_t slot_count;
+
+    /* Slots returned by the decoder, to be sent to the encoder */
+    queue_t decoded_queue;
+
+    /* Slots returned by the encoder, to be sent back to the decoder */
+    queue_t encoded_queue;
+
+    /* Post this semaphore whenever a slot is added to a queue */
+    sem_t smp_slot;
+
+    /* True if the End-of-Stream buffer has been sent to the encoder */
+    bool eos;
+
+    /* True if the relay thread must exit */
+    atomic_bool stop;
+
+    /* Thread which moves slots between the components */
+    pthread_t thread;
+
+    /* Statistics */
+
+    /* The number of frames handed to the encoder without a copy */
+    uint64_t frame_count;
+
+    /* The number of bytes those frames contain */
+    uint64_t frame_bytes;
+
+    /* The highest number of slots owned by the encoder at the same time */
+    uint32_t enc_owned;
+    uint32_t enc_owned_max;
+
+    /* The number of callbacks which returned a slot they did not own */
+    atomic_uint bad_transitions;
+
+} relay_t;
+
+/******************************************************************************
+ *                            FUNCTION DECLARATION                            *
+ ******************************************************************************/
+
+/* Pair the 'count' output buffers of the decoder 'pp_dec_bufs' with the input
+ * buffers of the encoder 'pp_enc_bufs' ('pp_enc_bufs[i]' must use the memory
+ * of 'pp_dec_bufs[i]'). All slots are owned by the relay.
+ * Return true if successful. Otherwise, return false */
+bool relay_init(relay_t * p_relay,
+                OMX_HANDLETYPE dec_handle, OMX_BUFFERHEADERTYPE ** pp_dec_bufs,
+                OMX_HANDLETYPE enc_handle, OMX_BUFFERHEADERTYPE ** pp_enc_bufs,
+                uint32_t count);
+
+/* Start the relay thread and send all slots to the decoder.
+ * Both components must be in state EXECUTING.
+ * Return true if successful. Otherwise, return false */
+bool relay_start(relay_t * p_relay);
+
+/* Called by FillBufferDone of the decoder. It never blocks */
+void relay_on_decoded(relay_t * p_relay, OMX_BUFFERHEADERTYPE * p_dec_buf);
+
+/* Called by EmptyBufferDone of the encoder. It never blocks */
+void relay_on_encoded(relay_t * p_relay, OMX_BUFFERHEADERTYPE * p_enc_buf);
+
+/* Stop the relay thread. From now, returned slots stay with the relay */
+void relay_stop(relay_t * p_relay);
+
+/* Free the queues of 'p_relay' */
+void relay_deinit(relay_t * p_relay);
+
+/* Print statistics of 'p_relay' */
+void relay_print_stats(relay_t * p_relay);
+
+#endif /* _RELAY_H_ */
@@ -0,0 +1,460 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: writer.c
+ *
+ * DESCRIPTION:
+ *   Asynchronous output writer definition.
+ *
+ * NOTE:
+ *   For function usage, please refer to 'writer.h'.
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+/* Needed for 'O_DIRECT' */
+#define _GNU_SOURCE
+
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "writer.h"
+
+/******************************************************************************
+ *                          PRIVATE FUNCTION DECLARATION                      *
+ ******************************************************************************/
+
+/* Get current time (in ns) of the monotonic clock */
+static uint64_t writer_now_ns(void);
+
+/* Make sure the copy thread owns a staging buffer. Wait for the I/O thread
+ * if all staging buffers are being written */
+static writer_stage_t * writer_get_stage(writer_t * p_writer);
+
+/* Pass the staging buffer being filled to the I/O thread */
+static void writer_submit_stage(writer_t * p_writer);
+
+/* Copy 'len' bytes at 'p_src' to staging buffers */
+static void writer_copy(writer_t * p_writer, const uint8_t * p_src, size_t len);
+
+/* Write 'len' bytes at 'p_data' to output file.
+ * Return true if successful. Otherwise, return false */
+static bool writer_write_all(writer_t * p_writer,
+                             const uint8_t * p_data, size_t len);
+
+/* Thread functions */
+static void * writer_copy_thread(void * p_param);
+static void * writer_io_thread(void * p_param);
+
+/******************************************************************************
+ *                            FUNCTION DEFINITION                             *
+ ******************************************************************************/
+
+bool writer_open(writer_t * p_writer, const char * p_file_name,
+                 uint32_t buf_count, size_t stage_size, bool direct_io)
+{
+    uint32_t index = 0;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    /* Check parameters */
+    assert((p_writer != NULL) && (p_file_name != NULL));
+    assert((buf_count > 0) && (stage_size > 0));
+
+    memset(p_writer, 0, sizeof(writer_t));
+
+    p_writer->fd = -1;
+
+    if (direct_io)
+    {
+        p_writer->fd = open(p_file_name,
+                            O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+        if (p_writer->fd < 0)
+        {
+            printf("Warning: 'O_DIRECT' is not supported for '%s'\n",
+                   p_file_name);
+        }
+    }
+
+    p_writer->direct_io = (p_writer->fd >= 0);
+
+    if (p_writer->fd < 0)
+    {
+        p_writer->fd = open(p_file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (p_writer->fd < 0)
+        {
+            printf("Error: Failed to open '%s'\n", p_file_name);
+            return false;
+        }
+    }
+
+    /* 'O_DIRECT' requires page-aligned addresses and lengths */
+    p_writer->stage_size = ROUND_UP(stage_size, page_size);
+
+    for (index = 0; index < WRITER_STAGE_COUNT; index++)
+    {
+        if (posix_memalign((void **)&p_writer->stages[index].p_data,
+                           page_size, p_writer->stage_size) != 0)
+        {
+            printf("Error: Failed to allocate staging buffer '%d'\n", index);
+            writer_close(p_writer);
+            return false;
+        }
+    }
+
+    if (!queue_init(&p_writer->buf_queue, buf_count))
+    {
+        printf("Error: Failed to allocate queue of writer\n");
+        writer_close(p_writer);
+        return false;
+    }
+
+    sem_init(&p_writer->smp_buf, 0, 0);
+    sem_init(&p_writer->smp_stage_full, 0, 0);
+    sem_init(&p_writer->smp_stage_free, 0, WRITER_STAGE_COUNT);
+
+    atomic_init(&p_writer->stop, false);
+
+    return true;
+}
+
+bool writer_start(writer_t * p_writer,
+                  writer_release_fn release_fn, void * p_release_ctx)
+{
+    /* Check parameters */
+    assert((p_writer != NULL) && (release_fn != NULL));
+
+    p_writer->release_fn    = release_fn;
+    p_writer->p_release_ctx = p_release_ctx;
+
+    if (pthread_create(&p_writer->io_thread, NULL,
+                       writer_io_thread, p_writer) != 0)
+    {
+        printf("Error: Failed to create I/O thread of writer\n");
+        return false;
+    }
+
+    if (pthread_create(&p_writer->copy_thread, NULL,
+                       writer_copy_thread, p_writer) != 0)
+    {
+        printf("Error: Failed to create copy thread of writer\n");
+
+        /* Let the I/O thread exit with an empty staging buffer */
+        p_writer->stages[0].len = 0;
+        sem_post(&p_writer->smp_stage_full);
+        pthread_join(p_writer->io_thread, NULL);
+
+        p_writer->release_fn = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+void writer_push(writer_t * p_writer, OMX_BUFFERHEADERTYPE * p_buf)
+{
+    /* Check parameters */
+    assert((p_writer != NULL) && (p_buf != NULL));
+
+    /* The queue is never full because it can hold all output buffers */
+    assert(queue_push(&p_writer->buf_queue, p_buf));
+    sem_post(&p_writer->smp_buf);
+}
+
+bool writer_close(writer_t * p_writer)
+{
+    uint32_t index = 0;
+
+    /* Check parameter */
+    assert(p_writer != NULL);
+
+    if (p_writer->release_fn != NULL)
+    {
+        /* The copy thread drains the queue, submits the last staging buffer
+         * and then asks the I/O thread to exit */
+        atomic_store(&p_writer->stop, true);
+        sem_post(&p_writer->smp_buf);
+
+        pthread_join(p_writer->copy_thread, NULL);
+        pthread_join(p_writer->io_thread, NULL);
+
+        p_writer->release_fn = NULL;
+    }
+
+    if (p_writer->buf_queue.pp_items != NULL)
+    {
+        queue_deinit(&p_writer->buf_queue);
+
+        sem_destroy(&p_writer->smp_buf);
+        sem_destroy(&p_writer->smp_stage_full);
+        sem_destroy(&p_writer->smp_stage_free);
+    }
+
+    for (index = 0; index < WRITER_STAGE_COUNT; index++)
+    {
+        free(p_writer->stages[index].p_data);
+        p_writer->stages[index].p_data = NULL;
+    }
+
+    if (p_writer->fd >= 0)
+    {
+        /* Data written through the page cache may only fail now */
+        if (close(p_writer->fd) != 0)
+        {
+            printf("Error: Failed to close output file (errno %d)\n", errno);
+            p_writer->write_failed = true;
+        }
+
+        p_writer->fd = -1;
+    }
+
+    return !p_writer->write_failed;
+}
+
+void writer_print_stats(writer_t * p_writer)
+{
+    writer_stats_t * p_stats = NULL;
+
+    /* Check parameter */
+    assert(p_writer != NULL);
+
+    p_stats = &p_writer->stats;
+
+    printf("Writer: %llu buffers, queue depth avg %.2f / max %u\n",
+           (unsigned long long)p_stats->buf_count,
+           (p_stats->buf_count > 0) ?
+           (double)p_stats->queue_depth_sum / p_stats->buf_count : 0.0,
+           p_stats->queue_depth_max);
+
+    printf("Writer: %llu writes, %llu bytes, write time %.3f ms / max %.3f ms\n",
+           (unsigned long long)p_stats->write_count,
+           (unsigned long long)p_stats->write_bytes,
+           p_stats->write_ns / 1e6, p_stats->write_ns_max / 1e6);
+
+    printf("Writer: stall time %.3f ms / max %.3f ms%s\n",
+           p_stats->stall_ns / 1e6, p_stats->stall_ns_max / 1e6,
+           p_writer->direct_io ? " (O_DIRECT)" : "");
+}
+
+/******************************************************************************
+ *                        PRIVATE FUNCTION DEFINITION                         *
+ ******************************************************************************/
+
+static uint64_t writer_now_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static writer_stage_t * writer_get_stage(writer_t * p_writer)
+{
+    uint64_t start_ns = 0;
+    uint64_t stall_ns = 0;
+
+    if (!p_writer->fill_busy)
+    {
+        if (sem_trywait(&p_writer->smp_stage_free) != 0)
+        {
+            /* All staging buffers are being written, so the storage is
+             * holding the pipeline back */
+            start_ns = writer_now_ns();
+            sem_wait(&p_writer->smp_stage_free);
+            stall_ns = writer_now_ns() - start_ns;
+
+            p_writer->stats.stall_ns += stall_ns;
+            if (stall_ns > p_writer->stats.stall_ns_max)
+            {
+                p_writer->stats.stall_ns_max = stall_ns;
+            }
+        }
+
+        p_writer->stages[p_writer->fill_idx].len = 0;
+        p_writer->fill_busy = true;
+    }
+
+    return &p_writer->stages[p_writer->fill_idx];
+}
+
+static void writer_submit_stage(writer_t * p_writer)
+{
+    p_writer->fill_busy = false;
+    p_writer->fill_idx  = (p_writer->fill_idx + 1) % WRITER_STAGE_COUNT;
+
+    sem_post(&p_writer->smp_stage_full);
+}
+
+static void writer_copy(writer_t * p_writer, const uint8_t * p_src, size_t len)
+{
+    size_t chunk = 0;
+    writer_stage_t * p_stage = NULL;
+
+    while (len > 0)
+    {
+        p_stage = writer_get_stage(p_writer);
+
+        chunk = p_writer->stage_size - p_stage->len;
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+
+        memcpy(p_stage->p_data + p_stage->len, p_src, chunk);
+
+        p_stage->len += chunk;
+        p_src        += chunk;
+        len          -= chunk;
+
+        if (p_stage->len == p_writer->stage_size)
+        {
+            writer_submit_stage(p_writer);
+        }
+    }
+}
+
+static bool writer_write_all(writer_t * p_writer,
+                             const uint8_t * p_data, size_t len)
+{
+    bool is_success = true;
+
+    ssize_t ret = 0;
+    int flags   = 0;
+
+    if (p_writer->direct_io && ((len % p_writer->stage_size) != 0))
+    {
+        /* Only the last staging buffer can be partially filled. Its length
+         * may not be aligned, so write it through the page cache */
+        flags = fcntl(p_writer->fd, F_GETFL);
+        fcntl(p_writer->fd, F_SETFL, flags & ~O_DIRECT);
+    }
+
+    while (len > 0)
+    {
+        ret = write(p_writer->fd, p_data, len);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            printf("Error: Failed to write output file (errno %d)\n", errno);
+            is_success = false;
+            break;
+        }
+
+        p_data += ret;
+        len    -= (size_t)ret;
+    }
+
+    if ((flags != -1) && ((flags & O_DIRECT) != 0))
+    {
+        /* Bypass the page cache again for the next staging buffers */
+        fcntl(p_writer->fd, F_SETFL, flags);
+    }
+
+    return is_success;
+}
+
+static void * writer_copy_thread(void * p_param)
+{
+    writer_t * p_writer = (writer_t *)p_param;
+    writer_stage_t * p_stage = NULL;
+
+    OMX_BUFFERHEADERTYPE * p_buf = NULL;
+    uint32_t depth = 0;
+
+    while (true)
+    {
+        sem_wait(&p_writer->smp_buf);
+
+        depth = queue_size(&p_writer->buf_queue);
+
+        p_buf = (OMX_BUFFERHEADERTYPE *)queue_pop(&p_writer->buf_queue);
+        if (p_buf == NULL)
+        {
+            if (atomic_load(&p_writer->stop))
+            {
+                break;
+            }
+
+            continue;
+        }
+
+        p_writer->stats.buf_count++;
+        p_writer->stats.queue_depth_sum += depth;
+        if (depth > p_writer->stats.queue_depth_max)
+        {
+            p_writer->stats.queue_depth_max = depth;
+        }
+
+        if (p_buf->nFilledLen > 0)
+        {
+            writer_copy(p_writer, p_buf->pBuffer + p_buf->nOffset,
+                        p_buf->nFilledLen);
+        }
+
+        /* The data is in a staging buffer, so 'p_buf' can be reused */
+        p_writer->release_fn(p_writer->p_release_ctx, p_buf);
+    }
+
+    /* Submit the last (partially filled) staging buffer */
+    if (p_writer->fill_busy && (p_writer->stages[p_writer->fill_idx].len > 0))
+    {
+        writer_submit_stage(p_writer);
+    }
+
+    /* Submit an empty staging buffer to ask the I/O thread to exit */
+    p_stage = writer_get_stage(p_writer);
+    p_stage->len = 0;
+    writer_submit_stage(p_writer);
+
+    return NULL;
+}
+
+static void * writer_io_thread(void * p_param)
+{
+    writer_t * p_writer = (writer_t *)p_param;
+    writer_stage_t * p_stage = NULL;
+
+    uint64_t start_ns = 0;
+    uint64_t write_ns = 0;
+
+    while (true)
+    {
+        sem_wait(&p_writer->smp_stage_full);
+
+        p_stage = &p_writer->stages[p_writer->write_idx];
+        p_writer->write_idx = (p_writer->write_idx + 1) % WRITER_STAGE_COUNT;
+
+        if (p_stage->len == 0)
+        {
+            /* Empty staging buffer: the copy thread has exited */
+            break;
+        }
+
+        start_ns = writer_now_ns();
+        if (!p_writer->write_failed &&
+            !writer_write_all(p_writer, p_stage->p_data, p_stage->len))
+        {
+            p_writer->write_failed = true;
+        }
+        write_ns = writer_now_ns() - start_ns;
+
+        p_writer->stats.write_count++;
+        p_writer->stats.write_bytes += p_stage->len;
+        p_writer->stats.write_ns    += write_ns;
+        if (write_ns > p_writer->stats.write_ns_max)
+        {
+            p_writer->stats.write_ns_max = write_ns;
+        }
+
+        sem_post(&p_writer->smp_stage_free);
+    }
+
+    return NULL;
+}
@@ -0,0 +1,19 @@
+# Copyright (c) 2024 Renesas Electronics Corp.
+# SPDX-License-Identifier: MIT-0
+
+# Build a sample app out of tree with its own Makefile: run it in the build
+# directory with 'make -f app.mk SRC_DIR=<directory of the sample app>'.
+#
+# Only sources are searched in SRC_DIR ('vpath', not 'VPATH'), so the app
+# and the objects already built next to the sources are never picked up.
+# Each build directory gets its own objects, built with its own CPPFLAGS
+
+include $(SRC_DIR)/Makefile
+
+vpath %.c $(SRC_DIR)
+vpath %.h $(SRC_DIR)
+
+# Rebuild objects when a header they include changes
+override CPPFLAGS += -MMD
+
+-include $(OBJS:%.o=%.d)
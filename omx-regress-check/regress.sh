@@ -0,0 +1,246 @@
+#!/bin/sh
+# Copyright (c) 2024 Renesas Electronics Corp.
+# SPDX-License-Identifier: MIT-0
+
+# Performance regression check of the sample apps with the stand-in core.
+#
+# Usage:
+#   regress.sh BUILD STANDIN_DIR ENC_DIR DEC_DIR
+#
+# The apps are built by the Makefile twice: from the working tree in
+# BUILD/cur and from the reference revision in BUILD/ref (encoder in
+# encoder-WIDTHxHEIGHT, decoder in decoder). Each scenario runs 'RUNS' times
+# with option '-b' for each build, alternating the builds so that both see
+# the same load of the host. The median of each metric is kept:
+#   - fps:              frames per second (higher is better).
+#   - latency_p99_ms:   99th percentile of end-to-end latency.
+#   - cpu_ms_per_frame: CPU time of the process per frame.
+#   - peak_rss_kb:      peak resident memory of the process.
+#
+# The script exits with status 1 if a metric of the working tree is worse
+# than the one of the reference by more than its tolerance. Scenarios run in
+# BUILD/run/<build>/<scenario>.
+
+set -e
+
+if [ $# -ne 4 ]; then
+    echo "Usage: $0 BUILD STANDIN_DIR ENC_DIR DEC_DIR"
+    exit 2
+fi
+
+BUILD=$(cd "$1" && pwd)
+STANDIN_DIR=$2
+ENC_DIR=$3
+DEC_DIR=$4
+
+# Processing time (in us) of one frame in the stand-in components
+FRAME_US=${FRAME_US:-0}
+
+# The number of runs of each scenario by each build
+RUNS=${RUNS:-5}
+
+# The number of frames of synthetic input files
+SYNTH_FRAMES=30
+
+# Tolerances (in percent). CPU time varies more than memory between runs on
+# a shared CI host. Without processing time in the stand-in components
+# (FRAME_US=0), p99 latency is a fraction of a millisecond and mostly
+# measures the scheduler of the host: it is only printed
+TOL_FPS=25
+TOL_CPU=25
+TOL_RSS=10
+TOL_P99=50
+
+# Results of this run ('scenario metric reference current' per line)
+RESULTS=$BUILD/results.txt
+
+# Print the metrics of JSON report '$1' ('metric value' per line)
+read_report()
+{
+    sed -n -e 's/^  "fps": \([0-9.]*\),$/fps \1/p'                        \
+           -e 's/^  "latency_ms": {.*"p99": \([0-9.]*\),.*/latency_p99_ms \1/p' \
+           -e 's/^  "cpu_ms_per_frame": \([0-9.]*\),$/cpu_ms_per_frame \1/p' \
+           -e 's/^  "peak_rss_kb": \([0-9]*\),$/peak_rss_kb \1/p' "$1"
+}
+
+# Create file '$3' with synthetic NV12 frames of '$1'x'$2' pixels. Their
+# content does not matter to the stand-in encoder
+make_nv12()
+{
+    if [ ! -f "$3" ]; then
+        dd if=/dev/zero of="$3" bs=$(($1 * $2 * 3 / 2)) \
+           count=$SYNTH_FRAMES 2> /dev/null
+    fi
+}
+
+# Run app '$1' in directory '$2' once and append its metrics to
+# '$2/metrics.txt'
+run_app()
+{
+    if ! (cd "$2" &&
+          STANDIN_FRAME_US=$FRAME_US STANDIN_FILL=0 \
+          LD_LIBRARY_PATH=$STANDIN_DIR "$1" -b report.json \
+          > app.log 2>&1); then
+        echo "Error: Scenario '$(basename "$2")' failed (see '$2/app.log')"
+        exit 1
+    fi
+
+    read_report "$2/report.json" >> "$2/metrics.txt"
+}
+
+# Print the median of each metric of file '$1' ('metric value' per line)
+median()
+{
+    awk '
+        { n[$1]++; v[$1, n[$1]] = $2 }
+        END {
+            split("fps latency_p99_ms cpu_ms_per_frame peak_rss_kb", m, " ")
+            for (i = 1; i <= 4; i++) {
+                k = m[i]
+                if (!(k in n))
+                    continue
+
+                # Insertion sort of the values of metric k
+                for (a = 2; a <= n[k]; a++) {
+                    x = v[k, a]
+                    for (b = a - 1; (b >= 1) && (v[k, b] > x); b--)
+                        v[k, b + 1] = v[k, b]
+                    v[k, b + 1] = x
+                }
+
+                if (n[k] % 2)
+                    med = v[k, (n[k] + 1) / 2]
+                else
+                    med = (v[k, n[k] / 2] + v[k, n[k] / 2 + 1]) / 2
+
+                print k, med
+            }
+        }' "$1"
+}
+
+# Run scenario '$1': app '$2' (path relative to the build directory) reads
+# input file '$3', which is linked in the directory of the run as '$4' (the
+# name the app expects)
+run_scenario()
+{
+    name=$1
+    app=$2
+    input=$3
+
+    if [ ! -f "$input" ]; then
+        echo "Error: Input file '$input' of scenario '$name' is missing"
+        exit 1
+    fi
+
+    for build in ref cur; do
+        dir=$BUILD/run/$build/$name
+
+        mkdir -p "$dir"
+        ln -sf "$(cd "$(dirname "$input")" && pwd)/$(basename "$input")" \
+               "$dir/$4"
+        : > "$dir/metrics.txt"
+    done
+
+    run=1
+    while [ $run -le "$RUNS" ]; do
+        for build in ref cur; do
+            run_app "$BUILD/$build/$app" "$BUILD/run/$build/$name"
+        done
+
+        run=$((run + 1))
+    done
+
+    for build in ref cur; do
+        median "$BUILD/run/$build/$name/metrics.txt" \
+               > "$BUILD/run/$build/$name/median.txt"
+    done
+
+    awk -v name="$name" '
+        FNR == NR { ref[$1] = $2; next }
+        ($1 in ref) { print name, $1, ref[$1], $2 }' \
+        "$BUILD/run/ref/$name/median.txt" "$BUILD/run/cur/$name/median.txt" \
+        >> "$RESULTS"
+
+    echo "Scenario '$name': done"
+}
+
+mkdir -p "$BUILD/inputs"
+: > "$RESULTS"
+
+# Encode: sample file, then synthetic 720p and 1080p frames
+run_scenario encode-640x480 encoder-640x480/encoder \
+             "$ENC_DIR/in-nv12-640x480.raw" in-nv12-640x480.raw
+
+for size in 1280x720 1920x1080; do
+    make_nv12 "${size%x*}" "${size#*x}" "$BUILD/inputs/in-nv12-$size.raw"
+
+    run_scenario "encode-$size" "encoder-$size/encoder" \
+                 "$BUILD/inputs/in-nv12-$size.raw" in-nv12-640x480.raw
+done
+
+# Decode: sample file, then the 720p and 1080p streams of the reference
+# encoder (both decoders read the same streams)
+run_scenario decode-640x480 decoder/decoder \
+             "$DEC_DIR/in-h264-640x480.264" in-h264-640x480.264
+
+for size in 1280x720 1920x1080; do
+    cp "$BUILD/run/ref/encode-$size/out-h264-640x480.264" \
+       "$BUILD/inputs/in-h264-$size.264"
+
+    run_scenario "decode-$size" decoder/decoder \
+                 "$BUILD/inputs/in-h264-$size.264" in-h264-640x480.264
+done
+
+if [ -f "$BUILD/ref-rev.txt" ]; then
+    echo "Reference: $(cat "$BUILD/ref-rev.txt"), $RUNS runs per build" \
+         "(STANDIN_FRAME_US=$FRAME_US)"
+fi
+
+printf "%-17s %-18s %12s %12s %8s  %s\n" scenario metric reference current \
+       change status
+
+awk -v fps=$TOL_FPS -v cpu=$TOL_CPU -v rss=$TOL_RSS -v p99=$TOL_P99 \
+    -v frame_us="$FRAME_US" '
+    {
+        if ($2 == "fps")
+            tol = fps
+        else if ($2 == "cpu_ms_per_frame")
+            tol = cpu
+        else if ($2 == "peak_rss_kb")
+            tol = rss
+        else if (frame_us > 0)
+            tol = p99
+        else
+            tol = -1
+
+        change = ($3 > 0) ? (($4 - $3) * 100 / $3) : 0
+
+        if (tol < 0)
+            bad = 0
+        else if ($2 == "fps")
+            bad = ($4 < ($3 * (1 - (tol / 100))))
+        else
+            bad = ($4 > ($3 * (1 + (tol / 100))))
+
+        if (bad)
+            fail = 1
+
+        printf "%-17s %-18s %12s %12s %+7.1f%%  %s\n", $1, $2, $3, $4,
+               change, bad ? "REGRESSION" : ((tol < 0) ? "info" : "ok")
+    }
+    END {
+        if (NR == 0) {
+            print "Error: No result"
+            fail = 1
+        }
+
+        exit fail
+    }' "$RESULTS" && status=0 || status=1
+
+if [ $status -ne 0 ]; then
+    echo "Performance regression check: FAILED"
+else
+    echo "Performance regression check: passed"
+fi
+
+exit $status
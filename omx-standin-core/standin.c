@@ -0,0 +1,2081 @@
+/* Copyright (c) 2024 Renesas Electronics Corp.
+ * SPDX-License-Identifier: MIT-0 */
+
+/*******************************************************************************
+ * FILENAME: standin.c
+ *
+ * DESCRIPTION:
+ *   Software stand-in for the OMX IL core of RZ/G2 boards ('libomxr_core').
+ *
+ *   It emulates the two components used by the sample apps:
+ *     - "OMX.RENESAS.VIDEO.DECODER.H264": H.264 (Annex-B) -> NV12.
+ *     - "OMX.RENESAS.VIDEO.ENCODER.H264": NV12 -> H.264 (Annex-B).
+ *
+ *   No real decoding/encoding is done. Each component has its own thread
+ *   which follows the OMX IL state machine, processes one frame per
+ *   'STANDIN_FRAME_US' microseconds and calls the application's callbacks.
+ *   The decoder parses SPS headers and sends 'OMX_EventPortSettingsChanged'
+ *   when the resolution of the stream differs from its output port. The
+ *   encoder produces a valid Annex-B layout (SPS, PPS and slice NAL units)
+ *   whose size follows the configured bitrate, so its output can be fed to
+ *   the decoder.
+ *
+ *   Environment variables:
+ *     STANDIN_FRAME_US: Processing time of one frame (default: 0).
+ *     STANDIN_FILL:     Set to 0 to leave the pixels of decoded frames
+ *                       untouched (default: 1, write a test pattern).
+ *
+ * AUTHOR: RVC       START DATE: 16/10/2026
+ *
+ ******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <OMX_Core.h>
+#include <OMX_Component.h>
+#include <OMXR_Extension_h264e.h>
+
+/******************************************************************************
+ *                              MACRO VARIABLES                               *
+ ******************************************************************************/
+
+#define STANDIN_DECODER_NAME "OMX.RENESAS.VIDEO.DECODER.H264"
+#define STANDIN_ENCODER_NAME "OMX.RENESAS.VIDEO.ENCODER.H264"
+
+/* Maximum number of buffers per port */
+#define STANDIN_MAX_BUFFERS 64
+
+/* Maximum number of pending commands */
+#define STANDIN_MAX_COMMANDS 16
+
+/* Default resolution of both components */
+#define STANDIN_DEFAULT_WIDTH  1920
+#define STANDIN_DEFAULT_HEIGHT 1080
+
+/* Size of buffers of the compressed ports */
+#define STANDIN_STREAM_BUF_SIZE (2 * 1024 * 1024)
+
+/* Alignment of buffers allocated by the components */
+#define STANDIN_BUF_ALIGN 4096
+
+/******************************************************************************
+ *                              FUNCTION MACROS                               *
+ ******************************************************************************/
+
+#define STANDIN_ROUND_UP(VAL, RND) (((VAL) + (RND) - 1) & (~((RND) - 1)))
+
+#define STANDIN_INIT_STRUCTURE(P_STRUCT)                            \
+{                                                                   \
+    memset((P_STRUCT), 0, sizeof(*(P_STRUCT)));                     \
+                                                                    \
+    (P_STRUCT)->nSize = sizeof(*(P_STRUCT));                        \
+                                                                    \
+    (P_STRUCT)->nVersion.s.nVersionMajor = OMX_VERSION_MAJOR;       \
+    (P_STRUCT)->nVersion.s.nVersionMinor = OMX_VERSION_MINOR;       \
+    (P_STRUCT)->nVersion.s.nRevision     = OMX_VERSION_REVISION;    \
+    (P_STRUCT)->nVersion.s.nStep         = OMX_VERSION_STEP;        \
+}
+
+/******************************************************************************
+ *                                 STRUCTURES                                 *
+ ******************************************************************************/
+
+typedef struct
+{
+    /* Port definition returned by 'OMX_GetParameter' */
+    OMX_PARAM_PORTDEFINITIONTYPE def;
+
+    /* Buffer headers allocated on the port */
+    OMX_BUFFERHEADERTYPE * p_hdrs[STANDIN_MAX_BUFFERS];
+
+    /* True if 'pBuffer' of the header was allocated by the component */
+    bool own_data[STANDIN_MAX_BUFFERS];
+
+    /* The number of headers in 'p_hdrs' */
+    uint32_t hdr_count;
+
+    /* FIFO of buffers currently owned by the component */
+    OMX_BUFFERHEADERTYPE * p_fifo[STANDIN_MAX_BUFFERS];
+    uint32_t fifo_head;
+    uint32_t fifo_len;
+
+} standin_port_t;
+
+typedef struct
+{
+    OMX_COMMANDTYPE cmd;
+    OMX_U32 param;
+
+} standin_cmd_t;
+
+typedef struct
+{
+    /* Handle given to the application */
+    OMX_COMPONENTTYPE * p_comp;
+
+    /* True for the encoder, false for the decoder */
+    bool is_encoder;
+
+    /* Current state */
+    OMX_STATETYPE state;
+
+    /* Application's callbacks */
+    OMX_CALLBACKTYPE callbacks;
+    OMX_PTR p_app_data;
+
+    /* Port 0 (input) and port 1 (output) */
+    standin_port_t ports[2];
+
+    /* Commands sent by 'OMX_SendCommand' and not started yet */
+    standin_cmd_t cmds[STANDIN_MAX_COMMANDS];
+    uint32_t cmd_head;
+    uint32_t cmd_len;
+
+    /* Command which has started but waits for buffers to be (de)allocated */
+    bool cmd_active;
+    standin_cmd_t active;
+
+    /* Thread of the component */
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool quit;
+
+    /* Emulation settings */
+    uint32_t frame_us;
+    bool fill;
+
+    /* The number of frames produced */
+    uint32_t frame_count;
+
+    /* Decoder: 'OMX_EventPortSettingsChanged' is sent and output port has
+     * not been re-enabled yet */
+    bool settings_pending;
+
+    /* Encoder settings */
+    OMX_VIDEO_PARAM_BITRATETYPE bitrate;
+    OMX_VIDEO_PARAM_AVCTYPE avc;
+    OMX_VIDEO_PARAM_INTRAREFRESHTYPE intra_refresh;
+    OMXR_MC_VIDEO_PARAM_AVC_VUI_PROPERTY vui;
+    OMX_U32 x_encode_framerate;
+
+    /* Encoder: an IDR frame is requested by the application */
+    bool idr_request;
+
+    /* Encoder: the number of frames since the last IDR frame */
+    uint32_t frames_since_idr;
+
+    /* Encoder: index of the next slice of the current frame */
+    uint32_t slice_idx;
+
+} standin_t;
+
+typedef struct
+{
+    /* Output data */
+    uint8_t * p_data;
+    uint32_t cap;
+    uint32_t len;
+
+    /* Bits not yet written to 'p_data' */
+    uint32_t acc;
+    uint32_t acc_bits;
+
+    /* The number of consecutive zero bytes written (for emulation
+     * prevention) */
+    uint32_t zeros;
+
+} standin_bitwriter_t;
+
+typedef struct
+{
+    const uint8_t * p_data;
+    uint32_t len;
+    uint32_t pos;
+    uint32_t bit;
+    uint32_t zeros;
+
+} standin_bitreader_t;
+
+/******************************************************************************
+ *                              PRIVATE VARIABLES                             *
+ ******************************************************************************/
+
+static pthread_mutex_t g_core_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t g_core_refs = 0;
+
+static const char * g_component_names[] =
+{
+    STANDIN_DECODER_NAME,
+    STANDIN_ENCODER_NAME,
+};
+
+/******************************************************************************
+ *                              BIT STREAM HELPERS                            *
+ ******************************************************************************/
+
+static void bw_byte(standin_bitwriter_t * p_bw, uint8_t byte, bool escape)
+{
+    if (escape && (p_bw->zeros >= 2) && (byte <= 3) && (p_bw->len < p_bw->cap))
+    {
+        /* Emulation prevention byte */
+        p_bw->p_data[p_bw->len++] = 0x03;
+        p_bw->zeros = 0;
+    }
+
+    if (p_bw->len < p_bw->cap)
+    {
+        p_bw->p_data[p_bw->len++] = byte;
+    }
+
+    p_bw->zeros = (byte == 0) ? (p_bw->zeros + 1) : 0;
+}
+
+static void bw_bits(standin_bitwriter_t * p_bw, uint32_t value, uint32_t bits)
+{
+    while (bits > 0)
+    {
+        bits--;
+
+        p_bw->acc = (p_bw->acc << 1) | ((value >> bits) & 1);
+        p_bw->acc_bits++;
+
+        if (p_bw->acc_bits == 8)
+        {
+            bw_byte(p_bw, (uint8_t)p_bw->acc, true);
+
+            p_bw->acc = 0;
+            p_bw->acc_bits = 0;
+        }
+    }
+}
+
+static void bw_ue(standin_bitwriter_t * p_bw, uint32_t value)
+{
+    uint32_t code = value + 1;
+    uint32_t bits = 0;
+
+    while ((code >> bits) > 1)
+    {
+        bits++;
+    }
+
+    bw_bits(p_bw, 0, bits);
+    bw_bits(p_bw, code, bits + 1);
+}
+
+static void bw_trailing(standin_bitwriter_t * p_bw)
+{
+    bw_bits(p_bw, 1, 1);
+
+    while (p_bw->acc_bits != 0)
+    {
+        bw_bits(p_bw, 0, 1);
+    }
+}
+
+static void bw_start_nal(standin_bitwriter_t * p_bw, uint8_t nal_header)
+{
+    bw_byte(p_bw, 0x00, false);
+    bw_byte(p_bw, 0x00, false);
+    bw_byte(p_bw, 0x00, false);
+    bw_byte(p_bw, 0x01, false);
+    bw_byte(p_bw, nal_header, false);
+
+    p_bw->zeros = 0;
+}
+
+static uint32_t br_bit(standin_bitreader_t * p_br)
+{
+    uint8_t byte = 0;
+    uint32_t value = 0;
+
+    if (p_br->pos >= p_br->len)
+    {
+        return 0;
+    }
+
+    if ((p_br->bit == 0) && (p_br->zeros >= 2) &&
+        (p_br->p_data[p_br->pos] == 3))
+    {
+        /* Skip emulation prevention byte */
+        p_br->pos++;
+        p_br->zeros = 0;
+
+        if (p_br->pos >= p_br->len)
+        {
+            return 0;
+        }
+    }
+
+    byte  = p_br->p_data[p_br->pos];
+    value = (byte >> (7 - p_br->bit)) & 1;
+
+    if (++p_br->bit == 8)
+    {
+        p_br->bit = 0;
+        p_br->pos++;
+        p_br->zeros = (byte == 0) ? (p_br->zeros + 1) : 0;
+    }
+
+    return value;
+}
+
+static uint32_t br_bits(standin_bitreader_t * p_br, uint32_t bits)
+{
+    uint32_t value = 0;
+
+    while (bits-- > 0)
+    {
+        value = (value << 1) | br_bit(p_br);
+    }
+
+    return value;
+}
+
+static uint32_t br_ue(standin_bitreader_t * p_br)
+{
+    uint32_t zeros = 0;
+
+    while ((br_bit(p_br) == 0) && (zeros < 32) && (p_br->pos < p_br->len))
+    {
+        zeros++;
+    }
+
+    return ((1u << zeros) - 1) + br_bits(p_br, zeros);
+}
+
+static int32_t br_se(standin_bitreader_t * p_br)
+{
+    uint32_t code = br_ue(p_br);
+
+    return (code & 1) ? (int32_t)((code + 1) / 2) : -(int32_t)(code / 2);
+}
+
+static void br_skip_scaling_list(standin_bitreader_t * p_br, uint32_t size)
+{
+    int32_t last = 8;
+    int32_t next = 8;
+    uint32_t index = 0;
+
+    for (index = 0; index < size; index++)
+    {
+        if (next != 0)
+        {
+            next = (last + br_se(p_br) + 256) % 256;
+        }
+
+        last = (next == 0) ? last : next;
+    }
+}
+
+/* Parse the SPS at 'p_rbsp' (after the NAL header).
+ * Return true and the cropped resolution if successful */
+static bool standin_parse_sps(const uint8_t * p_rbsp, uint32_t len,
+                              uint32_t * p_width, uint32_t * p_height)
+{
+    standin_bitreader_t br = { p_rbsp, len, 0, 0, 0 };
+
+    uint32_t profile_idc = 0;
+    uint32_t chroma_format_idc = 1;
+    uint32_t index = 0;
+    uint32_t poc_type = 0;
+    uint32_t width_mbs = 0;
+    uint32_t height_units = 0;
+    uint32_t frame_mbs_only = 0;
+    uint32_t crop[4] = { 0, 0, 0, 0 };
+
+    profile_idc = br_bits(&br, 8);
+    br_bits(&br, 16);   /* constraint flags, level_idc */
+    br_ue(&br);         /* seq_parameter_set_id */
+
+    if ((profile_idc == 100) || (profile_idc == 110) || (profile_idc == 122) ||
+        (profile_idc == 244) || (profile_idc == 44)  || (profile_idc == 83)  ||
+        (profile_idc == 86)  || (profile_idc == 118) || (profile_idc == 128) ||
+        (profile_idc == 138) || (profile_idc == 139) || (profile_idc == 134) ||
+        (profile_idc == 135))
+    {
+        chroma_format_idc = br_ue(&br);
+        if (chroma_format_idc == 3)
+        {
+            br_bits(&br, 1);    /* separate_colour_plane_flag */
+        }
+
+        br_ue(&br);             /* bit_depth_luma_minus8 */
+        br_ue(&br);             /* bit_depth_chroma_minus8 */
+        br_bits(&br, 1);        /* qpprime_y_zero_transform_bypass_flag */
+
+        if (br_bits(&br, 1))    /* seq_scaling_matrix_present_flag */
+        {
+            uint32_t list_count = (chroma_format_idc != 3) ? 8 : 12;
+
+            for (index = 0; index < list_count; index++)
+            {
+                if (br_bits(&br, 1))
+                {
+                    br_skip_scaling_list(&br, (index < 6) ? 16 : 64);
+                }
+            }
+        }
+    }
+
+    br_ue(&br);                 /* log2_max_frame_num_minus4 */
+
+    poc_type = br_ue(&br);
+    if (poc_type == 0)
+    {
+        br_ue(&br);             /* log2_max_pic_order_cnt_lsb_minus4 */
+    }
+    else if (poc_type == 1)
+    {
+        br_bits(&br, 1);
+        br_se(&br);
+        br_se(&br);
+
+        for (index = br_ue(&br); index > 0; index--)
+        {
+            br_se(&br);
+        }
+    }
+
+    br_ue(&br);                 /* max_num_ref_frames */
+    br_bits(&br, 1);            /* gaps_in_frame_num_value_allowed_flag */
+
+    width_mbs      = br_ue(&br) + 1;
+    height_units   = br_ue(&br) + 1;
+    frame_mbs_only = br_bits(&br, 1);
+
+    if (!frame_mbs_only)
+    {
+        br_bits(&br, 1);        /* mb_adaptive_frame_field_flag */
+    }
+
+    br_bits(&br, 1);            /* direct_8x8_inference_flag */
+
+    if (br_bits(&br, 1))        /* frame_cropping_flag */
+    {
+        for (index = 0; index < 4; index++)
+        {
+            crop[index] = br_ue(&br);
+        }
+    }
+
+    if (br.pos >= br.len)
+    {
+        return false;
+    }
+
+    *p_width  = (width_mbs * 16) - ((crop[0] + crop[1]) * 2);
+    *p_height = ((2 - frame_mbs_only) * height_units * 16) -
+                ((crop[2] + crop[3]) * 2 * (2 - frame_mbs_only));
+
+    return (*p_width > 0) && (*p_height > 0);
+}
+
+/* Find the next NAL unit in 'p_data'. Return its offset (after the start
+ * code) or 'len' if there is none */
+static uint32_t standin_next_nal(const uint8_t * p_data, uint32_t len,
+                                 uint32_t pos)
+{
+    while ((pos + 3) <= len)
+    {
+        if ((p_data[pos] == 0) && (p_data[pos + 1] == 0) &&
+            (p_data[pos + 2] == 1))
+        {
+            return pos + 3;
+        }
+
+        pos++;
+    }
+
+    return len;
+}
+
+/******************************************************************************
+ *                            COMPONENT HELPERS                               *
+ ******************************************************************************/
+
+static void standin_update_raw_port(OMX_PARAM_PORTDEFINITIONTYPE * p_def,
+                                    uint32_t slice_align)
+{
+    OMX_VIDEO_PORTDEFINITIONTYPE * p_video = &p_def->format.video;
+
+    if (p_video->nStride < (OMX_S32)p_video->nFrameWidth)
+    {
+        p_video->nStride = STANDIN_ROUND_UP(p_video->nFrameWidth, 32);
+    }
+
+    if (p_video->nSliceHeight < p_video->nFrameHeight)
+    {
+        p_video->nSliceHeight = STANDIN_ROUND_UP(p_video->nFrameHeight,
+                                                 slice_align);
+    }
+
+    p_def->nBufferSize = (p_video->nStride * p_video->nSliceHeight * 3) / 2;
+}
+
+static void standin_init_port(standin_t * p_st, OMX_U32 port_idx, bool raw)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE * p_def = &p_st->ports[port_idx].def;
+
+    STANDIN_INIT_STRUCTURE(p_def);
+
+    p_def->nPortIndex         = port_idx;
+    p_def->eDir               = (port_idx == 0) ? OMX_DirInput : OMX_DirOutput;
+    p_def->nBufferCountMin    = 2;
+    p_def->nBufferCountActual = 2;
+    p_def->bEnabled           = OMX_TRUE;
+    p_def->eDomain            = OMX_PortDomainVideo;
+    p_def->nBufferAlignment   = STANDIN_BUF_ALIGN;
+    p_def->bBuffersContiguous = OMX_TRUE;
+
+    p_def->format.video.nFrameWidth  = STANDIN_DEFAULT_WIDTH;
+    p_def->format.video.nFrameHeight = STANDIN_DEFAULT_HEIGHT;
+    p_def->format.video.xFramerate   = 30 << 16;
+
+    if (raw)
+    {
+        p_def->format.video.eCompressionFormat = OMX_VIDEO_CodingUnused;
+        p_def->format.video.eColorFormat = OMX_COLOR_FormatYUV420SemiPlanar;
+
+        /* The decoder aligns the height of its output to macroblocks */
+        standin_update_raw_port(p_def, p_st->is_encoder ? 2 : 16);
+    }
+    else
+    {
+        p_def->format.video.eCompressionFormat = OMX_VIDEO_CodingAVC;
+        p_def->format.video.eColorFormat = OMX_COLOR_FormatUnused;
+        p_def->nBufferSize = STANDIN_STREAM_BUF_SIZE;
+    }
+}
+
+/* Call the event handler without holding the lock */
+static void standin_event(standin_t * p_st, OMX_EVENTTYPE event,
+                          OMX_U32 data1, OMX_U32 data2)
+{
+    pthread_mutex_unlock(&p_st->mutex);
+    p_st->callbacks.EventHandler(p_st->p_comp, p_st->p_app_data,
+                                 event, data1, data2, NULL);
+    pthread_mutex_lock(&p_st->mutex);
+}
+
+/* Return 'p_hdr' to the application without holding the lock */
+static void standin_return(standin_t * p_st, OMX_U32 port_idx,
+                           OMX_BUFFERHEADERTYPE * p_hdr)
+{
+    pthread_mutex_unlock(&p_st->mutex);
+
+    if (port_idx == 0)
+    {
+        p_st->callbacks.EmptyBufferDone(p_st->p_comp, p_st->p_app_data, p_hdr);
+    }
+    else
+    {
+        p_st->callbacks.FillBufferDone(p_st->p_comp, p_st->p_app_data, p_hdr);
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+}
+
+static OMX_BUFFERHEADERTYPE * standin_fifo_peek(standin_port_t * p_port)
+{
+    return (p_port->fifo_len > 0) ? p_port->p_fifo[p_port->fifo_head] : NULL;
+}
+
+static OMX_BUFFERHEADERTYPE * standin_fifo_pop(standin_port_t * p_port)
+{
+    OMX_BUFFERHEADERTYPE * p_hdr = standin_fifo_peek(p_port);
+
+    if (p_hdr != NULL)
+    {
+        p_port->fifo_head = (p_port->fifo_head + 1) % STANDIN_MAX_BUFFERS;
+        p_port->fifo_len--;
+    }
+
+    return p_hdr;
+}
+
+/* Give back all buffers of port 'port_idx' held by the component */
+static void standin_return_all(standin_t * p_st, OMX_U32 port_idx)
+{
+    OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+
+    while ((p_hdr = standin_fifo_pop(&p_st->ports[port_idx])) != NULL)
+    {
+        if (port_idx == 1)
+        {
+            p_hdr->nFilledLen = 0;
+        }
+
+        standin_return(p_st, port_idx, p_hdr);
+    }
+}
+
+static bool standin_populated(standin_port_t * p_port)
+{
+    return (p_port->def.bEnabled == OMX_FALSE) ||
+           (p_port->hdr_count >= p_port->def.nBufferCountActual);
+}
+
+static void standin_start_cmd(standin_t * p_st, standin_cmd_t * p_cmd)
+{
+    OMX_STATETYPE target = (OMX_STATETYPE)p_cmd->param;
+
+    switch (p_cmd->cmd)
+    {
+        case OMX_CommandStateSet:
+        {
+            if (target == p_st->state)
+            {
+                standin_event(p_st, OMX_EventError,
+                              (OMX_U32)OMX_ErrorSameState, 0);
+                return;
+            }
+
+            if (target == OMX_StateIdle)
+            {
+                /* Executing/Pause -> Idle: return all buffers */
+                standin_return_all(p_st, 0);
+                standin_return_all(p_st, 1);
+            }
+        }
+        break;
+
+        case OMX_CommandPortDisable:
+        case OMX_CommandFlush:
+        {
+            if (p_cmd->param < 2)
+            {
+                if (p_cmd->cmd == OMX_CommandPortDisable)
+                {
+                    p_st->ports[p_cmd->param].def.bEnabled = OMX_FALSE;
+                }
+
+                standin_return_all(p_st, p_cmd->param);
+            }
+        }
+        break;
+
+        case OMX_CommandPortEnable:
+        {
+            if (p_cmd->param < 2)
+            {
+                p_st->ports[p_cmd->param].def.bEnabled = OMX_TRUE;
+            }
+        }
+        break;
+
+        default:
+        {
+            /* Intentionally left blank */
+        }
+        break;
+    }
+
+    p_st->active     = *p_cmd;
+    p_st->cmd_active = true;
+}
+
+/* Return true if the active command has completed */
+static bool standin_try_complete(standin_t * p_st)
+{
+    standin_cmd_t * p_cmd = &p_st->active;
+    standin_port_t * p_port = NULL;
+    OMX_STATETYPE target = (OMX_STATETYPE)p_cmd->param;
+
+    switch (p_cmd->cmd)
+    {
+        case OMX_CommandStateSet:
+        {
+            if ((p_st->state == OMX_StateLoaded) && (target == OMX_StateIdle))
+            {
+                if (!standin_populated(&p_st->ports[0]) ||
+                    !standin_populated(&p_st->ports[1]))
+                {
+                    return false;
+                }
+            }
+            else if (target == OMX_StateLoaded)
+            {
+                if ((p_st->ports[0].hdr_count > 0) ||
+                    (p_st->ports[1].hdr_count > 0))
+                {
+                    return false;
+                }
+            }
+
+            p_st->state = target;
+        }
+        break;
+
+        case OMX_CommandPortDisable:
+        {
+            if ((p_cmd->param < 2) && (p_st->ports[p_cmd->param].hdr_count > 0))
+            {
+                return false;
+            }
+        }
+        break;
+
+        case OMX_CommandPortEnable:
+        {
+            if (p_cmd->param < 2)
+            {
+                p_port = &p_st->ports[p_cmd->param];
+
+                if ((p_st->state != OMX_StateLoaded) &&
+                    (p_port->hdr_count < p_port->def.nBufferCountActual))
+                {
+                    return false;
+                }
+
+                if (p_cmd->param == 1)
+                {
+                    p_st->settings_pending = false;
+                }
+            }
+        }
+        break;
+
+        default:
+        {
+            /* Intentionally left blank */
+        }
+        break;
+    }
+
+    p_st->cmd_active = false;
+    standin_event(p_st, OMX_EventCmdComplete, p_cmd->cmd, p_cmd->param);
+
+    return true;
+}
+
+/* Write a test pattern (moving gradient) to an NV12 frame */
+static void standin_fill_nv12(standin_t * p_st, OMX_BUFFERHEADERTYPE * p_hdr)
+{
+    OMX_VIDEO_PORTDEFINITIONTYPE * p_video = &p_st->ports[1].def.format.video;
+
+    uint32_t row = 0;
+    uint32_t stride = (uint32_t)p_video->nStride;
+    uint8_t * p_y  = p_hdr->pBuffer + p_hdr->nOffset;
+    uint8_t * p_uv = p_y + (stride * p_video->nSliceHeight);
+
+    for (row = 0; row < p_video->nFrameHeight; row++)
+    {
+        memset(p_y + (row * stride),
+               (uint8_t)(16 + ((row + p_st->frame_count) % 220)),
+               p_video->nFrameWidth);
+    }
+
+    for (row = 0; row < (p_video->nFrameHeight / 2); row++)
+    {
+        memset(p_uv + (row * stride), 128, p_video->nFrameWidth);
+    }
+}
+
+/* Decoder: process the first input buffer.
+ * Return true if some progress was made */
+static bool standin_decode(standin_t * p_st)
+{
+    standin_port_t * p_in  = &p_st->ports[0];
+    standin_port_t * p_out = &p_st->ports[1];
+
+    OMX_BUFFERHEADERTYPE * p_in_hdr  = standin_fifo_peek(p_in);
+    OMX_BUFFERHEADERTYPE * p_out_hdr = NULL;
+    OMX_VIDEO_PORTDEFINITIONTYPE * p_video = &p_out->def.format.video;
+
+    const uint8_t * p_data = NULL;
+    uint32_t len = 0;
+    uint32_t pos = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t nal_type = 0;
+    bool has_picture = false;
+    bool eos = false;
+
+    if ((p_in_hdr == NULL) || p_st->settings_pending)
+    {
+        return false;
+    }
+
+    p_data = p_in_hdr->pBuffer + p_in_hdr->nOffset;
+    len    = p_in_hdr->nFilledLen;
+    eos    = (p_in_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0;
+
+    for (pos = standin_next_nal(p_data, len, 0); pos < len;
+         pos = standin_next_nal(p_data, len, pos))
+    {
+        nal_type = p_data[pos] & 0x1F;
+
+        if ((nal_type == 1) || (nal_type == 5))
+        {
+            has_picture = true;
+        }
+        else if ((nal_type == 7) &&
+                 standin_parse_sps(p_data + pos + 1, len - pos - 1,
+                                   &width, &height) &&
+                 ((width != p_video->nFrameWidth) ||
+                  (height != p_video->nFrameHeight)))
+        {
+            /* New resolution: update output port and wait until
+             * the application reconfigures it */
+            p_video->nFrameWidth  = width;
+            p_video->nFrameHeight = height;
+            p_video->nStride      = STANDIN_ROUND_UP(width, 32);
+            p_video->nSliceHeight = STANDIN_ROUND_UP(height, 16);
+            standin_update_raw_port(&p_out->def, 16);
+
+            p_st->settings_pending = true;
+            standin_event(p_st, OMX_EventPortSettingsChanged, 1, 0);
+
+            return true;
+        }
+    }
+
+    if (has_picture || eos)
+    {
+        /* An output buffer is needed */
+        if ((p_out->def.bEnabled == OMX_FALSE) ||
+            (standin_fifo_peek(p_out) == NULL))
+        {
+            return false;
+        }
+    }
+
+    if (has_picture && (p_st->frame_us > 0))
+    {
+        pthread_mutex_unlock(&p_st->mutex);
+        usleep(p_st->frame_us);
+        pthread_mutex_lock(&p_st->mutex);
+
+        if ((p_st->state != OMX_StateExecuting) ||
+            (standin_fifo_peek(p_in) != p_in_hdr) ||
+            ((has_picture || eos) && (standin_fifo_peek(p_out) == NULL)))
+        {
+            /* Buffers were returned (flush, port disable...) meanwhile */
+            return true;
+        }
+    }
+
+    if (has_picture || eos)
+    {
+        p_out_hdr = standin_fifo_pop(p_out);
+
+        p_out_hdr->nOffset    = 0;
+        p_out_hdr->nFilledLen = 0;
+        p_out_hdr->nFlags     = 0;
+        p_out_hdr->nTimeStamp = p_in_hdr->nTimeStamp;
+
+        if (has_picture)
+        {
+            if (p_st->fill)
+            {
+                standin_fill_nv12(p_st, p_out_hdr);
+            }
+
+            p_out_hdr->nFilledLen = p_out->def.nBufferSize;
+            p_out_hdr->nFlags    |= OMX_BUFFERFLAG_ENDOFFRAME;
+            p_st->frame_count++;
+        }
+
+        if (eos)
+        {
+            p_out_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
+        }
+    }
+
+    standin_fifo_pop(p_in);
+    p_in_hdr->nFilledLen = 0;
+    standin_return(p_st, 0, p_in_hdr);
+
+    if (p_out_hdr != NULL)
+    {
+        standin_return(p_st, 1, p_out_hdr);
+
+        if (eos)
+        {
+            standin_event(p_st, OMX_EventBufferFlag, 1, OMX_BUFFERFLAG_EOS);
+        }
+    }
+
+    return true;
+}
+
+/* Encoder: write SPS and PPS of the configured resolution */
+static void standin_write_headers(standin_t * p_st, standin_bitwriter_t * p_bw)
+{
+    OMX_VIDEO_PORTDEFINITIONTYPE * p_video = &p_st->ports[0].def.format.video;
+
+    uint32_t width_mbs  = (p_video->nFrameWidth + 15) / 16;
+    uint32_t height_mbs = (p_video->nFrameHeight + 15) / 16;
+    uint32_t crop_right  = ((width_mbs * 16) - p_video->nFrameWidth) / 2;
+    uint32_t crop_bottom = ((height_mbs * 16) - p_video->nFrameHeight) / 2;
+
+    /* SPS (baseline profile, level 4.0) */
+    bw_start_nal(p_bw, 0x67);
+    bw_bits(p_bw, 66, 8);
+    bw_bits(p_bw, 0xC0, 8);
+    bw_bits(p_bw, 40, 8);
+    bw_ue(p_bw, 0);                 /* seq_parameter_set_id */
+    bw_ue(p_bw, 0);                 /* log2_max_frame_num_minus4 */
+    bw_ue(p_bw, 2);                 /* pic_order_cnt_type */
+    bw_ue(p_bw, 1);                 /* max_num_ref_frames */
+    bw_bits(p_bw, 0, 1);            /* gaps_in_frame_num_value_allowed_flag */
+    bw_ue(p_bw, width_mbs - 1);
+    bw_ue(p_bw, height_mbs - 1);
+    bw_bits(p_bw, 1, 1);            /* frame_mbs_only_flag */
+    bw_bits(p_bw, 1, 1);            /* direct_8x8_inference_flag */
+
+    if ((crop_right > 0) || (crop_bottom > 0))
+    {
+        bw_bits(p_bw, 1, 1);
+        bw_ue(p_bw, 0);
+        bw_ue(p_bw, crop_right);
+        bw_ue(p_bw, 0);
+        bw_ue(p_bw, crop_bottom);
+    }
+    else
+    {
+        bw_bits(p_bw, 0, 1);
+    }
+
+    bw_bits(p_bw, 0, 1);            /* vui_parameters_present_flag */
+    bw_trailing(p_bw);
+
+    /* PPS */
+    bw_start_nal(p_bw, 0x68);
+    bw_ue(p_bw, 0);                 /* pic_parameter_set_id */
+    bw_ue(p_bw, 0);                 /* seq_parameter_set_id */
+    bw_bits(p_bw, 0, 2);            /* entropy_coding_mode, bottom_field_poc */
+    bw_ue(p_bw, 0);                 /* num_slice_groups_minus1 */
+    bw_ue(p_bw, 0);                 /* num_ref_idx_l0_default_active_minus1 */
+    bw_ue(p_bw, 0);                 /* num_ref_idx_l1_default_active_minus1 */
+    bw_bits(p_bw, 0, 3);            /* weighted_(bi)pred flag and idc */
+    bw_ue(p_bw, 0);                 /* pic_init_qp_minus26 */
+    bw_ue(p_bw, 0);                 /* pic_init_qs_minus26 */
+    bw_ue(p_bw, 0);                 /* chroma_qp_index_offset */
+    bw_bits(p_bw, 4, 3);            /* deblocking_filter_control_present_flag */
+    bw_trailing(p_bw);
+}
+
+/* Encoder: encode the next slice of the first input buffer.
+ * Return true if some progress was made */
+static bool standin_encode(standin_t * p_st)
+{
+    standin_port_t * p_in  = &p_st->ports[0];
+    standin_port_t * p_out = &p_st->ports[1];
+
+    OMX_BUFFERHEADERTYPE * p_in_hdr  = standin_fifo_peek(p_in);
+    OMX_BUFFERHEADERTYPE * p_out_hdr = NULL;
+    OMX_VIDEO_PORTDEFINITIONTYPE * p_video = &p_in->def.format.video;
+
+    standin_bitwriter_t bw;
+
+    uint32_t mbs_per_row = (p_video->nFrameWidth + 15) / 16;
+    uint32_t mb_rows = (p_video->nFrameHeight + 15) / 16;
+    uint32_t slice_count = 1;
+    uint32_t slice_rows = mb_rows;
+    uint32_t frame_bytes = 0;
+    uint32_t slice_bytes = 0;
+    uint32_t fps = 0;
+    bool has_frame = false;
+    bool eos = false;
+    bool idr = false;
+    bool last_slice = true;
+
+    if ((p_in_hdr == NULL) || (p_out->def.bEnabled == OMX_FALSE) ||
+        (standin_fifo_peek(p_out) == NULL))
+    {
+        return false;
+    }
+
+    has_frame = (p_in_hdr->nFilledLen > 0);
+    eos       = (p_in_hdr->nFlags & OMX_BUFFERFLAG_EOS) != 0;
+
+    if (has_frame && (p_st->avc.nSliceHeaderSpacing > 0))
+    {
+        /* 'nSliceHeaderSpacing' is the number of macroblocks per slice */
+        slice_rows  = (p_st->avc.nSliceHeaderSpacing + mbs_per_row - 1) /
+                      mbs_per_row;
+        slice_rows  = (slice_rows == 0) ? 1 : slice_rows;
+        slice_count = (mb_rows + slice_rows - 1) / slice_rows;
+    }
+
+    last_slice = ((p_st->slice_idx + 1) >= slice_count);
+
+    if (has_frame && (p_st->frame_us > 0))
+    {
+        pthread_mutex_unlock(&p_st->mutex);
+        usleep(p_st->frame_us / slice_count);
+        pthread_mutex_lock(&p_st->mutex);
+
+        if ((p_st->state != OMX_StateExecuting) ||
+            (standin_fifo_peek(p_in) != p_in_hdr) ||
+            (standin_fifo_peek(p_out) == NULL))
+        {
+            return true;
+        }
+    }
+
+    p_out_hdr = standin_fifo_pop(p_out);
+
+    p_out_hdr->nOffset    = 0;
+    p_out_hdr->nFilledLen = 0;
+    p_out_hdr->nFlags     = 0;
+    p_out_hdr->nTimeStamp = p_in_hdr->nTimeStamp;
+
+    if (has_frame)
+    {
+        idr = (p_st->frame_count == 0) || p_st->idr_request ||
+              ((p_st->avc.nPFrames > 0) &&
+               (p_st->frames_since_idr > p_st->avc.nPFrames));
+
+        /* Size of the frame from the bitrate (IDR frames are 4 times bigger) */
+        fps = p_st->x_encode_framerate >> 16;
+        fps = (fps == 0) ? 30 : fps;
+
+        frame_bytes = p_st->bitrate.nTargetBitrate / 8 / fps;
+        frame_bytes = idr ? (frame_bytes * 4) : frame_bytes;
+        slice_bytes = (frame_bytes / slice_count) + 16;
+
+        memset(&bw, 0, sizeof(bw));
+        bw.p_data = p_out_hdr->pBuffer;
+        bw.cap    = p_out_hdr->nAllocLen;
+
+        if (idr && (p_st->slice_idx == 0))
+        {
+            standin_write_headers(p_st, &bw);
+        }
+
+        /* Slice header: first_mb_in_slice, slice_type, pps_id, frame_num */
+        bw_start_nal(&bw, idr ? 0x65 : 0x41);
+        bw_ue(&bw, p_st->slice_idx * slice_rows * mbs_per_row);
+        bw_ue(&bw, idr ? 7 : 5);
+        bw_ue(&bw, 0);
+        bw_bits(&bw, p_st->frames_since_idr & 0xF, 4);
+        bw_trailing(&bw);
+
+        /* Slice data (never contains start code emulation) */
+        while ((slice_bytes-- > 0) && (bw.len < bw.cap))
+        {
+            bw_byte(&bw, 0x55, false);
+        }
+
+        p_out_hdr->nFilledLen = bw.len;
+
+        if (idr)
+        {
+            p_out_hdr->nFlags |= OMX_BUFFERFLAG_SYNCFRAME;
+        }
+
+        if (last_slice)
+        {
+            p_out_hdr->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
+        }
+    }
+
+    if (!last_slice)
+    {
+        p_st->slice_idx++;
+        standin_return(p_st, 1, p_out_hdr);
+
+        return true;
+    }
+
+    if (has_frame)
+    {
+        if (idr)
+        {
+            p_st->idr_request = false;
+            p_st->frames_since_idr = 0;
+        }
+
+        p_st->frames_since_idr++;
+        p_st->frame_count++;
+    }
+
+    p_st->slice_idx = 0;
+
+    if (eos)
+    {
+        p_out_hdr->nFlags |= OMX_BUFFERFLAG_EOS;
+    }
+
+    standin_fifo_pop(p_in);
+    p_in_hdr->nFilledLen = 0;
+    standin_return(p_st, 0, p_in_hdr);
+    standin_return(p_st, 1, p_out_hdr);
+
+    if (eos)
+    {
+        standin_event(p_st, OMX_EventBufferFlag, 1, OMX_BUFFERFLAG_EOS);
+    }
+
+    return true;
+}
+
+static void * standin_thread(void * p_param)
+{
+    standin_t * p_st = (standin_t *)p_param;
+    standin_cmd_t cmd;
+    bool progress = false;
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    while (!p_st->quit)
+    {
+        progress = false;
+
+        if (!p_st->cmd_active && (p_st->cmd_len > 0))
+        {
+            cmd = p_st->cmds[p_st->cmd_head];
+            p_st->cmd_head = (p_st->cmd_head + 1) % STANDIN_MAX_COMMANDS;
+            p_st->cmd_len--;
+
+            standin_start_cmd(p_st, &cmd);
+            progress = true;
+        }
+
+        if (p_st->cmd_active && standin_try_complete(p_st))
+        {
+            progress = true;
+        }
+
+        if (p_st->state == OMX_StateExecuting)
+        {
+            if (p_st->is_encoder)
+            {
+                progress |= standin_encode(p_st);
+            }
+            else
+            {
+                progress |= standin_decode(p_st);
+            }
+        }
+
+        if (!progress)
+        {
+            pthread_cond_wait(&p_st->cond, &p_st->mutex);
+        }
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return NULL;
+}
+
+/******************************************************************************
+ *                           COMPONENT METHODS                                *
+ ******************************************************************************/
+
+static standin_t * standin_get(OMX_HANDLETYPE handle)
+{
+    return (standin_t *)((OMX_COMPONENTTYPE *)handle)->pComponentPrivate;
+}
+
+static OMX_ERRORTYPE standin_check_header(OMX_PTR p_struct, OMX_U32 size)
+{
+    if (p_struct == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    if (*(OMX_U32 *)p_struct < size)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE standin_get_version(OMX_HANDLETYPE handle,
+                                         OMX_STRING p_name,
+                                         OMX_VERSIONTYPE * p_comp_version,
+                                         OMX_VERSIONTYPE * p_spec_version,
+                                         OMX_UUIDTYPE * p_uuid)
+{
+    standin_t * p_st = standin_get(handle);
+
+    if (p_name != NULL)
+    {
+        strcpy(p_name, p_st->is_encoder ? STANDIN_ENCODER_NAME :
+                                          STANDIN_DECODER_NAME);
+    }
+
+    if (p_comp_version != NULL)
+    {
+        p_comp_version->nVersion = 0;
+    }
+
+    if (p_spec_version != NULL)
+    {
+        p_spec_version->s.nVersionMajor = OMX_VERSION_MAJOR;
+        p_spec_version->s.nVersionMinor = OMX_VERSION_MINOR;
+        p_spec_version->s.nRevision     = OMX_VERSION_REVISION;
+        p_spec_version->s.nStep         = OMX_VERSION_STEP;
+    }
+
+    if (p_uuid != NULL)
+    {
+        memset(p_uuid, 0, sizeof(OMX_UUIDTYPE));
+    }
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE standin_send_command(OMX_HANDLETYPE handle,
+                                          OMX_COMMANDTYPE cmd,
+                                          OMX_U32 param, OMX_PTR p_data)
+{
+    standin_t * p_st = standin_get(handle);
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+    (void)p_data;
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    if (p_st->cmd_len == STANDIN_MAX_COMMANDS)
+    {
+        ret = OMX_ErrorInsufficientResources;
+    }
+    else
+    {
+        p_st->cmds[(p_st->cmd_head + p_st->cmd_len) % STANDIN_MAX_COMMANDS] =
+            (standin_cmd_t){ cmd, param };
+        p_st->cmd_len++;
+
+        pthread_cond_signal(&p_st->cond);
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_get_parameter(OMX_HANDLETYPE handle,
+                                           OMX_INDEXTYPE index, OMX_PTR p_param)
+{
+    standin_t * p_st = standin_get(handle);
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+    OMX_U32 port_idx = 0;
+
+    if (p_param == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    /* All structures start with 'nSize', 'nVersion' and 'nPortIndex' */
+    port_idx = ((OMX_PARAM_PORTDEFINITIONTYPE *)p_param)->nPortIndex;
+    if (port_idx > 1)
+    {
+        return OMX_ErrorBadPortIndex;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    switch ((int)index)
+    {
+        case OMX_IndexParamPortDefinition:
+        {
+            ret = standin_check_header(p_param,
+                                       sizeof(OMX_PARAM_PORTDEFINITIONTYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                memcpy(p_param, &p_st->ports[port_idx].def,
+                       sizeof(OMX_PARAM_PORTDEFINITIONTYPE));
+            }
+        }
+        break;
+
+        case OMX_IndexParamVideoBitrate:
+        {
+            ret = standin_check_header(p_param,
+                                       sizeof(OMX_VIDEO_PARAM_BITRATETYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                memcpy(p_param, &p_st->bitrate,
+                       sizeof(OMX_VIDEO_PARAM_BITRATETYPE));
+                ((OMX_VIDEO_PARAM_BITRATETYPE *)p_param)->nPortIndex = port_idx;
+            }
+        }
+        break;
+
+        case OMX_IndexParamVideoAvc:
+        {
+            ret = standin_check_header(p_param,
+                                       sizeof(OMX_VIDEO_PARAM_AVCTYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                memcpy(p_param, &p_st->avc, sizeof(OMX_VIDEO_PARAM_AVCTYPE));
+                ((OMX_VIDEO_PARAM_AVCTYPE *)p_param)->nPortIndex = port_idx;
+            }
+        }
+        break;
+
+        case OMX_IndexParamVideoIntraRefresh:
+        {
+            ret = standin_check_header(
+                      p_param, sizeof(OMX_VIDEO_PARAM_INTRAREFRESHTYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                memcpy(p_param, &p_st->intra_refresh,
+                       sizeof(OMX_VIDEO_PARAM_INTRAREFRESHTYPE));
+                ((OMX_VIDEO_PARAM_INTRAREFRESHTYPE *)p_param)->nPortIndex =
+                    port_idx;
+            }
+        }
+        break;
+
+        default:
+        {
+            if (index == OMXR_MC_IndexParamVideoAVCVuiProperty)
+            {
+                ret = standin_check_header(p_param,
+                          sizeof(OMXR_MC_VIDEO_PARAM_AVC_VUI_PROPERTY));
+                if (ret == OMX_ErrorNone)
+                {
+                    memcpy(p_param, &p_st->vui,
+                           sizeof(OMXR_MC_VIDEO_PARAM_AVC_VUI_PROPERTY));
+                }
+            }
+            else
+            {
+                ret = OMX_ErrorUnsupportedIndex;
+            }
+        }
+        break;
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_set_port(standin_t * p_st,
+                                      OMX_PARAM_PORTDEFINITIONTYPE * p_new)
+{
+    standin_port_t * p_port = &p_st->ports[p_new->nPortIndex];
+    OMX_PARAM_PORTDEFINITIONTYPE def = p_port->def;
+    OMX_VIDEO_PORTDEFINITIONTYPE * p_video = &def.format.video;
+    bool raw = (def.format.video.eCompressionFormat == OMX_VIDEO_CodingUnused);
+
+    if ((p_st->state != OMX_StateLoaded) && (def.bEnabled == OMX_TRUE))
+    {
+        return OMX_ErrorIncorrectStateOperation;
+    }
+
+    if ((p_new->nBufferCountActual < def.nBufferCountMin) ||
+        (p_new->nBufferCountActual > STANDIN_MAX_BUFFERS))
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    def.nBufferCountActual = p_new->nBufferCountActual;
+
+    p_video->nFrameWidth  = p_new->format.video.nFrameWidth;
+    p_video->nFrameHeight = p_new->format.video.nFrameHeight;
+    p_video->xFramerate   = p_new->format.video.xFramerate;
+    p_video->nBitrate     = p_new->format.video.nBitrate;
+
+    if (raw)
+    {
+        /* Rules of document 'R01USxxxxEJxxxx_vecmn_v1.0.pdf' */
+        p_video->eColorFormat = p_new->format.video.eColorFormat;
+        p_video->nStride      = p_new->format.video.nStride;
+        p_video->nSliceHeight = p_new->format.video.nSliceHeight & ~1u;
+
+        if ((p_video->nStride % 32) != 0)
+        {
+            return OMX_ErrorBadParameter;
+        }
+
+        if ((p_video->nStride > 0) &&
+            (p_video->nStride < (OMX_S32)p_video->nFrameWidth))
+        {
+            return OMX_ErrorBadParameter;
+        }
+
+        if ((p_video->nSliceHeight > 0) &&
+            (p_video->nSliceHeight < (p_video->nFrameHeight & ~1u)))
+        {
+            return OMX_ErrorBadParameter;
+        }
+
+        standin_update_raw_port(&def, p_st->is_encoder ? 2 : 16);
+    }
+    else
+    {
+        p_video->eCompressionFormat = p_new->format.video.eCompressionFormat;
+    }
+
+    p_port->def = def;
+
+    if (p_st->is_encoder && (p_new->nPortIndex == 0))
+    {
+        /* Output port follows the resolution of input port */
+        p_st->ports[1].def.format.video.nFrameWidth  = p_video->nFrameWidth;
+        p_st->ports[1].def.format.video.nFrameHeight = p_video->nFrameHeight;
+
+        if (p_video->xFramerate != 0)
+        {
+            p_st->x_encode_framerate = p_video->xFramerate;
+        }
+    }
+
+    if (p_st->is_encoder && (p_new->nPortIndex == 1) &&
+        (p_new->format.video.nBitrate != 0))
+    {
+        p_st->bitrate.nTargetBitrate = p_new->format.video.nBitrate;
+    }
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE standin_set_parameter(OMX_HANDLETYPE handle,
+                                           OMX_INDEXTYPE index, OMX_PTR p_param)
+{
+    standin_t * p_st = standin_get(handle);
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+    OMX_U32 port_idx = 0;
+
+    if (p_param == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    port_idx = ((OMX_PARAM_PORTDEFINITIONTYPE *)p_param)->nPortIndex;
+    if (port_idx > 1)
+    {
+        return OMX_ErrorBadPortIndex;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    switch ((int)index)
+    {
+        case OMX_IndexParamPortDefinition:
+        {
+            ret = standin_check_header(p_param,
+                                       sizeof(OMX_PARAM_PORTDEFINITIONTYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                ret = standin_set_port(p_st, p_param);
+            }
+        }
+        break;
+
+        case OMX_IndexParamVideoBitrate:
+        {
+            ret = standin_check_header(p_param,
+                                       sizeof(OMX_VIDEO_PARAM_BITRATETYPE));
+            if ((ret == OMX_ErrorNone) && p_st->is_encoder)
+            {
+                memcpy(&p_st->bitrate, p_param,
+                       sizeof(OMX_VIDEO_PARAM_BITRATETYPE));
+                p_st->ports[1].def.format.video.nBitrate =
+                    p_st->bitrate.nTargetBitrate;
+            }
+        }
+        break;
+
+        case OMX_IndexParamVideoAvc:
+        {
+            ret = standin_check_header(p_param,
+                                       sizeof(OMX_VIDEO_PARAM_AVCTYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                memcpy(&p_st->avc, p_param, sizeof(OMX_VIDEO_PARAM_AVCTYPE));
+            }
+        }
+        break;
+
+        case OMX_IndexParamVideoIntraRefresh:
+        {
+            ret = standin_check_header(
+                      p_param, sizeof(OMX_VIDEO_PARAM_INTRAREFRESHTYPE));
+            if (ret == OMX_ErrorNone)
+            {
+                memcpy(&p_st->intra_refresh, p_param,
+                       sizeof(OMX_VIDEO_PARAM_INTRAREFRESHTYPE));
+            }
+        }
+        break;
+
+        default:
+        {
+            if (index == OMXR_MC_IndexParamVideoAVCVuiProperty)
+            {
+                ret = standin_check_header(p_param,
+                          sizeof(OMXR_MC_VIDEO_PARAM_AVC_VUI_PROPERTY));
+                if (ret == OMX_ErrorNone)
+                {
+                    memcpy(&p_st->vui, p_param,
+                           sizeof(OMXR_MC_VIDEO_PARAM_AVC_VUI_PROPERTY));
+
+                    if (p_st->vui.bTimingInfoPresentFlag &&
+                        (p_st->vui.u32NumUnitsInTick > 0))
+                    {
+                        /* 'u32TimeScale' is twice the framerate */
+                        p_st->x_encode_framerate =
+                            (p_st->vui.u32TimeScale /
+                             (2 * p_st->vui.u32NumUnitsInTick)) << 16;
+                    }
+                }
+            }
+            else
+            {
+                ret = OMX_ErrorUnsupportedIndex;
+            }
+        }
+        break;
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_get_config(OMX_HANDLETYPE handle,
+                                        OMX_INDEXTYPE index, OMX_PTR p_config)
+{
+    standin_t * p_st = standin_get(handle);
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+    if (p_config == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    switch ((int)index)
+    {
+        case OMX_IndexConfigVideoBitrate:
+        {
+            ((OMX_VIDEO_CONFIG_BITRATETYPE *)p_config)->nEncodeBitrate =
+                p_st->bitrate.nTargetBitrate;
+        }
+        break;
+
+        case OMX_IndexConfigVideoFramerate:
+        {
+            ((OMX_CONFIG_FRAMERATETYPE *)p_config)->xEncodeFramerate =
+                p_st->x_encode_framerate;
+        }
+        break;
+
+        case OMX_IndexConfigVideoIntraVOPRefresh:
+        {
+            ((OMX_CONFIG_INTRAREFRESHVOPTYPE *)p_config)->IntraRefreshVOP =
+                p_st->idr_request ? OMX_TRUE : OMX_FALSE;
+        }
+        break;
+
+        default:
+        {
+            ret = OMX_ErrorUnsupportedIndex;
+        }
+        break;
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_set_config(OMX_HANDLETYPE handle,
+                                        OMX_INDEXTYPE index, OMX_PTR p_config)
+{
+    standin_t * p_st = standin_get(handle);
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+    if (p_config == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    if (!p_st->is_encoder)
+    {
+        return OMX_ErrorUnsupportedIndex;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    switch ((int)index)
+    {
+        case OMX_IndexConfigVideoBitrate:
+        {
+            p_st->bitrate.nTargetBitrate =
+                ((OMX_VIDEO_CONFIG_BITRATETYPE *)p_config)->nEncodeBitrate;
+            p_st->ports[1].def.format.video.nBitrate =
+                p_st->bitrate.nTargetBitrate;
+        }
+        break;
+
+        case OMX_IndexConfigVideoFramerate:
+        {
+            p_st->x_encode_framerate =
+                ((OMX_CONFIG_FRAMERATETYPE *)p_config)->xEncodeFramerate;
+        }
+        break;
+
+        case OMX_IndexConfigVideoIntraVOPRefresh:
+        {
+            if (((OMX_CONFIG_INTRAREFRESHVOPTYPE *)p_config)->IntraRefreshVOP)
+            {
+                p_st->idr_request = true;
+            }
+        }
+        break;
+
+        default:
+        {
+            ret = OMX_ErrorUnsupportedIndex;
+        }
+        break;
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_get_extension_index(OMX_HANDLETYPE handle,
+                                                 OMX_STRING p_name,
+                                                 OMX_INDEXTYPE * p_index)
+{
+    (void)handle;
+    (void)p_name;
+    (void)p_index;
+
+    return OMX_ErrorUnsupportedIndex;
+}
+
+static OMX_ERRORTYPE standin_get_state(OMX_HANDLETYPE handle,
+                                       OMX_STATETYPE * p_state)
+{
+    standin_t * p_st = standin_get(handle);
+
+    if (p_state == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+    *p_state = p_st->state;
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE standin_add_buffer(OMX_HANDLETYPE handle,
+                                        OMX_BUFFERHEADERTYPE ** pp_hdr,
+                                        OMX_U32 port_idx, OMX_PTR p_app_private,
+                                        OMX_U32 size, OMX_U8 * p_data)
+{
+    standin_t * p_st = standin_get(handle);
+    standin_port_t * p_port = NULL;
+    OMX_BUFFERHEADERTYPE * p_hdr = NULL;
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+    bool own_data = (p_data == NULL);
+
+    if ((pp_hdr == NULL) || (port_idx > 1))
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    p_port = &p_st->ports[port_idx];
+
+    if (size < p_port->def.nBufferSize)
+    {
+        ret = OMX_ErrorBadParameter;
+    }
+    else if (p_port->hdr_count >= p_port->def.nBufferCountActual)
+    {
+        ret = OMX_ErrorIncorrectStateOperation;
+    }
+    else
+    {
+        p_hdr = (OMX_BUFFERHEADERTYPE *)calloc(1, sizeof(OMX_BUFFERHEADERTYPE));
+
+        if (own_data && (p_hdr != NULL))
+        {
+            p_data = (OMX_U8 *)aligned_alloc(STANDIN_BUF_ALIGN,
+                                   STANDIN_ROUND_UP(size, STANDIN_BUF_ALIGN));
+        }
+
+        if ((p_hdr == NULL) || (p_data == NULL))
+        {
+            free(p_hdr);
+            ret = OMX_ErrorInsufficientResources;
+        }
+        else
+        {
+            STANDIN_INIT_STRUCTURE(p_hdr);
+
+            p_hdr->pBuffer          = p_data;
+            p_hdr->nAllocLen        = size;
+            p_hdr->pAppPrivate      = p_app_private;
+            p_hdr->nInputPortIndex  = (port_idx == 0) ? 0 : OMX_ALL;
+            p_hdr->nOutputPortIndex = (port_idx == 1) ? 1 : OMX_ALL;
+
+            p_port->own_data[p_port->hdr_count] = own_data;
+            p_port->p_hdrs[p_port->hdr_count++] = p_hdr;
+
+            if (p_port->hdr_count == p_port->def.nBufferCountActual)
+            {
+                p_port->def.bPopulated = OMX_TRUE;
+            }
+
+            *pp_hdr = p_hdr;
+            pthread_cond_signal(&p_st->cond);
+        }
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_use_buffer(OMX_HANDLETYPE handle,
+                                        OMX_BUFFERHEADERTYPE ** pp_hdr,
+                                        OMX_U32 port_idx, OMX_PTR p_app_private,
+                                        OMX_U32 size, OMX_U8 * p_data)
+{
+    if (p_data == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    return standin_add_buffer(handle, pp_hdr, port_idx,
+                              p_app_private, size, p_data);
+}
+
+static OMX_ERRORTYPE standin_allocate_buffer(OMX_HANDLETYPE handle,
+                                             OMX_BUFFERHEADERTYPE ** pp_hdr,
+                                             OMX_U32 port_idx,
+                                             OMX_PTR p_app_private,
+                                             OMX_U32 size)
+{
+    return standin_add_buffer(handle, pp_hdr, port_idx,
+                              p_app_private, size, NULL);
+}
+
+static OMX_ERRORTYPE standin_free_buffer(OMX_HANDLETYPE handle,
+                                         OMX_U32 port_idx,
+                                         OMX_BUFFERHEADERTYPE * p_hdr)
+{
+    standin_t * p_st = standin_get(handle);
+    standin_port_t * p_port = NULL;
+    uint32_t index = 0;
+
+    if ((p_hdr == NULL) || (port_idx > 1))
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    p_port = &p_st->ports[port_idx];
+
+    for (index = 0; index < p_port->hdr_count; index++)
+    {
+        if (p_port->p_hdrs[index] == p_hdr)
+        {
+            break;
+        }
+    }
+
+    if (index == p_port->hdr_count)
+    {
+        pthread_mutex_unlock(&p_st->mutex);
+        return OMX_ErrorBadParameter;
+    }
+
+    if (p_port->own_data[index])
+    {
+        free(p_hdr->pBuffer);
+    }
+
+    free(p_hdr);
+
+    p_port->hdr_count--;
+    p_port->p_hdrs[index]   = p_port->p_hdrs[p_port->hdr_count];
+    p_port->own_data[index] = p_port->own_data[p_port->hdr_count];
+    p_port->def.bPopulated  = OMX_FALSE;
+
+    pthread_cond_signal(&p_st->cond);
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE standin_queue_buffer(OMX_HANDLETYPE handle,
+                                          OMX_U32 port_idx,
+                                          OMX_BUFFERHEADERTYPE * p_hdr)
+{
+    standin_t * p_st = standin_get(handle);
+    standin_port_t * p_port = NULL;
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+    if (p_hdr == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    p_port = &p_st->ports[port_idx];
+
+    if ((p_st->state != OMX_StateExecuting) &&
+        (p_st->state != OMX_StatePause) &&
+        (p_st->state != OMX_StateIdle))
+    {
+        ret = OMX_ErrorIncorrectStateOperation;
+    }
+    else if (p_port->def.bEnabled == OMX_FALSE)
+    {
+        ret = OMX_ErrorIncorrectStateOperation;
+    }
+    else if (p_port->fifo_len == STANDIN_MAX_BUFFERS)
+    {
+        ret = OMX_ErrorOverflow;
+    }
+    else
+    {
+        p_port->p_fifo[(p_port->fifo_head + p_port->fifo_len) %
+                       STANDIN_MAX_BUFFERS] = p_hdr;
+        p_port->fifo_len++;
+
+        pthread_cond_signal(&p_st->cond);
+    }
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return ret;
+}
+
+static OMX_ERRORTYPE standin_empty_this_buffer(OMX_HANDLETYPE handle,
+                                               OMX_BUFFERHEADERTYPE * p_hdr)
+{
+    return standin_queue_buffer(handle, 0, p_hdr);
+}
+
+static OMX_ERRORTYPE standin_fill_this_buffer(OMX_HANDLETYPE handle,
+                                              OMX_BUFFERHEADERTYPE * p_hdr)
+{
+    return standin_queue_buffer(handle, 1, p_hdr);
+}
+
+static OMX_ERRORTYPE standin_set_callbacks(OMX_HANDLETYPE handle,
+                                           OMX_CALLBACKTYPE * p_callbacks,
+                                           OMX_PTR p_app_data)
+{
+    standin_t * p_st = standin_get(handle);
+
+    if (p_callbacks == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    pthread_mutex_lock(&p_st->mutex);
+
+    p_st->callbacks  = *p_callbacks;
+    p_st->p_app_data = p_app_data;
+
+    pthread_mutex_unlock(&p_st->mutex);
+
+    return OMX_ErrorNone;
+}
+
+/******************************************************************************
+ *                              CORE FUNCTIONS                                *
+ ******************************************************************************/
+
+OMX_ERRORTYPE OMX_Init(void)
+{
+    pthread_mutex_lock(&g_core_mutex);
+    g_core_refs++;
+    pthread_mutex_unlock(&g_core_mutex);
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE OMX_Deinit(void)
+{
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+
+    pthread_mutex_lock(&g_core_mutex);
+
+    if (g_core_refs == 0)
+    {
+        ret = OMX_ErrorNotReady;
+    }
+    else
+    {
+        g_core_refs--;
+    }
+
+    pthread_mutex_unlock(&g_core_mutex);
+
+    return ret;
+}
+
+OMX_ERRORTYPE OMX_ComponentNameEnum(OMX_STRING p_name, OMX_U32 len,
+                                    OMX_U32 index)
+{
+    if (index >= (sizeof(g_component_names) / sizeof(g_component_names[0])))
+    {
+        return OMX_ErrorNoMore;
+    }
+
+    if ((p_name == NULL) || (len <= strlen(g_component_names[index])))
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    strcpy(p_name, g_component_names[index]);
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE OMX_GetHandle(OMX_HANDLETYPE * p_handle, OMX_STRING p_name,
+                            OMX_PTR p_app_data, OMX_CALLBACKTYPE * p_callbacks)
+{
+    OMX_COMPONENTTYPE * p_comp = NULL;
+    standin_t * p_st = NULL;
+    const char * p_env = NULL;
+
+    if ((p_handle == NULL) || (p_name == NULL) || (p_callbacks == NULL))
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    if ((strcmp(p_name, STANDIN_DECODER_NAME) != 0) &&
+        (strcmp(p_name, STANDIN_ENCODER_NAME) != 0))
+    {
+        return OMX_ErrorComponentNotFound;
+    }
+
+    p_comp = (OMX_COMPONENTTYPE *)calloc(1, sizeof(OMX_COMPONENTTYPE));
+    p_st   = (standin_t *)calloc(1, sizeof(standin_t));
+
+    if ((p_comp == NULL) || (p_st == NULL))
+    {
+        free(p_comp);
+        free(p_st);
+        return OMX_ErrorInsufficientResources;
+    }
+
+    STANDIN_INIT_STRUCTURE(p_comp);
+
+    p_comp->pComponentPrivate   = p_st;
+    p_comp->pApplicationPrivate = p_app_data;
+    p_comp->GetComponentVersion = standin_get_version;
+    p_comp->SendCommand         = standin_send_command;
+    p_comp->GetParameter        = standin_get_parameter;
+    p_comp->SetParameter        = standin_set_parameter;
+    p_comp->GetConfig           = standin_get_config;
+    p_comp->SetConfig           = standin_set_config;
+    p_comp->GetExtensionIndex   = standin_get_extension_index;
+    p_comp->GetState            = standin_get_state;
+    p_comp->UseBuffer           = standin_use_buffer;
+    p_comp->AllocateBuffer      = standin_allocate_buffer;
+    p_comp->FreeBuffer          = standin_free_buffer;
+    p_comp->EmptyThisBuffer     = standin_empty_this_buffer;
+    p_comp->FillThisBuffer      = standin_fill_this_buffer;
+    p_comp->SetCallbacks        = standin_set_callbacks;
+
+    p_st->p_comp     = p_comp;
+    p_st->is_encoder = (strcmp(p_name, STANDIN_ENCODER_NAME) == 0);
+    p_st->state      = OMX_StateLoaded;
+    p_st->callbacks  = *p_callbacks;
+    p_st->p_app_data = p_app_data;
+    p_st->fill       = true;
+
+    p_env = getenv("STANDIN_FRAME_US");
+    if (p_env != NULL)
+    {
+        p_st->frame_us = (uint32_t)strtoul(p_env, NULL, 10);
+    }
+
+    p_env = getenv("STANDIN_FILL");
+    if (p_env != NULL)
+    {
+        p_st->fill = (strtoul(p_env, NULL, 10) != 0);
+    }
+
+    standin_init_port(p_st, 0, p_st->is_encoder);
+    standin_init_port(p_st, 1, !p_st->is_encoder);
+
+    STANDIN_INIT_STRUCTURE(&p_st->bitrate);
+    p_st->bitrate.nPortIndex     = 1;
+    p_st->bitrate.eControlRate   = OMX_Video_ControlRateVariable;
+    p_st->bitrate.nTargetBitrate = 4000000;
+
+    STANDIN_INIT_STRUCTURE(&p_st->avc);
+    p_st->avc.nPortIndex = 1;
+    p_st->avc.nPFrames   = 29;
+    p_st->avc.nRefFrames = 1;
+    p_st->avc.eProfile   = OMX_VIDEO_AVCProfileHigh;
+    p_st->avc.eLevel     = OMX_VIDEO_AVCLevel4;
+
+    STANDIN_INIT_STRUCTURE(&p_st->intra_refresh);
+    p_st->intra_refresh.nPortIndex = 1;
+
+    STANDIN_INIT_STRUCTURE(&p_st->vui);
+    p_st->vui.nPortIndex = 1;
+
+    p_st->x_encode_framerate = 30 << 16;
+
+    pthread_mutex_init(&p_st->mutex, NULL);
+    pthread_cond_init(&p_st->cond, NULL);
+
+    if (pthread_create(&p_st->thread, NULL, standin_thread, p_st) != 0)
+    {
+        free(p_comp);
+        free(p_st);
+        return OMX_ErrorInsufficientResources;
+    }
+
+    *p_handle = p_comp;
+
+    return OMX_ErrorNone;
+}
+
+OMX_ERRORTYPE OMX_FreeHandle(OMX_HANDLETYPE handle)
+{
+    standin_t * p_st = NULL;
+
+    if (handle == NULL)
+    {
+        return OMX_ErrorBadParameter;
+    }
+
+    p_st = standin_get(handle);
+
+    pthread_mutex_lock(&p_st->mutex);
+    p_st->quit = true;
+    pthread_cond_signal(&p_st->cond);
+    pthread_mutex_unlock(&p_st->mutex);
+
+    pthread_join(p_st->thread, NULL);
+
+    pthread_cond_destroy(&p_st->cond);
+    pthread_mutex_destroy(&p_st->mutex);
+
+    free(p_st);
+    free(handle);
+
+    return OMX_ErrorNone;
+}